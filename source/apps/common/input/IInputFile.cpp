@@ -33,6 +33,14 @@
 
 namespace vca {
 
+bool IInputFile::skipFrames(unsigned nrFrames, FrameWithData &frame)
+{
+    for (unsigned i = 0; i < nrFrames; i++)
+        if (!this->readFrame(frame))
+            return false;
+    return true;
+}
+
 bool IInputFile::isEof() const
 {
     return !this->input || this->input->eof();
@@ -48,6 +56,11 @@ vca_frame_info IInputFile::getFrameInfo() const
     return this->frameInfo;
 }
 
+unsigned IInputFile::getFrameCount() const
+{
+    return this->frameCount;
+}
+
 bool IInputFile::openInput(std::string &fileName)
 {
     if (fileName == "stdin")
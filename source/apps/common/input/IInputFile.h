@@ -46,10 +46,16 @@ public:
 
     virtual bool readFrame(FrameWithData &frame) = 0;
 
+    // Skip the next nrFrames frames. The default implementation reads the frames into the
+    // given frame. Inputs that support it seek over the frames.
+    virtual bool skipFrames(unsigned nrFrames, FrameWithData &frame);
+
     bool isEof() const;
     bool isFail() const;
 
     vca_frame_info getFrameInfo() const;
+    // The number of frames in the input. 0 if unknown (e.g. for a pipe).
+    unsigned getFrameCount() const;
     virtual double getFPS() const = 0;
 
     bool openInput(std::string &fileName);
@@ -28,6 +28,7 @@ namespace filesystem = std::experimental::filesystem;
 namespace filesystem = std::filesystem;
 #endif
 
+#include <algorithm>
 #include <iterator>
 #include <string>
 namespace vca {
@@ -205,6 +206,40 @@ bool Y4MInput::readFrame(FrameWithData &frame)
     return true;
 }
 
+bool Y4MInput::skipFrames(unsigned nrFrames, FrameWithData &frame)
+{
+    if (this->isStdin() || nrFrames == 0)
+        return IInputFile::skipFrames(nrFrames, frame);
+
+    // Most files have no parameters in the frame headers. Then all frames have the same size
+    // and we can seek to the frame. If the expected frame header is not found there, the
+    // frames are read.
+    const char frameHeader[] = "FRAME\n";
+    const auto headerSize    = sizeof(frameHeader) - 1;
+    auto isAtFrameHeader     = [&]() {
+        char header[headerSize];
+        this->input->read(header, headerSize);
+        return this->input->good() && std::equal(header, header + headerSize, frameHeader);
+    };
+
+    const auto start = this->input->tellg();
+    if (isAtFrameHeader())
+    {
+        const auto frameSize = std::streamoff(headerSize + frame.getFrameSize());
+        const auto target    = start + frameSize * nrFrames;
+        this->input->seekg(target);
+        if (isAtFrameHeader())
+        {
+            this->input->seekg(target);
+            return true;
+        }
+    }
+
+    this->input->clear();
+    this->input->seekg(start);
+    return IInputFile::skipFrames(nrFrames, frame);
+}
+
 double Y4MInput::getFPS() const
 {
     return this->fps;
@@ -36,6 +36,7 @@ public:
     ~Y4MInput() = default;
 
     bool readFrame(FrameWithData &frame) override;
+    bool skipFrames(unsigned nrFrames, FrameWithData &frame) override;
     double getFPS() const override;
 };
 
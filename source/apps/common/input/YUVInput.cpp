@@ -74,6 +74,15 @@ bool YUVInput::readFrame(FrameWithData &frame)
     return true;
 }
 
+bool YUVInput::skipFrames(unsigned nrFrames, FrameWithData &frame)
+{
+    if (this->isStdin())
+        return IInputFile::skipFrames(nrFrames, frame);
+
+    this->input->seekg(std::streamoff(frame.getFrameSize()) * nrFrames, std::ios::cur);
+    return this->input->good();
+}
+
 double YUVInput::getFPS() const
 {
     return 0.0;
@@ -31,6 +31,7 @@ public:
     ~YUVInput() = default;
 
     bool readFrame(FrameWithData &frame) override;
+    bool skipFrames(unsigned nrFrames, FrameWithData &frame) override;
     double getFPS() const override;
 };
 
@@ -26,9 +26,11 @@ using namespace std::string_literals;
 
 YUViewStatsFile::YUViewStatsFile(const std::string &filename,
                                  const std::string &inputFilename,
-                                 const vca_frame_info &info)
+                                 const vca_frame_info &info,
+                                 const std::vector<unsigned> &blockGridSizes)
 {
-    this->info = info;
+    this->info           = info;
+    this->blockGridSizes = blockGridSizes;
     this->file.open(filename);
 
     vca_log(LogLevel::Info, "Opened YUView csv file " + filename);
@@ -46,6 +48,17 @@ YUViewStatsFile::YUViewStatsFile(const std::string &filename,
     this->file << "%;defaultRange;0;10000;heat\n"s;
     this->file << "%;type;2;SAD;range\n"s;
     this->file << "%;defaultRange;0;3000;heat\n"s;
+
+    for (unsigned i = 0; i < blockGridSizes.size(); i++)
+    {
+        const auto size = std::to_string(blockGridSizes[i]);
+        this->file << "%;type;"s << 3 + i * 2 << ";BlockBrightness"s << size << "x"s << size
+                   << ";range\n"s;
+        this->file << "%;defaultRange;0;300;heat\n"s;
+        this->file << "%;type;"s << 4 + i * 2 << ";BlockEnergy"s << size << "x"s << size
+                   << ";range\n"s;
+        this->file << "%;defaultRange;0;10000;heat\n"s;
+    }
 }
 
 void YUViewStatsFile::write(const vca_frame_results &results,
@@ -97,6 +110,26 @@ void YUViewStatsFile::write(const vca_frame_results &results,
                                << blockSize << ";" << blockSize << ";2;" << *(data++) << "\n";
         }
     }
+
+    for (unsigned i = 0; i < this->blockGridSizes.size(); i++)
+    {
+        const auto gridBlockSize = this->blockGridSizes[i];
+        const auto &grid         = results.blockGrids[i];
+        const auto gridWidth     = (info.width + gridBlockSize - 1) / gridBlockSize;
+        const auto gridHeight    = (info.height + gridBlockSize - 1) / gridBlockSize;
+        for (unsigned type = 0; type < 2; type++)
+        {
+            auto data = (type == 0) ? grid.brightnessPerBlock : grid.energyPerBlock;
+            if (!enableDCTenergy || data == nullptr)
+                continue;
+            for (unsigned y = 0; y < gridHeight; y++)
+                for (unsigned x = 0; x < gridWidth; x++)
+                    this->file << results.poc << ";" << x * gridBlockSize << ";"
+                               << y * gridBlockSize << ";" << gridBlockSize << ";"
+                               << gridBlockSize << ";" << 3 + i * 2 + type << ";" << *(data++)
+                               << "\n";
+        }
+    }
 }
 
 } // namespace vca
\ No newline at end of file
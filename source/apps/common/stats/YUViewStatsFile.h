@@ -23,15 +23,19 @@
 #include <fstream>
 #include <iostream>
 #include <string>
+#include <vector>
 
 namespace vca {
 
 class YUViewStatsFile
 {
 public:
+    // The results of vca_frame_results::blockGrids are written for the block grids with
+    // these block sizes (in luma samples of the input)
     YUViewStatsFile(const std::string &filename,
                     const std::string &inputFilename,
-                    const vca_frame_info &info);
+                    const vca_frame_info &info,
+                    const std::vector<unsigned> &blockGridSizes = {});
     ~YUViewStatsFile() = default;
 
     void write(const vca_frame_results &results,
@@ -43,6 +47,7 @@ private:
     std::ofstream file;
 
     vca_frame_info info;
+    std::vector<unsigned> blockGridSizes;
 };
 
 } // namespace vca
\ No newline at end of file
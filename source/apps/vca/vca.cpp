@@ -26,12 +26,15 @@
 #include <lib/vcaLib.h>
 
 #include <algorithm>
+#include <array>
 #include <chrono>
+#include <cstdio>
 #include <cstring>
 #include <memory>
 #include <optional>
 #include <signal.h>
 #include <queue>
+#include <sstream>
 #include <cmath>
 
 #ifdef _WIN32
@@ -111,11 +114,15 @@ struct CLIOptions
     bool openAsY4m{};
     unsigned skipFrames{};
     unsigned framesToBeAnalyzed{};
+    unsigned frameStep{};
+    unsigned frameBudget{};
+    unsigned frameRun{2};
     unsigned segmentSize{};
     std::string complexityCSVFilename;
     std::string segmentFeatureCSVFilename;
     std::string shotCSVFilename;
     std::string yuviewStatsFilename;
+    std::string traceFilename;
 
     vca_param vcaParam;
     vca_shot_detection_param shotDetectParam;
@@ -123,7 +130,10 @@ struct CLIOptions
 
 struct Result
 {
-    Result(const vca_frame_info &info, unsigned blockSize)
+    Result(const vca_frame_info &info,
+           unsigned blockSize,
+           unsigned nrLadderResolutions     = 0,
+           const vca_param *blockGridsParam = nullptr)
     {
         auto widthInBlocks = (info.width + blockSize - 1) / blockSize;
         auto heightInBlock = (info.height + blockSize - 1) / blockSize;
@@ -134,14 +144,81 @@ struct Result
         this->result.energyPerBlock = this->energyPerBlockData.data();
         this->sadPerBlockData.resize(numberBlocks);
         this->result.energyDiffPerBlock = this->sadPerBlockData.data();
+
+        if (blockGridsParam != nullptr)
+        {
+            // The grid sizes are given in samples of the analyzed (possibly decimated) frame
+            const auto scale = blockSize / blockGridsParam->blockSize;
+            for (unsigned i = 0; i < blockGridsParam->nrBlockGrids; i++)
+            {
+                const auto gridBlockSize = blockGridsParam->blockGridSizes[i] * scale;
+                const auto nrGridBlocks  = ((info.width + gridBlockSize - 1) / gridBlockSize)
+                                          * ((info.height + gridBlockSize - 1) / gridBlockSize);
+                this->blockGridData[i][0].resize(nrGridBlocks);
+                this->blockGridData[i][1].resize(nrGridBlocks);
+                this->result.blockGrids[i].brightnessPerBlock = this->blockGridData[i][0].data();
+                this->result.blockGrids[i].energyPerBlock     = this->blockGridData[i][1].data();
+            }
+        }
+
+        // Only the frame level values are used for the ladder resolutions
+        if (nrLadderResolutions > 0)
+        {
+            this->ladderResultsData.resize(nrLadderResolutions);
+            this->result.ladderResults = this->ladderResultsData.data();
+        }
     }
 
     std::vector<uint32_t> brightnessPerBlockData;
     std::vector<uint32_t> energyPerBlockData;
     std::vector<uint32_t> sadPerBlockData;
+    std::vector<vca_frame_results> ladderResultsData;
+    std::array<std::array<std::vector<uint32_t>, 2>, VCA_MAX_BLOCK_GRIDS> blockGridData;
     vca_frame_results result;
 };
 
+bool parseLadderResolutions(const std::string &arg, vca_param &param)
+{
+    param.nrLadderResolutions = 0;
+    size_t start              = 0;
+    while (start < arg.size())
+    {
+        auto end = arg.find(',', start);
+        if (end == std::string::npos)
+            end = arg.size();
+        if (param.nrLadderResolutions == VCA_MAX_LADDER_RESOLUTIONS)
+        {
+            vca_log(LogLevel::Error,
+                    "Too many ladder resolutions. At most "
+                        + std::to_string(VCA_MAX_LADDER_RESOLUTIONS) + " are supported.");
+            return false;
+        }
+        auto &resolution = param.ladderResolutions[param.nrLadderResolutions];
+        const auto entry = arg.substr(start, end - start);
+        if (sscanf(entry.c_str(), "%ux%u", &resolution.width, &resolution.height) != 2)
+        {
+            vca_log(LogLevel::Error, "Invalid ladder resolution " + entry + ". Format WxH.");
+            return false;
+        }
+        param.nrLadderResolutions++;
+        start = end + 1;
+    }
+    return true;
+}
+
+// The complexity CSV of a ladder resolution gets the resolution appended to the file name
+// (before the extension)
+std::string getLadderFilename(const std::string &filename, vca_resolution resolution)
+{
+    const auto suffix = "_" + std::to_string(resolution.width) + "x"
+                        + std::to_string(resolution.height);
+    const auto dot    = filename.rfind('.');
+    const auto slash  = filename.find_last_of("/\\");
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+        return filename + suffix;
+    return filename.substr(0, dot) + suffix + filename.substr(dot);
+}
+
 std::optional<CLIOptions> parseCLIOptions(int argc, char **argv)
 {
     bool bError = false;
@@ -212,6 +289,23 @@ std::optional<CLIOptions> parseCLIOptions(int argc, char **argv)
             options.vcaParam.enableEntropy = false;
         else if (name == "no-edgedensity")
             options.vcaParam.enableEdgeDensity = false;
+        else if (name == "shot-detection-only")
+        {
+            options.vcaParam.enableShotDetectionOnly = true;
+            options.vcaParam.enableDCTenergy         = true;
+            options.vcaParam.enableEntropy           = false;
+            options.vcaParam.enableEdgeDensity       = false;
+            options.vcaParam.enableEnergyChroma      = false;
+            options.vcaParam.enableEntropyChroma     = false;
+        }
+        else if (name == "hadamard-energy")
+            options.vcaParam.enableHadamardEnergy = true;
+        else if (name == "static-block-cache")
+            options.vcaParam.enableStaticBlockCache = true;
+        else if (name == "detect-duplicate-frames")
+            options.vcaParam.enableDuplicateFrameDetection = true;
+        else if (name == "stage-timings")
+            options.vcaParam.enableStageTimings = true;
         else if (name == "y4m")
             options.openAsY4m = true;
         else
@@ -249,6 +343,12 @@ std::optional<CLIOptions> parseCLIOptions(int argc, char **argv)
                 options.skipFrames = std::stoul(optarg);
             else if (name == "frames")
                 options.framesToBeAnalyzed = std::stoul(optarg);
+            else if (name == "frame-step")
+                options.frameStep = std::stoul(optarg);
+            else if (name == "frame-budget")
+                options.frameBudget = std::stoul(optarg);
+            else if (name == "frame-run")
+                options.frameRun = std::stoul(optarg);
             else if (name == "complexity-csv")
                 options.complexityCSVFilename = optarg;
             else if (name == "segment-size")
@@ -259,6 +359,11 @@ std::optional<CLIOptions> parseCLIOptions(int argc, char **argv)
                 options.shotCSVFilename = optarg;
             else if (name == "yuview-stats")
                 options.yuviewStatsFilename = optarg;
+            else if (name == "trace")
+            {
+                options.traceFilename          = optarg;
+                options.vcaParam.enableTracing = true;
+            }
             else if (name == "max-epsthresh")
                 options.shotDetectParam.maxEpsilonThresh = std::stod(optarg);
             else if (name == "min-epsthresh")
@@ -269,6 +374,63 @@ std::optional<CLIOptions> parseCLIOptions(int argc, char **argv)
                 options.vcaParam.blockSize = std::stoi(optarg);
             else if (name == "threads")
                 options.vcaParam.nrFrameThreads = std::stoi(optarg);
+            else if (name == "job-queue-size")
+                options.vcaParam.jobQueueSize = std::stoul(optarg);
+            else if (name == "max-results-memory")
+                options.vcaParam.maxQueuedResultsMemory = std::stoul(optarg) * 1024 * 1024;
+            else if (name == "roi")
+            {
+                auto &roi = options.vcaParam.regionOfInterest;
+                if (sscanf(optarg, "%u,%u,%u,%u", &roi.x, &roi.y, &roi.width, &roi.height) != 4)
+                {
+                    vca_log(LogLevel::Error, "Invalid region of interest. Format x,y,w,h.");
+                    return {};
+                }
+            }
+            else if (name == "decimate")
+                options.vcaParam.decimationFactor = std::stoul(optarg);
+            else if (name == "sample-blocks")
+                options.vcaParam.blockSamplingInterval = std::stoul(optarg);
+            else if (name == "sampling-pattern")
+            {
+                if (arg == "stratified")
+                    options.vcaParam.blockSamplingPattern = vca_sampling_pattern::Stratified;
+                else if (arg == "checkerboard")
+                    options.vcaParam.blockSamplingPattern = vca_sampling_pattern::Checkerboard;
+                else
+                {
+                    vca_log(LogLevel::Error,
+                            "Invalid sampling pattern. Must be stratified or checkerboard.");
+                    return {};
+                }
+            }
+            else if (name == "realtime-fps")
+                options.vcaParam.realTimeFrameRate = std::stod(optarg);
+            else if (name == "realtime-latency")
+                options.vcaParam.realTimeLatencyMs = std::stoul(optarg);
+            else if (name == "detect-letterbox")
+                options.vcaParam.letterboxDetectionFrames = std::stoul(optarg);
+            else if (name == "ladder")
+            {
+                if (!parseLadderResolutions(arg, options.vcaParam))
+                    return {};
+            }
+            else if (name == "block-grids")
+            {
+                auto &param = options.vcaParam;
+                std::istringstream sizes(arg);
+                std::string size;
+                param.nrBlockGrids = 0;
+                while (std::getline(sizes, size, ','))
+                {
+                    if (param.nrBlockGrids == VCA_MAX_BLOCK_GRIDS)
+                    {
+                        vca_log(LogLevel::Error, "Too many block grids provided.");
+                        return {};
+                    }
+                    param.blockGridSizes[param.nrBlockGrids++] = std::stoul(size);
+                }
+            }
         }
     }
 
@@ -301,15 +463,70 @@ bool checkOptions(CLIOptions options)
         return false;
     }
 
-    if (options.vcaParam.blockSize != 32 && options.vcaParam.blockSize != 16
-        && options.vcaParam.blockSize != 8)
+    const auto blockSize = options.vcaParam.blockSize;
+    if (blockSize != 8 && blockSize != 16 && blockSize != 32 && blockSize != 64 && blockSize != 128)
     {
         vca_log(LogLevel::Error,
-                "Invalid block size (" + std::to_string(options.vcaParam.blockSize)
-                    + ") provided. Valid values are 8, 16 and 32.");
+                "Invalid block size (" + std::to_string(blockSize)
+                    + ") provided. Valid values are 8, 16, 32, 64 and 128.");
         return false;
     }
 
+    const auto decimationFactor = options.vcaParam.decimationFactor;
+    if (decimationFactor != 1 && decimationFactor != 2 && decimationFactor != 4)
+    {
+        vca_log(LogLevel::Error,
+                "Invalid decimation factor (" + std::to_string(decimationFactor)
+                    + ") provided. Valid values are 1, 2 and 4.");
+        return false;
+    }
+    if (decimationFactor > 1 && blockSize > 32)
+    {
+        vca_log(LogLevel::Error, "Decimation can not be combined with a block size above 32.");
+        return false;
+    }
+
+    const auto samplingInterval = options.vcaParam.blockSamplingInterval;
+    if (samplingInterval == 0 || samplingInterval > 16)
+    {
+        vca_log(LogLevel::Error,
+                "Invalid block sampling interval (" + std::to_string(samplingInterval)
+                    + ") provided. Valid values are 1 to 16.");
+        return false;
+    }
+
+    if (options.vcaParam.realTimeFrameRate < 0.0)
+    {
+        vca_log(LogLevel::Error,
+                "Invalid real-time frame rate ("
+                    + std::to_string(options.vcaParam.realTimeFrameRate) + ") provided.");
+        return false;
+    }
+
+    if (options.frameStep > 0 || options.frameBudget > 0)
+    {
+        if (options.frameStep > 0 && options.frameBudget > 0)
+        {
+            vca_log(LogLevel::Error, "Only one of --frame-step and --frame-budget can be used.");
+            return false;
+        }
+        if (options.frameRun == 0
+            || (options.frameStep > 0 && options.frameStep < options.frameRun))
+        {
+            vca_log(LogLevel::Error,
+                    "Invalid frame run (" + std::to_string(options.frameRun)
+                        + ") provided. Must be at least 1 and at most the frame step.");
+            return false;
+        }
+        if (!options.shotCSVFilename.empty() || !options.segmentFeatureCSVFilename.empty())
+        {
+            vca_log(LogLevel::Error,
+                    "Shot detection and segment features need all frames. They can not be "
+                    "combined with --frame-step or --frame-budget.");
+            return false;
+        }
+    }
+
     if (!options.vcaParam.enableDCTenergy && !options.vcaParam.enableEntropy && !options.vcaParam.enableEdgeDensity)
     {
         vca_log(LogLevel::Error, " Either DCT energy or entropy or edge density calculation should be enabled ");
@@ -339,11 +556,15 @@ void logOptions(const CLIOptions &options)
             "  Enable Edge density: "s + (options.vcaParam.enableEdgeDensity ? "True"s : "False"s));
     vca_log(LogLevel::Info, "  Skip frames:       "s + std::to_string(options.skipFrames));
     vca_log(LogLevel::Info, "  Frames to analyze: "s + std::to_string(options.framesToBeAnalyzed));
+    vca_log(LogLevel::Info, "  Frame step:        "s + std::to_string(options.frameStep));
+    vca_log(LogLevel::Info, "  Frame budget:      "s + std::to_string(options.frameBudget));
+    vca_log(LogLevel::Info, "  Frame run:         "s + std::to_string(options.frameRun));
     vca_log(LogLevel::Info, "  Segment Size:       "s + std::to_string(options.segmentSize));  
     vca_log(LogLevel::Info, "  Segment Feature csv:"s + options.segmentFeatureCSVFilename);
     vca_log(LogLevel::Info, "  Complexity csv:    "s + options.complexityCSVFilename);
     vca_log(LogLevel::Info, "  Shot csv:          "s + options.shotCSVFilename);
     vca_log(LogLevel::Info, "  YUView stats file: "s + options.yuviewStatsFilename);
+    vca_log(LogLevel::Info, "  Trace file:        "s + options.traceFilename);
 }
 
 void logResult(const Result &result, const vca_frame *frame, const unsigned resultsCounter)
@@ -353,9 +574,9 @@ void logResult(const Result &result, const vca_frame *frame, const unsigned resu
                 "The poc of the returned data (" + std::to_string(result.result.poc)
                     + ") does not match the expected next frames POC ("
                     + std::to_string(frame->stats.poc) + ").");
-    if (result.result.poc != resultsCounter)
+    if (result.result.jobID != resultsCounter)
         vca_log(LogLevel::Warning,
-                "The poc of the returned data (" + std::to_string(result.result.poc)
+                "The job ID of the returned data (" + std::to_string(result.result.jobID)
                     + ") does not match the expected results counter ("
                     + std::to_string(resultsCounter) + ").");
 
@@ -366,42 +587,184 @@ void logResult(const Result &result, const vca_frame *frame, const unsigned resu
                 + std::to_string(result.result.energyDiff));
 }
 
-void writeComplexityStatsToFile(const Result &result,
+void writeComplexityStatsToFile(const vca_frame_results &result,
                                 std::ofstream &file,
                                 bool enableEnergyChroma,
                                 bool enableEntropyChroma,
                                 bool enableDCTenergy,
                                 bool enableEntropy,
-                                bool enableEdgeDensity)
+                                bool enableEdgeDensity,
+                                bool enableConfidence  = false,
+                                bool enableQualityTier = false)
 {
-    file << result.result.poc;
+    file << result.poc;
     if (enableDCTenergy)
     {
-        file << "," << result.result.averageEnergy << "," << result.result.energyDiff << ","
-             << result.result.energyEpsilon << ", " << result.result.averageBrightness;
+        file << "," << result.averageEnergy << "," << result.energyDiff << ","
+             << result.energyEpsilon << ", " << result.averageBrightness;
         if (enableEnergyChroma)
-            file << "," << result.result.averageU << "," << result.result.energyU << ","
-                 << result.result.averageV << "," << result.result.energyV;
+            file << "," << result.averageU << "," << result.energyU << ","
+                 << result.averageV << "," << result.energyV;
     }
     if (enableEntropy)
     {
-        file << "," << result.result.averageEntropy << "," << result.result.entropyDiff << ","
-            <<result.result.entropyEpsilon;
+        file << "," << result.averageEntropy << "," << result.entropyDiff << ","
+            <<result.entropyEpsilon;
         if (enableEntropyChroma)
-            file << "," << result.result.entropyU << "," << result.result.entropyV;
+            file << "," << result.entropyU << "," << result.entropyV;
     }
     if (enableEdgeDensity)
     {
-        file << "," << result.result.averageEdgeDensity;
+        file << "," << result.averageEdgeDensity;
+    }
+    if (enableConfidence)
+    {
+        // Only set with block sampling
+        if (enableDCTenergy)
+            file << "," << result.averageEnergyConfidence;
+        if (enableEntropy)
+            file << "," << result.averageEntropyConfidence;
+        if (enableEdgeDensity)
+            file << "," << result.averageEdgeDensityConfidence;
+    }
+    if (enableQualityTier)
+        file << "," << result.qualityTier;
+    file << "\n";
+}
+
+bool isRealTimeModeEnabled(const vca_param &param)
+{
+    return param.realTimeFrameRate > 0.0 || param.realTimeLatencyMs > 0;
+}
+
+void logStageTimings(const vca_analyzer_stats &stats, unsigned nrFrames)
+{
+    const std::array<const char *, VCA_NR_STAGES> stageNames = {"Queue wait",
+                                                                 "Frame",
+                                                                 "DCT",
+                                                                 "Weighted sum",
+                                                                 "Entropy",
+                                                                 "Edge density",
+                                                                 "Chroma",
+                                                                 "Reorder wait",
+                                                                 "Temporal",
+                                                                 "Copy out"};
+
+    vca_log(LogLevel::Info, "Stage timings (total s, average ms/frame, recent ms/frame):");
+    for (unsigned i = 0; i < VCA_NR_STAGES; i++)
+    {
+        const auto average = nrFrames > 0 ? stats.stageTimeTotal[i] * 1000.0 / nrFrames : 0.0;
+        vca_log(LogLevel::Info,
+                "  " + std::string(stageNames[i]) + ": " + std::to_string(stats.stageTimeTotal[i])
+                    + " " + std::to_string(average) + " "
+                    + std::to_string(stats.stageTimeRecent[i] * 1000.0));
+    }
+
+    std::string utilization;
+    for (unsigned i = 0; i < stats.nrThreads && i < VCA_MAX_THREAD_STATS; i++)
+        utilization += " " + std::to_string(int(stats.threadUtilization[i] * 100.0 + 0.5)) + "%";
+    vca_log(LogLevel::Info, "Thread utilization:" + utilization);
+}
+
+void writeLadderComplexityStatsToFiles(const vca_frame_results &result,
+                                       std::vector<std::ofstream> &files,
+                                       const vca_param &param)
+{
+    for (size_t i = 0; i < files.size(); i++)
+        writeComplexityStatsToFile(result.ladderResults[i],
+                                   files[i],
+                                   param.enableEnergyChroma,
+                                   param.enableEntropyChroma,
+                                   param.enableDCTenergy,
+                                   param.enableEntropy,
+                                   param.enableEdgeDensity,
+                                   param.blockSamplingInterval > 1,
+                                   isRealTimeModeEnabled(param));
+}
+
+bool openComplexityFile(std::ofstream &file, const std::string &filename, const vca_param &param)
+{
+    file.open(filename);
+    if (!file.is_open())
+    {
+        vca_log(LogLevel::Error, "Error opening complexity CSV file " + filename);
+        return false;
+    }
+    file << "POC";
+    if (param.enableDCTenergy)
+    {
+        file << ",E,h,epsilon,L";
+        if (param.enableEnergyChroma)
+            file << ",avgU,energyU,avgV,energyV";
+    }
+    if (param.enableEntropy)
+    {
+        file << ",entropy,entropyDiff, entropyEpsilon";
+        if (param.enableEntropyChroma)
+            file << ",entropyU,entropyV";
+    }
+    if (param.enableEdgeDensity)
+    {
+        file << ",edgeDensity";
+    }
+    if (param.blockSamplingInterval > 1)
+    {
+        if (param.enableDCTenergy)
+            file << ",E_ci95";
+        if (param.enableEntropy)
+            file << ",entropy_ci95";
+        if (param.enableEdgeDensity)
+            file << ",edgeDensity_ci95";
     }
+    if (isRealTimeModeEnabled(param))
+        file << ",tier";
     file << "\n";
+    return true;
 }
 
-void writeShotDetectionResultsToFile(const std::vector<vca_frame_results> &shotDetectFrames,
-                                     std::ofstream &file)
+class ShotResultWriter
 {
-    size_t shotCounter = 0;
+public:
+    ShotResultWriter(std::ofstream &file)
+        : file(file)
+    {}
+
+    void addFrame(const vca_frame_results &frame)
+    {
+        if (frame.isNewShot)
+        {
+            if (this->averageValuesShot)
+            {
+                this->writeShot();
+                this->shotCounter++;
+            }
+            this->averageValuesShot      = AverageValuesShot();
+            this->averageValuesShot->poc = frame.poc;
+            this->nrShots++;
+        }
+        this->averageValuesShot->brightness += frame.averageBrightness;
+        this->averageValuesShot->energy += frame.averageEnergy;
+        this->averageValuesShot->sad += frame.energyDiff;
+        this->averageValuesShot->u += frame.averageU;
+        this->averageValuesShot->v += frame.averageV;
+        this->averageValuesShot->energyU += frame.energyU;
+        this->averageValuesShot->energyV += frame.energyV;
+        this->averageValuesShot->epsilon += frame.energyEpsilon;
+        this->averageValuesShot->nrFramesInAverage++;
+        this->nrFrames++;
+    }
+
+    void finish()
+    {
+        if (this->averageValuesShot)
+            this->writeShot();
+        this->averageValuesShot.reset();
+    }
+
+    size_t getNrFrames() const { return this->nrFrames; }
+    size_t getNrShots() const { return this->nrShots; }
 
+private:
     struct AverageValuesShot
     {
         uint64_t brightness{};
@@ -411,51 +774,47 @@ void writeShotDetectionResultsToFile(const std::vector<vca_frame_results> &shotD
         uint64_t v{};
         uint64_t energyU{};
         uint64_t energyV{};
-        double epsilon;
+        double epsilon{};
         int poc{};
         unsigned nrFramesInAverage{};
     };
-    std::optional<AverageValuesShot> averageValuesShot{};
 
-    auto writeToFile = [&file](const AverageValuesShot &averageValuesShot, size_t shotCounter) {
-        const auto nrFrames = averageValuesShot.nrFramesInAverage;
-        file << shotCounter << ", "                             //
-             << averageValuesShot.poc << ", "                   //
-             << averageValuesShot.brightness / nrFrames << ", " //
-             << averageValuesShot.energy / nrFrames << ", "     //
-             << averageValuesShot.sad / nrFrames << ", "        //
-             << averageValuesShot.u / nrFrames << ", "          //
-             << averageValuesShot.v / nrFrames << ", "          //
-             << averageValuesShot.energyU / nrFrames << ", "    //
-             << averageValuesShot.energyV / nrFrames << ", "    //
-             << averageValuesShot.epsilon / nrFrames << "\n";
-    };
+    void writeShot()
+    {
+        const auto &shot    = *this->averageValuesShot;
+        const auto nrFrames = shot.nrFramesInAverage;
+        this->file << this->shotCounter << ", "          //
+                   << shot.poc << ", "                   //
+                   << shot.brightness / nrFrames << ", " //
+                   << shot.energy / nrFrames << ", "     //
+                   << shot.sad / nrFrames << ", "        //
+                   << shot.u / nrFrames << ", "          //
+                   << shot.v / nrFrames << ", "          //
+                   << shot.energyU / nrFrames << ", "    //
+                   << shot.energyV / nrFrames << ", "    //
+                   << shot.epsilon / nrFrames << "\n";
+    }
+
+    std::ofstream &file;
+    std::optional<AverageValuesShot> averageValuesShot{};
+    size_t shotCounter{};
+    size_t nrShots{};
+    size_t nrFrames{};
+};
 
-    for (const auto &frame : shotDetectFrames)
+bool pullShotDetectorResults(vca_shot_detector *shotDetector, ShotResultWriter &shotWriter)
+{
+    while (vca_shot_detector_result_available(shotDetector))
     {
-        if (frame.isNewShot)
+        vca_frame_results frame;
+        if (vca_shot_detector_pull(shotDetector, &frame) == VCA_ERROR)
         {
-            if (averageValuesShot)
-            {
-                writeToFile(*averageValuesShot, shotCounter);
-                shotCounter++;
-            }
-            averageValuesShot      = AverageValuesShot();
-            averageValuesShot->poc = frame.poc;
+            vca_log(LogLevel::Error, "Error pulling shot detection result");
+            return false;
         }
-        averageValuesShot->brightness += frame.averageBrightness;
-        averageValuesShot->energy += frame.averageEnergy;
-        averageValuesShot->sad += frame.energyDiff;
-        averageValuesShot->u += frame.averageU;
-        averageValuesShot->v += frame.averageV;
-        averageValuesShot->energyU += frame.energyU;
-        averageValuesShot->energyV += frame.energyV;
-        averageValuesShot->epsilon += frame.energyEpsilon;
-        averageValuesShot->nrFramesInAverage++;
-    }
-
-    if (averageValuesShot)
-        writeToFile(*averageValuesShot, shotCounter);
+        shotWriter.addFrame(frame);
+    }
+    return true;
 }
 
 void segment_result_init(Result *segment_result)
@@ -594,34 +953,40 @@ int main(int argc, char **argv)
 
     vca_log(LogLevel::Debug, "File opened");
 
-    std::ofstream complexityFile;
-    if (!options.complexityCSVFilename.empty())
+    // Spread the runs of analyzed frames evenly over the frames after the skipped frames
+    if (options.frameBudget > 0)
     {
-        complexityFile.open(options.complexityCSVFilename);
-        if (!complexityFile.is_open())
+        const auto frameCount = inputFile->getFrameCount();
+        if (frameCount == 0)
         {
             vca_log(LogLevel::Error,
-                    "Error opening complexity CSV file " + options.complexityCSVFilename);
+                    "The number of frames in the input is unknown. Use --frame-step instead of "
+                    "--frame-budget.");
             return 1;
         }
-        complexityFile << "POC";
-        if (options.vcaParam.enableDCTenergy)
-        {
-            complexityFile << ",E,h,epsilon,L";
-            if (options.vcaParam.enableEnergyChroma) 
-                complexityFile << ",avgU,energyU,avgV,energyV";
-        }
-        if (options.vcaParam.enableEntropy)
-        {
-            complexityFile << ",entropy,entropyDiff, entropyEpsilon";
-            if (options.vcaParam.enableEntropyChroma)
-                complexityFile << ",entropyU,entropyV";
-        }
-        if (options.vcaParam.enableEdgeDensity)
+        const auto nrFrames = (frameCount > options.skipFrames) ? frameCount - options.skipFrames
+                                                                : 0;
+        const auto step     = (nrFrames + options.frameBudget - 1) / options.frameBudget;
+        options.frameStep   = std::max(step, options.frameRun);
+        vca_log(LogLevel::Info,
+                "Analyzing " + std::to_string(options.frameRun) + " frames every "
+                    + std::to_string(options.frameStep) + " frames");
+    }
+
+    std::ofstream complexityFile;
+    std::vector<std::ofstream> ladderComplexityFiles;
+    if (!options.complexityCSVFilename.empty())
+    {
+        if (!openComplexityFile(complexityFile, options.complexityCSVFilename, options.vcaParam))
+            return 1;
+        for (unsigned i = 0; i < options.vcaParam.nrLadderResolutions; i++)
         {
-            complexityFile << ",edgeDensity";
+            const auto filename = getLadderFilename(options.complexityCSVFilename,
+                                                    options.vcaParam.ladderResolutions[i]);
+            ladderComplexityFiles.emplace_back();
+            if (!openComplexityFile(ladderComplexityFiles.back(), filename, options.vcaParam))
+                return 1;
         }
-        complexityFile << "\n";
     }
     
     std::ofstream segmentFeatureFile;
@@ -660,16 +1025,43 @@ int main(int argc, char **argv)
 
     auto frameInfo = inputFile->getFrameInfo();
 
+    std::ofstream shotsFile;
+    std::unique_ptr<ShotResultWriter> shotWriter;
+    vca_shot_detector *shotDetector{};
+    if (!options.shotCSVFilename.empty())
+    {
+        if (options.shotDetectParam.fps == 0.0)
+            options.shotDetectParam.fps = inputFile->getFPS();
+
+        shotsFile.open(options.shotCSVFilename);
+        if (!shotsFile.is_open())
+        {
+            vca_log(LogLevel::Error, "Error opening shot CSV file " + options.shotCSVFilename);
+            return 1;
+        }
+        shotsFile << "ID, Start POC, avg brightness, avg energy, avg sad, avg u, avg v, avg energy "
+                     "u, avg energy v, avg epsilon\n";
+        shotWriter = std::make_unique<ShotResultWriter>(shotsFile);
+
+        shotDetector = vca_shot_detector_open(options.shotDetectParam);
+        if (shotDetector == nullptr)
+        {
+            vca_log(LogLevel::Error, "Error opening shot detector");
+            return 2;
+        }
+    }
+
     vca_log(LogLevel::Debug, "Start main analysis loop");
 
     using framePtr = std::unique_ptr<FrameWithData>;
     std::queue<framePtr> frameRecycling;
     std::queue<framePtr> activeFrames;
     std::unique_ptr<YUViewStatsFile> yuviewStatsFile;
-    std::vector<vca_frame_results> shotDetectFrames;
     unsigned pushedFrames   = 0;
     unsigned resultsCounter = 0;
-    unsigned skippedFrames  = 0;
+
+    // The index of the next frame in the input (not counting the skipped frames)
+    unsigned inputFrameIndex = 0;
 
     int Segment_size = 0;
     int T_fps       = 0;
@@ -686,7 +1078,10 @@ int main(int argc, char **argv)
             Segment_size   = T_fps;
     }
 
-    Result segment_result(frameInfo, options.vcaParam.blockSize);
+    // With decimation, one block of the results covers more samples of the input frame
+    const auto resultBlockSize = options.vcaParam.blockSize * options.vcaParam.decimationFactor;
+
+    Result segment_result(frameInfo, resultBlockSize);
     segment_result_init(&segment_result);
 
     while (!inputFile->isEof() && !inputFile->isFail()
@@ -702,8 +1097,17 @@ int main(int argc, char **argv)
                 frameRecycling.pop();
             }
 
+            // After each run of analyzed frames, jump to the start of the next run
+            auto nrFramesToSkip = 0u;
+            if (pushedFrames == 0)
+                nrFramesToSkip = options.skipFrames;
+            else if (options.frameStep > 0 && pushedFrames % options.frameRun == 0)
+                nrFramesToSkip = options.frameStep - options.frameRun;
+
             try
             {
+                if (nrFramesToSkip > 0 && !inputFile->skipFrames(nrFramesToSkip, *frame))
+                    break;
                 if (!inputFile->readFrame(*frame))
                     break;
             }
@@ -713,22 +1117,26 @@ int main(int argc, char **argv)
                 return 3;
             }
 
-            if (options.skipFrames > 0)
-            {
-                frameRecycling.push(std::move(frame));
-                options.skipFrames--;
-                skippedFrames++;
-                vca_log(LogLevel::Debug, "Skipped frame " + std::to_string(skippedFrames));
-                continue;
-            }
-
-            frame->getFrame()->stats.poc = pushedFrames;
-            vca_log(LogLevel::Debug, "Read frame " + std::to_string(pushedFrames) + " from input");
+            if (pushedFrames > 0)
+                inputFrameIndex += nrFramesToSkip;
+            frame->getFrame()->stats.poc       = inputFrameIndex;
+            frame->getFrame()->isDiscontinuity = (pushedFrames > 0 && nrFramesToSkip > 0);
+            vca_log(LogLevel::Debug,
+                    "Read frame " + std::to_string(inputFrameIndex) + " from input");
 
             if (!options.yuviewStatsFilename.empty() && !yuviewStatsFile)
+            {
+                // The grid sizes are given in samples of the analyzed (possibly decimated)
+                // frame
+                std::vector<unsigned> blockGridSizes;
+                for (unsigned i = 0; i < options.vcaParam.nrBlockGrids; i++)
+                    blockGridSizes.push_back(options.vcaParam.blockGridSizes[i]
+                                             * options.vcaParam.decimationFactor);
                 yuviewStatsFile = std::make_unique<YUViewStatsFile>(options.yuviewStatsFilename,
                                                                     options.inputFilename,
-                                                                    frame->getFrame()->info);
+                                                                    frame->getFrame()->info,
+                                                                    blockGridSizes);
+            }
 
             auto ret = vca_analyzer_push(analyzer, frame->getFrame());
             if (ret == VCA_ERROR)
@@ -741,11 +1149,15 @@ int main(int argc, char **argv)
 
             activeFrames.push(std::move(frame));
             pushedFrames++;
+            inputFrameIndex++;
         }
 
         while (vca_result_available(analyzer))
         {
-            Result result(frameInfo, options.vcaParam.blockSize);
+            Result result(frameInfo,
+                      resultBlockSize,
+                      unsigned(ladderComplexityFiles.size()),
+                      options.yuviewStatsFilename.empty() ? nullptr : &options.vcaParam);
 
             if (vca_analyzer_pull_frame_result(analyzer, &result.result) == VCA_ERROR)
             {
@@ -764,7 +1176,7 @@ int main(int argc, char **argv)
 
                 if (((result.result.poc) % Segment_size == 0) && !(result.result.poc == 0))
                 {
-                    writeComplexityStatsToFile(segment_result,
+                    writeComplexityStatsToFile(segment_result.result,
                                                segmentFeatureFile,
                                                options.vcaParam.enableEnergyChroma,
                                                options.vcaParam.enableEntropyChroma,
@@ -777,19 +1189,33 @@ int main(int argc, char **argv)
 
             if (yuviewStatsFile)
                 yuviewStatsFile->write(result.result,
-                                       options.vcaParam.blockSize,
+                                       resultBlockSize,
                                        options.vcaParam.enableDCTenergy,
                                        options.vcaParam.enableEntropy);
             if (complexityFile.is_open())
-                writeComplexityStatsToFile(result,
+            {
+                writeComplexityStatsToFile(result.result,
                                            complexityFile,
                                            options.vcaParam.enableEnergyChroma,
                                            options.vcaParam.enableEntropyChroma,
                                            options.vcaParam.enableDCTenergy,
                                            options.vcaParam.enableEntropy,
-                                           options.vcaParam.enableEdgeDensity);
-            if (!options.shotCSVFilename.empty())
-                shotDetectFrames.push_back(result.result);
+                                           options.vcaParam.enableEdgeDensity,
+                                           options.vcaParam.blockSamplingInterval > 1,
+                                           isRealTimeModeEnabled(options.vcaParam));
+                writeLadderComplexityStatsToFiles(result.result,
+                                                  ladderComplexityFiles,
+                                                  options.vcaParam);
+            }
+            if (shotDetector)
+            {
+                if (vca_shot_detector_push(shotDetector, &result.result) == VCA_ERROR
+                    || !pullShotDetectorResults(shotDetector, *shotWriter))
+                {
+                    vca_log(LogLevel::Error, "Error in shot detection");
+                    return 3;
+                }
+            }
 
             auto processedFrame = std::move(activeFrames.front());
             activeFrames.pop();
@@ -805,7 +1231,10 @@ int main(int argc, char **argv)
 
     while (resultsCounter < pushedFrames)
     {
-        Result result(frameInfo, options.vcaParam.blockSize);
+        Result result(frameInfo,
+                      resultBlockSize,
+                      unsigned(ladderComplexityFiles.size()),
+                      options.yuviewStatsFilename.empty() ? nullptr : &options.vcaParam);
 
         if (vca_analyzer_pull_frame_result(analyzer, &result.result) == VCA_ERROR)
         {
@@ -823,7 +1252,7 @@ int main(int argc, char **argv)
             
             if (resultsCounter == (pushedFrames - 1))
             {
-                writeComplexityStatsToFile(segment_result,
+                writeComplexityStatsToFile(segment_result.result,
                                            segmentFeatureFile,
                                            options.vcaParam.enableEnergyChroma,
                                            options.vcaParam.enableEntropyChroma,
@@ -835,19 +1264,33 @@ int main(int argc, char **argv)
         }
         if (yuviewStatsFile)
             yuviewStatsFile->write(result.result,
-                                   options.vcaParam.blockSize,
+                                   resultBlockSize,
                                    options.vcaParam.enableDCTenergy,
                                    options.vcaParam.enableEntropy);
         if (complexityFile.is_open())
-            writeComplexityStatsToFile(result,
+        {
+            writeComplexityStatsToFile(result.result,
                                        complexityFile,
                                        options.vcaParam.enableEnergyChroma,
                                        options.vcaParam.enableEntropyChroma,
                                        options.vcaParam.enableDCTenergy,
                                        options.vcaParam.enableEntropy,
-                                       options.vcaParam.enableEdgeDensity);
-        if (!options.shotCSVFilename.empty())
-            shotDetectFrames.push_back(result.result);
+                                       options.vcaParam.enableEdgeDensity,
+                                       options.vcaParam.blockSamplingInterval > 1,
+                                       isRealTimeModeEnabled(options.vcaParam));
+            writeLadderComplexityStatsToFiles(result.result,
+                                              ladderComplexityFiles,
+                                              options.vcaParam);
+        }
+        if (shotDetector)
+        {
+            if (vca_shot_detector_push(shotDetector, &result.result) == VCA_ERROR
+                || !pullShotDetectorResults(shotDetector, *shotWriter))
+            {
+                vca_log(LogLevel::Error, "Error in shot detection");
+                return 3;
+            }
+        }
 
         auto processedFrame = std::move(activeFrames.front());
         activeFrames.pop();
@@ -857,35 +1300,54 @@ int main(int argc, char **argv)
         resultsCounter++;
     }
 
+    vca_analyzer_stats stats;
+    if (vca_analyzer_get_stats(analyzer, &stats) == VCA_OK)
+    {
+        vca_log(LogLevel::Info,
+                "Skipped " + std::to_string(stats.blocksSkipped) + " of "
+                    + std::to_string(stats.blocksAnalyzed) + " flat blocks ("
+                    + std::to_string(stats.skipRatio * 100.0) + "%)");
+        if (options.vcaParam.enableStaticBlockCache)
+            vca_log(LogLevel::Info,
+                    "Reused " + std::to_string(stats.blocksReused) + " of "
+                        + std::to_string(stats.blocksAnalyzed) + " static blocks ("
+                        + std::to_string(stats.reuseRatio * 100.0) + "%)");
+        if (options.vcaParam.enableDuplicateFrameDetection)
+            vca_log(LogLevel::Info,
+                    "Detected " + std::to_string(stats.duplicateFrames) + " duplicate frames");
+        vca_log(LogLevel::Info,
+                "Job queue size " + std::to_string(stats.jobQueueSize)
+                    + ", peak memory of queued results "
+                    + std::to_string(stats.peakQueuedResultsMemory / 1024) + " KB");
+        if (isRealTimeModeEnabled(options.vcaParam))
+        {
+            std::string frames;
+            for (unsigned tier = 0; tier < VCA_NR_QUALITY_TIERS; tier++)
+                frames += " " + std::to_string(stats.framesPerQualityTier[tier]);
+            vca_log(LogLevel::Info, "Frames analyzed per quality tier:" + frames);
+        }
+        if (options.vcaParam.enableStageTimings)
+            logStageTimings(stats, resultsCounter);
+    }
+
+    if (!options.traceFilename.empty()
+        && vca_analyzer_write_trace(analyzer, options.traceFilename.c_str()) != VCA_OK)
+        vca_log(LogLevel::Error, "Error writing the trace file " + options.traceFilename);
+
     vca_analyzer_close(analyzer);
     printStatus(resultsCounter, pushedFrames, true);
 
-    if (!options.shotCSVFilename.empty())
+    if (shotDetector)
     {
-        if (options.shotDetectParam.fps == 0.0)
-            options.shotDetectParam.fps = inputFile->getFPS();
-
-        vca_shot_detection(options.shotDetectParam,
-                           shotDetectFrames.data(),
-                           shotDetectFrames.size());
-
-        std::ofstream shotsFile;
-        shotsFile.open(options.shotCSVFilename);
-        if (!shotsFile.is_open())
-        {
-            vca_log(LogLevel::Error, "Error opening shot CSV file " + options.shotCSVFilename);
-            return 1;
-        }
-        shotsFile << "ID, Start POC, avg brightness, avg energy, avg sad, avg u, avg v, avg energy "
-                     "u, avg energy v, avg epsilon\n";
-        writeShotDetectionResultsToFile(shotDetectFrames, shotsFile);
+        vca_shot_detector_flush(shotDetector);
+        if (!pullShotDetectorResults(shotDetector, *shotWriter))
+            return 3;
+        vca_shot_detector_close(shotDetector);
+        shotWriter->finish();
 
-        auto nrShots = std::count_if(shotDetectFrames.begin(),
-                                     shotDetectFrames.end(),
-                                     [](auto frame) { return frame.isNewShot; });
         vca_log(LogLevel::Info,
-                "Performed shot detection for " + std::to_string(shotDetectFrames.size())
-                    + " frames. Detected " + std::to_string(nrShots) + " shots.");
+                "Performed shot detection for " + std::to_string(shotWriter->getNrFrames())
+                    + " frames. Detected " + std::to_string(shotWriter->getNrShots()) + " shots.");
     }
 
     return 0;
@@ -38,11 +38,15 @@ static const struct option long_options[] = {{"help", no_argument, NULL, 'h'},
                                              {"input-fps", required_argument, NULL, 0},
                                              {"skip", required_argument, NULL, 0},
                                              {"frames", required_argument, NULL, 'f'},
+                                             {"frame-step", required_argument, NULL, 0},
+                                             {"frame-budget", required_argument, NULL, 0},
+                                             {"frame-run", required_argument, NULL, 0},
                                              {"complexity-csv", required_argument, NULL, 0},
                                              {"segment-size", required_argument, NULL, 0},
                                              {"segment-feature-csv", required_argument, NULL, 0},
                                              {"shot-csv", required_argument, NULL, 0},
                                              {"yuview-stats", required_argument, NULL, 0},
+                                             {"trace", required_argument, NULL, 0},
                                              {"max-epsthresh", required_argument, NULL, 0},
                                              {"min-epsthresh", required_argument, NULL, 0},
                                              {"max-sadthresh", required_argument, NULL, 0},
@@ -51,8 +55,22 @@ static const struct option long_options[] = {{"help", no_argument, NULL, 'h'},
                                              {"no-dctenergy", no_argument, 0},
                                              {"no-entropy", no_argument, 0},
                                              {"no-edgedensity", no_argument, 0},
-                                             {0, 0, 0, 0},
-                                             {0, 0, 0, 0},
+                                             {"shot-detection-only", no_argument, NULL, 0},
+                                             {"hadamard-energy", no_argument, NULL, 0},
+                                             {"static-block-cache", no_argument, NULL, 0},
+                                             {"detect-duplicate-frames", no_argument, NULL, 0},
+                                             {"stage-timings", no_argument, NULL, 0},
+                                             {"roi", required_argument, NULL, 0},
+                                             {"decimate", required_argument, NULL, 0},
+                                             {"sample-blocks", required_argument, NULL, 0},
+                                             {"sampling-pattern", required_argument, NULL, 0},
+                                             {"detect-letterbox", required_argument, NULL, 0},
+                                             {"ladder", required_argument, NULL, 0},
+                                             {"block-grids", required_argument, NULL, 0},
+                                             {"realtime-fps", required_argument, NULL, 0},
+                                             {"realtime-latency", required_argument, NULL, 0},
+                                             {"job-queue-size", required_argument, NULL, 0},
+                                             {"max-results-memory", required_argument, NULL, 0},
                                              {0, 0, 0, 0},
                                              {0, 0, 0, 0},
                                              {0, 0, 0, 0}};
@@ -79,6 +97,11 @@ static void showHelp()
     printf("-f/--frames <integer>            Maximum number of frames to analyze. Default all\n");
     printf("   --skip <integer>              Skip N frames in the input before starting the "
            "analysis\n");
+    printf("   --frame-step <integer>        Only analyze a run of frames every N frames\n");
+    printf("   --frame-budget <integer>      Only analyze runs of frames at N positions spread\n");
+    printf("                                 evenly over the input. Not for stdin.\n");
+    printf("   --frame-run <integer>         Consecutive frames analyzed at each position with\n");
+    printf("                                 --frame-step/--frame-budget. Default 2\n");
     printf("   --segment-size <integer>      Specifies the size of segment (Example: 1 = fps, 2 = "
             "2xfps)");
     printf("\nOutput Options:\n");
@@ -90,6 +113,8 @@ static void showHelp()
     printf("   --yuview-stats <filename>     Write the per block results (energy, sad) to a stats "
            "file\n");
     printf("                                 that can be visualized using YUView.\n");
+    printf("   --trace <filename>            Write a timeline of the work of the threads as a\n");
+    printf("                                 Chrome trace JSON file.\n");
     printf("\nOperation Options:\n");
     printf("   --no-simd                     Disable SIMD. Default: Enabled\n");
     printf("   --no-dctenergy-chroma         Disable chroma for DCT energy. Default: Enabled\n");
@@ -98,10 +123,47 @@ static void showHelp()
     printf("   --max-epsthresh <float>       Maximum threshold of epsilon in shot detection\n");
     printf("   --min-epsthresh <float>       Minimum threshold of epsilon in shot detection\n");
     printf("   --min-sadthresh <float>       Minimum threshold of h in shot detection\n");
-    printf("   --block-size <integer>        Block size for DCT transform. Must be 8, 16 or 32 "
-           "(Default).\n");
+    printf("   --block-size <integer>        Block size for DCT transform. Must be 8, 16, 32 "
+           "(Default), 64 or 128.\n");
     printf("   --threads <integer>           Nr of threads to use. (Default: 0 (autodetect))\n");
+    printf("   --job-queue-size <integer>    Frames that can wait for a free thread.\n");
+    printf("                                 (Default: 0 (adaptive))\n");
+    printf("   --max-results-memory <integer> Memory limit in MB for analyzed results that\n");
+    printf("                                 wait to be written. (Default: 0 (no limit))\n");
     printf("   --no-dctenergy                Disable DCT energy features. Default: Enabled\n");
     printf("   --no-entropy                  Disable entropy features. Default: Enabled\n");
     printf("   -no-edgedensity               Disable edge density calculation. Default: Enabled\n");
+    printf("   --shot-detection-only         Only compute the features needed for shot\n");
+    printf("                                 detection from the downsampled luma plane\n");
+    printf("                                 (block size 16 or more). Default: Disabled\n");
+    printf("   --hadamard-energy             Estimate the energy with the Walsh-Hadamard\n");
+    printf("                                 transform instead of the DCT. Default: Disabled\n");
+    printf("   --static-block-cache          Reuse the results of blocks that did not change\n");
+    printf("                                 since the last analyzed frame. Default: Disabled\n");
+    printf("   --detect-duplicate-frames     Reuse the results of the previous frame for frames\n");
+    printf("                                 that are identical to it. Default: Disabled\n");
+    printf("   --stage-timings               Measure the time per analysis stage and the\n");
+    printf("                                 utilization of the threads. Default: Disabled\n");
+    printf("   --roi <x,y,w,h>               Only analyze the blocks in this rectangle (in luma\n");
+    printf("                                 samples). Default: Whole frame\n");
+    printf("   --decimate <integer>          Analyze the frames decimated by 2 or 4 in each\n");
+    printf("                                 dimension. Faster but less accurate. Default: 1\n");
+    printf("   --sample-blocks <integer>     Only analyze one of N blocks (1 to 16) per frame\n");
+    printf("                                 and estimate the frame averages. The complexity\n");
+    printf("                                 CSV gets 95%% confidence columns. Default: 1\n");
+    printf("   --sampling-pattern <string>   Blocks analyzed with --sample-blocks:\n");
+    printf("                                 stratified (Default) or checkerboard\n");
+    printf("   --realtime-fps <double>       Real-time mode: Step down to cheaper quality tiers\n");
+    printf("                                 if the analysis is slower than this frame rate.\n");
+    printf("                                 The complexity CSV gets a tier column. Default: 0\n");
+    printf("   --realtime-latency <integer>  Real-time mode with a latency budget per frame in\n");
+    printf("                                 ms (from reading until analyzed). Default: 0\n");
+    printf("   --detect-letterbox <integer>  Detect black borders in the first N frames and\n");
+    printf("                                 only analyze the active picture area.\n");
+    printf("                                 Default: 0 (Disabled)\n");
+    printf("   --ladder <WxH,WxH,...>        Also analyze every frame at these resolutions.\n");
+    printf("                                 One complexity CSV is written per resolution.\n");
+    printf("   --block-grids <size,size>     Derive brightness, energy and edge density for\n");
+    printf("                                 these larger block sizes (16, 32) from the\n");
+    printf("                                 analysis. Written to the YUView stats file.\n");
 }
@@ -24,10 +24,18 @@
 #include <common/stats/YUViewStatsFile.h>
 #include <lib/vcaLib.h>
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <map>
 #include <optional>
 #include <random>
 #include <signal.h>
+#include <sstream>
 #include <thread>
 #include <queue>
 
@@ -113,20 +121,89 @@ void printStatus(uint32_t frameNum,
     fflush(stdout); // needed in windows
 }
 
+// The feature toggles that the sweep can switch. Applied on top of the library defaults.
+const std::vector<std::pair<std::string, std::function<void(vca_param &)>>> featureSets = {
+    {"default", [](vca_param &) {}},
+    {"noChroma",
+     [](vca_param &param) {
+         param.enableEnergyChroma  = false;
+         param.enableEntropyChroma = false;
+     }},
+    {"noLowpass", [](vca_param &param) { param.enableLowpass = false; }},
+    {"energyOnly",
+     [](vca_param &param) {
+         param.enableEntropy     = false;
+         param.enableEdgeDensity = false;
+     }},
+    {"hadamard", [](vca_param &param) { param.enableHadamardEnergy = true; }},
+    {"shotDetectionOnly", [](vca_param &param) { param.enableShotDetectionOnly = true; }}};
+
+struct Resolution
+{
+    unsigned width{};
+    unsigned height{};
+};
+
 struct CLIOptions
 {
     unsigned nrFrames{1000};
     vca_param vcaParam;
+
+    bool sweep{false};
+    std::vector<unsigned> threadCounts;
+    std::vector<Resolution> resolutions;
+    std::vector<unsigned> bitDepths;
+    std::vector<vca_colorSpace> colorspaces;
+    std::vector<std::string> featureSets;
+    std::string csvFilename;
+    std::string jsonFilename;
+    std::string baselineFilename;
+    double tolerance{5.0};
 };
 
+std::vector<std::string> splitList(const std::string &list)
+{
+    std::vector<std::string> items;
+    std::stringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ','))
+        items.push_back(item);
+    return items;
+}
+
+std::optional<Resolution> parseResolution(const std::string &arg)
+{
+    auto posX = arg.find("x");
+    if (posX == std::string::npos)
+    {
+        vca_log(LogLevel::Error, "Invalid resolution provided. Format WxH.");
+        return {};
+    }
+    return Resolution{unsigned(std::stoul(arg.substr(0, posX))),
+                      unsigned(std::stoul(arg.substr(posX + 1)))};
+}
+
+std::optional<vca_colorSpace> parseColorspace(const std::string &arg)
+{
+    if (arg == "400" || arg == "4:0:0")
+        return vca_colorSpace::YUV400;
+    if (arg == "420" || arg == "4:2:0")
+        return vca_colorSpace::YUV420;
+    if (arg == "422" || arg == "4:2:2")
+        return vca_colorSpace::YUV422;
+    if (arg == "444" || arg == "4:4:4")
+        return vca_colorSpace::YUV444;
+    vca_log(LogLevel::Error, "Invalid chroma subsampling " + arg);
+    return {};
+}
+
 std::optional<CLIOptions> parseCLIOptions(int argc, char **argv)
 {
-    bool bError = false;
     CLIOptions options;
 
-    int long_options_index = -1;
     while (true)
     {
+        int long_options_index = -1;
         auto c = getopt_long(argc, argv, short_options, long_options, &long_options_index);
         if (c == -1)
             break;
@@ -165,44 +242,137 @@ std::optional<CLIOptions> parseCLIOptions(int argc, char **argv)
         }
 
         auto name = std::string(long_options[long_options_index].name);
-        auto arg  = std::string(optarg);
-        if (name == "iterations")
-            options.nrFrames = std::stoul(optarg);
-        else if (name == "input-depth")
-            options.vcaParam.frameInfo.bitDepth = std::stoul(optarg);
-        else if (name == "input-res")
+        auto arg  = optarg != nullptr ? std::string(optarg) : std::string();
+        try
         {
-            auto posX = arg.find("x");
-            if (posX == std::string::npos)
+            if (name == "iterations")
+                options.nrFrames = std::stoul(arg);
+            else if (name == "input-depth")
+                options.vcaParam.frameInfo.bitDepth = std::stoul(arg);
+            else if (name == "input-res")
             {
-                vca_log(LogLevel::Error, "Invalid resolution provided. Format WxH.");
-                return {};
+                auto resolution = parseResolution(arg);
+                if (!resolution)
+                    return {};
+                options.vcaParam.frameInfo.width  = resolution->width;
+                options.vcaParam.frameInfo.height = resolution->height;
+            }
+            else if (name == "input-csp")
+            {
+                auto colorspace = parseColorspace(arg);
+                if (!colorspace)
+                    return {};
+                options.vcaParam.frameInfo.colorspace = *colorspace;
+            }
+            else if (name == "sweep")
+                options.sweep = true;
+            else if (name == "threads")
+            {
+                for (const auto &item : splitList(arg))
+                    options.threadCounts.push_back(std::stoul(item));
             }
-            options.vcaParam.frameInfo.width  = std::stoul(arg.substr(0, posX));
-            options.vcaParam.frameInfo.height = std::stoul(arg.substr(posX + 1));
+            else if (name == "resolutions")
+            {
+                for (const auto &item : splitList(arg))
+                {
+                    auto resolution = parseResolution(item);
+                    if (!resolution)
+                        return {};
+                    options.resolutions.push_back(*resolution);
+                }
+            }
+            else if (name == "depths")
+            {
+                for (const auto &item : splitList(arg))
+                    options.bitDepths.push_back(std::stoul(item));
+            }
+            else if (name == "csps")
+            {
+                for (const auto &item : splitList(arg))
+                {
+                    auto colorspace = parseColorspace(item);
+                    if (!colorspace)
+                        return {};
+                    options.colorspaces.push_back(*colorspace);
+                }
+            }
+            else if (name == "features")
+                options.featureSets = splitList(arg);
+            else if (name == "csv")
+                options.csvFilename = arg;
+            else if (name == "json")
+                options.jsonFilename = arg;
+            else if (name == "baseline")
+                options.baselineFilename = arg;
+            else if (name == "tolerance")
+                options.tolerance = std::stod(arg);
         }
-        else if (name == "input-csp")
+        catch (const std::exception &)
         {
-            if (arg == "400" || arg == "4:0:0")
-                options.vcaParam.frameInfo.colorspace = vca_colorSpace::YUV400;
-            else if (arg == "420" || arg == "4:2:0")
-                options.vcaParam.frameInfo.colorspace = vca_colorSpace::YUV420;
-            else if (arg == "422" || arg == "4:2:2")
-                options.vcaParam.frameInfo.colorspace = vca_colorSpace::YUV422;
-            else if (arg == "444" || arg == "4:4:4")
-                options.vcaParam.frameInfo.colorspace = vca_colorSpace::YUV444;
+            vca_log(LogLevel::Error, "Invalid value " + arg + " for option " + name);
+            return {};
         }
     }
 
     return options;
 }
 
+// Fill in the defaults of the sweep lists from the single run options
+void setSweepDefaults(CLIOptions &options)
+{
+    const auto &frameInfo = options.vcaParam.frameInfo;
+    if (options.threadCounts.empty())
+    {
+        const auto nrCores = std::max(std::thread::hardware_concurrency(), 1u);
+        for (unsigned threads = 1; threads < nrCores; threads *= 2)
+            options.threadCounts.push_back(threads);
+        options.threadCounts.push_back(nrCores);
+    }
+    std::sort(options.threadCounts.begin(), options.threadCounts.end());
+    options.threadCounts.erase(std::unique(options.threadCounts.begin(),
+                                           options.threadCounts.end()),
+                               options.threadCounts.end());
+
+    if (options.resolutions.empty())
+        options.resolutions.push_back({frameInfo.width, frameInfo.height});
+    if (options.bitDepths.empty())
+        options.bitDepths.push_back(frameInfo.bitDepth);
+    if (options.colorspaces.empty())
+        options.colorspaces.push_back(frameInfo.colorspace);
+    if (options.featureSets.empty())
+        options.featureSets.push_back("default");
+}
+
 bool checkOptions(CLIOptions options)
 {
-    const auto bitDepth = options.vcaParam.frameInfo.bitDepth;
-    if (bitDepth != 8 && bitDepth != 10 && bitDepth != 12)
+    auto bitDepths = options.bitDepths;
+    bitDepths.push_back(options.vcaParam.frameInfo.bitDepth);
+    for (const auto bitDepth : bitDepths)
+        if (bitDepth != 8 && bitDepth != 10 && bitDepth != 12)
+        {
+            vca_log(LogLevel::Error, "Invalid bit depth: " + std::to_string(bitDepth));
+            return false;
+        }
+
+    for (const auto threads : options.threadCounts)
+        if (threads == 0)
+        {
+            vca_log(LogLevel::Error, "The number of threads of a sweep must be at least 1");
+            return false;
+        }
+
+    for (const auto &name : options.featureSets)
+        if (std::none_of(featureSets.begin(), featureSets.end(), [&name](const auto &set) {
+                return set.first == name;
+            }))
+        {
+            vca_log(LogLevel::Error, "Unknown feature set: " + name);
+            return false;
+        }
+
+    if (options.tolerance < 0)
     {
-        vca_log(LogLevel::Error, "Invalid bit depth: " + std::to_string(bitDepth));
+        vca_log(LogLevel::Error, "The tolerance must not be negative");
         return false;
     }
 
@@ -218,12 +388,9 @@ void logOptions(CLIOptions options)
 std::vector<std::unique_ptr<FrameWithData>> generateRandomFrames(vca_frame_info frameInfo,
                                                                  unsigned nrFrames)
 {
-    if (frameInfo.colorspace != vca_colorSpace::YUV420)
-        throw std::exception("Not implemented yet");
-
     std::random_device randomDevice;
     std::default_random_engine randomEngine(randomDevice());
-    std::uniform_int_distribution<unsigned> uniform_dist(0, 255);
+    std::uniform_int_distribution<unsigned> uniform_dist(0, (1u << frameInfo.bitDepth) - 1);
 
     std::vector<std::unique_ptr<FrameWithData>> frames;
     for (unsigned i = 0; i < nrFrames; i++)
@@ -231,11 +398,20 @@ std::vector<std::unique_ptr<FrameWithData>> generateRandomFrames(vca_frame_info
         auto newFrame = std::make_unique<FrameWithData>(frameInfo);
         auto dataSize = newFrame->getFrameSize();
         auto data     = newFrame->getData();
-        for (size_t i = 0; i < dataSize; i++)
-            data[i] = uint8_t(uniform_dist(randomEngine));
+        if (frameInfo.bitDepth == 8)
+        {
+            for (size_t i = 0; i < dataSize; i++)
+                data[i] = uint8_t(uniform_dist(randomEngine));
+        }
+        else
+        {
+            auto samples = reinterpret_cast<uint16_t *>(data);
+            for (size_t i = 0; i < dataSize / 2; i++)
+                samples[i] = uint16_t(uniform_dist(randomEngine));
+        }
         frames.push_back(std::move(newFrame));
     }
-    return std::move(frames);
+    return frames;
 }
 
 #ifdef _WIN32
@@ -278,22 +454,60 @@ static int get_argv_utf8(int *argc_ptr, char ***argv_ptr)
 }
 #endif
 
-void runTest(CLIOptions &options, std::vector<std::unique_ptr<FrameWithData>> &pushFrames)
+struct RunResult
 {
-    auto analyzer = vca_analyzer_open(options.vcaParam);
+    double fps{};
+    // From pushing a frame until its result was pulled
+    std::vector<double> latenciesMs;
+};
+
+std::optional<RunResult> runTest(const vca_param &param,
+                                 unsigned nrFrames,
+                                 std::vector<std::unique_ptr<FrameWithData>> &pushFrames)
+{
+    auto analyzer = vca_analyzer_open(param);
     if (analyzer == nullptr)
     {
         vca_log(LogLevel::Error, "Error opening analyzer");
-        return;
+        return {};
     }
 
-    printStatus(0, options.nrFrames, true);
+    printStatus(0, nrFrames, true);
 
-    using framePtr          = std::unique_ptr<FrameWithData>;
+    using Clock = std::chrono::steady_clock;
+    std::vector<Clock::time_point> pushTimes(nrFrames);
+    RunResult runResult;
+
+    const auto startTime    = Clock::now();
     auto frameIt            = pushFrames.begin();
     unsigned pushedFrames   = 0;
     unsigned resultsCounter = 0;
-    for (; pushedFrames < options.nrFrames; pushedFrames++)
+
+    auto pullResult = [&]() {
+        vca_frame_results result;
+
+        vca_log(LogLevel::Debug, "Result available. Pulling it");
+
+        if (vca_analyzer_pull_frame_result(analyzer, &result) == VCA_ERROR)
+        {
+            vca_log(LogLevel::Error, "Error pulling frame result");
+            return false;
+        }
+
+        const auto latency = Clock::now() - pushTimes.at(result.poc);
+        runResult.latenciesMs.push_back(
+            std::chrono::duration<double, std::milli>(latency).count());
+
+        vca_log(LogLevel::Debug,
+                "Got results POC " + std::to_string(result.poc) + " averageEnergy "
+                    + std::to_string(result.averageEnergy) + " energyDiff "
+                    + std::to_string(result.energyDiff));
+
+        resultsCounter++;
+        return true;
+    };
+
+    for (; pushedFrames < nrFrames; pushedFrames++)
     {
         auto vcaFrame       = (*frameIt)->getFrame();
         vcaFrame->stats.poc = pushedFrames;
@@ -301,36 +515,25 @@ void runTest(CLIOptions &options, std::vector<std::unique_ptr<FrameWithData>> &p
         vca_log(LogLevel::Debug,
                 "Start push frame " + std::to_string(pushedFrames) + " to analyzer");
 
-        auto ret = vca_analyzer_push(analyzer, vcaFrame);
+        pushTimes[pushedFrames] = Clock::now();
+        auto ret                = vca_analyzer_push(analyzer, vcaFrame);
         if (ret == VCA_ERROR)
         {
             vca_log(LogLevel::Error, "Error pushing frame to lib");
-            return;
+            vca_analyzer_close(analyzer);
+            return {};
         }
 
         vca_log(LogLevel::Debug, "Pushed frame " + std::to_string(pushedFrames) + " to analyzer");
 
         while (vca_result_available(analyzer))
-        {
-            vca_frame_results result;
-
-            vca_log(LogLevel::Debug, "Result available. Pulling it");
-
-            if (vca_analyzer_pull_frame_result(analyzer, &result) == VCA_ERROR)
+            if (!pullResult())
             {
-                vca_log(LogLevel::Error, "Error pulling frame result");
-                return;
+                vca_analyzer_close(analyzer);
+                return {};
             }
 
-            vca_log(LogLevel::Debug,
-                    "Got results POC " + std::to_string(result.poc) + " averageEnergy "
-                        + std::to_string(result.averageEnergy) + " sad "
-                        + std::to_string(result.sad));
-
-            resultsCounter++;
-        }
-
-        printStatus(resultsCounter, options.nrFrames);
+        printStatus(resultsCounter, nrFrames);
 
         frameIt++;
         if (frameIt == pushFrames.end())
@@ -338,26 +541,292 @@ void runTest(CLIOptions &options, std::vector<std::unique_ptr<FrameWithData>> &p
     }
 
     while (resultsCounter < pushedFrames)
+        if (!pullResult())
+        {
+            vca_analyzer_close(analyzer);
+            return {};
+        }
+
+    const auto duration = std::chrono::duration<double>(Clock::now() - startTime).count();
+    runResult.fps       = duration > 0 ? nrFrames / duration : 0.0;
+
+    vca_analyzer_close(analyzer);
+    printStatus(nrFrames, nrFrames, false, true);
+    return runResult;
+}
+
+struct SweepResult
+{
+    Resolution resolution;
+    unsigned bitDepth{};
+    vca_colorSpace colorspace{};
+    std::string features;
+    unsigned threads{};
+    unsigned nrFrames{};
+
+    double fps{};
+    // The speedup over the run with the fewest threads of the same configuration divided by
+    // the ratio of the thread counts
+    double efficiency{};
+    double latencyP50Ms{};
+    double latencyP90Ms{};
+    double latencyP99Ms{};
+    double latencyMaxMs{};
+
+    std::optional<double> baselineFps;
+    bool isRegression{};
+};
+
+std::string getResolutionName(const Resolution &resolution)
+{
+    return std::to_string(resolution.width) + "x" + std::to_string(resolution.height);
+}
+
+// Identifies a run in the baseline file
+std::string getSweepKey(const std::string &resolution,
+                        const std::string &bitDepth,
+                        const std::string &colorspace,
+                        const std::string &features,
+                        const std::string &threads)
+{
+    return resolution + "," + bitDepth + "," + colorspace + "," + features + "," + threads;
+}
+
+std::string getSweepKey(const SweepResult &result)
+{
+    return getSweepKey(getResolutionName(result.resolution),
+                       std::to_string(result.bitDepth),
+                       vca_colorSpaceMapper.getName(result.colorspace),
+                       result.features,
+                       std::to_string(result.threads));
+}
+
+// Nearest rank percentile of sorted values
+double getPercentile(const std::vector<double> &sortedValues, double percentile)
+{
+    if (sortedValues.empty())
+        return 0.0;
+    const auto rank = size_t(std::ceil(percentile / 100.0 * double(sortedValues.size())));
+    return sortedValues[std::clamp(rank, size_t(1), sortedValues.size()) - 1];
+}
+
+std::vector<SweepResult> runSweep(const CLIOptions &options)
+{
+    std::vector<SweepResult> results;
+    const auto maxThreads = options.threadCounts.back();
+    for (const auto &resolution : options.resolutions)
+        for (const auto bitDepth : options.bitDepths)
+            for (const auto colorspace : options.colorspaces)
+            {
+                auto frameInfo       = options.vcaParam.frameInfo;
+                frameInfo.width      = resolution.width;
+                frameInfo.height     = resolution.height;
+                frameInfo.bitDepth   = bitDepth;
+                frameInfo.colorspace = colorspace;
+                auto pushFrames      = generateRandomFrames(frameInfo, maxThreads + 1);
+
+                for (const auto &features : options.featureSets)
+                {
+                    double referenceFps       = 0.0;
+                    unsigned referenceThreads = 0;
+                    for (const auto threads : options.threadCounts)
+                    {
+                        std::cout << "  [Sweep " << getResolutionName(resolution) << " "
+                                  << bitDepth << "bit "
+                                  << vca_colorSpaceMapper.getName(colorspace) << " " << features
+                                  << " " << threads << " threads]\n";
+
+                        auto param           = options.vcaParam;
+                        param.frameInfo      = frameInfo;
+                        param.nrFrameThreads = threads;
+                        for (const auto &set : featureSets)
+                            if (set.first == features)
+                                set.second(param);
+
+                        auto runResult = runTest(param, options.nrFrames, pushFrames);
+                        std::cout << "\n";
+                        if (!runResult)
+                            continue;
+
+                        if (referenceThreads == 0)
+                        {
+                            referenceFps     = runResult->fps;
+                            referenceThreads = threads;
+                        }
+
+                        auto latencies = runResult->latenciesMs;
+                        std::sort(latencies.begin(), latencies.end());
+
+                        SweepResult result;
+                        result.resolution = resolution;
+                        result.bitDepth   = bitDepth;
+                        result.colorspace = colorspace;
+                        result.features   = features;
+                        result.threads    = threads;
+                        result.nrFrames   = options.nrFrames;
+                        result.fps        = runResult->fps;
+                        result.efficiency = referenceFps > 0 ? (runResult->fps / referenceFps)
+                                                                   / (double(threads)
+                                                                      / referenceThreads)
+                                                             : 0.0;
+                        result.latencyP50Ms = getPercentile(latencies, 50);
+                        result.latencyP90Ms = getPercentile(latencies, 90);
+                        result.latencyP99Ms = getPercentile(latencies, 99);
+                        result.latencyMaxMs = latencies.empty() ? 0.0 : latencies.back();
+                        results.push_back(result);
+                    }
+                }
+            }
+    return results;
+}
+
+// Read the fps of the runs from the CSV file of a previous sweep
+std::optional<std::map<std::string, double>> readBaseline(const std::string &filename)
+{
+    std::ifstream file(filename);
+    if (!file)
     {
-        vca_frame_results result;
+        vca_log(LogLevel::Error, "Error opening baseline file " + filename);
+        return {};
+    }
 
-        vca_log(LogLevel::Debug, "Result available. Pulling it");
+    std::string line;
+    std::getline(file, line);
+    const auto header = splitList(line);
+    std::map<std::string, size_t> columns;
+    for (size_t i = 0; i < header.size(); i++)
+        columns[header[i]] = i;
+    for (auto column : {"resolution", "bitDepth", "colorspace", "features", "threads", "fps"})
+        if (columns.count(column) == 0)
+        {
+            vca_log(LogLevel::Error, "Column " + std::string(column) + " missing in " + filename);
+            return {};
+        }
 
-        if (vca_analyzer_pull_frame_result(analyzer, &result) == VCA_ERROR)
+    std::map<std::string, double> baseline;
+    while (std::getline(file, line))
+    {
+        const auto values = splitList(line);
+        if (values.size() != header.size())
+            continue;
+        const auto key = getSweepKey(values[columns["resolution"]],
+                                     values[columns["bitDepth"]],
+                                     values[columns["colorspace"]],
+                                     values[columns["features"]],
+                                     values[columns["threads"]]);
+        baseline[key] = std::stod(values[columns["fps"]]);
+    }
+    return baseline;
+}
+
+// Returns the number of runs that are slower than the baseline by more than the tolerance
+unsigned compareWithBaseline(std::vector<SweepResult> &results,
+                             const std::map<std::string, double> &baseline,
+                             double tolerancePercent)
+{
+    unsigned nrRegressions = 0;
+    for (auto &result : results)
+    {
+        const auto key = getSweepKey(result);
+        const auto it  = baseline.find(key);
+        if (it == baseline.end())
         {
-            vca_log(LogLevel::Error, "Error pulling frame result");
-            return;
+            vca_log(LogLevel::Warning, "No baseline for " + key);
+            continue;
         }
 
-        vca_log(LogLevel::Debug,
-                "Got results POC " + std::to_string(result.poc) + " averageEnergy "
-                    + std::to_string(result.averageEnergy) + " sad " + std::to_string(result.sad));
+        result.baselineFps  = it->second;
+        result.isRegression = result.fps < it->second * (1.0 - tolerancePercent / 100.0);
+        if (result.isRegression)
+        {
+            nrRegressions++;
+            std::stringstream message;
+            message << std::fixed << std::setprecision(2) << "Regression " << key << ": "
+                    << result.fps << " fps (baseline " << it->second << " fps)";
+            vca_log(LogLevel::Warning, message.str());
+        }
+    }
+    return nrRegressions;
+}
 
-        resultsCounter++;
+void writeCSV(std::ostream &stream, const std::vector<SweepResult> &results)
+{
+    stream << "resolution,bitDepth,colorspace,features,threads,frames,fps,efficiency,"
+              "latencyP50Ms,latencyP90Ms,latencyP99Ms,latencyMaxMs\n";
+    for (const auto &result : results)
+        stream << getSweepKey(result) << "," << result.nrFrames << "," << result.fps << ","
+               << result.efficiency << "," << result.latencyP50Ms << "," << result.latencyP90Ms
+               << "," << result.latencyP99Ms << "," << result.latencyMaxMs << "\n";
+}
+
+void writeJSON(std::ostream &stream, const std::vector<SweepResult> &results)
+{
+    stream << "{\n  \"version\": \"" << vca_version_str << "\",\n  \"results\": [";
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const auto &result = results[i];
+        stream << (i == 0 ? "\n" : ",\n");
+        stream << "    {\"resolution\": \"" << getResolutionName(result.resolution)
+               << "\", \"bitDepth\": " << result.bitDepth << ", \"colorspace\": \""
+               << vca_colorSpaceMapper.getName(result.colorspace) << "\", \"features\": \""
+               << result.features << "\", \"threads\": " << result.threads
+               << ", \"frames\": " << result.nrFrames << ", \"fps\": " << result.fps
+               << ", \"efficiency\": " << result.efficiency
+               << ", \"latencyMs\": {\"p50\": " << result.latencyP50Ms
+               << ", \"p90\": " << result.latencyP90Ms << ", \"p99\": " << result.latencyP99Ms
+               << ", \"max\": " << result.latencyMaxMs << "}";
+        if (result.baselineFps)
+            stream << ", \"baselineFps\": " << *result.baselineFps
+                   << ", \"regression\": " << (result.isRegression ? "true" : "false");
+        stream << "}";
     }
+    stream << "\n  ]\n}\n";
+}
 
-    vca_analyzer_close(analyzer);
-    printStatus(options.nrFrames, options.nrFrames, false, true);
+int runSweepMode(CLIOptions &options)
+{
+    std::optional<std::map<std::string, double>> baseline;
+    if (!options.baselineFilename.empty())
+    {
+        baseline = readBaseline(options.baselineFilename);
+        if (!baseline)
+            return 1;
+    }
+
+    auto results = runSweep(options);
+
+    unsigned nrRegressions = 0;
+    if (baseline)
+        nrRegressions = compareWithBaseline(results, *baseline, options.tolerance);
+
+    std::cout << "\n";
+    writeCSV(std::cout, results);
+
+    for (const auto &[filename, write] :
+         {std::make_pair(options.csvFilename, &writeCSV),
+          std::make_pair(options.jsonFilename, &writeJSON)})
+    {
+        if (filename.empty())
+            continue;
+        std::ofstream file(filename);
+        write(file, results);
+        if (!file)
+        {
+            vca_log(LogLevel::Error, "Error writing " + filename);
+            return 1;
+        }
+    }
+
+    if (baseline)
+    {
+        std::stringstream message;
+        message << nrRegressions << " of " << results.size() << " runs are more than "
+                << options.tolerance << "% slower than the baseline";
+        vca_log(nrRegressions > 0 ? LogLevel::Warning : LogLevel::Info, message.str());
+        if (nrRegressions > 0)
+            return 2;
+    }
+    return 0;
 }
 
 int main(int argc, char **argv)
@@ -399,6 +868,12 @@ int main(int argc, char **argv)
         vca_log(LogLevel::Error,
                 "Unable to register CTRL+C handler: " + std::string(strerror(errno)));
 
+    if (options.sweep)
+    {
+        setSweepDefaults(options);
+        return runSweepMode(options);
+    }
+
     auto nrFramesToAllocate = options.vcaParam.nrFrameThreads;
     if (nrFramesToAllocate == 0)
         nrFramesToAllocate = std::thread::hardware_concurrency();
@@ -426,7 +901,7 @@ int main(int argc, char **argv)
             options.vcaParam.cpuSimd   = simd.first;
             options.vcaParam.blockSize = blocksize;
 
-            runTest(options, pushFrames);
+            runTest(options.vcaParam, options.nrFrames, pushFrames);
             std::cout << "\n";
         }
     }
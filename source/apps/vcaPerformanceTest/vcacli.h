@@ -24,18 +24,22 @@
 
 #include <stdio.h>
 
-static const char short_options[]         = "f:h?";
+static const char short_options[]         = "N:h?";
 static const struct option long_options[] = {{"help", no_argument, NULL, 'h'},
                                              {"iterations", required_argument, NULL, 'N'},
                                              {"input-res", required_argument, NULL, 0},
                                              {"input-depth", required_argument, NULL, 0},
                                              {"input-csp", required_argument, NULL, 0},
-                                             {0, 0, 0, 0},
-                                             {0, 0, 0, 0},
-                                             {0, 0, 0, 0},
-                                             {0, 0, 0, 0},
-                                             {0, 0, 0, 0},
-                                             {0, 0, 0, 0},
+                                             {"sweep", no_argument, NULL, 0},
+                                             {"threads", required_argument, NULL, 0},
+                                             {"resolutions", required_argument, NULL, 0},
+                                             {"depths", required_argument, NULL, 0},
+                                             {"csps", required_argument, NULL, 0},
+                                             {"features", required_argument, NULL, 0},
+                                             {"csv", required_argument, NULL, 0},
+                                             {"json", required_argument, NULL, 0},
+                                             {"baseline", required_argument, NULL, 0},
+                                             {"tolerance", required_argument, NULL, 0},
                                              {0, 0, 0, 0}};
 
 static void showHelp()
@@ -54,4 +58,27 @@ static void showHelp()
     printf("                                 420 (4:2:0 default)\n");
     printf("                                 422 (4:2:2)\n");
     printf("                                 444 (4:4:4)\n");
+    printf("\nSweep Options:\n");
+    printf("   --sweep                       Analyze every combination of the lists below\n");
+    printf("                                 instead of all SIMD levels and block sizes\n");
+    printf("   --threads <list>              Frame threads, e.g. 1,2,4 (Default powers of 2 up\n");
+    printf("                                 to the number of cores)\n");
+    printf("   --resolutions <list>          Picture sizes, e.g. 1280x720,1920x1080 (Default\n");
+    printf("                                 --input-res)\n");
+    printf("   --depths <list>               Bit depths, e.g. 8,10 (Default --input-depth)\n");
+    printf("   --csps <list>                 Chroma subsamplings, e.g. 420,444 (Default\n");
+    printf("                                 --input-csp)\n");
+    printf("   --features <list>             Feature sets (Default default)\n");
+    printf("                                 default (library defaults)\n");
+    printf("                                 noChroma (no chroma energy and entropy)\n");
+    printf("                                 noLowpass (full DCT for all block sizes)\n");
+    printf("                                 energyOnly (no entropy and edge density)\n");
+    printf("                                 hadamard (Walsh-Hadamard energy)\n");
+    printf("                                 shotDetectionOnly (shot detection only mode)\n");
+    printf("   --csv <filename>              Write the sweep results as CSV\n");
+    printf("   --json <filename>             Write the sweep results as JSON\n");
+    printf("   --baseline <filename>         Compare the fps with the CSV file of a previous\n");
+    printf("                                 sweep\n");
+    printf("   --tolerance <float>           Allowed fps decrease in percent before a run is\n");
+    printf("                                 reported as a regression (Default 5)\n");
 }
@@ -21,25 +21,315 @@
 #include <analyzer/EntropyCalculation.h>
 #include <analyzer/simd/cpu.h>
 
+#include <algorithm>
 #include <cstring>
+#include <fstream>
 #include <map>
 #include <string>
 
 namespace vca {
 
+namespace {
+
+uint16_t saturateToUInt16(double value)
+{
+    if (value <= 0.0)
+        return 0;
+    if (value >= 65535.0)
+        return 65535;
+    return static_cast<uint16_t>(value + 0.5);
+}
+
+// Copy the per block values to the output memory of the caller in the requested format.
+// The destination type of the Native format is the type of the source values. For the
+// Fixed16 format, the values are multiplied by fixedPointScale before rounding and values
+// above the range are saturated to 65535.
+template<typename T>
+void copyPerBlockValues(void *destination,
+                        const std::vector<T> &values,
+                        vca_block_format format,
+                        double fixedPointScale = 1.0)
+{
+    if (destination == nullptr)
+        return;
+
+    switch (format)
+    {
+        case vca_block_format::Native:
+            std::memcpy(destination, values.data(), values.size() * sizeof(T));
+            break;
+        case vca_block_format::Float32:
+        {
+            auto output = static_cast<float *>(destination);
+            for (size_t i = 0; i < values.size(); i++)
+                output[i] = static_cast<float>(values[i]);
+            break;
+        }
+        case vca_block_format::Fixed16:
+        {
+            auto output = static_cast<uint16_t *>(destination);
+            for (size_t i = 0; i < values.size(); i++)
+                output[i] = saturateToUInt16(double(values[i]) * fixedPointScale);
+            break;
+        }
+    }
+}
+
+void clearTemporalResults(Result &result)
+{
+    result.energyDiffPerBlock.clear();
+    result.energyEpsilonPerBlock.clear();
+    result.entropyDiffPerBlock.clear();
+    result.energyDiff       = 0;
+    result.energyEpsilon    = 0;
+    result.entropyDiff      = 0;
+    result.entropyEpsilon   = 0;
+    result.nrAnalyzedBlocks = 0;
+    result.nrSkippedBlocks  = 0;
+    result.nrReusedBlocks   = 0;
+}
+
+// A duplicate frame has the same per block and frame level results as the previous frame.
+// Only the temporal values are calculated again (which are 0 for the differences).
+void copyResultsOfPreviousFrame(Result &result, const Result &previousResult)
+{
+    const auto poc             = result.poc;
+    const auto jobID           = result.jobID;
+    const auto isDiscontinuity = result.isDiscontinuity;
+    const auto threadIndex     = result.threadIndex;
+    const auto processingTime  = result.processingTime;
+    const auto stageTimes      = result.stageTimes;
+
+    result                 = previousResult;
+    result.poc             = poc;
+    result.jobID           = jobID;
+    result.isDuplicate     = true;
+    result.isDiscontinuity = isDiscontinuity;
+    result.threadIndex     = threadIndex;
+    result.processingTime  = processingTime;
+    result.stageTimes      = stageTimes;
+
+    clearTemporalResults(result);
+    for (auto &levelResult : result.ladderResults)
+    {
+        levelResult.poc   = poc;
+        levelResult.jobID = jobID;
+        clearTemporalResults(levelResult);
+    }
+}
+
+vca_rect intersectRects(const vca_rect &a, const vca_rect &b)
+{
+    const auto left   = std::max(a.x, b.x);
+    const auto top    = std::max(a.y, b.y);
+    const auto right  = std::min(a.x + a.width, b.x + b.width);
+    const auto bottom = std::min(a.y + a.height, b.y + b.height);
+    if (right <= left || bottom <= top)
+        return {};
+    return {left, top, right - left, bottom - top};
+}
+
+std::string rectToString(const vca_rect &rect)
+{
+    return std::to_string(rect.width) + "x" + std::to_string(rect.height) + " at "
+           + std::to_string(rect.x) + "," + std::to_string(rect.y);
+}
+
+} // namespace
+
 Analyzer::Analyzer(vca_param cfg)
 {
     this->cfg = cfg;
-    this->jobs.setMaximumQueueSize(5);
 
     const auto blockSize = this->cfg.blockSize;
-    if (blockSize != 8 && blockSize != 16 && blockSize != 32)
+    if (blockSize != 8 && blockSize != 16 && blockSize != 32 && blockSize != 64
+        && blockSize != 128)
     {
         log(cfg, LogLevel::Error, "Invalid block size: " + std::to_string(this->cfg.blockSize));
         throw std::invalid_argument("Invalid block size");
     }
     log(cfg, LogLevel::Info, "Block size: " + std::to_string(this->cfg.blockSize));
 
+    if (this->cfg.enableHadamardEnergy)
+        log(cfg, LogLevel::Info, "Estimating the energy with the Walsh-Hadamard transform");
+    if (this->cfg.enableStaticBlockCache)
+        log(cfg, LogLevel::Info, "Static block cache enabled");
+    if (this->cfg.enableDuplicateFrameDetection)
+        log(cfg, LogLevel::Info, "Duplicate frame detection enabled");
+    if (this->cfg.letterboxDetectionFrames > 0)
+    {
+        this->letterboxDetector.emplace();
+        log(cfg,
+            LogLevel::Info,
+            "Letterbox detection over " + std::to_string(this->cfg.letterboxDetectionFrames)
+                + " frames enabled");
+    }
+
+    const auto decimationFactor = this->cfg.decimationFactor;
+    if (decimationFactor != 1 && decimationFactor != 2 && decimationFactor != 4)
+    {
+        log(cfg,
+            LogLevel::Error,
+            "Invalid decimation factor: " + std::to_string(decimationFactor));
+        throw std::invalid_argument("Invalid decimation factor");
+    }
+    if (decimationFactor > 1)
+        log(cfg,
+            LogLevel::Info,
+            "Analyzing in reduced resolution (decimation factor "
+                + std::to_string(decimationFactor) + ")");
+    if (blockSize > 32)
+    {
+        // These blocks are already analyzed as 32x32 blocks of a decimated frame
+        if (decimationFactor > 1)
+        {
+            log(cfg,
+                LogLevel::Error,
+                "Decimation is not supported with block size " + std::to_string(blockSize));
+            throw std::invalid_argument("Decimation is not supported with this block size");
+        }
+        log(cfg,
+            LogLevel::Info,
+            "Analyzing " + std::to_string(blockSize) + "x" + std::to_string(blockSize)
+                + " blocks as 32x32 blocks of the frame decimated by "
+                + std::to_string(blockSize / 32));
+    }
+
+    if (this->cfg.nrLadderResolutions > VCA_MAX_LADDER_RESOLUTIONS)
+    {
+        log(cfg,
+            LogLevel::Error,
+            "Too many ladder resolutions: " + std::to_string(this->cfg.nrLadderResolutions));
+        throw std::invalid_argument("Too many ladder resolutions");
+    }
+    for (unsigned i = 0; i < this->cfg.nrLadderResolutions; i++)
+    {
+        const auto resolution = this->cfg.ladderResolutions[i];
+        const auto name       = std::to_string(resolution.width) + "x"
+                          + std::to_string(resolution.height);
+        if (resolution.width == 0 || resolution.width % 2 != 0 || resolution.height == 0
+            || resolution.height % 2 != 0)
+        {
+            log(cfg, LogLevel::Error, "Invalid ladder resolution: " + name);
+            throw std::invalid_argument("Invalid ladder resolution");
+        }
+        log(cfg, LogLevel::Info, "Analyzing ladder resolution " + name);
+    }
+
+    if (this->cfg.nrBlockGrids > VCA_MAX_BLOCK_GRIDS)
+    {
+        log(cfg,
+            LogLevel::Error,
+            "Too many block grids: " + std::to_string(this->cfg.nrBlockGrids));
+        throw std::invalid_argument("Too many block grids");
+    }
+    for (unsigned i = 0; i < this->cfg.nrBlockGrids; i++)
+    {
+        const auto gridBlockSize = this->cfg.blockGridSizes[i];
+        if ((gridBlockSize != 16 && gridBlockSize != 32) || gridBlockSize <= blockSize)
+        {
+            log(cfg,
+                LogLevel::Error,
+                "Invalid block grid size " + std::to_string(gridBlockSize)
+                    + ". Must be 16 or 32 and larger than the block size.");
+            throw std::invalid_argument("Invalid block grid size");
+        }
+        log(cfg,
+            LogLevel::Info,
+            "Deriving results for block grid " + std::to_string(gridBlockSize));
+    }
+
+    const auto samplingInterval = this->cfg.blockSamplingInterval;
+    if (samplingInterval == 0 || samplingInterval > 16)
+    {
+        log(cfg,
+            LogLevel::Error,
+            "Invalid block sampling interval: " + std::to_string(samplingInterval));
+        throw std::invalid_argument("Invalid block sampling interval");
+    }
+    if (this->cfg.blockSamplingPattern != vca_sampling_pattern::Stratified
+        && this->cfg.blockSamplingPattern != vca_sampling_pattern::Checkerboard)
+    {
+        log(cfg, LogLevel::Error, "Invalid block sampling pattern");
+        throw std::invalid_argument("Invalid block sampling pattern");
+    }
+
+    if (this->cfg.blockFormat != vca_block_format::Native
+        && this->cfg.blockFormat != vca_block_format::Float32
+        && this->cfg.blockFormat != vca_block_format::Fixed16)
+    {
+        log(cfg, LogLevel::Error, "Invalid per block output format");
+        throw std::invalid_argument("Invalid per block output format");
+    }
+
+    if (this->cfg.enableShotDetectionOnly)
+    {
+        // The 8x8 blocks can not be downsampled any further and the thresholds of the shot
+        // detection are not reached by the energy of 8x8 blocks at cuts.
+        if (this->cfg.blockSize == 8)
+        {
+            log(cfg,
+                LogLevel::Error,
+                "The shot detection only mode requires a block size of 16 or more");
+            throw std::invalid_argument("Invalid block size for the shot detection only mode");
+        }
+        this->cfg.enableDCTenergy     = true;
+        this->cfg.enableEntropy       = false;
+        this->cfg.enableEdgeDensity   = false;
+        this->cfg.enableEnergyChroma  = false;
+        this->cfg.enableEntropyChroma = false;
+        log(cfg,
+            LogLevel::Info,
+            "Shot detection only mode. Entropy, edge density and chroma are disabled.");
+        if (this->cfg.nrBlockGrids > 0)
+        {
+            this->cfg.nrBlockGrids = 0;
+            log(cfg,
+                LogLevel::Warning,
+                "Block grids are not supported in shot detection only mode");
+        }
+        if (this->cfg.enableHadamardEnergy)
+        {
+            this->cfg.enableHadamardEnergy = false;
+            log(cfg,
+                LogLevel::Warning,
+                "The Hadamard energy is not used in shot detection only mode");
+        }
+        if (this->cfg.blockSamplingInterval > 1)
+        {
+            this->cfg.blockSamplingInterval = 1;
+            log(cfg,
+                LogLevel::Warning,
+                "Block sampling is not supported in shot detection only mode");
+        }
+    }
+
+    this->applyRequiredOutputs();
+
+    if (this->cfg.blockSamplingInterval > 1)
+    {
+        log(cfg,
+            LogLevel::Info,
+            "Analyzing one of " + std::to_string(this->cfg.blockSamplingInterval)
+                + " blocks per frame ("
+                + (this->cfg.blockSamplingPattern == vca_sampling_pattern::Checkerboard
+                       ? "checkerboard"
+                       : "stratified")
+                + " pattern). The temporal differences are not calculated.");
+        if (this->cfg.nrBlockGrids > 0)
+        {
+            this->cfg.nrBlockGrids = 0;
+            log(cfg, LogLevel::Warning, "Block grids are not supported with block sampling");
+        }
+        if (this->cfg.enableStaticBlockCache)
+        {
+            this->cfg.enableStaticBlockCache = false;
+            log(cfg,
+                LogLevel::Warning,
+                "The static block cache is not supported with block sampling");
+        }
+    }
+
     const auto bitDepth = this->cfg.frameInfo.bitDepth;
     if (bitDepth != 8 && bitDepth != 10 && bitDepth != 12)
     {
@@ -70,11 +360,75 @@ Analyzer::Analyzer(vca_param cfg)
         log(cfg, LogLevel::Info, "Autodetect nr threads " + std::to_string(cfg.nrFrameThreads));
     }
 
+    if (this->cfg.realTimeFrameRate < 0.0)
+    {
+        log(cfg,
+            LogLevel::Error,
+            "Invalid real-time frame rate: " + std::to_string(this->cfg.realTimeFrameRate));
+        throw std::invalid_argument("Invalid real-time frame rate");
+    }
+    if (this->cfg.realTimeFrameRate > 0.0 || this->cfg.realTimeLatencyMs > 0)
+    {
+        if (this->cfg.enableShotDetectionOnly)
+            log(cfg,
+                LogLevel::Warning,
+                "The real-time mode is not supported in shot detection only mode");
+        else
+        {
+            this->qualityController.emplace(this->cfg, cfg.nrFrameThreads);
+            log(cfg,
+                LogLevel::Info,
+                "Real-time mode enabled (frame rate "
+                    + std::to_string(this->cfg.realTimeFrameRate) + ", latency budget "
+                    + std::to_string(this->cfg.realTimeLatencyMs) + " ms)");
+        }
+    }
+
     auto nrThreads = cfg.nrFrameThreads;
+
+    this->jobQueueController  = JobQueueController(this->cfg.jobQueueSize, nrThreads);
+    this->performanceCounters = PerformanceCounters(nrThreads, this->cfg.enableStageTimings);
+    this->jobs.setMaximumQueueSize(this->jobQueueController.getSize());
+    if (this->cfg.jobQueueSize > 0)
+        log(cfg, LogLevel::Info, "Job queue size " + std::to_string(this->cfg.jobQueueSize));
+    if (this->cfg.maxQueuedResultsMemory > 0)
+    {
+        this->results.setMaximumQueueMemory(this->cfg.maxQueuedResultsMemory);
+        log(cfg,
+            LogLevel::Info,
+            "Limiting the memory of queued results to "
+                + std::to_string(this->cfg.maxQueuedResultsMemory) + " bytes");
+    }
+
+    if (this->cfg.enableTracing)
+    {
+        if (this->cfg.traceBufferSize == 0)
+        {
+            log(cfg, LogLevel::Error, "Invalid trace buffer size 0");
+            throw std::invalid_argument("Invalid trace buffer size");
+        }
+        this->tracer.emplace(nrThreads, this->cfg.traceBufferSize);
+        log(cfg, LogLevel::Info, "Tracing enabled");
+    }
+
+    if (this->cfg.logFunction)
+        this->logFlusher.emplace(this->cfg, nrThreads);
+
     log(cfg, LogLevel::Info, "Starting " + std::to_string(nrThreads) + " threads");
     for (unsigned i = 0; i < nrThreads; i++)
     {
-        auto newThread = std::make_unique<ProcessingThread>(this->cfg, this->jobs, this->results, i);
+        auto newThread = std::make_unique<ProcessingThread>(this->cfg,
+                                                            this->jobs,
+                                                            this->results,
+                                                            this->blockCache,
+                                                            this->frameHashes,
+                                                            i,
+                                                            this->tracer
+                                                                ? this->tracer->getThreadBuffer(i)
+                                                                : nullptr,
+                                                            this->logFlusher
+                                                                ? this->logFlusher->getRing(i)
+                                                                : nullptr);
         this->threadPool.push_back(std::move(newThread));
     }
 }
@@ -85,6 +439,8 @@ Analyzer::~Analyzer()
         thread->abort();
     this->jobs.abort();
     this->results.abort();
+    this->blockCache.abort();
+    this->frameHashes.abort();
     for (auto &thread : this->threadPool)
         thread->join();
 }
@@ -94,13 +450,40 @@ vca_result Analyzer::pushFrame(vca_frame *frame)
     if (!this->checkFrame(frame))
         return vca_result::VCA_ERROR;
 
+    if (frame->dirtyRects != nullptr)
+        this->blockCache.keepEntriesForNextFrame();
+
     Job job;
     job.frame = frame;
     job.jobID = this->frameCounter;
+    job.regionOfInterest = this->regionOfInterest;
+    job.decimationFactor = this->cfg.decimationFactor;
+    job.samplingInterval = this->cfg.blockSamplingInterval;
+    job.samplingPattern  = this->cfg.blockSamplingPattern;
+    job.isDiscontinuity  = frame->isDiscontinuity;
+    job.pushTime         = std::chrono::steady_clock::now();
+    if (this->qualityController)
+    {
+        job.qualityTier      = this->qualityController->getTier();
+        job.samplingInterval = getQualityTierConfig(this->cfg, job.qualityTier)
+                                   .blockSamplingInterval;
+    }
     // job.macroblockRange = TODO
 
-    this->jobs.waitAndPush(job);
     this->frameCounter++;
+    this->performanceCounters.addFrame();
+
+    if (this->letterboxDetector)
+    {
+        this->letterboxDetector->addFrame(*frame);
+        this->heldJobs.push_back(job);
+        if (this->letterboxDetector->getNrFrames() >= this->cfg.letterboxDetectionFrames)
+            this->finishLetterboxDetection();
+        return vca_result::VCA_OK;
+    }
+
+    TraceSpan span(this->tracer ? this->tracer->getPushBuffer() : nullptr, "Push", job.jobID);
+    this->jobs.waitAndPush(job);
 
     return vca_result::VCA_OK;
 }
@@ -112,117 +495,250 @@ bool Analyzer::resultAvailable()
 
 vca_result Analyzer::pullResult(vca_frame_results *outputResult)
 {
-    auto result = this->results.waitAndPop();
+    // Less frames than needed for the letterbox detection were pushed. Use what we have.
+    if (!this->heldJobs.empty())
+        this->finishLetterboxDetection();
+
+    const auto waitStartTime = std::chrono::steady_clock::now();
+    auto result              = this->results.waitAndPop();
     if (!result)
         return vca_result::VCA_ERROR;
 
-    if (this->previousResult)
+    auto traceBuffer = this->tracer ? this->tracer->getPullBuffer() : nullptr;
+    if (traceBuffer)
+        traceBuffer->add("Wait for result",
+                         result->jobID,
+                         waitStartTime,
+                         std::chrono::steady_clock::now());
+
+    if (this->jobQueueController.addResult(result->idleTime,
+                                           result->processingTime,
+                                           this->results.size()))
     {
-        if (this->cfg.enableDCTenergy)
+        const auto size = this->jobQueueController.getSize();
+        this->jobs.setMaximumQueueSize(size);
+        log(this->cfg, LogLevel::Debug, [&]() { return "Job queue size " + std::to_string(size); });
+    }
+
+    if (this->qualityController
+        && this->qualityController->addResult(result->qualityTier,
+                                              result->processingTime,
+                                              result->latency))
+        log(this->cfg,
+            LogLevel::Info,
+            "Real-time mode: Switching to quality tier "
+                + std::to_string(this->qualityController->getTier()) + " at job "
+                + std::to_string(result->jobID));
+
+    if (result->isDuplicate && this->previousResult)
+        copyResultsOfPreviousFrame(*result, *this->previousResult);
+
+    // With block sampling, the blocks of consecutive frames differ. The features of
+    // different quality tiers are not comparable.
+    const auto tierCfg = getQualityTierConfig(this->cfg, result->qualityTier);
+    if (this->previousResult && !result->isDiscontinuity && tierCfg.blockSamplingInterval == 1
+        && this->previousResult->qualityTier == result->qualityTier)
+    {
+        StageTimer timer(result->stageTimes, vca_stage::Temporal);
+        TraceSpan span(traceBuffer, "Temporal", result->jobID);
+        this->computeTemporalResults(*result, *this->previousResult, tierCfg);
+        const auto &previousLevels = this->previousResult->ladderResults;
+        for (size_t i = 0; i < result->ladderResults.size() && i < previousLevels.size(); i++)
+            this->computeTemporalResults(result->ladderResults[i], previousLevels[i], tierCfg);
+    }
+
+    {
+        StageTimer timer(result->stageTimes, vca_stage::CopyOut);
+        TraceSpan span(traceBuffer, "Copy out", result->jobID);
+        this->copyResultToOutput(*result,
+                                 outputResult,
+                                 {this->frameInfo->width, this->frameInfo->height});
+        if (outputResult->ladderResults != nullptr)
         {
-            computeTextureSAD(*result, *this->previousResult);
-            if (this->previousResult->energyDiff > 0)
-            {
-                computeTextureEpsilon(*result, *this->previousResult);
-            }
+            for (size_t i = 0; i < result->ladderResults.size(); i++)
+                this->copyResultToOutput(result->ladderResults[i],
+                                         &outputResult->ladderResults[i],
+                                         this->cfg.ladderResolutions[i]);
         }
-        if (this->cfg.enableEntropy)
+    }
+    this->performanceCounters.addResult(*result);
+
+    this->stats.blocksAnalyzed += result->nrAnalyzedBlocks;
+    this->stats.blocksSkipped += result->nrSkippedBlocks;
+    this->stats.blocksReused += result->nrReusedBlocks;
+    for (const auto &levelResult : result->ladderResults)
+    {
+        this->stats.blocksAnalyzed += levelResult.nrAnalyzedBlocks;
+        this->stats.blocksSkipped += levelResult.nrSkippedBlocks;
+    }
+    if (result->isDuplicate)
+        this->stats.duplicateFrames++;
+    else
+        this->stats.framesPerQualityTier[result->qualityTier]++;
+
+    this->previousResult = result;
+
+    return vca_result::VCA_OK;
+}
+
+void Analyzer::computeTemporalResults(Result &result,
+                                      const Result &previousResult,
+                                      const vca_param &tierCfg)
+{
+    if (tierCfg.enableDCTenergy && isOutputRequired(tierCfg, VCA_OUTPUT_ENERGY_DIFF))
+    {
+        computeTextureSAD(result, previousResult);
+        if (previousResult.energyDiff > 0)
         {
-            computeEntropySAD(*result, *this->previousResult);
-            auto entropyDiff     = result->entropyDiff;
-            auto entropyDiffPrev = this->previousResult->entropyDiff;
-            if (this->previousResult->entropyDiff > 0)
-                result->entropyEpsilon = abs(entropyDiffPrev - entropyDiff);
+            computeTextureEpsilon(result, previousResult);
         }
     }
+    if (tierCfg.enableEntropy && isOutputRequired(tierCfg, VCA_OUTPUT_ENTROPY_DIFF))
+    {
+        computeEntropySAD(result, previousResult);
+        auto entropyDiff     = result.entropyDiff;
+        auto entropyDiffPrev = previousResult.entropyDiff;
+        if (previousResult.entropyDiff > 0)
+            result.entropyEpsilon = abs(entropyDiffPrev - entropyDiff);
+    }
+}
+
+void Analyzer::copyResultToOutput(const Result &result,
+                                  vca_frame_results *outputResult,
+                                  vca_resolution frameSize)
+{
+    outputResult->poc               = result.poc;
+    outputResult->jobID             = result.jobID;
+    outputResult->isDuplicate       = result.isDuplicate;
+    outputResult->qualityTier       = result.qualityTier;
+    outputResult->analysisRegion    = result.regionOfInterest;
+    if (result.regionOfInterest.width == 0)
+        outputResult->analysisRegion = {0, 0, frameSize.width, frameSize.height};
 
-    outputResult->poc               = result->poc;
-    outputResult->jobID             = result->jobID;
+    const auto format = this->cfg.blockFormat;
 
     if (this->cfg.enableDCTenergy)
     {
-        outputResult->averageBrightness = result->averageBrightness;
-        outputResult->averageEnergy     = result->averageEnergy;
-        outputResult->energyDiff        = result->energyDiff;
-        outputResult->energyEpsilon     = result->energyEpsilon;
-
-        if (outputResult->brightnessPerBlock)
-            std::memcpy(outputResult->brightnessPerBlock,
-                        result->brightnessPerBlock.data(),
-                        result->brightnessPerBlock.size() * sizeof(uint32_t));
-        if (outputResult->energyPerBlock)
-            std::memcpy(outputResult->energyPerBlock,
-                        result->energyPerBlock.data(),
-                        result->energyPerBlock.size() * sizeof(uint32_t));
-        if (outputResult->energyDiffPerBlock)
-            std::memcpy(outputResult->energyDiffPerBlock,
-                        result->energyDiffPerBlock.data(),
-                        result->energyDiffPerBlock.size() * sizeof(uint32_t));
+        outputResult->averageBrightness       = result.averageBrightness;
+        outputResult->averageEnergy           = result.averageEnergy;
+        outputResult->averageEnergyConfidence = result.averageEnergyConfidence;
+        outputResult->energyDiff              = result.energyDiff;
+        outputResult->energyEpsilon           = result.energyEpsilon;
+
+        copyPerBlockValues(outputResult->brightnessPerBlock, result.brightnessPerBlock, format);
+        copyPerBlockValues(outputResult->energyPerBlock, result.energyPerBlock, format);
+        copyPerBlockValues(outputResult->energyDiffPerBlock, result.energyDiffPerBlock, format);
+        copyPerBlockValues(outputResult->energyEpsilonPerBlock,
+                           result.energyEpsilonPerBlock,
+                           format);
         if (this->cfg.enableEnergyChroma)
         {
-            outputResult->averageU = result->averageU;
-            outputResult->averageV = result->averageV;
-            outputResult->energyU  = result->energyU;
-            outputResult->energyV  = result->energyV;
-            if (outputResult->averageUPerBlock)
-                std::memcpy(outputResult->averageUPerBlock,
-                            result->averageUPerBlock.data(),
-                            result->averageUPerBlock.size() * sizeof(uint32_t));
-            if (outputResult->averageVPerBlock)
-                std::memcpy(outputResult->averageVPerBlock,
-                            result->averageVPerBlock.data(),
-                            result->averageVPerBlock.size() * sizeof(uint32_t));
-            if (outputResult->energyUPerBlock)
-                std::memcpy(outputResult->energyUPerBlock,
-                            result->energyUPerBlock.data(),
-                            result->energyUPerBlock.size() * sizeof(uint32_t));
-            if (outputResult->energyVPerBlock)
-                std::memcpy(outputResult->energyVPerBlock,
-                            result->energyVPerBlock.data(),
-                            result->energyVPerBlock.size() * sizeof(uint32_t));
+            outputResult->averageU = result.averageU;
+            outputResult->averageV = result.averageV;
+            outputResult->energyU  = result.energyU;
+            outputResult->energyV  = result.energyV;
+            copyPerBlockValues(outputResult->averageUPerBlock, result.averageUPerBlock, format);
+            copyPerBlockValues(outputResult->averageVPerBlock, result.averageVPerBlock, format);
+            copyPerBlockValues(outputResult->energyUPerBlock, result.energyUPerBlock, format);
+            copyPerBlockValues(outputResult->energyVPerBlock, result.energyVPerBlock, format);
         }
     }
     if (this->cfg.enableEntropy)
     {
-        outputResult->averageEntropy = result->entropyY;
-        outputResult->entropyDiff     = result->entropyDiff;
-        outputResult->entropyEpsilon = result->entropyEpsilon;
-
-        if (outputResult->entropyPerBlock)
-            std::memcpy(outputResult->entropyPerBlock,
-                        result->entropyPerBlock.data(),
-                        result->entropyPerBlock.size() * sizeof(double));
-        if (outputResult->entropyDiffPerBlock)
-            std::memcpy(outputResult->entropyDiffPerBlock,
-                        result->entropyDiffPerBlock.data(),
-                        result->entropyDiffPerBlock.size() * sizeof(double));
+        outputResult->averageEntropy           = result.entropyY;
+        outputResult->averageEntropyConfidence = result.entropyConfidence;
+        outputResult->entropyDiff              = result.entropyDiff;
+        outputResult->entropyEpsilon           = result.entropyEpsilon;
+
+        copyPerBlockValues(outputResult->entropyPerBlock,
+                           result.entropyPerBlock,
+                           format,
+                           VCA_FIXED16_ENTROPY_SCALE);
+        copyPerBlockValues(outputResult->entropyDiffPerBlock,
+                           result.entropyDiffPerBlock,
+                           format,
+                           VCA_FIXED16_ENTROPY_SCALE);
         if (this->cfg.enableEntropyChroma)
         {
-            outputResult->entropyU = result->entropyU;
-            outputResult->entropyV = result->entropyV;
-            if (outputResult->entropyUPerBlock)
-                std::memcpy(outputResult->entropyUPerBlock,
-                            result->entropyUPerBlock.data(),
-                            result->entropyUPerBlock.size() * sizeof(double));
-            if (outputResult->entropyVPerBlock)
-                std::memcpy(outputResult->entropyVPerBlock,
-                            result->entropyVPerBlock.data(),
-                            result->entropyVPerBlock.size() * sizeof(double));
+            outputResult->entropyU = result.entropyU;
+            outputResult->entropyV = result.entropyV;
+            copyPerBlockValues(outputResult->entropyUPerBlock,
+                               result.entropyUPerBlock,
+                               format,
+                               VCA_FIXED16_ENTROPY_SCALE);
+            copyPerBlockValues(outputResult->entropyVPerBlock,
+                               result.entropyVPerBlock,
+                               format,
+                               VCA_FIXED16_ENTROPY_SCALE);
         }
-
     }
     if (this->cfg.enableEdgeDensity)
     {
-        outputResult->averageEdgeDensity = result->averageEdgeDensity;
-        if (outputResult->edgeDensityPerBlock)
-            std::memcpy(outputResult->edgeDensityPerBlock,
-                        result->edgeDensityPerBlock.data(),
-                        result->edgeDensityPerBlock.size() * sizeof(double));
+        outputResult->averageEdgeDensity           = result.averageEdgeDensity;
+        outputResult->averageEdgeDensityConfidence = result.averageEdgeDensityConfidence;
+        copyPerBlockValues(outputResult->edgeDensityPerBlock,
+                           result.edgeDensityPerBlock,
+                           format,
+                           VCA_FIXED16_EDGE_DENSITY_SCALE);
     }
 
-    this->previousResult = result;
+    for (size_t i = 0; i < result.blockGrids.size(); i++)
+    {
+        const auto &grid     = result.blockGrids[i];
+        auto &outputGrid     = outputResult->blockGrids[i];
+        outputGrid.blockSize = grid.blockSize;
+        if (this->cfg.enableDCTenergy)
+        {
+            outputGrid.averageBrightness = grid.averageBrightness;
+            outputGrid.averageEnergy     = grid.averageEnergy;
+            copyPerBlockValues(outputGrid.brightnessPerBlock, grid.brightnessPerBlock, format);
+            copyPerBlockValues(outputGrid.energyPerBlock, grid.energyPerBlock, format);
+        }
+        if (this->cfg.enableEdgeDensity)
+        {
+            outputGrid.averageEdgeDensity = grid.averageEdgeDensity;
+            copyPerBlockValues(outputGrid.edgeDensityPerBlock,
+                               grid.edgeDensityPerBlock,
+                               format,
+                               VCA_FIXED16_EDGE_DENSITY_SCALE);
+        }
+    }
+}
 
-    return vca_result::VCA_OK;
+void Analyzer::getStats(vca_analyzer_stats *stats)
+{
+    *stats                         = this->stats;
+    stats->jobQueueSize            = this->jobQueueController.getSize();
+    stats->peakQueuedResultsMemory = this->results.getPeakMemory();
+    this->performanceCounters.getStats(stats);
+    if (stats->blocksAnalyzed > 0)
+    {
+        stats->skipRatio  = double(stats->blocksSkipped) / double(stats->blocksAnalyzed);
+        stats->reuseRatio = double(stats->blocksReused) / double(stats->blocksAnalyzed);
+    }
+}
+
+bool Analyzer::writeTrace(const std::string &filename)
+{
+    if (!this->tracer)
+    {
+        log(this->cfg, LogLevel::Error, "Tracing is not enabled");
+        return false;
+    }
+
+    std::ofstream file(filename);
+    if (!file.is_open())
+    {
+        log(this->cfg, LogLevel::Error, "Error opening trace file " + filename);
+        return false;
+    }
+    this->tracer->write(file);
+
+    if (const auto nrDropped = this->tracer->getNrDroppedEvents())
+        log(this->cfg,
+            LogLevel::Warning,
+            std::to_string(nrDropped) + " trace events were dropped because the buffers are full");
+    return file.good();
 }
 
 bool Analyzer::checkFrame(const vca_frame *frame)
@@ -239,6 +755,12 @@ bool Analyzer::checkFrame(const vca_frame *frame)
         return false;
     }
 
+    if (frame->isDiscontinuity && frame->dirtyRects != nullptr)
+    {
+        log(this->cfg, LogLevel::Error, "Dirty rectangles provided for a discontinuous frame");
+        return false;
+    }
+
     const auto &info = frame->info;
 
     if (!this->frameInfo)
@@ -259,6 +781,20 @@ bool Analyzer::checkFrame(const vca_frame *frame)
                     + std::to_string(info.height) + " depth provided");
             return false;
         }
+        for (unsigned i = 0; i < this->cfg.nrLadderResolutions; i++)
+        {
+            const auto resolution = this->cfg.ladderResolutions[i];
+            if (resolution.width > info.width || resolution.height > info.height)
+            {
+                log(this->cfg,
+                    LogLevel::Error,
+                    "Ladder resolution " + std::to_string(resolution.width) + "x"
+                        + std::to_string(resolution.height) + " is larger than the frame");
+                return false;
+            }
+        }
+        if (!this->initRegionOfInterest(info))
+            return false;
         this->frameInfo = info;
     }
 
@@ -274,4 +810,116 @@ bool Analyzer::checkFrame(const vca_frame *frame)
     return true;
 }
 
+// Disable the features that none of the required outputs depends on
+void Analyzer::applyRequiredOutputs()
+{
+    auto &cfg = this->cfg;
+
+    // The shot detection only mode has a fixed set of features
+    if (cfg.enableShotDetectionOnly)
+    {
+        cfg.requiredOutputs = VCA_OUTPUT_ALL;
+        return;
+    }
+
+    if (cfg.requiredOutputs == 0 || (cfg.requiredOutputs & ~VCA_OUTPUT_ALL) != 0)
+    {
+        log(cfg,
+            LogLevel::Error,
+            "Invalid required outputs: " + std::to_string(cfg.requiredOutputs));
+        throw std::invalid_argument("Invalid required outputs");
+    }
+
+    if (cfg.nrBlockGrids > 0)
+        cfg.requiredOutputs |= VCA_OUTPUT_BRIGHTNESS | VCA_OUTPUT_ENERGY | VCA_OUTPUT_EDGE_DENSITY;
+    if (cfg.requiredOutputs == VCA_OUTPUT_ALL)
+        return;
+
+    // The brightness is calculated in the energy pass. The temporal differences are
+    // calculated from the per block values.
+    const auto energyOutputs  = VCA_OUTPUT_BRIGHTNESS | VCA_OUTPUT_ENERGY | VCA_OUTPUT_ENERGY_DIFF
+                               | VCA_OUTPUT_CHROMA_ENERGY;
+    const auto entropyOutputs = VCA_OUTPUT_ENTROPY | VCA_OUTPUT_ENTROPY_DIFF
+                                | VCA_OUTPUT_CHROMA_ENTROPY;
+    cfg.enableDCTenergy     = cfg.enableDCTenergy && isOutputRequired(cfg, energyOutputs);
+    cfg.enableEnergyChroma  = cfg.enableEnergyChroma
+                             && isOutputRequired(cfg, VCA_OUTPUT_CHROMA_ENERGY);
+    cfg.enableEntropy       = cfg.enableEntropy && isOutputRequired(cfg, entropyOutputs);
+    cfg.enableEntropyChroma = cfg.enableEntropyChroma
+                              && isOutputRequired(cfg, VCA_OUTPUT_CHROMA_ENTROPY);
+    cfg.enableEdgeDensity   = cfg.enableEdgeDensity
+                            && isOutputRequired(cfg, VCA_OUTPUT_EDGE_DENSITY);
+
+    log(cfg,
+        LogLevel::Info,
+        "Only calculating the features of the required outputs (DCT energy "
+            + std::string(cfg.enableDCTenergy ? "on" : "off") + ", entropy "
+            + (cfg.enableEntropy ? "on" : "off") + ", edge density "
+            + (cfg.enableEdgeDensity ? "on" : "off") + ")");
+}
+
+bool Analyzer::initRegionOfInterest(const vca_frame_info &info)
+{
+    const vca_rect frameRect = {0, 0, info.width, info.height};
+
+    auto region     = frameRect;
+    const auto &roi = this->cfg.regionOfInterest;
+    if (roi.width > 0 && roi.height > 0)
+    {
+        region = intersectRects(roi, frameRect);
+        if (region.width == 0)
+        {
+            log(this->cfg,
+                LogLevel::Error,
+                "Region of interest " + rectToString(roi) + " is outside of the frame");
+            return false;
+        }
+    }
+
+    // With the letterbox detection, the region is cropped further and aligned at the end of
+    // the detection. The blocks are bigger than blockSize in the input frame if the frame is
+    // decimated.
+    const auto blockSize = this->cfg.blockSize * this->cfg.decimationFactor;
+    if (this->letterboxDetector)
+        this->regionOfInterest = region;
+    else
+        this->regionOfInterest = alignToBlockGrid(region, blockSize, info);
+
+    if (this->regionOfInterest.width > 0 && !this->letterboxDetector)
+        log(this->cfg,
+            LogLevel::Info,
+            "Analyzing region " + rectToString(this->regionOfInterest));
+    return true;
+}
+
+void Analyzer::finishLetterboxDetection()
+{
+    auto region = this->regionOfInterest;
+    if (const auto activeArea = this->letterboxDetector->getActiveArea())
+    {
+        log(this->cfg,
+            LogLevel::Info,
+            "Detected active picture area " + rectToString(*activeArea) + " in "
+                + std::to_string(this->letterboxDetector->getNrFrames()) + " frames");
+        const auto croppedRegion = intersectRects(region, *activeArea);
+        if (croppedRegion.width > 0)
+            region = croppedRegion;
+    }
+    this->letterboxDetector.reset();
+
+    const auto blockSize   = this->cfg.blockSize * this->cfg.decimationFactor;
+    this->regionOfInterest = alignToBlockGrid(region, blockSize, *this->frameInfo);
+    if (this->regionOfInterest.width > 0)
+        log(this->cfg,
+            LogLevel::Info,
+            "Analyzing region " + rectToString(this->regionOfInterest));
+
+    for (auto &job : this->heldJobs)
+    {
+        job.regionOfInterest = this->regionOfInterest;
+        this->jobs.waitAndPush(job);
+    }
+    this->heldJobs.clear();
+}
+
 } // namespace vca
@@ -18,8 +18,15 @@
 
 #pragma once
 
+#include <analyzer/BlockCache.h>
+#include <analyzer/JobQueueControl.h>
+#include <analyzer/LetterboxDetection.h>
+#include <analyzer/Logging.h>
 #include <analyzer/MultiThreadQueue.h>
+#include <analyzer/PerformanceCounters.h>
 #include <analyzer/ProcessingThread.h>
+#include <analyzer/QualityControl.h>
+#include <analyzer/Tracing.h>
 #include <analyzer/common/common.h>
 #include <vcaLib.h>
 
@@ -39,19 +46,52 @@ public:
     vca_result pushFrame(vca_frame *frame);
     bool resultAvailable();
     vca_result pullResult(vca_frame_results *result);
+    void getStats(vca_analyzer_stats *stats);
+    bool writeTrace(const std::string &filename);
 
 private:
     vca_param cfg{};
     bool checkFrame(const vca_frame *frame);
+    bool initRegionOfInterest(const vca_frame_info &info);
+    void applyRequiredOutputs();
+    void finishLetterboxDetection();
+    void computeTemporalResults(Result &result,
+                                const Result &previousResult,
+                                const vca_param &tierCfg);
+    void copyResultToOutput(const Result &result,
+                            vca_frame_results *outputResult,
+                            vca_resolution frameSize);
     std::optional<vca_frame_info> frameInfo;
+
+    // The analyzed region aligned to the block grid. Empty if the whole frame is analyzed.
+    vca_rect regionOfInterest{};
+
+    // While the letterbox detection is running, the region to analyze is not known yet and
+    // the jobs are held back.
+    std::optional<LetterboxDetector> letterboxDetector;
+    std::vector<Job> heldJobs;
     unsigned frameCounter{0};
 
     std::vector<std::unique_ptr<ProcessingThread>> threadPool;
 
     MultiThreadQueue<Job> jobs;
     MultiThreadQueue<Result> results;
+    JobQueueController jobQueueController{0, 1};
+    BlockCache blockCache;
+    FrameHashHistory frameHashes;
 
     std::optional<Result> previousResult;
+
+    // Selects the quality tier of the pushed frames in the real-time mode
+    std::optional<QualityController> qualityController;
+
+    PerformanceCounters performanceCounters{0, false};
+    std::optional<Tracer> tracer;
+
+    // Passes the log messages of the processing threads to the log function
+    std::optional<LogFlusher> logFlusher;
+
+    vca_analyzer_stats stats{};
 };
 
 } // namespace vca
@@ -0,0 +1,277 @@
+/* Copyright (C) 2024 Christian Doppler Laboratory ATHENA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.
+ *****************************************************************************/
+
+#include "BlockCache.h"
+
+#include <analyzer/FrameHash.h>
+
+#include <algorithm>
+
+namespace vca {
+
+namespace {
+
+uint64_t calculateBlockHash(const uint8_t *src,
+                            unsigned srcStrideBytes,
+                            unsigned nrBytesPerLine,
+                            unsigned nrLines,
+                            CpuSimd cpuSimd)
+{
+    uint64_t hash = 0;
+    for (unsigned y = 0; y < nrLines; y++, src += srcStrideBytes)
+        hash = combineHash(hash, hashLine(src, nrBytesPerLine, cpuSimd));
+    return hash;
+}
+
+// The block grid and the padding match the loops in computeWeightedDCTEnergy and
+// computeEntropy.
+void calculatePlaneBlockHashes(std::vector<uint64_t> &hashes,
+                               const uint8_t *src,
+                               unsigned srcStrideBytes,
+                               unsigned width,
+                               unsigned height,
+                               unsigned blockSize,
+                               unsigned bitDepth,
+                               CpuSimd cpuSimd)
+{
+    const auto bytesPerPixel = (bitDepth > 8) ? 2u : 1u;
+
+    auto [widthInBlocks, heightInBlock] = getChromaFrameSizeInBlocks(blockSize,
+                                                                     int(width),
+                                                                     int(height));
+    hashes.resize(widthInBlocks * heightInBlock);
+
+    auto blockIndex = 0u;
+    for (unsigned blockY = 0; blockY < heightInBlock * blockSize; blockY += blockSize)
+    {
+        const auto paddingBottom = unsigned(std::max(int(blockY + blockSize) - int(height), 0));
+        for (unsigned blockX = 0; blockX < widthInBlocks * blockSize; blockX += blockSize)
+        {
+            const auto paddingRight = unsigned(std::max(int(blockX + blockSize) - int(width), 0));
+
+            const auto nrBytesPerLine = (blockSize - paddingRight) * bytesPerPixel;
+            hashes[blockIndex++] = calculateBlockHash(src + blockX * bytesPerPixel
+                                                          + blockY * srcStrideBytes,
+                                                      srcStrideBytes,
+                                                      nrBytesPerLine,
+                                                      blockSize - paddingBottom,
+                                                      cpuSimd);
+        }
+    }
+}
+
+} // namespace
+
+FrameBlockHashes calculateFrameBlockHashes(const vca_frame *frame,
+                                           unsigned blockSize,
+                                           bool enableChroma,
+                                           CpuSimd cpuSimd)
+{
+    const auto bitDepth      = frame->info.bitDepth;
+    const auto bytesPerPixel = (bitDepth > 8) ? 2u : 1u;
+
+    FrameBlockHashes hashes;
+    calculatePlaneBlockHashes(hashes.planes[0],
+                              frame->planes[0],
+                              unsigned(frame->stride[0]),
+                              frame->info.width,
+                              frame->info.height,
+                              blockSize,
+                              bitDepth,
+                              cpuSimd);
+
+    if (enableChroma)
+    {
+        const auto strideC = unsigned(frame->stride[1]);
+        const auto heightC = unsigned(frame->height[1]);
+        for (unsigned plane = 1; plane < 3; plane++)
+            calculatePlaneBlockHashes(hashes.planes[plane],
+                                      frame->planes[plane],
+                                      strideC,
+                                      strideC / bytesPerPixel,
+                                      heightC,
+                                      blockSize,
+                                      bitDepth,
+                                      cpuSimd);
+    }
+
+    return hashes;
+}
+
+StaticBlocks::StaticBlocks(const FrameBlockHashes &hashes,
+                           std::shared_ptr<const BlockCacheEntry> reference)
+    : reference(std::move(reference))
+{
+    for (unsigned plane = 0; plane < 3; plane++)
+    {
+        const auto &current         = hashes.planes[plane];
+        const auto &referenceHashes = this->reference->hashes.planes[plane];
+        if (current.size() != referenceHashes.size())
+            continue;
+
+        this->staticBlocks[plane].resize(current.size());
+        for (size_t i = 0; i < current.size(); i++)
+            this->staticBlocks[plane][i] = (current[i] == referenceHashes[i]);
+    }
+}
+
+StaticBlocks::StaticBlocks(const vca_frame &frame,
+                           unsigned blockSize,
+                           bool enableChroma,
+                           std::shared_ptr<const BlockCacheEntry> reference)
+    : reference(std::move(reference))
+{
+    const auto &info         = frame.info;
+    const auto bytesPerPixel = (info.bitDepth > 8) ? 2u : 1u;
+
+    const auto hasChroma = enableChroma && info.colorspace != vca_colorSpace::YUV400;
+    const auto nrPlanes  = hasChroma ? 3u : 1u;
+    const auto [subsamplingX, subsamplingY] = getChromaSubsampling(info.colorspace);
+
+    for (unsigned plane = 0; plane < nrPlanes; plane++)
+    {
+        const auto isLuma = (plane == 0);
+        const auto scaleX = isLuma ? 1u : subsamplingX;
+        const auto scaleY = isLuma ? 1u : subsamplingY;
+
+        // Same block grid as in the analysis functions
+        const auto [widthInBlocks, heightInBlocks] = isLuma
+                                                         ? getFrameSizeInBlocks(blockSize, info)
+                                                         : getChromaFrameSizeInBlocks(
+                                                             blockSize,
+                                                             frame.stride[1] / bytesPerPixel,
+                                                             frame.height[1]);
+        auto &blocks = this->staticBlocks[plane];
+        blocks.assign(widthInBlocks * heightInBlocks, true);
+
+        for (unsigned i = 0; i < frame.nrDirtyRects; i++)
+        {
+            const auto &rect = frame.dirtyRects[i];
+            if (rect.width == 0 || rect.height == 0 || rect.x >= info.width
+                || rect.y >= info.height)
+                continue;
+            const auto rectRight  = std::min(rect.x + rect.width, info.width);
+            const auto rectBottom = std::min(rect.y + rect.height, info.height);
+
+            const auto firstBlockX = (rect.x / scaleX) / blockSize;
+            const auto firstBlockY = (rect.y / scaleY) / blockSize;
+            const auto lastBlockX  = std::min(((rectRight + scaleX - 1) / scaleX - 1) / blockSize,
+                                             widthInBlocks - 1);
+            const auto lastBlockY  = std::min(((rectBottom + scaleY - 1) / scaleY - 1) / blockSize,
+                                             heightInBlocks - 1);
+            for (auto blockY = firstBlockY; blockY <= lastBlockY; blockY++)
+                for (auto blockX = firstBlockX; blockX <= lastBlockX; blockX++)
+                    blocks[blockY * widthInBlocks + blockX] = false;
+        }
+    }
+}
+
+bool StaticBlocks::isStatic(unsigned plane, unsigned blockIndex) const
+{
+    const auto &blocks = this->staticBlocks[plane];
+    return blockIndex < blocks.size() && blocks[blockIndex];
+}
+
+std::shared_ptr<const BlockCacheEntry> BlockCache::getReference()
+{
+    std::unique_lock<std::mutex> lock(this->accessMutex);
+    return this->latestEntry;
+}
+
+void BlockCache::keepEntriesForNextFrame()
+{
+    std::unique_lock<std::mutex> lock(this->accessMutex);
+    this->keepEntries = true;
+}
+
+std::shared_ptr<const BlockCacheEntry> BlockCache::waitAndTakeEntry(unsigned jobID)
+{
+    std::unique_lock<std::mutex> lock(this->accessMutex);
+    this->entryAddedCV.wait(lock, [this, jobID]() {
+        return this->aborted || this->entries.count(jobID) > 0
+               || this->notKeptEntries.count(jobID) > 0;
+    });
+    if (this->aborted || this->notKeptEntries.erase(jobID) > 0)
+        return {};
+
+    auto entry = std::move(this->entries[jobID]);
+    this->entries.erase(jobID);
+    return entry;
+}
+
+void BlockCache::releaseEntry(unsigned jobID)
+{
+    std::unique_lock<std::mutex> lock(this->accessMutex);
+    if (this->entries.erase(jobID) == 0 && this->notKeptEntries.erase(jobID) == 0)
+        this->releasedEntries.insert(jobID);
+}
+
+void BlockCache::addEntry(unsigned jobID,
+                          FrameBlockHashes &&hashes,
+                          const Result &result,
+                          bool isReference)
+{
+    bool keepEntry;
+    {
+        std::unique_lock<std::mutex> lock(this->accessMutex);
+        keepEntry = this->keepEntries && this->releasedEntries.count(jobID) == 0;
+    }
+
+    // Copying the results is only needed if the frame is used as a reference
+    std::shared_ptr<BlockCacheEntry> entry;
+    if (keepEntry || isReference)
+    {
+        entry         = std::make_shared<BlockCacheEntry>();
+        entry->jobID  = jobID;
+        entry->hashes = std::move(hashes);
+        entry->result = result;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(this->accessMutex);
+        if (isReference && (!this->latestEntry || this->latestEntry->jobID < jobID))
+            this->latestEntry = entry;
+        if (this->releasedEntries.erase(jobID) == 0)
+        {
+            if (keepEntry)
+                this->entries[jobID] = std::move(entry);
+            else
+                this->notKeptEntries.insert(jobID);
+        }
+    }
+    this->entryAddedCV.notify_all();
+}
+
+void BlockCache::addEntryWithoutResult(unsigned jobID)
+{
+    {
+        std::unique_lock<std::mutex> lock(this->accessMutex);
+        if (this->releasedEntries.erase(jobID) == 0)
+            this->notKeptEntries.insert(jobID);
+    }
+    this->entryAddedCV.notify_all();
+}
+
+void BlockCache::abort()
+{
+    {
+        std::unique_lock<std::mutex> lock(this->accessMutex);
+        this->aborted = true;
+    }
+    this->entryAddedCV.notify_all();
+}
+
+} // namespace vca
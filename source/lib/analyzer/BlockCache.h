@@ -0,0 +1,116 @@
+/* Copyright (C) 2024 Christian Doppler Laboratory ATHENA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.
+ *****************************************************************************/
+
+#pragma once
+
+#include <analyzer/common/common.h>
+
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <vector>
+
+namespace vca {
+
+// 64 bit hashes of the samples of all blocks in the luma and chroma planes of a frame.
+// The hashed region of a block contains all samples that are read when the block is copied
+// to the analysis buffer, so two blocks with the same hash give the same analysis results.
+struct FrameBlockHashes
+{
+    std::vector<uint64_t> planes[3];
+};
+
+FrameBlockHashes calculateFrameBlockHashes(const vca_frame *frame,
+                                           unsigned blockSize,
+                                           bool enableChroma,
+                                           CpuSimd cpuSimd);
+
+struct BlockCacheEntry
+{
+    unsigned jobID{};
+    FrameBlockHashes hashes;
+    Result result;
+};
+
+// The blocks of a frame for which the per block results can be copied from a reference
+// frame. These are either the blocks that are identical to the block at the same position
+// in the reference (same hash) or the blocks that do not intersect any of the dirty
+// rectangles of the frame (the reference is then the previous frame).
+class StaticBlocks
+{
+public:
+    StaticBlocks(const FrameBlockHashes &hashes, std::shared_ptr<const BlockCacheEntry> reference);
+    StaticBlocks(const vca_frame &frame,
+                 unsigned blockSize,
+                 bool enableChroma,
+                 std::shared_ptr<const BlockCacheEntry> reference);
+
+    bool isStatic(unsigned plane, unsigned blockIndex) const;
+    const Result &referenceResult() const { return this->reference->result; }
+
+private:
+    std::vector<bool> staticBlocks[3];
+    std::shared_ptr<const BlockCacheEntry> reference;
+};
+
+// Holds the hashes and results of analyzed frames for the reuse of per block results.
+// The frames are processed by several threads, so the frames may finish in any order.
+class BlockCache
+{
+public:
+    // The most recent frame that finished processing. This is not necessarily the previous
+    // frame. Since the results of a block only depend on its samples, any analyzed frame can
+    // be used as the reference for the hash based reuse.
+    std::shared_ptr<const BlockCacheEntry> getReference();
+
+    // From now on keep the entry of every frame until the next frame takes or releases it.
+    // This is enabled once the first frame with dirty rectangles is pushed, so that there is
+    // no overhead if dirty rectangles are not used.
+    void keepEntriesForNextFrame();
+
+    // Every job must either take or release the entry of the previous job. Taking waits until
+    // the previous job was added. Returns nullptr if the entry was not kept or if aborted.
+    std::shared_ptr<const BlockCacheEntry> waitAndTakeEntry(unsigned jobID);
+    void releaseEntry(unsigned jobID);
+
+    // Add a frame that finished processing. If isReference is set, the frame is used as the
+    // reference for the hash based reuse.
+    void addEntry(unsigned jobID,
+                  FrameBlockHashes &&hashes,
+                  const Result &result,
+                  bool isReference);
+    // Add a frame that was not analyzed (e.g. a duplicate frame). It is not kept.
+    void addEntryWithoutResult(unsigned jobID);
+
+    void abort();
+
+private:
+    std::mutex accessMutex;
+    std::condition_variable entryAddedCV;
+
+    std::shared_ptr<const BlockCacheEntry> latestEntry;
+
+    bool keepEntries{};
+    std::map<unsigned, std::shared_ptr<const BlockCacheEntry>> entries;
+    std::set<unsigned> notKeptEntries;
+    std::set<unsigned> releasedEntries;
+
+    bool aborted{};
+};
+
+} // namespace vca
@@ -0,0 +1,90 @@
+/* Copyright (C) 2024 Christian Doppler Laboratory ATHENA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.
+ *****************************************************************************/
+
+#include "BlockSampling.h"
+
+#include <cmath>
+
+namespace vca {
+
+namespace {
+
+// The 97.5% quantile of the normal distribution
+const auto confidenceQuantile = 1.96;
+
+// A well mixed hash (splitmix64 finalizer) of the stratum and the frame
+uint32_t hashStratum(unsigned stratum, unsigned frameIndex)
+{
+    auto x = (uint64_t(stratum) << 32) | frameIndex;
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ull;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebull;
+    x ^= x >> 31;
+    return uint32_t(x);
+}
+
+} // namespace
+
+BlockSampler::BlockSampler(const Job &job, const BlockRegion &region)
+    : region(region), pattern(job.samplingPattern), frameIndex(job.jobID)
+{
+    // The checkerboard has at least one block per row if the region is at least one interval
+    // wide
+    const auto interval     = job.samplingInterval;
+    const auto isWideEnough = this->pattern == vca_sampling_pattern::Stratified
+                              || region.right - region.left >= interval;
+    if (isWideEnough && region.getNrBlocks() >= 2 * interval)
+        this->interval = interval;
+}
+
+bool BlockSampler::isSampled(unsigned blockX, unsigned blockY) const
+{
+    if (this->interval <= 1)
+        return true;
+
+    const auto x = blockX - this->region.left;
+    const auto y = blockY - this->region.top;
+
+    // Diagonal lines of blocks. Consecutive rows are shifted by half an interval, which is a
+    // checkerboard for an interval of 2. Each frame shifts the pattern by one block.
+    if (this->pattern == vca_sampling_pattern::Checkerboard)
+    {
+        const auto rowShift = std::max(this->interval / 2, 1u);
+        return (x + y * rowShift + this->frameIndex) % this->interval == 0;
+    }
+
+    // One random block out of each run of interval blocks in raster order. A run that is cut
+    // off at the end of the region can have no analyzed block, which keeps the probability
+    // to be analyzed the same for all blocks.
+    const auto index   = y * (this->region.right - this->region.left) + x;
+    const auto stratum = index / this->interval;
+    return hashStratum(stratum, this->frameIndex) % this->interval == index % this->interval;
+}
+
+double SampleStatistics::getConfidence(unsigned nrBlocks) const
+{
+    if (this->count >= nrBlocks || this->count < 2)
+        return 0.0;
+
+    const auto n        = double(this->count);
+    const auto mean     = this->sum / n;
+    const auto variance = std::max(this->sumOfSquares / n - mean * mean, 0.0) * n / (n - 1);
+    const auto finitePopulationCorrection = 1.0 - n / double(nrBlocks);
+    return confidenceQuantile * std::sqrt(variance / n * finitePopulationCorrection);
+}
+
+} // namespace vca
@@ -0,0 +1,69 @@
+/* Copyright (C) 2024 Christian Doppler Laboratory ATHENA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.
+ *****************************************************************************/
+
+#pragma once
+
+#include <analyzer/common/common.h>
+#include <vcaLib.h>
+
+namespace vca {
+
+// Selects the blocks of a region that are analyzed in the block sampling mode (see
+// vca_param::blockSamplingInterval). The selection changes from frame to frame. In regions
+// with less than two intervals of blocks (or narrower than one interval for the checkerboard)
+// all blocks are selected, so that there are always at least two analyzed blocks.
+class BlockSampler
+{
+public:
+    BlockSampler(const Job &job, const BlockRegion &region);
+
+    // blockX and blockY are the position of the block in blocks (not in samples)
+    bool isSampled(unsigned blockX, unsigned blockY) const;
+    bool isEnabled() const { return this->interval > 1; }
+
+private:
+    BlockRegion region;
+    unsigned interval{1};
+    vca_sampling_pattern pattern{};
+    unsigned frameIndex{};
+};
+
+// The mean of the per block values of the analyzed blocks and its confidence interval as an
+// estimate of the mean over all blocks of the region
+class SampleStatistics
+{
+public:
+    void add(double value)
+    {
+        this->sum += value;
+        this->sumOfSquares += value * value;
+        this->count++;
+    }
+
+    unsigned getCount() const { return this->count; }
+
+    // The half width of the 95% confidence interval of the mean over nrBlocks blocks. The
+    // analyzed blocks are treated as a simple random sample (with the finite population
+    // correction). 0 if all blocks were analyzed.
+    double getConfidence(unsigned nrBlocks) const;
+
+private:
+    double sum{};
+    double sumOfSquares{};
+    unsigned count{};
+};
+
+} // namespace vca
@@ -0,0 +1,94 @@
+/* Copyright (C) 2024 Christian Doppler Laboratory ATHENA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.
+ *****************************************************************************/
+
+#include "BlockStatistics.h"
+
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define VCA_BLOCK_STATISTICS_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace vca {
+
+namespace {
+
+BlockStatistics calculateBlockStatistics_c(const int16_t *pixelBuffer, unsigned nrSamples)
+{
+    BlockStatistics statistics;
+    statistics.min = pixelBuffer[0];
+    statistics.max = pixelBuffer[0];
+    for (unsigned i = 0; i < nrSamples; i++)
+    {
+        statistics.min = std::min(statistics.min, pixelBuffer[i]);
+        statistics.max = std::max(statistics.max, pixelBuffer[i]);
+        statistics.sum += pixelBuffer[i];
+    }
+    return statistics;
+}
+
+#if VCA_BLOCK_STATISTICS_SSE2
+
+BlockStatistics calculateBlockStatistics_sse2(const int16_t *pixelBuffer, unsigned nrSamples)
+{
+    const auto ones = _mm_set1_epi16(1);
+
+    auto values = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pixelBuffer));
+    auto minVec = values;
+    auto maxVec = values;
+    auto sumVec = _mm_madd_epi16(values, ones);
+    for (unsigned i = 8; i < nrSamples; i += 8)
+    {
+        values = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pixelBuffer + i));
+        minVec = _mm_min_epi16(minVec, values);
+        maxVec = _mm_max_epi16(maxVec, values);
+        sumVec = _mm_add_epi32(sumVec, _mm_madd_epi16(values, ones));
+    }
+
+    // Horizontal reduction
+    minVec = _mm_min_epi16(minVec, _mm_shuffle_epi32(minVec, _MM_SHUFFLE(1, 0, 3, 2)));
+    minVec = _mm_min_epi16(minVec, _mm_shuffle_epi32(minVec, _MM_SHUFFLE(2, 3, 0, 1)));
+    minVec = _mm_min_epi16(minVec, _mm_shufflelo_epi16(minVec, _MM_SHUFFLE(2, 3, 0, 1)));
+    maxVec = _mm_max_epi16(maxVec, _mm_shuffle_epi32(maxVec, _MM_SHUFFLE(1, 0, 3, 2)));
+    maxVec = _mm_max_epi16(maxVec, _mm_shuffle_epi32(maxVec, _MM_SHUFFLE(2, 3, 0, 1)));
+    maxVec = _mm_max_epi16(maxVec, _mm_shufflelo_epi16(maxVec, _MM_SHUFFLE(2, 3, 0, 1)));
+    sumVec = _mm_add_epi32(sumVec, _mm_shuffle_epi32(sumVec, _MM_SHUFFLE(1, 0, 3, 2)));
+    sumVec = _mm_add_epi32(sumVec, _mm_shuffle_epi32(sumVec, _MM_SHUFFLE(2, 3, 0, 1)));
+
+    BlockStatistics statistics;
+    statistics.min = int16_t(_mm_extract_epi16(minVec, 0));
+    statistics.max = int16_t(_mm_extract_epi16(maxVec, 0));
+    statistics.sum = _mm_cvtsi128_si32(sumVec);
+    return statistics;
+}
+
+#endif
+
+} // namespace
+
+BlockStatistics calculateBlockStatistics(const int16_t *pixelBuffer,
+                                         unsigned nrSamples,
+                                         CpuSimd cpuSimd)
+{
+#if VCA_BLOCK_STATISTICS_SSE2
+    if (cpuSimd != CpuSimd::None)
+        return calculateBlockStatistics_sse2(pixelBuffer, nrSamples);
+#endif
+    return calculateBlockStatistics_c(pixelBuffer, nrSamples);
+}
+
+} // namespace vca
@@ -0,0 +1,39 @@
+/* Copyright (C) 2024 Christian Doppler Laboratory ATHENA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.
+ *****************************************************************************/
+
+#pragma once
+
+#include <vcaLib.h>
+
+#include <stdint.h>
+
+namespace vca {
+
+struct BlockStatistics
+{
+    int16_t min{};
+    int16_t max{};
+    int32_t sum{};
+
+    unsigned range() const { return unsigned(this->max - this->min); }
+};
+
+// Calculate min, max and sum of the samples in the buffer. nrSamples must be a multiple of 8.
+BlockStatistics calculateBlockStatistics(const int16_t *pixelBuffer,
+                                         unsigned nrSamples,
+                                         CpuSimd cpuSimd);
+
+} // namespace vca
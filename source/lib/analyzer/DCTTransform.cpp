@@ -124,26 +124,16 @@ void performDCTBlockSize8(const unsigned bitDepth,
         vca::dct8_c(pixelBuffer, coeffBuffer, 8, bitDepth);
 }
 
-void performLowpassDCTBlockSize16(const unsigned bitDepth,
-                                  const int16_t *src,
-                                  int16_t *dst,
-                                  CpuSimd cpuSimd)
+// Transform the 8x8 block of 2x2 averages of a 16x16 block. The coefficients are placed
+// in the top left corner of the 16x16 coefficient buffer and the DC is calculated from
+// the sum of the 16x16 samples.
+void transformLowpassBlockSize16(const unsigned bitDepth,
+                                 const int16_t *avgBlock,
+                                 int32_t totalSum,
+                                 int16_t *dst,
+                                 CpuSimd cpuSimd)
 {
     ALIGN_VAR_32(int16_t, coef[8 * 8]);
-    ALIGN_VAR_32(int16_t, avgBlock[8 * 8]);
-    int32_t totalSum = 0;
-    int16_t sum      = 0;
-    for (int i = 0; i < 8; i++)
-    {
-        for (int j = 0; j < 8; j++)
-        {
-            sum = src[2 * i * 16 + 2 * j] + src[2 * i * 16 + 2 * j + 1]
-                  + src[(2 * i + 1) * 16 + 2 * j] + src[(2 * i + 1) * 16 + 2 * j + 1];
-            avgBlock[i * 8 + j] = sum >> 2;
-            totalSum += sum;
-        }
-    }
-
     if (cpuSimd == CpuSimd::AVX2)
     {
         if (bitDepth == 8)
@@ -182,24 +172,14 @@ void performLowpassDCTBlockSize16(const unsigned bitDepth,
     dst[0] = static_cast<int16_t>(totalSum >> 1);
 }
 
-void performLowpassDCTBlockSize32(const unsigned bitDepth,
-                                  const int16_t *src,
-                                  int16_t *dst,
-                                  CpuSimd cpuSimd)
+// Same as transformLowpassBlockSize16 for the 16x16 averages of a 32x32 block
+void transformLowpassBlockSize32(const unsigned bitDepth,
+                                 const int16_t *avgBlock,
+                                 int32_t totalSum,
+                                 int16_t *dst,
+                                 CpuSimd cpuSimd)
 {
     ALIGN_VAR_32(int16_t, coef[16 * 16]);
-    ALIGN_VAR_32(int16_t, avgBlock[16 * 16]);
-    int32_t totalSum = 0;
-    int16_t sum      = 0;
-    for (int i = 0; i < 16; i++)
-        for (int j = 0; j < 16; j++)
-        {
-            sum = src[2 * i * 32 + 2 * j] + src[2 * i * 32 + 2 * j + 1]
-                  + src[(2 * i + 1) * 32 + 2 * j] + src[(2 * i + 1) * 32 + 2 * j + 1];
-            avgBlock[i * 16 + j] = sum >> 2;
-            totalSum += sum;
-        }
-
     if (cpuSimd == CpuSimd::AVX2)
     {
         if (bitDepth == 8)
@@ -228,6 +208,46 @@ void performLowpassDCTBlockSize32(const unsigned bitDepth,
     dst[0] = static_cast<int16_t>(totalSum >> 3);
 }
 
+void performLowpassDCTBlockSize16(const unsigned bitDepth,
+                                  const int16_t *src,
+                                  int16_t *dst,
+                                  CpuSimd cpuSimd)
+{
+    ALIGN_VAR_32(int16_t, avgBlock[8 * 8]);
+    int32_t totalSum = 0;
+    int16_t sum      = 0;
+    for (int i = 0; i < 8; i++)
+    {
+        for (int j = 0; j < 8; j++)
+        {
+            sum = src[2 * i * 16 + 2 * j] + src[2 * i * 16 + 2 * j + 1]
+                  + src[(2 * i + 1) * 16 + 2 * j] + src[(2 * i + 1) * 16 + 2 * j + 1];
+            avgBlock[i * 8 + j] = sum >> 2;
+            totalSum += sum;
+        }
+    }
+    transformLowpassBlockSize16(bitDepth, avgBlock, totalSum, dst, cpuSimd);
+}
+
+void performLowpassDCTBlockSize32(const unsigned bitDepth,
+                                  const int16_t *src,
+                                  int16_t *dst,
+                                  CpuSimd cpuSimd)
+{
+    ALIGN_VAR_32(int16_t, avgBlock[16 * 16]);
+    int32_t totalSum = 0;
+    int16_t sum      = 0;
+    for (int i = 0; i < 16; i++)
+        for (int j = 0; j < 16; j++)
+        {
+            sum = src[2 * i * 32 + 2 * j] + src[2 * i * 32 + 2 * j + 1]
+                  + src[(2 * i + 1) * 32 + 2 * j] + src[(2 * i + 1) * 32 + 2 * j + 1];
+            avgBlock[i * 16 + j] = sum >> 2;
+            totalSum += sum;
+        }
+    transformLowpassBlockSize32(bitDepth, avgBlock, totalSum, dst, cpuSimd);
+}
+
 void performDCT(const unsigned blockSize,
                 const unsigned bitDepth,
                 int16_t *pixelBuffer,
@@ -260,4 +280,49 @@ void performDCT(const unsigned blockSize,
     }
 }
 
+void performLowpassDCT(const unsigned blockSize,
+                       const unsigned bitDepth,
+                       const int16_t *halfResolutionBlock,
+                       unsigned halfResolutionStride,
+                       int32_t sum,
+                       int16_t *coeffBuffer,
+                       CpuSimd cpuSimd)
+{
+    if (bitDepth != 8 && bitDepth != 10 && bitDepth != 12)
+        throw std::invalid_argument("Invalid bit depth " + std::to_string(bitDepth));
+    if (blockSize != 16 && blockSize != 32)
+        throw std::invalid_argument("Invalid block size " + std::to_string(blockSize));
+
+    // The SIMD kernels need an aligned and contiguous block
+    ALIGN_VAR_32(int16_t, avgBlock[16 * 16]);
+    const auto halfBlockSize = blockSize / 2;
+    for (unsigned i = 0; i < halfBlockSize; i++)
+        std::memcpy(&avgBlock[i * halfBlockSize],
+                    halfResolutionBlock + i * halfResolutionStride,
+                    halfBlockSize * sizeof(int16_t));
+
+    if (blockSize == 16)
+        transformLowpassBlockSize16(bitDepth, avgBlock, sum, coeffBuffer, cpuSimd);
+    else
+        transformLowpassBlockSize32(bitDepth, avgBlock, sum, coeffBuffer, cpuSimd);
+}
+
+int16_t calculateFlatBlockDC(const unsigned blockSize,
+                             const unsigned bitDepth,
+                             int32_t sum,
+                             bool enableLowpassDCT)
+{
+    // The lowpass kernels calculate the DC directly from the sum of the samples
+    if (enableLowpassDCT && blockSize == 16)
+        return static_cast<int16_t>(sum >> 1);
+    if (enableLowpassDCT && blockSize == 32)
+        return static_cast<int16_t>(sum >> 3);
+
+    // For all transform sizes the DC of a flat block is value * 2^(15 - bitDepth)
+    unsigned log2NrSamples = 0;
+    while ((1u << log2NrSamples) < blockSize * blockSize)
+        log2NrSamples++;
+    return static_cast<int16_t>((int64_t(sum) << (15 - bitDepth)) >> log2NrSamples);
+}
+
 } // namespace vca
@@ -36,4 +36,23 @@ void performDCT(const unsigned blockSize,
                 CpuSimd cpuSimd,
                 bool enableLowpassDCT);
 
+// The lowpass DCT of a 16x16 or 32x32 block (like performDCT with enableLowpassDCT) from
+// the block in a plane that was downsampled by 2 (see HalfResolutionFrame). sum is the sum
+// over all samples of the full resolution block.
+void performLowpassDCT(const unsigned blockSize,
+                       const unsigned bitDepth,
+                       const int16_t *halfResolutionBlock,
+                       unsigned halfResolutionStride,
+                       int32_t sum,
+                       int16_t *coeffBuffer,
+                       CpuSimd cpuSimd);
+
+// The DC coefficient that performDCT returns for a block of which all samples have the
+// same value. sum is the sum over all samples of the block. All AC coefficients of such
+// a block are 0.
+int16_t calculateFlatBlockDC(const unsigned blockSize,
+                             const unsigned bitDepth,
+                             int32_t sum,
+                             bool enableLowpassDCT);
+
 } // namespace vca
@@ -0,0 +1,442 @@
+/* Copyright (C) 2024 Christian Doppler Laboratory ATHENA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.
+ *****************************************************************************/
+
+#include "Decimation.h"
+
+#include <analyzer/common/common.h>
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define VCA_DECIMATION_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace vca {
+
+namespace {
+
+constexpr unsigned MAX_FACTOR = 4;
+
+unsigned log2Factor(unsigned factor)
+{
+    return factor == 4 ? 2 : 1;
+}
+
+// Decimate the output samples [startX, outputWidth) of one output line
+template<typename T>
+void decimateLine_c(const T *const *lines,
+                    unsigned width,
+                    unsigned factor,
+                    unsigned startX,
+                    unsigned outputWidth,
+                    T *dst)
+{
+    const auto shift    = 2 * log2Factor(factor);
+    const auto rounding = (1u << shift) >> 1;
+    for (auto x = startX; x < outputWidth; x++)
+    {
+        unsigned sum = 0;
+        for (unsigned i = 0; i < factor; i++)
+            for (unsigned j = 0; j < factor; j++)
+                sum += lines[i][std::min(x * factor + j, width - 1)];
+        dst[x] = T((sum + rounding) >> shift);
+    }
+}
+
+// Downsample the output samples [startX, outputWidth) of one output line
+template<typename T>
+void downsampleLine2x2_c(const T *const *lines,
+                         unsigned width,
+                         unsigned startX,
+                         unsigned outputWidth,
+                         int16_t *dst)
+{
+    for (auto x = startX; x < outputWidth; x++)
+    {
+        const auto x0  = std::min(2 * x, width - 1);
+        const auto x1  = std::min(2 * x + 1, width - 1);
+        const auto sum = lines[0][x0] + lines[0][x1] + lines[1][x0] + lines[1][x1];
+        dst[x]         = int16_t(sum >> 2);
+    }
+}
+
+#if VCA_DECIMATION_SSE2
+
+// Returns the number of output samples that were written. The rest is done by the native
+// implementation. The vertical sums of up to 4 lines fit into 16 bit for all bit depths.
+unsigned decimateLine8bit_sse2(const uint8_t *const *lines,
+                               unsigned width,
+                               unsigned factor,
+                               uint8_t *dst)
+{
+    const auto zero     = _mm_setzero_si128();
+    const auto ones     = _mm_set1_epi16(1);
+    const auto shift    = int(2 * log2Factor(factor));
+    const auto rounding = _mm_set1_epi32(int(factor * factor / 2));
+
+    // 16 input samples per iteration. Only complete boxes are read.
+    const auto outputsPerIteration = 16 / factor;
+    const auto nrCompleteOutputs   = width / factor;
+
+    unsigned x = 0;
+    for (; x + outputsPerIteration <= nrCompleteOutputs; x += outputsPerIteration)
+    {
+        auto sumLow  = zero;
+        auto sumHigh = zero;
+        for (unsigned i = 0; i < factor; i++)
+        {
+            const auto values = _mm_loadu_si128(
+                reinterpret_cast<const __m128i *>(lines[i] + x * factor));
+            sumLow  = _mm_add_epi16(sumLow, _mm_unpacklo_epi8(values, zero));
+            sumHigh = _mm_add_epi16(sumHigh, _mm_unpackhi_epi8(values, zero));
+        }
+
+        // Horizontal sums of pairs
+        auto boxLow  = _mm_madd_epi16(sumLow, ones);
+        auto boxHigh = _mm_madd_epi16(sumHigh, ones);
+        if (factor == 4)
+        {
+            boxLow = _mm_madd_epi16(_mm_packs_epi32(boxLow, boxHigh), ones);
+            boxLow = _mm_srli_epi32(_mm_add_epi32(boxLow, rounding), shift);
+            const auto packed = _mm_packus_epi16(_mm_packs_epi32(boxLow, zero), zero);
+            const auto output = _mm_cvtsi128_si32(packed);
+            std::memcpy(dst + x, &output, 4);
+        }
+        else
+        {
+            boxLow  = _mm_srli_epi32(_mm_add_epi32(boxLow, rounding), shift);
+            boxHigh = _mm_srli_epi32(_mm_add_epi32(boxHigh, rounding), shift);
+            const auto packed = _mm_packus_epi16(_mm_packs_epi32(boxLow, boxHigh), zero);
+            _mm_storel_epi64(reinterpret_cast<__m128i *>(dst + x), packed);
+        }
+    }
+    return x;
+}
+
+unsigned decimateLine16bit_sse2(const uint16_t *const *lines,
+                                unsigned width,
+                                unsigned factor,
+                                uint16_t *dst)
+{
+    const auto zero     = _mm_setzero_si128();
+    const auto ones     = _mm_set1_epi16(1);
+    const auto shift    = int(2 * log2Factor(factor));
+    const auto rounding = _mm_set1_epi32(int(factor * factor / 2));
+
+    // 4 output samples per iteration
+    const auto inputsPerIteration = 4 * factor;
+    const auto nrCompleteOutputs  = width / factor;
+
+    unsigned x = 0;
+    for (; x + 4 <= nrCompleteOutputs; x += 4)
+    {
+        auto sumLow  = zero;
+        auto sumHigh = zero;
+        for (unsigned i = 0; i < factor; i++)
+        {
+            const auto src = reinterpret_cast<const __m128i *>(lines[i] + x * factor);
+            sumLow         = _mm_add_epi16(sumLow, _mm_loadu_si128(src));
+            if (inputsPerIteration == 16)
+                sumHigh = _mm_add_epi16(sumHigh, _mm_loadu_si128(src + 1));
+        }
+
+        auto box = _mm_madd_epi16(sumLow, ones);
+        if (factor == 4)
+            box = _mm_madd_epi16(_mm_packs_epi32(box, _mm_madd_epi16(sumHigh, ones)), ones);
+        box = _mm_srli_epi32(_mm_add_epi32(box, rounding), shift);
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(dst + x), _mm_packs_epi32(box, zero));
+    }
+    return x;
+}
+
+// 8 output samples per iteration. Only complete boxes are read.
+unsigned downsampleLine2x2_8bit_sse2(const uint8_t *const *lines, unsigned width, int16_t *dst)
+{
+    const auto zero = _mm_setzero_si128();
+    const auto ones = _mm_set1_epi16(1);
+
+    unsigned x = 0;
+    for (; x + 8 <= width / 2; x += 8)
+    {
+        const auto line0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(lines[0] + 2 * x));
+        const auto line1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(lines[1] + 2 * x));
+        const auto sumLow  = _mm_add_epi16(_mm_unpacklo_epi8(line0, zero),
+                                          _mm_unpacklo_epi8(line1, zero));
+        const auto sumHigh = _mm_add_epi16(_mm_unpackhi_epi8(line0, zero),
+                                           _mm_unpackhi_epi8(line1, zero));
+        const auto boxLow  = _mm_srli_epi32(_mm_madd_epi16(sumLow, ones), 2);
+        const auto boxHigh = _mm_srli_epi32(_mm_madd_epi16(sumHigh, ones), 2);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + x), _mm_packs_epi32(boxLow, boxHigh));
+    }
+    return x;
+}
+
+unsigned downsampleLine2x2_16bit_sse2(const uint16_t *const *lines, unsigned width, int16_t *dst)
+{
+    const auto ones = _mm_set1_epi16(1);
+
+    unsigned x = 0;
+    for (; x + 8 <= width / 2; x += 8)
+    {
+        const auto src0 = reinterpret_cast<const __m128i *>(lines[0] + 2 * x);
+        const auto src1 = reinterpret_cast<const __m128i *>(lines[1] + 2 * x);
+        const auto sumLow  = _mm_add_epi16(_mm_loadu_si128(src0), _mm_loadu_si128(src1));
+        const auto sumHigh = _mm_add_epi16(_mm_loadu_si128(src0 + 1), _mm_loadu_si128(src1 + 1));
+        const auto boxLow  = _mm_srli_epi32(_mm_madd_epi16(sumLow, ones), 2);
+        const auto boxHigh = _mm_srli_epi32(_mm_madd_epi16(sumHigh, ones), 2);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + x), _mm_packs_epi32(boxLow, boxHigh));
+    }
+    return x;
+}
+
+#endif
+
+template<typename T>
+void downsamplePlane2x2(const uint8_t *src,
+                        unsigned srcStride,
+                        unsigned width,
+                        unsigned height,
+                        int16_t *dst,
+                        unsigned dstStride,
+                        unsigned outputWidth,
+                        unsigned outputHeight,
+                        CpuSimd cpuSimd)
+{
+    const T *lines[2];
+    for (unsigned y = 0; y < outputHeight; y++)
+    {
+        for (unsigned i = 0; i < 2; i++)
+        {
+            const auto srcY = std::min(y * 2 + i, height - 1);
+            lines[i]        = reinterpret_cast<const T *>(src + srcY * srcStride);
+        }
+        auto dstLine = dst + y * dstStride;
+
+        unsigned startX = 0;
+#if VCA_DECIMATION_SSE2
+        if (cpuSimd != CpuSimd::None)
+        {
+            if constexpr (sizeof(T) == 1)
+                startX = downsampleLine2x2_8bit_sse2(lines, width, dstLine);
+            else
+                startX = downsampleLine2x2_16bit_sse2(lines, width, dstLine);
+        }
+#else
+        (void) cpuSimd;
+#endif
+        downsampleLine2x2_c(lines, width, startX, outputWidth, dstLine);
+    }
+}
+
+template<typename T>
+void decimatePlane(const uint8_t *src,
+                   unsigned srcStride,
+                   unsigned width,
+                   unsigned height,
+                   uint8_t *dst,
+                   unsigned dstStride,
+                   unsigned factor,
+                   CpuSimd cpuSimd)
+{
+    const auto outputWidth  = (width + factor - 1) / factor;
+    const auto outputHeight = (height + factor - 1) / factor;
+
+    const T *lines[MAX_FACTOR];
+    for (unsigned y = 0; y < outputHeight; y++)
+    {
+        for (unsigned i = 0; i < factor; i++)
+        {
+            const auto srcY = std::min(y * factor + i, height - 1);
+            lines[i]        = reinterpret_cast<const T *>(src + srcY * srcStride);
+        }
+        auto dstLine = reinterpret_cast<T *>(dst + y * dstStride);
+
+        unsigned startX = 0;
+#if VCA_DECIMATION_SSE2
+        if (cpuSimd != CpuSimd::None)
+        {
+            if constexpr (sizeof(T) == 1)
+                startX = decimateLine8bit_sse2(lines, width, factor, dstLine);
+            else
+                startX = decimateLine16bit_sse2(lines, width, factor, dstLine);
+        }
+#else
+        (void) cpuSimd;
+#endif
+        decimateLine_c(lines, width, factor, startX, outputWidth, dstLine);
+    }
+}
+
+} // namespace
+
+void decimatePlane(const uint8_t *src,
+                   unsigned srcStride,
+                   unsigned width,
+                   unsigned height,
+                   uint8_t *dst,
+                   unsigned dstStride,
+                   unsigned factor,
+                   unsigned bitDepth,
+                   CpuSimd cpuSimd)
+{
+    if (factor != 2 && factor != 4)
+        throw std::invalid_argument("Invalid decimation factor");
+
+    if (bitDepth > 8)
+        decimatePlane<uint16_t>(src, srcStride, width, height, dst, dstStride, factor, cpuSimd);
+    else
+        decimatePlane<uint8_t>(src, srcStride, width, height, dst, dstStride, factor, cpuSimd);
+}
+
+void downsamplePlane2x2(const uint8_t *src,
+                        unsigned srcStride,
+                        unsigned width,
+                        unsigned height,
+                        int16_t *dst,
+                        unsigned dstStride,
+                        unsigned outputWidth,
+                        unsigned outputHeight,
+                        unsigned bitDepth,
+                        CpuSimd cpuSimd)
+{
+    if (bitDepth > 8)
+        downsamplePlane2x2<uint16_t>(src,
+                                     srcStride,
+                                     width,
+                                     height,
+                                     dst,
+                                     dstStride,
+                                     outputWidth,
+                                     outputHeight,
+                                     cpuSimd);
+    else
+        downsamplePlane2x2<uint8_t>(src,
+                                    srcStride,
+                                    width,
+                                    height,
+                                    dst,
+                                    dstStride,
+                                    outputWidth,
+                                    outputHeight,
+                                    cpuSimd);
+}
+
+vca_rect decimateRect(const vca_rect &rect, unsigned factor)
+{
+    if (rect.width == 0 || rect.height == 0)
+        return {};
+    const auto left   = rect.x / factor;
+    const auto top    = rect.y / factor;
+    const auto right  = (rect.x + rect.width + factor - 1) / factor;
+    const auto bottom = (rect.y + rect.height + factor - 1) / factor;
+    return {left, top, right - left, bottom - top};
+}
+
+vca_frame *DecimatedFrame::decimate(const vca_frame &frame, unsigned factor, CpuSimd cpuSimd)
+{
+    const auto &info         = frame.info;
+    const auto bytesPerPixel = (info.bitDepth > 8) ? 2u : 1u;
+
+    this->frame             = {};
+    this->frame.stats       = frame.stats;
+    this->frame.info        = info;
+    this->frame.info.width  = (info.width + factor - 1) / factor;
+    this->frame.info.height = (info.height + factor - 1) / factor;
+
+    const auto [subsamplingX, subsamplingY] = getChromaSubsampling(info.colorspace);
+    const auto nrPlanes = (info.colorspace == vca_colorSpace::YUV400) ? 1u : 3u;
+    for (unsigned plane = 0; plane < nrPlanes; plane++)
+    {
+        if (frame.planes[plane] == nullptr)
+            continue;
+
+        const auto isLuma       = (plane == 0);
+        const auto width        = isLuma ? info.width : info.width / subsamplingX;
+        const auto height       = isLuma ? info.height : info.height / subsamplingY;
+        const auto outputWidth  = (width + factor - 1) / factor;
+        const auto outputHeight = (height + factor - 1) / factor;
+        const auto outputStride = outputWidth * bytesPerPixel;
+
+        auto &data = this->planes[plane];
+        data.resize(outputStride * outputHeight);
+        decimatePlane(frame.planes[plane],
+                      unsigned(frame.stride[plane]),
+                      width,
+                      height,
+                      data.data(),
+                      outputStride,
+                      factor,
+                      info.bitDepth,
+                      cpuSimd);
+
+        this->frame.planes[plane] = data.data();
+        this->frame.stride[plane] = int(outputStride);
+        this->frame.height[plane] = int(outputHeight);
+    }
+
+    if (frame.dirtyRects != nullptr)
+    {
+        // An empty list must not be nullptr (which means that the whole frame changed)
+        this->dirtyRects.resize(std::max(frame.nrDirtyRects, 1u));
+        for (unsigned i = 0; i < frame.nrDirtyRects; i++)
+            this->dirtyRects[i] = decimateRect(frame.dirtyRects[i], factor);
+        this->frame.dirtyRects   = this->dirtyRects.data();
+        this->frame.nrDirtyRects = frame.nrDirtyRects;
+    }
+
+    return &this->frame;
+}
+
+void HalfResolutionFrame::update(const vca_frame &frame,
+                                 unsigned blockSize,
+                                 bool enableChroma,
+                                 CpuSimd cpuSimd)
+{
+    const auto bytesPerPixel = (frame.info.bitDepth > 8) ? 2u : 1u;
+
+    // The same plane sizes and block grids as in the analysis of the blocks
+    const auto nrPlanes = enableChroma ? 3u : 1u;
+    for (unsigned plane = 0; plane < nrPlanes; plane++)
+    {
+        if (frame.planes[plane] == nullptr)
+            continue;
+
+        const auto isLuma = (plane == 0);
+        const auto width  = isLuma ? frame.info.width
+                                   : unsigned(frame.stride[plane]) / bytesPerPixel;
+        const auto height = isLuma ? frame.info.height : unsigned(frame.height[plane]);
+        const auto outputWidth  = (width + blockSize - 1) / blockSize * blockSize / 2;
+        const auto outputHeight = (height + blockSize - 1) / blockSize * blockSize / 2;
+
+        this->strides[plane] = outputWidth;
+        this->planes[plane].resize(outputWidth * outputHeight);
+        downsamplePlane2x2(frame.planes[plane],
+                           unsigned(frame.stride[plane]),
+                           width,
+                           height,
+                           this->planes[plane].data(),
+                           outputWidth,
+                           outputWidth,
+                           outputHeight,
+                           frame.info.bitDepth,
+                           cpuSimd);
+    }
+}
+
+} // namespace vca
@@ -0,0 +1,103 @@
+/* Copyright (C) 2024 Christian Doppler Laboratory ATHENA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.
+ *****************************************************************************/
+
+#pragma once
+
+#include <vcaLib.h>
+
+#include <array>
+#include <stdint.h>
+#include <vector>
+
+namespace vca {
+
+// Decimate a plane by averaging factor x factor samples (box filter with rounding). The
+// output has ceil(width / factor) x ceil(height / factor) samples. At the right and bottom
+// border, the last sample / line is repeated. The factor must be 2 or 4. The SIMD and the
+// native implementation give the same result.
+void decimatePlane(const uint8_t *src,
+                   unsigned srcStride,
+                   unsigned width,
+                   unsigned height,
+                   uint8_t *dst,
+                   unsigned dstStride,
+                   unsigned factor,
+                   unsigned bitDepth,
+                   CpuSimd cpuSimd);
+
+// Downsample a plane by 2 in both dimensions into int16_t samples. Every output sample is
+// the mean of a 2x2 box (rounded down like the lowpass DCT and entropy of a block). The
+// output has outputWidth x outputHeight samples, which may be more than half of the input.
+// Samples outside of the input repeat the last sample / line like the padding of the
+// blocks at the border. The SIMD and the native implementation give the same result.
+void downsamplePlane2x2(const uint8_t *src,
+                        unsigned srcStride,
+                        unsigned width,
+                        unsigned height,
+                        int16_t *dst,
+                        unsigned dstStride,
+                        unsigned outputWidth,
+                        unsigned outputHeight,
+                        unsigned bitDepth,
+                        CpuSimd cpuSimd);
+
+// Scale a rectangle in luma samples to the decimated frame. The result covers all
+// decimated samples that the rectangle touches. An empty rectangle stays empty.
+vca_rect decimateRect(const vca_rect &rect, unsigned factor);
+
+// A decimated copy of a frame. The memory is kept so that it can be reused for the next
+// frame. The dirty rectangles are scaled to the decimated frame.
+class DecimatedFrame
+{
+public:
+    DecimatedFrame() = default;
+    DecimatedFrame(const DecimatedFrame &) = delete;
+    DecimatedFrame &operator=(const DecimatedFrame &) = delete;
+
+    vca_frame *decimate(const vca_frame &frame, unsigned factor, CpuSimd cpuSimd);
+
+private:
+    std::array<std::vector<uint8_t>, 3> planes;
+    std::vector<vca_rect> dirtyRects;
+    vca_frame frame;
+};
+
+// The planes of a frame downsampled by 2 in both dimensions for the lowpass DCT and the
+// lowpass entropy. This is calculated once per frame instead of downsampling every block
+// in the analysis of every feature. The planes cover the frame padded to the block grid,
+// so the downsampled version of every (padded) block can be read from them.
+class HalfResolutionFrame
+{
+public:
+    HalfResolutionFrame() = default;
+    HalfResolutionFrame(const HalfResolutionFrame &) = delete;
+    HalfResolutionFrame &operator=(const HalfResolutionFrame &) = delete;
+
+    void update(const vca_frame &frame, unsigned blockSize, bool enableChroma, CpuSimd cpuSimd);
+
+    // The downsampled block with the top left sample (x, y) in the full resolution plane
+    const int16_t *getBlock(unsigned plane, unsigned x, unsigned y) const
+    {
+        return this->planes[plane].data() + (y / 2) * this->strides[plane] + x / 2;
+    }
+    unsigned getStride(unsigned plane) const { return this->strides[plane]; }
+
+private:
+    std::array<std::vector<int16_t>, 3> planes;
+    std::array<unsigned, 3> strides{};
+};
+
+} // namespace vca
@@ -20,14 +20,22 @@
 
 #include "EnergyCalculation.h"
 
+#include <analyzer/BlockCache.h>
+#include <analyzer/BlockSampling.h>
+#include <analyzer/BlockStatistics.h>
 #include <analyzer/DCTTransform.h>
+#include <analyzer/Decimation.h>
 #include <analyzer/EntropyCalculation.h>
+#include <analyzer/Hadamard.h>
 
 #include <algorithm>
+#include <array>
 #include <cmath>
 #include <cstdlib>
 #include <cstring>
+#include <mutex>
 #include <stdexcept>
+#include <vector>
 
 namespace {
 
@@ -115,36 +123,415 @@ static const int16_t weights_dct32[1024] = {
     120, 124, 128, 133, 138, 144, 150, 157, 164, 172, 181, 191, 201, 213, 225, 239, 255,
 };
 
+// The weights of the lowest 32x32 frequencies of a 64x64 and a 128x128 DCT (same formula as
+// the tables above). Blocks of these sizes are analyzed with a 32x32 DCT of the block
+// decimated by 2 or 4, which only gives these coefficients.
+static const int16_t weights_dct64[1024] = {
+    0,   27,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,
+    93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  27,  93,  93,  93,  93,  93,
+    93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,
+    93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,
+    93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,
+    93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,
+    93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,
+    93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,
+    93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,
+    93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,
+    94,  94,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,
+    93,  93,  93,  93,  93,  93,  93,  93,  93,  94,  94,  94,  94,  94,  94,  93,  93,  93,  93,
+    93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,
+    94,  94,  94,  94,  94,  94,  94,  94,  94,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,
+    93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  94,  94,  94,  94,  94,  94,  94,  94,  94,
+    94,  94,  94,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,
+    93,  93,  94,  94,  94,  94,  94,  94,  94,  94,  94,  94,  94,  94,  94,  94,  93,  93,  93,
+    93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  94,  94,  94,  94,  94,  94,
+    94,  94,  94,  94,  94,  94,  94,  94,  94,  94,  93,  93,  93,  93,  93,  93,  93,  93,  93,
+    93,  93,  93,  93,  93,  93,  94,  94,  94,  94,  94,  94,  94,  94,  94,  94,  94,  94,  94,
+    94,  94,  94,  94,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  94,
+    94,  94,  94,  94,  94,  94,  94,  94,  94,  94,  94,  94,  94,  94,  94,  94,  94,  93,  93,
+    93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  94,  94,  94,  94,  94,  94,  94,  94,
+    94,  94,  94,  94,  94,  94,  94,  94,  94,  94,  94,  93,  93,  93,  93,  93,  93,  93,  93,
+    93,  93,  93,  93,  94,  94,  94,  94,  94,  94,  94,  94,  94,  94,  94,  94,  94,  94,  94,
+    94,  94,  94,  95,  95,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  94,  94,  94,
+    94,  94,  94,  94,  94,  94,  94,  94,  94,  94,  94,  94,  94,  94,  95,  95,  95,  95,  93,
+    93,  93,  93,  93,  93,  93,  93,  93,  93,  94,  94,  94,  94,  94,  94,  94,  94,  94,  94,
+    94,  94,  94,  94,  94,  94,  94,  95,  95,  95,  95,  95,  93,  93,  93,  93,  93,  93,  93,
+    93,  93,  93,  94,  94,  94,  94,  94,  94,  94,  94,  94,  94,  94,  94,  94,  94,  94,  95,
+    95,  95,  95,  95,  95,  95,  93,  93,  93,  93,  93,  93,  93,  93,  93,  94,  94,  94,  94,
+    94,  94,  94,  94,  94,  94,  94,  94,  94,  94,  94,  95,  95,  95,  95,  95,  95,  95,  95,
+    93,  93,  93,  93,  93,  93,  93,  93,  93,  94,  94,  94,  94,  94,  94,  94,  94,  94,  94,
+    94,  94,  94,  94,  95,  95,  95,  95,  95,  95,  95,  95,  96,  93,  93,  93,  93,  93,  93,
+    93,  93,  94,  94,  94,  94,  94,  94,  94,  94,  94,  94,  94,  94,  94,  95,  95,  95,  95,
+    95,  95,  95,  95,  96,  96,  96,  93,  93,  93,  93,  93,  93,  93,  93,  94,  94,  94,  94,
+    94,  94,  94,  94,  94,  94,  94,  94,  95,  95,  95,  95,  95,  95,  95,  95,  96,  96,  96,
+    96,  93,  93,  93,  93,  93,  93,  93,  93,  94,  94,  94,  94,  94,  94,  94,  94,  94,  94,
+    94,  94,  95,  95,  95,  95,  95,  95,  95,  96,  96,  96,  96,  96,  93,  93,  93,  93,  93,
+    93,  93,  94,  94,  94,  94,  94,  94,  94,  94,  94,  94,  94,  94,  95,  95,  95,  95,  95,
+    95,  96,  96,  96,  96,  96,  96,  97,  93,  93,  93,  93,  93,  93,  93,  94,  94,  94,  94,
+    94,  94,  94,  94,  94,  94,  94,  95,  95,  95,  95,  95,  95,  96,  96,  96,  96,  96,  97,
+    97,  97,  93,  93,  93,  93,  93,  93,  93,  94,  94,  94,  94,  94,  94,  94,  94,  94,  94,
+    95,  95,  95,  95,  95,  95,  96,  96,  96,  96,  96,  97,  97,  97,  97,  93,  93,  93,  93,
+    93,  93,  94,  94,  94,  94,  94,  94,  94,  94,  94,  94,  94,  95,  95,  95,  95,  95,  95,
+    96,  96,  96,  96,  97,  97,  97,  97,  98,  93,  93,  93,  93,  93,  93,  94,  94,  94,  94,
+    94,  94,  94,  94,  94,  94,  95,  95,  95,  95,  95,  95,  96,  96,  96,  96,  97,  97,  97,
+    97,  98,  98,  93,  93,  93,  93,  93,  93,  94,  94,  94,  94,  94,  94,  94,  94,  94,  95,
+    95,  95,  95,  95,  95,  96,  96,  96,  96,  97,  97,  97,  97,  98,  98,  98,  93,  93,  93,
+    93,  93,  93,  94,  94,  94,  94,  94,  94,  94,  94,  94,  95,  95,  95,  95,  95,  96,  96,
+    96,  96,  97,  97,  97,  97,  98,  98,  98,  99,  93,  93,  93,  93,  93,  94,  94,  94,  94,
+    94,  94,  94,  94,  94,  95,  95,  95,  95,  95,  95,  96,  96,  96,  96,  97,  97,  97,  98,
+    98,  98,  99,  99,  93,  93,  93,  93,  93,  94,  94,  94,  94,  94,  94,  94,  94,  94,  95,
+    95,  95,  95,  95,  96,  96,  96,  96,  97,  97,  97,  98,  98,  98,  99,  99,  99,
+};
+
+static const int16_t weights_dct128[1024] = {
+    0,   27,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,
+    93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  27,  93,  93,  93,  93,  93,
+    93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,
+    93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,
+    93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,
+    93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,
+    93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,
+    93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,
+    93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,
+    93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,
+    93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,
+    93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,
+    93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,
+    93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,
+    93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,
+    93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,
+    93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,
+    93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,
+    93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,
+    93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,
+    93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,
+    93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,
+    93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,
+    93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,
+    93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,
+    93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,
+    93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,
+    93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,
+    93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,
+    93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,
+    93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,
+    93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,
+    93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,
+    93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,
+    93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,
+    93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,
+    93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,
+    93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,
+    93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,
+    93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,
+    93,  93,  93,  93,  93,  93,  94,  94,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,
+    93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  94,
+    94,  94,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,
+    93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  94,  94,  94,  94,  93,  93,  93,  93,
+    93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,
+    93,  93,  93,  93,  94,  94,  94,  94,  94,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,
+    93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  94,  94,  94,
+    94,  94,  94,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,
+    93,  93,  93,  93,  93,  93,  93,  93,  93,  94,  94,  94,  94,  94,  94,  94,  93,  93,  93,
+    93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,
+    93,  93,  94,  94,  94,  94,  94,  94,  94,  94,  93,  93,  93,  93,  93,  93,  93,  93,  93,
+    93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  94,  94,  94,  94,  94,
+    94,  94,  94,  94,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,  93,
+    93,  93,  93,  93,  93,  93,  93,  93,  94,  94,  94,  94,  94,  94,  94,  94,  94,
+};
+
 static const double E_norm_factor = 90;
 static const double h_norm_factor = 18;
 
-uint32_t calculateWeightedCoeffSum(unsigned blockSize, int16_t *coeffBuffer, bool enableLowpassDCT)
+struct WeightFactorMatrix
 {
-    uint32_t weightedSum = 0;
+    const int16_t *weights{};
+    unsigned stride{};
 
-    auto weightFactorMatrix = weights_dct32;
-    switch (blockSize)
+    int16_t get(unsigned u, unsigned v) const
+    {
+        return this->weights[v * this->stride + u];
+    }
+};
+
+// The weights of a block of blockSize samples of a frame that was decimated by
+// decimationFactor. Its DCT gives the low frequencies of the DCT of the block of
+// blockSize * decimationFactor samples in the input frame, so the weights are the upper left
+// blockSize x blockSize part of the weights of that block size. The tables for 64x64 and
+// 128x128 blocks only hold this part for 32x32 blocks.
+WeightFactorMatrix getWeightFactorMatrix(unsigned blockSize, unsigned decimationFactor = 1)
+{
+    switch (blockSize * decimationFactor)
     {
-        case 32:
-            weightFactorMatrix = weights_dct32;
-            break;
-        case 16:
-            weightFactorMatrix = weights_dct16;
-            break;
         case 8:
-            weightFactorMatrix = weights_dct8;
-            break;
+            return {weights_dct8, 8};
+        case 16:
+            return {weights_dct16, 16};
+        case 32:
+            return {weights_dct32, 32};
+        case 64:
+            return {weights_dct64, 32};
+        case 128:
+            return {weights_dct128, 32};
+        default:
+            throw std::invalid_argument("Invalid block size "
+                                        + std::to_string(blockSize * decimationFactor));
     }
+}
 
-    for (unsigned i = 0; i < blockSize * blockSize; i++)
+// The DCT weights for the coefficients of the 8x8 Walsh-Hadamard transforms of a block. A
+// transformed 8x8 sub block covers 8 samples (16 with the lowpass DCT) of the block, so its
+// frequency k is the frequency k * blockSize / 8 (or / 16) of the block.
+vca::HadamardWeights getHadamardWeightsForBlock(unsigned blockSize,
+                                               unsigned decimationFactor,
+                                               bool lowpass)
+{
+    const auto weightFactorMatrix = getWeightFactorMatrix(blockSize, decimationFactor);
+    const auto frequencyScale     = blockSize / (lowpass ? 16 : 8);
+
+    int16_t weightsByFrequency[64];
+    for (unsigned v = 0; v < 8; v++)
+        for (unsigned u = 0; u < 8; u++)
+            weightsByFrequency[v * 8 + u] = weightFactorMatrix.get(u * frequencyScale,
+                                                                   v * frequencyScale);
+    return vca::getHadamardWeights(weightsByFrequency);
+}
+
+// A small random generator that gives the same calibration on all platforms
+class CalibrationRandom
+{
+public:
+    // Uniform in [-1, 1)
+    double next()
     {
-        auto weightedCoeff = (uint32_t)((weightFactorMatrix[i] * std::abs(coeffBuffer[i])) >> 8);
-        weightedSum += weightedCoeff;
+        this->state ^= this->state << 13;
+        this->state ^= this->state >> 17;
+        this->state ^= this->state << 5;
+        return double(this->state) / 2147483648.0 - 1.0;
     }
-    if (blockSize >= 16 && enableLowpassDCT)
-        weightedSum *= 2;
 
-    return weightedSum;
+private:
+    uint32_t state{2463534242u};
+};
+
+enum class CalibrationContent
+{
+    Noise,
+    Texture,
+    SmoothTexture,
+    Gradients,
+    Edges
+};
+
+// An 8 bit block of blockSize x blockSize samples. The textures are sums of sinusoids with
+// random frequencies, directions and phases whose amplitude falls with the frequency f like
+// 1 / f (like natural images) or 1 / f^2. The gradients are sums of sinusoids with at most
+// one period per block. The edges are random straight steps. The contrast of the block is
+// random between 1 / 16 and 1, because the rounding of the weighted DCT coefficients removes
+// more of the energy of blocks with a low contrast.
+void generateCalibrationBlock(CalibrationContent content,
+                              unsigned blockSize,
+                              CalibrationRandom &random,
+                              uint8_t *samples)
+{
+    const auto pi       = std::acos(-1.0);
+    const auto contrast = std::pow(2.0, 2 * (random.next() - 1));
+
+    struct Component
+    {
+        double frequencyX{}, frequencyY{}, phase{}, amplitude{};
+    };
+    std::vector<Component> components;
+    if (content == CalibrationContent::Texture || content == CalibrationContent::SmoothTexture)
+    {
+        const auto exponent = (content == CalibrationContent::Texture) ? 1.0 : 2.0;
+        for (unsigned i = 0; i < 12; i++)
+        {
+            // Log uniform between a quarter period per block (a gradient) and the Nyquist
+            // frequency
+            const auto frequency = std::pow(blockSize * 2.0, (random.next() + 1) / 2)
+                                   / (blockSize * 4);
+            const auto angle     = random.next() * pi;
+            components.push_back({frequency * std::cos(angle),
+                                  frequency * std::sin(angle),
+                                  random.next() * pi,
+                                  contrast * 8.0
+                                      / std::pow(std::max(frequency * blockSize, 1.0), exponent)});
+        }
+    }
+    if (content == CalibrationContent::Gradients)
+        for (unsigned i = 0; i < 4; i++)
+        {
+            const auto frequency = std::pow(4.0, random.next()) / (blockSize * 4);
+            const auto angle     = random.next() * pi;
+            components.push_back({frequency * std::cos(angle),
+                                  frequency * std::sin(angle),
+                                  random.next() * pi,
+                                  contrast * 32.0});
+        }
+    if (content == CalibrationContent::Edges)
+        for (unsigned i = 0; i < 3; i++)
+        {
+            const auto angle = random.next() * pi;
+            components.push_back({std::cos(angle),
+                                  std::sin(angle),
+                                  random.next() * blockSize / 2,
+                                  contrast * random.next() * 64});
+        }
+
+    for (unsigned y = 0; y < blockSize; y++)
+        for (unsigned x = 0; x < blockSize; x++)
+        {
+            auto value = 128.0;
+            if (content == CalibrationContent::Noise)
+                value += contrast * random.next() * 64;
+            for (const auto &c : components)
+            {
+                const auto position = (x - blockSize / 2.0) * c.frequencyX
+                                      + (y - blockSize / 2.0) * c.frequencyY;
+                if (content == CalibrationContent::Edges)
+                    value += (position > c.phase) ? c.amplitude : 0.0;
+                else
+                    value += c.amplitude * std::cos(2 * pi * position + c.phase);
+            }
+            samples[y * blockSize + x] = uint8_t(std::clamp(std::lround(value), 0l, 255l));
+        }
+}
+
+// The geometric mean over several kinds of generated content of the ratio of two summed
+// energies. getEnergies returns the two energies of a generated block of blockSize x
+// blockSize 8 bit samples. Scales between two ways to calculate the energy depend on the
+// content, so they are calibrated like this instead of on a test sequence.
+template <typename GetEnergies>
+double calibrateOnGeneratedContent(unsigned blockSize, GetEnergies getEnergies)
+{
+    constexpr unsigned nrBlocks = 32;
+
+    ALIGN_VAR_32(uint8_t, samples[32 * 32]);
+
+    CalibrationRandom random;
+    double sumOfLogRatios = 0;
+    unsigned nrContents   = 0;
+    for (auto content : {CalibrationContent::Noise,
+                         CalibrationContent::Texture,
+                         CalibrationContent::SmoothTexture,
+                         CalibrationContent::Gradients,
+                         CalibrationContent::Edges})
+    {
+        double numerator   = 0;
+        double denominator = 0;
+        for (unsigned i = 0; i < nrBlocks; i++)
+        {
+            generateCalibrationBlock(content, blockSize, random, samples);
+            const auto [a, b] = getEnergies(samples);
+            numerator += a;
+            denominator += b;
+        }
+        if (numerator > 0 && denominator > 0)
+        {
+            sumOfLogRatios += std::log(numerator / denominator);
+            nrContents++;
+        }
+    }
+    return nrContents > 0 ? std::exp(sumOfLogRatios / nrContents) : 1.0;
+}
+
+// The weighted DCT energy of a block of 8 bit samples (with the given stride) like in the
+// analysis
+double calculateGeneratedBlockEnergy(const uint8_t *samples,
+                                     unsigned stride,
+                                     unsigned blockSize,
+                                     unsigned decimationFactor,
+                                     bool enableLowpass)
+{
+    ALIGN_VAR_32(int16_t, pixelBuffer[32 * 32]);
+    ALIGN_VAR_32(int16_t, coeffBuffer[32 * 32]);
+    for (unsigned y = 0; y < blockSize; y++)
+        for (unsigned x = 0; x < blockSize; x++)
+            pixelBuffer[y * blockSize + x] = samples[y * stride + x];
+    vca::performDCT(blockSize, 8, pixelBuffer, coeffBuffer, CpuSimd::None, enableLowpass);
+    return vca::calculateWeightedCoeffSum(blockSize, coeffBuffer, enableLowpass, decimationFactor);
+}
+
+// The Hadamard energy is scaled to the DCT energy with the ratio of the summed DCT and
+// Hadamard energies of generated blocks. The 8x8 sub blocks of a large block see less of a
+// smooth structure than the DCT of the block, and noise and edges are spread differently
+// over the coefficients of the transforms.
+double calibrateHadamardEnergyScale(unsigned blockSize,
+                                    unsigned decimationFactor,
+                                    bool lowpassBlock,
+                                    bool enableLowpassDCT)
+{
+    const auto weights = getHadamardWeightsForBlock(blockSize, decimationFactor, lowpassBlock);
+    return calibrateOnGeneratedContent(blockSize, [&](const uint8_t *samples) {
+        const auto dctEnergy = calculateGeneratedBlockEnergy(samples,
+                                                             blockSize,
+                                                             blockSize,
+                                                             decimationFactor,
+                                                             enableLowpassDCT);
+
+        ALIGN_VAR_32(int16_t, hadamardSamples[32 * 32]);
+        auto size = blockSize;
+        if (lowpassBlock)
+        {
+            size = blockSize / 2;
+            vca::downsamplePlane2x2(samples,
+                                    blockSize,
+                                    blockSize,
+                                    blockSize,
+                                    hadamardSamples,
+                                    size,
+                                    size,
+                                    size,
+                                    8,
+                                    CpuSimd::None);
+        }
+        else
+            for (unsigned i = 0; i < blockSize * blockSize; i++)
+                hadamardSamples[i] = samples[i];
+        const double hadamardEnergy = vca::calculateHadamardEnergy(hadamardSamples,
+                                                                   size,
+                                                                   size,
+                                                                   8,
+                                                                   weights,
+                                                                   CpuSimd::None);
+        return std::make_pair(dctEnergy, hadamardEnergy);
+    });
+}
+
+// The weights and the scale of the Hadamard energy of blocks of blockSize samples of a frame
+// that was decimated by decimationFactor. With lowpassBlock, the Hadamard energy is
+// calculated from the downsampled block. enableLowpassDCT is the DCT that it replaces. The
+// scale is calibrated when a configuration is used for the first time.
+struct HadamardCalibration
+{
+    vca::HadamardWeights weights{};
+    double scale{};
+};
+
+const HadamardCalibration &getHadamardCalibration(unsigned blockSize,
+                                                  unsigned decimationFactor,
+                                                  bool lowpassBlock,
+                                                  bool enableLowpassDCT)
+{
+    constexpr unsigned nrConfigurations = 3 * 3 * 2 * 2;
+    static std::array<std::once_flag, nrConfigurations> calibrated;
+    static std::array<HadamardCalibration, nrConfigurations> calibrations;
+
+    const auto sizeIndex   = blockSize == 8 ? 0u : (blockSize == 16 ? 1u : 2u);
+    const auto factorIndex = decimationFactor == 1 ? 0u : (decimationFactor == 2 ? 1u : 2u);
+    const auto index = ((sizeIndex * 3 + factorIndex) * 2 + unsigned(lowpassBlock)) * 2
+                       + unsigned(enableLowpassDCT);
+    std::call_once(calibrated[index], [&]() {
+        calibrations[index].weights = getHadamardWeightsForBlock(blockSize,
+                                                                 decimationFactor,
+                                                                 lowpassBlock);
+        calibrations[index].scale   = calibrateHadamardEnergyScale(blockSize,
+                                                                 decimationFactor,
+                                                                 lowpassBlock,
+                                                                 enableLowpassDCT);
+    });
+    return calibrations[index];
 }
 
 void copyPixelValuesToBufferNoPadding(unsigned bitDepth,
@@ -190,7 +577,7 @@ void copyPixelValuesToBufferWithPadding8Bit(unsigned blockSize,
         bufferLastLine = buffer;
         for (; x < blockSize - paddingRight; x++)
             *(buffer++) = static_cast<int16_t>(src[x]);
-        const auto lastValue = static_cast<int16_t>(src[x]);
+        const auto lastValue = static_cast<int16_t>(src[x - 1]);
         for (; x < blockSize; x++)
             *(buffer++) = lastValue;
     }
@@ -236,6 +623,218 @@ void copyPixelValuesToBufferWithPaddingHighBitDepth(unsigned blockSize,
     }
 }
 
+// The energyDiff (h) and energyEpsilon of a frame are compared to the absolute thresholds
+// maxSadThresh (100) and maxEpsilonThresh (50) in the shot detection, which were tuned on the
+// full DCT energy. The 8x8 DCT of the downsampled blocks misses the higher frequencies, and
+// how much of the energy these hold depends on the content. So the energy of one out of every
+// ShotDetectionCalibrationInterval x ShotDetectionCalibrationInterval blocks is also
+// calculated with the full DCT (like computeWeightedDCTEnergy does), and the energy of all
+// blocks is scaled by the ratio of the full to the reduced energy of these blocks in the
+// frame. For 16x16 blocks with the lowpass DCT, the reduced energy is the one of the lowpass
+// DCT before the doubling, so the ratio is 2.
+constexpr unsigned ShotDetectionCalibrationInterval = 4;
+
+bool isShotDetectionCalibrationBlock(unsigned x, unsigned y, const vca::BlockRegion &region)
+{
+    return (x - region.left) % ShotDetectionCalibrationInterval == 0
+           && (y - region.top) % ShotDetectionCalibrationInterval == 0;
+}
+
+// If the calibration blocks have no reduced energy, the missing upper half of the lowpass DCT
+// is accounted for as in calculateWeightedCoeffSum.
+double getShotDetectionEnergyScale(uint64_t fullEnergySum, uint64_t reducedEnergySum)
+{
+    if (reducedEnergySum == 0)
+        return 2.0;
+    return double(fullEnergySum) / double(reducedEnergySum);
+}
+
+struct BlockEnergy
+{
+    uint32_t brightness{};
+    uint32_t energy{};
+};
+
+// The downsampled version of a block in the half resolution planes of the frame. samples is
+// nullptr if there are no half resolution planes and the block is downsampled on the fly.
+struct HalfResolutionBlock
+{
+    const int16_t *samples{};
+    unsigned stride{};
+};
+
+HalfResolutionBlock getHalfResolutionBlock(const vca::HalfResolutionFrame *halfResolution,
+                                           unsigned plane,
+                                           unsigned x,
+                                           unsigned y)
+{
+    if (halfResolution == nullptr)
+        return {};
+    return {halfResolution->getBlock(plane, x, y), halfResolution->getStride(plane)};
+}
+
+// Calculate the brightness (from the DC) and the weighted DCT energy of the block in the
+// pixel buffer. Flat blocks (the range of the samples is not above flatBlockThreshold) are
+// not transformed. Their energy is 0 and the DC is calculated from the sum of the samples.
+// With hadamardCalibration, the DC is always calculated from the sum and the energy is the
+// scaled Hadamard energy of the block (or of the downsampled block for the lowpass DCT). Without
+// enableEnergy, only the DC is calculated from the sum.
+BlockEnergy calculateBlockEnergy(unsigned blockSize,
+                                 unsigned bitDepth,
+                                 int16_t *pixelBuffer,
+                                 int16_t *coeffBuffer,
+                                 CpuSimd cpuSimd,
+                                 bool enableEnergy,
+                                 bool enableLowpass,
+                                 const HadamardCalibration *hadamardCalibration,
+                                 unsigned flatBlockThreshold,
+                                 const HalfResolutionBlock &lowpassBlock,
+                                 unsigned decimationFactor,
+                                 vca::Result &result)
+{
+    result.nrAnalyzedBlocks++;
+
+    const auto statistics = vca::calculateBlockStatistics(pixelBuffer,
+                                                          blockSize * blockSize,
+                                                          cpuSimd);
+    if (statistics.range() <= flatBlockThreshold)
+    {
+        result.nrSkippedBlocks++;
+        const auto dc = vca::calculateFlatBlockDC(blockSize,
+                                                  bitDepth,
+                                                  statistics.sum,
+                                                  enableLowpass);
+        return {uint32_t(sqrt(dc)), 0};
+    }
+
+    if (hadamardCalibration != nullptr || !enableEnergy)
+    {
+        const auto dc = vca::calculateFlatBlockDC(blockSize,
+                                                  bitDepth,
+                                                  statistics.sum,
+                                                  enableLowpass);
+        if (!enableEnergy)
+            return {uint32_t(sqrt(dc)), 0};
+        vca::StageTimer timer(result.stageTimes,
+                              vca_stage::DCT,
+                              result.stageTimes.isBlockSampled());
+        const auto useLowpassBlock = enableLowpass && blockSize >= 16
+                                     && lowpassBlock.samples != nullptr;
+        const auto energy = useLowpassBlock
+                                ? vca::calculateHadamardEnergy(lowpassBlock.samples,
+                                                               lowpassBlock.stride,
+                                                               blockSize / 2,
+                                                               bitDepth,
+                                                               hadamardCalibration->weights,
+                                                               cpuSimd)
+                                : vca::calculateHadamardEnergy(pixelBuffer,
+                                                               blockSize,
+                                                               blockSize,
+                                                               bitDepth,
+                                                               hadamardCalibration->weights,
+                                                               cpuSimd);
+        return {uint32_t(sqrt(dc)), uint32_t(energy * hadamardCalibration->scale + 0.5)};
+    }
+
+    const auto isBlockSampled = result.stageTimes.isBlockSampled();
+    {
+        vca::StageTimer timer(result.stageTimes, vca_stage::DCT, isBlockSampled);
+        if (enableLowpass && blockSize >= 16 && lowpassBlock.samples != nullptr)
+            vca::performLowpassDCT(blockSize,
+                                   bitDepth,
+                                   lowpassBlock.samples,
+                                   lowpassBlock.stride,
+                                   statistics.sum,
+                                   coeffBuffer,
+                                   cpuSimd);
+        else
+            vca::performDCT(blockSize, bitDepth, pixelBuffer, coeffBuffer, cpuSimd, enableLowpass);
+    }
+
+    vca::StageTimer timer(result.stageTimes, vca_stage::WeightedSum, isBlockSampled);
+    const auto weightedSum = vca::calculateWeightedCoeffSum(blockSize,
+                                                            coeffBuffer,
+                                                            enableLowpass,
+                                                            decimationFactor);
+    return {uint32_t(sqrt(coeffBuffer[0])), weightedSum};
+}
+
+// The entropy of a flat block is 0.
+double calculateBlockEntropy(unsigned blockSize,
+                             unsigned bitDepth,
+                             int16_t *pixelBuffer,
+                             CpuSimd cpuSimd,
+                             bool enableLowpass,
+                             unsigned flatBlockThreshold,
+                             const HalfResolutionBlock &lowpassBlock,
+                             vca::Result &result)
+{
+    result.nrAnalyzedBlocks++;
+
+    const auto statistics = vca::calculateBlockStatistics(pixelBuffer,
+                                                          blockSize * blockSize,
+                                                          cpuSimd);
+    if (statistics.range() <= flatBlockThreshold)
+    {
+        result.nrSkippedBlocks++;
+        return 0.0;
+    }
+
+    vca::StageTimer timer(result.stageTimes,
+                          vca_stage::Entropy,
+                          result.stageTimes.isBlockSampled());
+    if (enableLowpass && lowpassBlock.samples != nullptr)
+        return vca::performLowpassEntropy(blockSize,
+                                          lowpassBlock.samples,
+                                          lowpassBlock.stride,
+                                          cpuSimd);
+    return vca::performEntropy(blockSize, bitDepth, pixelBuffer, cpuSimd, enableLowpass);
+}
+
+// Check if the results of the block can be copied from the reference frame of the static
+// block cache. Reused blocks are counted as analyzed blocks.
+bool isStaticBlock(const vca::StaticBlocks *staticBlocks,
+                   unsigned plane,
+                   unsigned blockIndex,
+                   vca::Result &result)
+{
+    if (staticBlocks == nullptr || !staticBlocks->isStatic(plane, blockIndex))
+        return false;
+    result.nrAnalyzedBlocks++;
+    result.nrReusedBlocks++;
+    return true;
+}
+
+} // namespace
+
+namespace vca {
+
+// A block of blockSize * decimationFactor samples is analyzed with the DCT of the block
+// decimated by decimationFactor. Like with the lowpass DCT, the sum is scaled up to make up
+// for the high frequencies that are not calculated.
+uint32_t calculateWeightedCoeffSum(unsigned blockSize,
+                                   int16_t *coeffBuffer,
+                                   bool enableLowpassDCT,
+                                   unsigned decimationFactor)
+{
+    uint32_t weightedSum = 0;
+
+    const auto weightFactorMatrix = getWeightFactorMatrix(blockSize, decimationFactor);
+
+    for (unsigned v = 0; v < blockSize; v++)
+    {
+        const auto weights = weightFactorMatrix.weights + v * weightFactorMatrix.stride;
+        const auto coeffs  = coeffBuffer + v * blockSize;
+        for (unsigned u = 0; u < blockSize; u++)
+            weightedSum += (uint32_t)((weights[u] * std::abs(coeffs[u])) >> 8);
+    }
+    if (blockSize >= 16 && enableLowpassDCT)
+        weightedSum *= 2;
+    weightedSum *= decimationFactor;
+
+    return weightedSum;
+}
+
 void copyPixelValuesToBuffer(unsigned bitDepth,
                              unsigned blockOffsetBytes,
                              unsigned blockSize,
@@ -271,16 +870,17 @@ void copyPixelValuesToBuffer(unsigned bitDepth,
     }
 }
 
-} // namespace
-
-namespace vca {
-
 void computeWeightedDCTEnergy(const Job &job,
                               Result &result,
                               const unsigned blockSize,
                               CpuSimd cpuSimd,
+                              bool enableEnergy,
                               bool enableChroma,
-                              bool enableLowpass)
+                              bool enableLowpass,
+                              bool enableHadamard,
+                              unsigned flatBlockThreshold,
+                              const StaticBlocks *staticBlocks,
+                              const HalfResolutionFrame *halfResolution)
 {
     const auto frame = job.frame;
     if (frame == nullptr)
@@ -294,14 +894,31 @@ void computeWeightedDCTEnergy(const Job &job,
 
     auto [widthInBlocks, heightInBlock] = getFrameSizeInBlocks(blockSize, frame->info);
     auto totalNumberBlocks              = widthInBlocks * heightInBlock;
-    auto widthInPixels                  = widthInBlocks * blockSize;
-    auto heightInPixels                 = heightInBlock * blockSize;
+
+    const auto region = getBlockRegion(job.regionOfInterest,
+                                       blockSize,
+                                       {widthInBlocks, heightInBlock});
+    result.nrBlocksInRegion = region.getNrBlocks();
+    // Reduced resolution and large blocks are analyzed in a decimated frame. The energies are
+    // weighted for the blocks of the input frame so that they are comparable with the full
+    // analysis of blocks of blockSize * decimationFactor samples.
+    const auto decimationFactor = job.decimationFactor * job.largeBlockFactor;
 
     if (result.brightnessPerBlock.size() < totalNumberBlocks)
         result.brightnessPerBlock.resize(totalNumberBlocks);
     if (result.energyPerBlock.size() < totalNumberBlocks)
         result.energyPerBlock.resize(totalNumberBlocks);
 
+    const HadamardCalibration *hadamardCalibration = nullptr;
+    if (enableHadamard)
+    {
+        const auto useLowpassBlock = enableLowpass && blockSize >= 16 && halfResolution != nullptr;
+        hadamardCalibration        = &getHadamardCalibration(blockSize,
+                                                      decimationFactor,
+                                                      useLowpassBlock,
+                                                      enableLowpass);
+    }
+
     // First, we will copy the source to a temporary buffer which has one int16_t value
     // per sample.
     //   - This may only be needed for 8 bit values. For 16 bit values we could also
@@ -311,49 +928,88 @@ void computeWeightedDCTEnergy(const Job &job,
     ALIGN_VAR_32(int16_t, pixelBuffer[32 * 32]);
     ALIGN_VAR_32(int16_t, coeffBuffer[32 * 32]);
 
-    auto blockIndex          = 0u;
+    const BlockSampler sampler(job, region);
+    SampleStatistics energyStatistics;
     uint32_t frameBrightness = 0;
     uint32_t frameTexture    = 0;
-    for (unsigned blockY = 0; blockY < heightInPixels; blockY += blockSize)
     {
-        auto paddingBottom = std::max(int(blockY + blockSize) - int(frame->info.height), 0);
-        for (unsigned blockX = 0; blockX < widthInPixels; blockX += blockSize)
+        BlockLoopTimer loopTimer(result.stageTimes);
+        for (auto blockY = region.top * blockSize; blockY < region.bottom * blockSize;
+             blockY += blockSize)
         {
-            auto paddingRight = std::max(int(blockX + blockSize) - int(frame->info.width), 0);
-            auto blockOffsetLumaBytes = blockX * bytesPerPixel + (blockY * srcStride);
-
-            copyPixelValuesToBuffer(bitDepth,
-                                    blockOffsetLumaBytes,
-                                    blockSize,
-                                    src,
-                                    srcStride,
-                                    pixelBuffer,
-                                    unsigned(paddingRight),
-                                    unsigned(paddingBottom));
-
-            performDCT(blockSize,
-                       bitDepth,
-                       pixelBuffer,
-                       coeffBuffer,
-                       cpuSimd,
-                       enableLowpass);
-
-            result.brightnessPerBlock[blockIndex] = uint32_t(sqrt(coeffBuffer[0]));
-            result.energyPerBlock[blockIndex]     = calculateWeightedCoeffSum(blockSize,
-                                                                              coeffBuffer,
-                                                                              enableLowpass);
-            frameBrightness += result.brightnessPerBlock[blockIndex];
-            frameTexture += result.energyPerBlock[blockIndex];
-
-            blockIndex++;
+            auto paddingBottom = std::max(int(blockY + blockSize) - int(frame->info.height), 0);
+            auto blockIndex    = (blockY / blockSize) * widthInBlocks + region.left;
+            for (auto blockX = region.left * blockSize; blockX < region.right * blockSize;
+                 blockX += blockSize)
+            {
+                if (!sampler.isSampled(blockX / blockSize, blockY / blockSize))
+                {
+                    blockIndex++;
+                    continue;
+                }
+
+                auto paddingRight = std::max(int(blockX + blockSize) - int(frame->info.width), 0);
+                auto blockOffsetLumaBytes = blockX * bytesPerPixel + (blockY * srcStride);
+
+                BlockEnergy blockEnergy;
+                if (isStaticBlock(staticBlocks, 0, blockIndex, result))
+                {
+                    const auto &reference = staticBlocks->referenceResult();
+                    blockEnergy = {reference.brightnessPerBlock[blockIndex],
+                                   reference.energyPerBlock[blockIndex]};
+                }
+                else
+                {
+                    copyPixelValuesToBuffer(bitDepth,
+                                            blockOffsetLumaBytes,
+                                            blockSize,
+                                            src,
+                                            srcStride,
+                                            pixelBuffer,
+                                            unsigned(paddingRight),
+                                            unsigned(paddingBottom));
+
+                    const auto lowpassBlock = getHalfResolutionBlock(halfResolution,
+                                                                     0,
+                                                                     blockX,
+                                                                     blockY);
+                    blockEnergy = calculateBlockEnergy(blockSize,
+                                                       bitDepth,
+                                                       pixelBuffer,
+                                                       coeffBuffer,
+                                                       cpuSimd,
+                                                       enableEnergy,
+                                                       enableLowpass,
+                                                       hadamardCalibration,
+                                                       flatBlockThreshold,
+                                                       lowpassBlock,
+                                                       decimationFactor,
+                                                       result);
+                }
+
+                result.brightnessPerBlock[blockIndex] = blockEnergy.brightness;
+                result.energyPerBlock[blockIndex]     = blockEnergy.energy;
+                frameBrightness += result.brightnessPerBlock[blockIndex];
+                frameTexture += result.energyPerBlock[blockIndex];
+                energyStatistics.add(result.energyPerBlock[blockIndex]);
+
+                blockIndex++;
+            }
         }
     }
 
-    result.averageBrightness = uint32_t((double) (frameBrightness) / totalNumberBlocks);
-    result.averageEnergy = uint32_t((double) (frameTexture) / (totalNumberBlocks * E_norm_factor));
+    const auto nrSampledBlocks = energyStatistics.getCount();
+    result.averageBrightness   = uint32_t((double) (frameBrightness) / nrSampledBlocks);
+    result.averageEnergy       = uint32_t((double) (frameTexture)
+                                     / (nrSampledBlocks * E_norm_factor));
+
+    result.averageEnergyConfidence = energyStatistics.getConfidence(region.getNrBlocks())
+                                     / E_norm_factor;
 
     if (enableChroma)
     {
+        StageTimer chromaTimer(result.stageTimes, vca_stage::Chroma);
+
         const auto srcU       = frame->planes[1];
         const auto srcV       = frame->planes[2];
         const auto srcUStride = frame->stride[1];
@@ -364,8 +1020,11 @@ void computeWeightedDCTEnergy(const Job &job,
                                                                            srcUWidth,
                                                                            srcUHeight);
         const auto totalNumberBlocksC         = widthInBlocksC * heightInBlockC;
-        const auto widthInPixelsC             = widthInBlocksC * blockSize;
-        const auto heightInPixelsC            = heightInBlockC * blockSize;
+
+        const auto regionC = getBlockRegion(job.regionOfInterest,
+                                            blockSize,
+                                            {widthInBlocksC, heightInBlockC},
+                                            getChromaSubsampling(frame->info.colorspace));
 
         if (result.averageUPerBlock.size() < totalNumberBlocksC)
             result.averageUPerBlock.resize(totalNumberBlocksC);
@@ -379,93 +1038,297 @@ void computeWeightedDCTEnergy(const Job &job,
         ALIGN_VAR_32(int16_t, pixelBufferC[32 * 32]);
         ALIGN_VAR_32(int16_t, coeffBufferC[32 * 32]);
 
-        auto blockIndexC      = 0u;
-        uint32_t frameU       = 0;
-        uint32_t frameV       = 0;
-        uint32_t frameEnergyU = 0;
-        uint32_t frameEnergyV = 0;
-        for (unsigned blockY = 0; blockY < heightInPixelsC; blockY += blockSize)
+        const BlockSampler samplerC(job, regionC);
+        unsigned nrSampledBlocksU = 0;
+        unsigned nrSampledBlocksV = 0;
+        uint32_t frameU           = 0;
+        uint32_t frameV           = 0;
+        uint32_t frameEnergyU     = 0;
+        uint32_t frameEnergyV     = 0;
+        for (auto blockY = regionC.top * blockSize; blockY < regionC.bottom * blockSize;
+             blockY += blockSize)
         {
             auto paddingBottom = std::max(int(blockY + blockSize) - int(srcUHeight), 0);
-            for (unsigned blockX = 0; blockX < widthInPixelsC; blockX += blockSize)
+            auto blockIndexC   = (blockY / blockSize) * widthInBlocksC + regionC.left;
+            for (auto blockX = regionC.left * blockSize; blockX < regionC.right * blockSize;
+                 blockX += blockSize)
             {
-                auto paddingRight = std::max(int(blockX + blockSize) - int(srcUStride), 0);
-                auto blockOffsetChromaBytes = blockX * bytesPerPixel + (blockY * srcUStride);
-
-                copyPixelValuesToBuffer(bitDepth,
-                                        blockOffsetChromaBytes,
-                                        blockSize,
-                                        srcU,
-                                        srcUStride,
-                                        pixelBufferC,
-                                        unsigned(paddingRight),
-                                        unsigned(paddingBottom));
+                if (!samplerC.isSampled(blockX / blockSize, blockY / blockSize))
+                {
+                    blockIndexC++;
+                    continue;
+                }
 
-                performDCT(blockSize,
-                           bitDepth,
-                           pixelBufferC,
-                           coeffBufferC,
-                           cpuSimd,
-                           enableLowpass);
+                auto paddingRight = std::max(int(blockX + blockSize) - int(srcUWidth), 0);
+                auto blockOffsetChromaBytes = blockX * bytesPerPixel + (blockY * srcUStride);
 
-                result.averageUPerBlock[blockIndexC] = uint32_t(sqrt(coeffBufferC[0]));
-                result.energyUPerBlock[blockIndexC]  = calculateWeightedCoeffSum(blockSize,
-                                                                                 coeffBufferC,
-                                                                                 enableLowpass);
+                BlockEnergy blockEnergy;
+                if (isStaticBlock(staticBlocks, 1, blockIndexC, result))
+                {
+                    const auto &reference = staticBlocks->referenceResult();
+                    blockEnergy = {reference.averageUPerBlock[blockIndexC],
+                                   reference.energyUPerBlock[blockIndexC]};
+                }
+                else
+                {
+                    copyPixelValuesToBuffer(bitDepth,
+                                            blockOffsetChromaBytes,
+                                            blockSize,
+                                            srcU,
+                                            srcUStride,
+                                            pixelBufferC,
+                                            unsigned(paddingRight),
+                                            unsigned(paddingBottom));
+
+                    const auto lowpassBlock = getHalfResolutionBlock(halfResolution,
+                                                                     1,
+                                                                     blockX,
+                                                                     blockY);
+                    blockEnergy = calculateBlockEnergy(blockSize,
+                                                       bitDepth,
+                                                       pixelBufferC,
+                                                       coeffBufferC,
+                                                       cpuSimd,
+                                                       true,
+                                                       enableLowpass,
+                                                       hadamardCalibration,
+                                                       flatBlockThreshold,
+                                                       lowpassBlock,
+                                                       decimationFactor,
+                                                       result);
+                }
+
+                result.averageUPerBlock[blockIndexC] = blockEnergy.brightness;
+                result.energyUPerBlock[blockIndexC]  = blockEnergy.energy;
                 frameU += result.averageUPerBlock[blockIndexC];
                 frameEnergyU += result.energyUPerBlock[blockIndexC];
+                nrSampledBlocksU++;
 
                 blockIndexC++;
             }
         }
-        result.averageU = uint32_t((double) (frameU) / totalNumberBlocksC);
-        result.energyU  = uint32_t((double) (frameEnergyU) / (totalNumberBlocksC * E_norm_factor));
+        result.averageU = uint32_t((double) (frameU) / nrSampledBlocksU);
+        result.energyU  = uint32_t((double) (frameEnergyU)
+                                    / (nrSampledBlocksU * E_norm_factor));
 
-        blockIndexC = 0u;
-        for (unsigned blockY = 0; blockY < heightInPixelsC; blockY += blockSize)
+        for (auto blockY = regionC.top * blockSize; blockY < regionC.bottom * blockSize;
+             blockY += blockSize)
         {
             auto paddingBottom = std::max(int(blockY + blockSize) - int(srcUHeight), 0);
-            for (unsigned blockX = 0; blockX < widthInPixelsC; blockX += blockSize)
+            auto blockIndexC   = (blockY / blockSize) * widthInBlocksC + regionC.left;
+            for (auto blockX = regionC.left * blockSize; blockX < regionC.right * blockSize;
+                 blockX += blockSize)
             {
-                auto paddingRight = std::max(int(blockX + blockSize) - int(srcUStride), 0);
+                if (!samplerC.isSampled(blockX / blockSize, blockY / blockSize))
+                {
+                    blockIndexC++;
+                    continue;
+                }
+
+                auto paddingRight = std::max(int(blockX + blockSize) - int(srcUWidth), 0);
                 auto blockOffsetChromaBytes = blockX * bytesPerPixel + (blockY * srcUStride);
 
+                BlockEnergy blockEnergy;
+                if (isStaticBlock(staticBlocks, 2, blockIndexC, result))
+                {
+                    const auto &reference = staticBlocks->referenceResult();
+                    blockEnergy = {reference.averageVPerBlock[blockIndexC],
+                                   reference.energyVPerBlock[blockIndexC]};
+                }
+                else
+                {
+                    copyPixelValuesToBuffer(bitDepth,
+                                            blockOffsetChromaBytes,
+                                            blockSize,
+                                            srcV,
+                                            srcUStride,
+                                            pixelBufferC,
+                                            unsigned(paddingRight),
+                                            unsigned(paddingBottom));
+
+                    const auto lowpassBlock = getHalfResolutionBlock(halfResolution,
+                                                                     2,
+                                                                     blockX,
+                                                                     blockY);
+                    blockEnergy = calculateBlockEnergy(blockSize,
+                                                       bitDepth,
+                                                       pixelBufferC,
+                                                       coeffBufferC,
+                                                       cpuSimd,
+                                                       true,
+                                                       enableLowpass,
+                                                       hadamardCalibration,
+                                                       flatBlockThreshold,
+                                                       lowpassBlock,
+                                                       decimationFactor,
+                                                       result);
+                }
+
+                result.averageVPerBlock[blockIndexC] = blockEnergy.brightness;
+                result.energyVPerBlock[blockIndexC]  = blockEnergy.energy;
+                frameV += result.averageVPerBlock[blockIndexC];
+                frameEnergyV += result.energyVPerBlock[blockIndexC];
+                nrSampledBlocksV++;
+
+                blockIndexC++;
+            }
+        }
+        result.averageV = uint32_t((double) (frameV) / nrSampledBlocksV);
+        result.energyV  = uint32_t((double) (frameEnergyV)
+                                    / (nrSampledBlocksV * E_norm_factor));
+    }
+}
+
+void computeShotDetectionEnergy(const Job &job,
+                                Result &result,
+                                const unsigned blockSize,
+                                CpuSimd cpuSimd,
+                                bool enableLowpass,
+                                std::vector<uint8_t> &downsampledLuma)
+{
+    const auto frame = job.frame;
+    if (frame == nullptr)
+        throw std::invalid_argument("Invalid frame pointer");
+    if (blockSize != 16 && blockSize != 32)
+        throw std::invalid_argument("Invalid block size " + std::to_string(blockSize));
+
+    const auto bitDepth      = frame->info.bitDepth;
+    const auto bytesPerPixel = (bitDepth > 8) ? 2u : 1u;
+
+    // Downsample the luma plane so that every block has 8x8 samples
+    const auto factor            = blockSize / 8;
+    const auto downsampledWidth  = (frame->info.width + factor - 1) / factor;
+    const auto downsampledHeight = (frame->info.height + factor - 1) / factor;
+    const auto downsampledStride = downsampledWidth * bytesPerPixel;
+    downsampledLuma.resize(downsampledStride * downsampledHeight);
+    decimatePlane(frame->planes[0],
+                  unsigned(frame->stride[0]),
+                  frame->info.width,
+                  frame->info.height,
+                  downsampledLuma.data(),
+                  downsampledStride,
+                  factor,
+                  bitDepth,
+                  cpuSimd);
+
+    auto [widthInBlocks, heightInBlock] = getFrameSizeInBlocks(blockSize, frame->info);
+    auto totalNumberBlocks              = widthInBlocks * heightInBlock;
+
+    const auto region = getBlockRegion(job.regionOfInterest,
+                                       blockSize,
+                                       {widthInBlocks, heightInBlock});
+    result.nrBlocksInRegion = region.getNrBlocks();
+    const auto decimationFactor = job.decimationFactor * job.largeBlockFactor;
+
+    if (result.brightnessPerBlock.size() < totalNumberBlocks)
+        result.brightnessPerBlock.resize(totalNumberBlocks);
+    if (result.energyPerBlock.size() < totalNumberBlocks)
+        result.energyPerBlock.resize(totalNumberBlocks);
+
+    const auto weightFactorMatrix = getWeightFactorMatrix(blockSize, decimationFactor);
+
+    ALIGN_VAR_32(int16_t, pixelBuffer[8 * 8]);
+    ALIGN_VAR_32(int16_t, coeffBuffer[8 * 8]);
+    ALIGN_VAR_32(int16_t, calibrationPixelBuffer[32 * 32]);
+    ALIGN_VAR_32(int16_t, calibrationCoeffBuffer[32 * 32]);
+
+    uint32_t frameBrightness  = 0;
+    uint64_t fullEnergySum    = 0;
+    uint64_t reducedEnergySum = 0;
+    for (auto y = region.top * 8; y < region.bottom * 8; y += 8)
+    {
+        const auto paddingBottom = 8 - std::min(8u, downsampledHeight - y);
+        auto blockIndex          = (y / 8) * widthInBlocks + region.left;
+        for (auto x = region.left * 8; x < region.right * 8; x += 8)
+        {
+            const auto paddingRight = 8 - std::min(8u, downsampledWidth - x);
+            copyPixelValuesToBuffer(bitDepth,
+                                    x * bytesPerPixel + y * downsampledStride,
+                                    8,
+                                    downsampledLuma.data(),
+                                    downsampledStride,
+                                    pixelBuffer,
+                                    paddingRight,
+                                    paddingBottom);
+
+            performDCT(8, bitDepth, pixelBuffer, coeffBuffer, cpuSimd, false);
+
+            uint32_t weightedSum = 0;
+            for (unsigned i = 1; i < 64; i++)
+            {
+                const auto weight = weightFactorMatrix.get(i % 8, i / 8);
+                weightedSum += uint32_t((weight * std::abs(coeffBuffer[i])) >> 8);
+            }
+
+            // Every downsampled sample is the mean of factor x factor samples of the block. The
+            // DC is calculated from the sum like for flat blocks in the full analysis, which
+            // also gives the DC of the lowpass DCT (with its scale for high bit depths).
+            const auto statistics = calculateBlockStatistics(pixelBuffer, 8 * 8, cpuSimd);
+            const auto dc         = calculateFlatBlockDC(blockSize,
+                                                         bitDepth,
+                                                         statistics.sum * int32_t(factor * factor),
+                                                         enableLowpass);
+
+            result.brightnessPerBlock[blockIndex] = uint32_t(sqrt(dc));
+            result.energyPerBlock[blockIndex]     = weightedSum;
+            frameBrightness += result.brightnessPerBlock[blockIndex];
+
+            if (isShotDetectionCalibrationBlock(x / 8, y / 8, region))
+            {
+                const auto blockX        = x * factor;
+                const auto blockY        = y * factor;
+                const auto blockPaddingX = blockSize
+                                           - std::min(blockSize, frame->info.width - blockX);
+                const auto blockPaddingY = blockSize
+                                           - std::min(blockSize, frame->info.height - blockY);
                 copyPixelValuesToBuffer(bitDepth,
-                                        blockOffsetChromaBytes,
+                                        blockX * bytesPerPixel + blockY * frame->stride[0],
                                         blockSize,
-                                        srcV,
-                                        srcUStride,
-                                        pixelBufferC,
-                                        unsigned(paddingRight),
-                                        unsigned(paddingBottom));
-
+                                        frame->planes[0],
+                                        frame->stride[0],
+                                        calibrationPixelBuffer,
+                                        blockPaddingX,
+                                        blockPaddingY);
                 performDCT(blockSize,
                            bitDepth,
-                           pixelBufferC,
-                           coeffBufferC,
+                           calibrationPixelBuffer,
+                           calibrationCoeffBuffer,
                            cpuSimd,
                            enableLowpass);
-
-                result.averageVPerBlock[blockIndexC] = uint32_t(sqrt(coeffBufferC[0]));
-                result.energyVPerBlock[blockIndexC]  = calculateWeightedCoeffSum(blockSize,
-                                                                                coeffBufferC,
-                                                                                enableLowpass);
-                frameV += result.averageVPerBlock[blockIndexC];
-                frameEnergyV += result.energyVPerBlock[blockIndexC];
-
-                blockIndexC++;
+                fullEnergySum += calculateWeightedCoeffSum(blockSize,
+                                                           calibrationCoeffBuffer,
+                                                           enableLowpass,
+                                                           decimationFactor);
+                reducedEnergySum += weightedSum;
             }
+
+            blockIndex++;
         }
-        result.averageV = uint32_t((double) (frameV) / totalNumberBlocksC);
-        result.energyV  = uint32_t((double) (frameEnergyV) / (totalNumberBlocksC * E_norm_factor));
     }
+
+    // The scale depends on the calibration blocks of the whole frame, so it is applied to the
+    // energy of the blocks afterwards
+    const auto energyScale = getShotDetectionEnergyScale(fullEnergySum, reducedEnergySum);
+    uint32_t frameTexture  = 0;
+    for (auto y = region.top; y < region.bottom; y++)
+        for (auto x = region.left; x < region.right; x++)
+        {
+            auto &energy = result.energyPerBlock[y * widthInBlocks + x];
+            energy       = uint32_t(energy * energyScale);
+            frameTexture += energy;
+        }
+
+    result.averageBrightness = uint32_t((double) (frameBrightness) / region.getNrBlocks());
+    result.averageEnergy     = uint32_t((double) (frameTexture)
+                                     / (region.getNrBlocks() * E_norm_factor));
 }
 
 void computeEdgeDensity(const Job &job,
                         Result &result,
                         const unsigned blockSize,
                         CpuSimd cpuSimd,
-                        bool enableLowpass)
+                        bool enableLowpass,
+                        const StaticBlocks *staticBlocks)
 {
     const auto frame = job.frame;
     if (frame == nullptr)
@@ -479,8 +1342,11 @@ void computeEdgeDensity(const Job &job,
 
     auto [widthInBlocks, heightInBlock] = getFrameSizeInBlocks(blockSize, frame->info);
     auto totalNumberBlocks              = widthInBlocks * heightInBlock;
-    auto widthInPixels                  = widthInBlocks * blockSize;
-    auto heightInPixels                 = heightInBlock * blockSize;
+
+    const auto region = getBlockRegion(job.regionOfInterest,
+                                       blockSize,
+                                       {widthInBlocks, heightInBlock});
+    result.nrBlocksInRegion = region.getNrBlocks();
 
         if (result.edgeDensityPerBlock.size() < totalNumberBlocks)
         result.edgeDensityPerBlock.resize(totalNumberBlocks);
@@ -493,37 +1359,209 @@ void computeEdgeDensity(const Job &job,
 
     ALIGN_VAR_32(int16_t, pixelBuffer[32 * 32]);
 
-    auto blockIndex     = 0u;
+    const auto edgeThreshold = unsigned(getEdgeDensityThreshold(bitDepth));
+
+    StageTimer timer(result.stageTimes, vca_stage::EdgeDensity);
+    const BlockSampler sampler(job, region);
+    SampleStatistics edgeDensityStatistics;
     double frameEdgeDensity = 0;
-    for (unsigned blockY = 0; blockY < heightInPixels; blockY += blockSize)
+    for (auto blockY = region.top * blockSize; blockY < region.bottom * blockSize;
+         blockY += blockSize)
     {
         auto paddingBottom = std::max(int(blockY + blockSize) - int(frame->info.height), 0);
-        for (unsigned blockX = 0; blockX < widthInPixels; blockX += blockSize)
+        auto blockIndex    = (blockY / blockSize) * widthInBlocks + region.left;
+        for (auto blockX = region.left * blockSize; blockX < region.right * blockSize;
+             blockX += blockSize)
         {
+            if (!sampler.isSampled(blockX / blockSize, blockY / blockSize))
+            {
+                blockIndex++;
+                continue;
+            }
+
             auto paddingRight = std::max(int(blockX + blockSize) - int(frame->info.width), 0);
             auto blockOffsetLumaBytes = blockX * bytesPerPixel + (blockY * srcStride);
 
-            copyPixelValuesToBuffer(bitDepth,
-                                    blockOffsetLumaBytes,
-                                    blockSize,
-                                    src,
-                                    srcStride,
-                                    pixelBuffer,
-                                    unsigned(paddingRight),
-                                    unsigned(paddingBottom));
-
-            result.edgeDensityPerBlock[blockIndex] = performEdgeDensity(blockSize,
-                                                                        bitDepth,
-                                                                        pixelBuffer,
-                                                                        cpuSimd,
-                                                                        enableLowpass);
+            if (isStaticBlock(staticBlocks, 0, blockIndex, result))
+                result.edgeDensityPerBlock[blockIndex] = staticBlocks->referenceResult()
+                                                             .edgeDensityPerBlock[blockIndex];
+            else
+            {
+                copyPixelValuesToBuffer(bitDepth,
+                                        blockOffsetLumaBytes,
+                                        blockSize,
+                                        src,
+                                        srcStride,
+                                        pixelBuffer,
+                                        unsigned(paddingRight),
+                                        unsigned(paddingBottom));
+
+                // Only neighboring samples that differ by more than the edge threshold count
+                // as edges. If the range of the block is below that, there are no edges.
+                result.nrAnalyzedBlocks++;
+                const auto statistics = calculateBlockStatistics(pixelBuffer,
+                                                                 blockSize * blockSize,
+                                                                 cpuSimd);
+                if (statistics.range() <= edgeThreshold)
+                {
+                    result.nrSkippedBlocks++;
+                    result.edgeDensityPerBlock[blockIndex] = 0.0;
+                }
+                else
+                    result.edgeDensityPerBlock[blockIndex] = performEdgeDensity(blockSize,
+                                                                                bitDepth,
+                                                                                pixelBuffer,
+                                                                                cpuSimd,
+                                                                                enableLowpass);
+            }
             frameEdgeDensity += result.edgeDensityPerBlock[blockIndex];
+            edgeDensityStatistics.add(result.edgeDensityPerBlock[blockIndex]);
             blockIndex++;
         }
     }
 
-    result.averageEdgeDensity = frameEdgeDensity / totalNumberBlocks;
+    result.averageEdgeDensity           = frameEdgeDensity / edgeDensityStatistics.getCount();
+    result.averageEdgeDensityConfidence = edgeDensityStatistics.getConfidence(
+        region.getNrBlocks());
+
+}
+
+namespace {
+
+// The ratio of the energy of a block of 2 * blockSize samples and the mean energy of its
+// four blocks of blockSize samples on generated content. The lowpass DCT of the larger
+// block sizes doubles the weighted sum, so the scale is higher with lowpass. It is calibrated
+// when a configuration is used for the first time.
+double getBlockGridEnergyScaleStep(unsigned blockSize,
+                                   unsigned decimationFactor,
+                                   bool enableLowpass)
+{
+    constexpr unsigned nrConfigurations = 2 * 3 * 2;
+    static std::array<std::once_flag, nrConfigurations> calibrated;
+    static std::array<double, nrConfigurations> scales;
+
+    const auto sizeIndex   = blockSize == 8 ? 0u : 1u;
+    const auto factorIndex = decimationFactor == 1 ? 0u : (decimationFactor == 2 ? 1u : 2u);
+    const auto index       = (sizeIndex * 3 + factorIndex) * 2 + unsigned(enableLowpass);
+    std::call_once(calibrated[index], [&]() {
+        const auto gridBlockSize = blockSize * 2;
+        scales[index] = calibrateOnGeneratedContent(gridBlockSize, [&](const uint8_t *samples) {
+            const auto gridEnergy = calculateGeneratedBlockEnergy(samples,
+                                                                  gridBlockSize,
+                                                                  gridBlockSize,
+                                                                  decimationFactor,
+                                                                  enableLowpass);
+            double blockEnergy = 0;
+            for (unsigned y = 0; y < gridBlockSize; y += blockSize)
+                for (unsigned x = 0; x < gridBlockSize; x += blockSize)
+                    blockEnergy += calculateGeneratedBlockEnergy(samples + y * gridBlockSize + x,
+                                                                 gridBlockSize,
+                                                                 blockSize,
+                                                                 decimationFactor,
+                                                                 enableLowpass)
+                                   / 4;
+            return std::make_pair(gridEnergy, blockEnergy);
+        });
+    });
+    return scales[index];
+}
+
+double getBlockGridEnergyScale(unsigned blockSize,
+                               unsigned gridBlockSize,
+                               unsigned decimationFactor,
+                               bool enableLowpass)
+{
+    auto scale = 1.0;
+    for (auto size = blockSize; size < gridBlockSize; size *= 2)
+        scale *= getBlockGridEnergyScaleStep(size, decimationFactor, enableLowpass);
+    return scale;
+}
+
+} // namespace
+
+void computeBlockGrid(const Job &job,
+                      const Result &result,
+                      unsigned blockSize,
+                      unsigned gridBlockSize,
+                      bool enableLowpass,
+                      BlockGridResult &grid)
+{
+    const auto &info         = job.frame->info;
+    const auto ratio         = gridBlockSize / blockSize;
+    const auto sizeInBlocks  = getFrameSizeInBlocks(blockSize, info);
+    const auto widthInBlocks = sizeInBlocks.first;
+    const auto [gridWidthInBlocks, gridHeightInBlocks] = getFrameSizeInBlocks(gridBlockSize,
+                                                                              info);
+    const auto region     = getBlockRegion(job.regionOfInterest, blockSize, sizeInBlocks);
+    const auto gridRegion = getBlockRegion(job.regionOfInterest,
+                                           gridBlockSize,
+                                           {gridWidthInBlocks, gridHeightInBlocks});
+    const auto energyScale = getBlockGridEnergyScale(blockSize,
+                                                     gridBlockSize,
+                                                     job.decimationFactor,
+                                                     enableLowpass);
+
+    const auto hasEnergy      = !result.energyPerBlock.empty();
+    const auto hasEdgeDensity = !result.edgeDensityPerBlock.empty();
+    const auto nrGridBlocks   = gridWidthInBlocks * gridHeightInBlocks;
+    grid.blockSize            = gridBlockSize;
+    grid.brightnessPerBlock.assign(hasEnergy ? nrGridBlocks : 0, 0);
+    grid.energyPerBlock.assign(hasEnergy ? nrGridBlocks : 0, 0);
+    grid.edgeDensityPerBlock.assign(hasEdgeDensity ? nrGridBlocks : 0, 0.0);
+
+    uint64_t frameBrightness = 0;
+    uint64_t frameEnergy     = 0;
+    double frameEdgeDensity  = 0;
+    for (auto gridY = gridRegion.top; gridY < gridRegion.bottom; gridY++)
+    {
+        for (auto gridX = gridRegion.left; gridX < gridRegion.right; gridX++)
+        {
+            // The analyzed blocks that are covered by this block of the grid
+            const auto left   = std::max(gridX * ratio, region.left);
+            const auto top    = std::max(gridY * ratio, region.top);
+            const auto right  = std::min((gridX + 1) * ratio, region.right);
+            const auto bottom = std::min((gridY + 1) * ratio, region.bottom);
+            const auto nrBlocks = (right - left) * (bottom - top);
+
+            uint64_t dc        = 0;
+            uint64_t energy    = 0;
+            double edgeDensity = 0;
+            for (auto y = top; y < bottom; y++)
+                for (auto x = left; x < right; x++)
+                {
+                    const auto blockIndex = y * widthInBlocks + x;
+                    if (hasEnergy)
+                    {
+                        // The brightness is the root of the DC, so the DC is in [b^2, (b+1)^2)
+                        const uint64_t brightness = result.brightnessPerBlock[blockIndex];
+                        dc += brightness * brightness + brightness;
+                        energy += result.energyPerBlock[blockIndex];
+                    }
+                    if (hasEdgeDensity)
+                        edgeDensity += result.edgeDensityPerBlock[blockIndex];
+                }
+
+            const auto gridIndex = gridY * gridWidthInBlocks + gridX;
+            if (hasEnergy)
+            {
+                grid.brightnessPerBlock[gridIndex] = uint32_t(sqrt(double(dc) / nrBlocks));
+                grid.energyPerBlock[gridIndex]     = uint32_t(double(energy) / nrBlocks
+                                                              * energyScale);
+                frameBrightness += grid.brightnessPerBlock[gridIndex];
+                frameEnergy += grid.energyPerBlock[gridIndex];
+            }
+            if (hasEdgeDensity)
+            {
+                grid.edgeDensityPerBlock[gridIndex] = edgeDensity / nrBlocks;
+                frameEdgeDensity += grid.edgeDensityPerBlock[gridIndex];
+            }
+        }
+    }
 
+    const auto nrBlocksInRegion = gridRegion.getNrBlocks();
+    grid.averageBrightness = uint32_t(double(frameBrightness) / nrBlocksInRegion);
+    grid.averageEnergy     = uint32_t(double(frameEnergy) / (nrBlocksInRegion * E_norm_factor));
+    grid.averageEdgeDensity = frameEdgeDensity / nrBlocksInRegion;
 }
 
 void computeEntropy(const Job &job,
@@ -531,7 +1569,10 @@ void computeEntropy(const Job &job,
                     const unsigned blockSize,
                     CpuSimd cpuSimd,
                     bool enableLowpass,
-                    bool enableChroma)
+                    bool enableChroma,
+                    unsigned flatBlockThreshold,
+                    const StaticBlocks *staticBlocks,
+                    const HalfResolutionFrame *halfResolution)
 {
     const auto frame = job.frame;
     if (frame == nullptr)
@@ -545,8 +1586,11 @@ void computeEntropy(const Job &job,
 
     auto [widthInBlocks, heightInBlock] = getFrameSizeInBlocks(blockSize, frame->info);
     auto totalNumberBlocks              = widthInBlocks * heightInBlock;
-    auto widthInPixels                  = widthInBlocks * blockSize;
-    auto heightInPixels                 = heightInBlock * blockSize;
+
+    const auto region = getBlockRegion(job.regionOfInterest,
+                                       blockSize,
+                                       {widthInBlocks, heightInBlock});
+    result.nrBlocksInRegion = region.getNrBlocks();
 
     if (result.entropyPerBlock.size() < totalNumberBlocks)
         result.entropyPerBlock.resize(totalNumberBlocks);
@@ -559,39 +1603,68 @@ void computeEntropy(const Job &job,
 
     ALIGN_VAR_32(int16_t, pixelBuffer[32 * 32]);
 
-    auto blockIndex          = 0u;
-    double frameEntropy    = 0;
-    for (unsigned blockY = 0; blockY < heightInPixels; blockY += blockSize)
+    const BlockSampler sampler(job, region);
+    SampleStatistics entropyStatistics;
+    double frameEntropy = 0;
     {
-        auto paddingBottom = std::max(int(blockY + blockSize) - int(frame->info.height), 0);
-        for (unsigned blockX = 0; blockX < widthInPixels; blockX += blockSize)
+        BlockLoopTimer loopTimer(result.stageTimes);
+        for (auto blockY = region.top * blockSize; blockY < region.bottom * blockSize;
+             blockY += blockSize)
         {
-            auto paddingRight = std::max(int(blockX + blockSize) - int(frame->info.width), 0);
-            auto blockOffsetLumaBytes = blockX * bytesPerPixel + (blockY * srcStride);
-
-            copyPixelValuesToBuffer(bitDepth,
-                                    blockOffsetLumaBytes,
-                                    blockSize,
-                                    src,
-                                    srcStride,
-                                    pixelBuffer,
-                                    unsigned(paddingRight),
-                                    unsigned(paddingBottom));
-
-            result.entropyPerBlock[blockIndex] = performEntropy(blockSize,
-                                                                bitDepth,
-                                                                pixelBuffer,
-                                                                cpuSimd,
-                                                                enableLowpass);
-            frameEntropy += result.entropyPerBlock[blockIndex];
-            blockIndex++;
+            auto paddingBottom = std::max(int(blockY + blockSize) - int(frame->info.height), 0);
+            auto blockIndex    = (blockY / blockSize) * widthInBlocks + region.left;
+            for (auto blockX = region.left * blockSize; blockX < region.right * blockSize;
+                 blockX += blockSize)
+            {
+                if (!sampler.isSampled(blockX / blockSize, blockY / blockSize))
+                {
+                    blockIndex++;
+                    continue;
+                }
+
+                auto paddingRight = std::max(int(blockX + blockSize) - int(frame->info.width), 0);
+                auto blockOffsetLumaBytes = blockX * bytesPerPixel + (blockY * srcStride);
+
+                if (isStaticBlock(staticBlocks, 0, blockIndex, result))
+                    result.entropyPerBlock[blockIndex] = staticBlocks->referenceResult()
+                                                             .entropyPerBlock[blockIndex];
+                else
+                {
+                    copyPixelValuesToBuffer(bitDepth,
+                                            blockOffsetLumaBytes,
+                                            blockSize,
+                                            src,
+                                            srcStride,
+                                            pixelBuffer,
+                                            unsigned(paddingRight),
+                                            unsigned(paddingBottom));
+                    const auto lowpassBlock = getHalfResolutionBlock(halfResolution,
+                                                                     0,
+                                                                     blockX,
+                                                                     blockY);
+                    result.entropyPerBlock[blockIndex] = calculateBlockEntropy(blockSize,
+                                                                               bitDepth,
+                                                                               pixelBuffer,
+                                                                               cpuSimd,
+                                                                               enableLowpass,
+                                                                               flatBlockThreshold,
+                                                                               lowpassBlock,
+                                                                               result);
+                }
+                frameEntropy += result.entropyPerBlock[blockIndex];
+                entropyStatistics.add(result.entropyPerBlock[blockIndex]);
+                blockIndex++;
+            }
         }
     }
 
-    result.entropyY = frameEntropy / totalNumberBlocks;
+    result.entropyY          = frameEntropy / entropyStatistics.getCount();
+    result.entropyConfidence = entropyStatistics.getConfidence(region.getNrBlocks());
 
     if (enableChroma)
     {
+        StageTimer chromaTimer(result.stageTimes, vca_stage::Chroma);
+
         const auto srcU       = frame->planes[1];
         const auto srcV       = frame->planes[2];
         const auto srcUStride = frame->stride[1];
@@ -602,8 +1675,11 @@ void computeEntropy(const Job &job,
                                                                            srcUWidth,
                                                                            srcUHeight);
         const auto totalNumberBlocksC         = widthInBlocksC * heightInBlockC;
-        const auto widthInPixelsC             = widthInBlocksC * blockSize;
-        const auto heightInPixelsC            = heightInBlockC * blockSize;
+
+        const auto regionC = getBlockRegion(job.regionOfInterest,
+                                            blockSize,
+                                            {widthInBlocksC, heightInBlockC},
+                                            getChromaSubsampling(frame->info.colorspace));
 
         if (result.entropyUPerBlock.size() < totalNumberBlocksC)
             result.entropyUPerBlock.resize(totalNumberBlocksC);
@@ -612,70 +1688,114 @@ void computeEntropy(const Job &job,
 
         ALIGN_VAR_32(int16_t, pixelBufferC[32 * 32]);
 
-        auto blockIndexC      = 0u;
-        uint32_t frameU       = 0;
-        uint32_t frameV       = 0;
-        double frameEntropyU  = 0;
-        double frameEntropyV  = 0;
-        for (unsigned blockY = 0; blockY < heightInPixelsC; blockY += blockSize)
+        const BlockSampler samplerC(job, regionC);
+        unsigned nrSampledBlocksU = 0;
+        unsigned nrSampledBlocksV = 0;
+        double frameEntropyU      = 0;
+        double frameEntropyV      = 0;
+        for (auto blockY = regionC.top * blockSize; blockY < regionC.bottom * blockSize;
+             blockY += blockSize)
         {
             auto paddingBottom = std::max(int(blockY + blockSize) - int(srcUHeight), 0);
-            for (unsigned blockX = 0; blockX < widthInPixelsC; blockX += blockSize)
+            auto blockIndexC   = (blockY / blockSize) * widthInBlocksC + regionC.left;
+            for (auto blockX = regionC.left * blockSize; blockX < regionC.right * blockSize;
+                 blockX += blockSize)
             {
-                auto paddingRight = std::max(int(blockX + blockSize) - int(srcUStride), 0);
+                if (!samplerC.isSampled(blockX / blockSize, blockY / blockSize))
+                {
+                    blockIndexC++;
+                    continue;
+                }
+
+                auto paddingRight = std::max(int(blockX + blockSize) - int(srcUWidth), 0);
                 auto blockOffsetChromaBytes = blockX * bytesPerPixel + (blockY * srcUStride);
 
-                copyPixelValuesToBuffer(bitDepth,
-                                        blockOffsetChromaBytes,
-                                        blockSize,
-                                        srcU,
-                                        srcUStride,
-                                        pixelBufferC,
-                                        unsigned(paddingRight),
-                                        unsigned(paddingBottom));
-                result.entropyUPerBlock[blockIndexC] = performEntropy(blockSize,
-                                                                      bitDepth,
-                                                                      pixelBufferC,
-                                                                      cpuSimd,
-                                                                      enableLowpass);
+                if (isStaticBlock(staticBlocks, 1, blockIndexC, result))
+                    result.entropyUPerBlock[blockIndexC] = staticBlocks->referenceResult()
+                                                               .entropyUPerBlock[blockIndexC];
+                else
+                {
+                    copyPixelValuesToBuffer(bitDepth,
+                                            blockOffsetChromaBytes,
+                                            blockSize,
+                                            srcU,
+                                            srcUStride,
+                                            pixelBufferC,
+                                            unsigned(paddingRight),
+                                            unsigned(paddingBottom));
+                    const auto lowpassBlock = getHalfResolutionBlock(halfResolution,
+                                                                     1,
+                                                                     blockX,
+                                                                     blockY);
+                    result.entropyUPerBlock[blockIndexC] = calculateBlockEntropy(blockSize,
+                                                                                 bitDepth,
+                                                                                 pixelBufferC,
+                                                                                 cpuSimd,
+                                                                                 enableLowpass,
+                                                                                 flatBlockThreshold,
+                                                                                 lowpassBlock,
+                                                                                 result);
+                }
 
                 frameEntropyU += result.entropyUPerBlock[blockIndexC];
+                nrSampledBlocksU++;
 
                 blockIndexC++;
             }
         }
-        result.entropyU  = frameEntropyU / totalNumberBlocksC;
+        result.entropyU = frameEntropyU / nrSampledBlocksU;
 
-        blockIndexC = 0u;
-        for (unsigned blockY = 0; blockY < heightInPixelsC; blockY += blockSize)
+        for (auto blockY = regionC.top * blockSize; blockY < regionC.bottom * blockSize;
+             blockY += blockSize)
         {
             auto paddingBottom = std::max(int(blockY + blockSize) - int(srcUHeight), 0);
-            for (unsigned blockX = 0; blockX < widthInPixelsC; blockX += blockSize)
+            auto blockIndexC   = (blockY / blockSize) * widthInBlocksC + regionC.left;
+            for (auto blockX = regionC.left * blockSize; blockX < regionC.right * blockSize;
+                 blockX += blockSize)
             {
-                auto paddingRight = std::max(int(blockX + blockSize) - int(srcUStride), 0);
-                auto blockOffsetChromaBytes = blockX * bytesPerPixel + (blockY * srcUStride);
+                if (!samplerC.isSampled(blockX / blockSize, blockY / blockSize))
+                {
+                    blockIndexC++;
+                    continue;
+                }
 
-                copyPixelValuesToBuffer(bitDepth,
-                                        blockOffsetChromaBytes,
-                                        blockSize,
-                                        srcV,
-                                        srcUStride,
-                                        pixelBufferC,
-                                        unsigned(paddingRight),
-                                        unsigned(paddingBottom));
+                auto paddingRight = std::max(int(blockX + blockSize) - int(srcUWidth), 0);
+                auto blockOffsetChromaBytes = blockX * bytesPerPixel + (blockY * srcUStride);
 
-                result.entropyVPerBlock[blockIndexC] = performEntropy(blockSize,
-                                                                      bitDepth,
-                                                                      pixelBufferC,
-                                                                      cpuSimd,
-                                                                      enableLowpass);
+                if (isStaticBlock(staticBlocks, 2, blockIndexC, result))
+                    result.entropyVPerBlock[blockIndexC] = staticBlocks->referenceResult()
+                                                               .entropyVPerBlock[blockIndexC];
+                else
+                {
+                    copyPixelValuesToBuffer(bitDepth,
+                                            blockOffsetChromaBytes,
+                                            blockSize,
+                                            srcV,
+                                            srcUStride,
+                                            pixelBufferC,
+                                            unsigned(paddingRight),
+                                            unsigned(paddingBottom));
+                    const auto lowpassBlock = getHalfResolutionBlock(halfResolution,
+                                                                     2,
+                                                                     blockX,
+                                                                     blockY);
+                    result.entropyVPerBlock[blockIndexC] = calculateBlockEntropy(blockSize,
+                                                                                 bitDepth,
+                                                                                 pixelBufferC,
+                                                                                 cpuSimd,
+                                                                                 enableLowpass,
+                                                                                 flatBlockThreshold,
+                                                                                 lowpassBlock,
+                                                                                 result);
+                }
 
                 frameEntropyV += result.entropyVPerBlock[blockIndexC];
+                nrSampledBlocksV++;
 
                 blockIndexC++;
             }
         }
-        result.entropyV = frameEntropyV / totalNumberBlocksC;
+        result.entropyV = frameEntropyV / nrSampledBlocksV;
     }
 
 }
@@ -697,7 +1817,7 @@ void computeTextureSAD(Result &result, const Result &resultsPreviousFrame)
         textureSad += result.energyDiffPerBlock[i];
     }
 
-    result.energyDiff = textureSad / (totalNumberBlocks * h_norm_factor);
+    result.energyDiff = textureSad / (result.nrBlocksInRegion * h_norm_factor);
 }
 
 void computeEntropySAD(Result &result, const Result &resultsPreviousFrame)
@@ -717,7 +1837,7 @@ void computeEntropySAD(Result &result, const Result &resultsPreviousFrame)
         entropyDiff += result.entropyDiffPerBlock[i];
     }
 
-    result.entropyDiff = entropyDiff / totalNumberBlocks;
+    result.entropyDiff = entropyDiff / result.nrBlocksInRegion;
 }
 
 void computeTextureEpsilon(Result& result, const Result& resultsPreviousFrame)
@@ -737,7 +1857,7 @@ void computeTextureEpsilon(Result& result, const Result& resultsPreviousFrame)
         textureEpsilon += result.energyEpsilonPerBlock[i];
     }
 
-    result.energyEpsilon = textureEpsilon / (totalNumberBlocks * h_norm_factor);
+    result.energyEpsilon = textureEpsilon / (result.nrBlocksInRegion * h_norm_factor);
 
 }
 
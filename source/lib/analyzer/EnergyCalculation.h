@@ -20,16 +20,55 @@
 
 #pragma once
 
+#include <analyzer/BlockCache.h>
+#include <analyzer/Decimation.h>
 #include <analyzer/common/common.h>
 
 namespace vca {
 
+// Copy a block of samples of one plane to buffer (blockSize * blockSize values). Samples
+// right of or below the plane (paddingRight / paddingBottom) repeat the last valid sample.
+void copyPixelValuesToBuffer(unsigned bitDepth,
+                             unsigned blockOffsetBytes,
+                             unsigned blockSize,
+                             uint8_t *srcData,
+                             unsigned srcStrideBytes,
+                             int16_t *buffer,
+                             unsigned paddingRight,
+                             unsigned paddingBottom);
+
+// The sum of the absolute DCT coefficients of a block weighted by the frequency
+uint32_t calculateWeightedCoeffSum(unsigned blockSize,
+                                   int16_t *coeffBuffer,
+                                   bool enableLowpassDCT,
+                                   unsigned decimationFactor = 1);
+
+// If enableLowpass is set, the downsampled blocks for the lowpass DCT and entropy are read
+// from halfResolution. If it is nullptr, every block is downsampled separately. If
+// enableHadamard is set, the energy is estimated with the Walsh-Hadamard transform (of the
+// downsampled block with the lowpass DCT). If enableEnergy is not set, only the brightness
+// of the luma blocks is calculated (from the sum of the samples) and the energy is 0.
 void computeWeightedDCTEnergy(const Job &job,
                               Result &result,
                               const unsigned blockSize,
                               CpuSimd cpuSimd,
+                              bool enableEnergy,
                               bool enableChroma,
-                              bool enableLowpass);
+                              bool enableLowpass,
+                              bool enableHadamard,
+                              unsigned flatBlockThreshold,
+                              const StaticBlocks *staticBlocks,
+                              const HalfResolutionFrame *halfResolution);
+// The brightness and energy for the shot detection only mode (block size 16 or 32). The luma
+// plane is downsampled into downsampledLuma so that every block has 8x8 samples, which are
+// transformed with the 8x8 DCT. The energy is scaled to the full DCT energy (with or without
+// enableLowpass) of a subset of the blocks.
+void computeShotDetectionEnergy(const Job &job,
+                                Result &result,
+                                const unsigned blockSize,
+                                CpuSimd cpuSimd,
+                                bool enableLowpass,
+                                std::vector<uint8_t> &downsampledLuma);
 void computeTextureSAD(Result &results, const Result &resultsPreviousFrame);
 void computeTextureEpsilon(Result &results, const Result &resultsPreviousFrame);
 void computeEntropy(const Job &job,
@@ -37,12 +76,29 @@ void computeEntropy(const Job &job,
                     const unsigned blockSize,
                     CpuSimd cpuSimd,
                     bool enableLowpass,
-                    bool enableChroma);
+                    bool enableChroma,
+                    unsigned flatBlockThreshold,
+                    const StaticBlocks *staticBlocks,
+                    const HalfResolutionFrame *halfResolution);
 void computeEntropySAD(Result &results, const Result &resultsPreviousFrame);
+
 void computeEdgeDensity(const Job &job,
                         Result &result,
                         const unsigned blockSize,
                         CpuSimd cpuSimd,
-                        bool enableLowpass);
+                        bool enableLowpass,
+                        const StaticBlocks *staticBlocks);
+
+// Derive the results on the grid of gridBlockSize from the per block results of blockSize.
+// The brightness is the root of the mean DC, the edge density is the mean of the contained
+// blocks. The energy is the mean energy of the contained blocks times a scale factor that
+// was measured on natural content (it depends on enableLowpass because the lowpass DCT is
+// used for the larger block sizes).
+void computeBlockGrid(const Job &job,
+                      const Result &result,
+                      unsigned blockSize,
+                      unsigned gridBlockSize,
+                      bool enableLowpass,
+                      BlockGridResult &grid);
 
 } // namespace vca
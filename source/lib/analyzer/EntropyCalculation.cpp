@@ -27,61 +27,59 @@
 
 namespace vca {
 
+namespace {
+
+double calculateEntropy(const int16_t *block, unsigned nrSamples, CpuSimd cpuSimd)
+{
+#ifdef WIN32
+    if (cpuSimd == CpuSimd::AVX2)
+        return entropy_avx2(block, nrSamples);
+#else
+    (void) cpuSimd;
+#endif
+    return vca::entropy_c(block, nrSamples);
+}
+
+} // namespace
+
 double performEntropy(const unsigned blockSize,
                       const unsigned bitDepth,
                       const int16_t *pixelBuffer,
                       CpuSimd cpuSimd,
                       bool enableLowpass)
 {
-    std::vector<int16_t> block(blockSize * blockSize);
+    if (!enableLowpass)
+        return calculateEntropy(pixelBuffer, blockSize * blockSize, cpuSimd);
 
-    // Copy pixels from pixelBuffer to block
-    for (uint32_t i = 0; i < blockSize; ++i)
+    // Downscale the block by averaging 2x2 blocks of pixels into a single pixel
+    ALIGN_VAR_32(int16_t, downscaledBlock[16 * 16]);
+    const auto downscaledWidth = blockSize >> 1;
+    for (uint32_t i = 0; i < blockSize; i += 2)
     {
-        for (uint32_t j = 0; j < blockSize; ++j)
+        for (uint32_t j = 0; j < blockSize; j += 2)
         {
-            block[i * blockSize + j] = pixelBuffer[i * blockSize + j];
+            // Compute average pixel value of 2x2 block
+            int sum = pixelBuffer[i * blockSize + j] + pixelBuffer[i * blockSize + j + 1]
+                      + pixelBuffer[(i + 1) * blockSize + j]
+                      + pixelBuffer[(i + 1) * blockSize + j + 1];
+            downscaledBlock[(i / 2) * downscaledWidth + (j / 2)] = static_cast<int16_t>(sum >> 2);
         }
     }
+    return calculateEntropy(downscaledBlock, downscaledWidth * downscaledWidth, cpuSimd);
+}
 
-    double entropy    = 0;
-    // Calculate entropy
-    if (enableLowpass)
-    {
-        // Downscale the block by averaging 2x2 blocks of pixels into a single pixel
-        int downscaledWidth = blockSize >> 1;
-        std::vector<int16_t> downscaledBlock(downscaledWidth * downscaledWidth, 0);
-
-        for (uint32_t i = 0; i < blockSize; i += 2)
-        {
-            for (uint32_t j = 0; j < blockSize; j += 2)
-            {
-                // Compute average pixel value of 2x2 block
-                int sum = block[i * blockSize + j] + block[i * blockSize + j + 1]
-                              + block[(i + 1) * blockSize + j] + block[(i + 1) * blockSize + j + 1];
-                int16_t averagePixel = static_cast<int16_t>(sum >> 2);
-
-                // Store the average pixel value in the downscaled block
-                downscaledBlock[(i / 2) * downscaledWidth + (j / 2)] = averagePixel;
-            }
-        }
-#ifdef WIN32
-        if (cpuSimd == CpuSimd::AVX2)
-            entropy = entropy_avx2(downscaledBlock);
-        else
-#endif
-            entropy = vca::entropy_c(downscaledBlock);
-    }
-    else 
-    {
-#ifdef WIN32
-        if (cpuSimd == CpuSimd::AVX2)
-            entropy = entropy_avx2(block);
-        else
-#endif
-            entropy = vca::entropy_c(block);
-    }
-    return entropy;
+double performLowpassEntropy(const unsigned blockSize,
+                             const int16_t *halfResolutionBlock,
+                             unsigned halfResolutionStride,
+                             CpuSimd cpuSimd)
+{
+    ALIGN_VAR_32(int16_t, downscaledBlock[16 * 16]);
+    const auto downscaledWidth = blockSize >> 1;
+    for (unsigned i = 0; i < downscaledWidth; i++)
+        std::memcpy(&downscaledBlock[i * downscaledWidth],
+                    halfResolutionBlock + i * halfResolutionStride,
+                    downscaledWidth * sizeof(int16_t));
+    return calculateEntropy(downscaledBlock, downscaledWidth * downscaledWidth, cpuSimd);
 }
 
 double performEdgeDensity(const unsigned blockSize,
@@ -94,7 +92,7 @@ double performEdgeDensity(const unsigned blockSize,
     unsigned blockSizeSq = blockSize * blockSize;
 
     // Threshold for edge detection based on bit depth
-    int threshold = (1 << (bitDepth - 1)) - 1;
+    int threshold = getEdgeDensityThreshold(bitDepth);
 
     // Initialize edge count to 0
     unsigned edgeCount = 0;
@@ -31,6 +31,19 @@ double performEntropy(const unsigned blockSize,
                       CpuSimd cpuSimd,
                       bool enableLowpass);
 
+// The lowpass entropy of a block (like performEntropy with enableLowpass) from the block in
+// a plane that was downsampled by 2 (see HalfResolutionFrame).
+double performLowpassEntropy(const unsigned blockSize,
+                             const int16_t *halfResolutionBlock,
+                             unsigned halfResolutionStride,
+                             CpuSimd cpuSimd);
+
+// Neighboring samples that differ by more than this value are counted as an edge
+inline int getEdgeDensityThreshold(const unsigned bitDepth)
+{
+    return (1 << (bitDepth - 1)) - 1;
+}
+
 double performEdgeDensity(const unsigned blockSize,
                           const unsigned bitDepth,
                           const int16_t *pixelBuffer,
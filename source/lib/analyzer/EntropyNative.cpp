@@ -23,15 +23,15 @@
 
 namespace vca {
 
-double entropy_c(const std::vector<int16_t> &block)
+double entropy_c(const int16_t *block, unsigned nrSamples)
 {
     std::unordered_map<int, int> pixelCounts;
-    int totalPixels = static_cast<int>(block.size());
+    int totalPixels = static_cast<int>(nrSamples);
 
     // Count occurrences of each pixel value
-    for (int pixel : block)
+    for (unsigned i = 0; i < nrSamples; i++)
     {
-        pixelCounts[pixel]++;
+        pixelCounts[block[i]]++;
     }
 
     // Calculate probability of each pixel value
@@ -28,7 +28,7 @@
 
 namespace vca {
 
-double entropy_c(const std::vector<int16_t> &block);
+double entropy_c(const int16_t *block, unsigned nrSamples);
 
 } // namespace vca
 
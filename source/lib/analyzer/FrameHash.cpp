@@ -0,0 +1,195 @@
+/* Copyright (C) 2024 Christian Doppler Laboratory ATHENA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.
+ *****************************************************************************/
+
+#include "FrameHash.h"
+
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define VCA_FRAME_HASH_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace vca {
+
+namespace {
+
+// The line is processed in chunks of 16 bytes (two 64 bit lanes). Every lane is xored with a
+// key that changes with the position and then multiplied (lower 32 bit times upper 32 bit).
+// The products and the input are accumulated per lane.
+constexpr uint64_t KEY_LANE0  = 0x9E3779B97F4A7C15ull;
+constexpr uint64_t KEY_LANE1  = 0xC2B2AE3D27D4EB4Full;
+constexpr uint64_t KEY_STEP_0 = 0x165667B19E3779F9ull;
+constexpr uint64_t KEY_STEP_1 = 0x85EBCA77C2B2AE63ull;
+
+inline uint64_t accumulateLane(uint64_t accumulator, uint64_t value, uint64_t key)
+{
+    const auto keyed = value ^ key;
+    return accumulator + (keyed & 0xFFFFFFFFull) * (keyed >> 32) + value;
+}
+
+inline uint64_t finalizeLine(uint64_t accumulator0, uint64_t accumulator1, unsigned nrBytes)
+{
+    return combineHash(combineHash(accumulator0, accumulator1), nrBytes);
+}
+
+void hashTail(const uint8_t *data,
+              unsigned nrBytes,
+              uint64_t &accumulator0,
+              uint64_t &accumulator1,
+              uint64_t key0,
+              uint64_t key1)
+{
+    uint8_t chunk[16] = {};
+    std::memcpy(chunk, data, nrBytes);
+    uint64_t values[2];
+    std::memcpy(values, chunk, 16);
+    accumulator0 = accumulateLane(accumulator0, values[0], key0);
+    accumulator1 = accumulateLane(accumulator1, values[1], key1);
+}
+
+uint64_t hashLine_c(const uint8_t *data, unsigned nrBytes)
+{
+    uint64_t accumulator0 = 0;
+    uint64_t accumulator1 = 0;
+    uint64_t key0         = KEY_LANE0;
+    uint64_t key1         = KEY_LANE1;
+
+    unsigned i = 0;
+    for (; i + 16 <= nrBytes; i += 16)
+    {
+        uint64_t values[2];
+        std::memcpy(values, data + i, 16);
+        accumulator0 = accumulateLane(accumulator0, values[0], key0);
+        accumulator1 = accumulateLane(accumulator1, values[1], key1);
+        key0 += KEY_STEP_0;
+        key1 += KEY_STEP_1;
+    }
+    if (i < nrBytes)
+        hashTail(data + i, nrBytes - i, accumulator0, accumulator1, key0, key1);
+
+    return finalizeLine(accumulator0, accumulator1, nrBytes);
+}
+
+#if VCA_FRAME_HASH_SSE2
+
+uint64_t hashLine_sse2(const uint8_t *data, unsigned nrBytes)
+{
+    auto accumulator = _mm_setzero_si128();
+    auto key         = _mm_set_epi64x(int64_t(KEY_LANE1), int64_t(KEY_LANE0));
+    const auto step  = _mm_set_epi64x(int64_t(KEY_STEP_1), int64_t(KEY_STEP_0));
+
+    unsigned i = 0;
+    for (; i + 16 <= nrBytes; i += 16)
+    {
+        const auto values  = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        const auto keyed   = _mm_xor_si128(values, key);
+        const auto product = _mm_mul_epu32(keyed, _mm_srli_epi64(keyed, 32));
+        accumulator        = _mm_add_epi64(accumulator, _mm_add_epi64(product, values));
+        key                = _mm_add_epi64(key, step);
+    }
+
+    uint64_t accumulators[2];
+    uint64_t keys[2];
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(accumulators), accumulator);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(keys), key);
+    if (i < nrBytes)
+        hashTail(data + i, nrBytes - i, accumulators[0], accumulators[1], keys[0], keys[1]);
+
+    return finalizeLine(accumulators[0], accumulators[1], nrBytes);
+}
+
+#endif
+
+} // namespace
+
+uint64_t hashLine(const uint8_t *data, unsigned nrBytes, CpuSimd cpuSimd)
+{
+#if VCA_FRAME_HASH_SSE2
+    if (cpuSimd != CpuSimd::None)
+        return hashLine_sse2(data, nrBytes);
+#endif
+    return hashLine_c(data, nrBytes);
+}
+
+uint64_t combineHash(uint64_t hash, uint64_t value)
+{
+    hash ^= value * 0x9E3779B97F4A7C15ull;
+    hash = (hash << 29) | (hash >> 35);
+    return hash * 0xBF58476D1CE4E5B9ull;
+}
+
+uint64_t calculateFrameHash(const vca_frame &frame, CpuSimd cpuSimd)
+{
+    const auto &info         = frame.info;
+    const auto bytesPerPixel = (info.bitDepth > 8) ? 2u : 1u;
+
+    unsigned widths[3]  = {info.width, info.width / 2, info.width / 2};
+    unsigned heights[3] = {info.height, info.height / 2, info.height / 2};
+    if (info.colorspace == vca_colorSpace::YUV422)
+        heights[1] = heights[2] = info.height;
+    else if (info.colorspace == vca_colorSpace::YUV444)
+    {
+        widths[1] = widths[2] = info.width;
+        heights[1] = heights[2] = info.height;
+    }
+    const auto nrPlanes = (info.colorspace == vca_colorSpace::YUV400) ? 1u : 3u;
+
+    uint64_t hash = 0;
+    for (unsigned plane = 0; plane < nrPlanes; plane++)
+    {
+        if (frame.planes[plane] == nullptr)
+            continue;
+        const auto *src = frame.planes[plane];
+        for (unsigned y = 0; y < heights[plane]; y++, src += frame.stride[plane])
+            hash = combineHash(hash, hashLine(src, widths[plane] * bytesPerPixel, cpuSimd));
+    }
+    return hash;
+}
+
+void FrameHashHistory::add(unsigned jobID, uint64_t hash)
+{
+    {
+        std::unique_lock<std::mutex> lock(this->accessMutex);
+        this->hashes[jobID] = hash;
+    }
+    this->hashAddedCV.notify_all();
+}
+
+std::optional<uint64_t> FrameHashHistory::waitAndTake(unsigned jobID)
+{
+    std::unique_lock<std::mutex> lock(this->accessMutex);
+    this->hashAddedCV.wait(lock, [this, jobID]() {
+        return this->aborted || this->hashes.count(jobID) > 0;
+    });
+    if (this->aborted)
+        return {};
+
+    const auto hash = this->hashes[jobID];
+    this->hashes.erase(jobID);
+    return hash;
+}
+
+void FrameHashHistory::abort()
+{
+    {
+        std::unique_lock<std::mutex> lock(this->accessMutex);
+        this->aborted = true;
+    }
+    this->hashAddedCV.notify_all();
+}
+
+} // namespace vca
@@ -0,0 +1,59 @@
+/* Copyright (C) 2024 Christian Doppler Laboratory ATHENA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.
+ *****************************************************************************/
+
+#pragma once
+
+#include <vcaLib.h>
+
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <stdint.h>
+
+namespace vca {
+
+// 64 bit hash of a line of bytes. The hash depends on the position of every byte. The SIMD
+// and the native implementation give the same result.
+uint64_t hashLine(const uint8_t *data, unsigned nrBytes, CpuSimd cpuSimd);
+
+// Combine the hashes of several lines. This depends on the order of the lines.
+uint64_t combineHash(uint64_t hash, uint64_t value);
+
+// Hash of the samples of all planes of the frame (without the padding in the stride)
+uint64_t calculateFrameHash(const vca_frame &frame, CpuSimd cpuSimd);
+
+// The frame hashes of the jobs. A job adds its hash and then waits for the hash of the
+// previous job. This way, the previous frame does not have to be analyzed completely before
+// the duplicate check can be done.
+class FrameHashHistory
+{
+public:
+    void add(unsigned jobID, uint64_t hash);
+
+    // Wait until the hash of the job was added and remove it. Returns empty if aborted.
+    std::optional<uint64_t> waitAndTake(unsigned jobID);
+
+    void abort();
+
+private:
+    std::mutex accessMutex;
+    std::condition_variable hashAddedCV;
+    std::map<unsigned, uint64_t> hashes;
+    bool aborted{};
+};
+
+} // namespace vca
@@ -0,0 +1,202 @@
+/* Copyright (C) 2024 Christian Doppler Laboratory ATHENA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.
+ *****************************************************************************/
+
+#include "Hadamard.h"
+
+#include <cstdlib>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define VCA_HADAMARD_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace vca {
+
+namespace {
+
+// The frequency (number of sign changes) of the outputs 0-7 of the butterfly implementation
+// of the transform
+const unsigned hadamardFrequency[8] = {0, 7, 3, 4, 1, 6, 2, 5};
+
+// After the first 1D transform the values are scaled to 12 bit so that for up to 12 bit
+// samples the second transform and the absolute values fit into 16 bit. Together this gives
+// the scale of the DCT coefficients.
+int32_t scaleFirstStage(int32_t value, unsigned bitDepth)
+{
+    if (bitDepth == 8)
+        return value * 2;
+    return value >> (bitDepth - 9);
+}
+
+// In place transform of 8 values with the stride. The output is in natural (Hadamard) order.
+template<typename T>
+void hadamard8(T *values, unsigned stride)
+{
+    for (unsigned half = 1; half < 8; half *= 2)
+        for (unsigned i = 0; i < 8; i += 2 * half)
+            for (auto j = i; j < i + half; j++)
+            {
+                const auto a                = values[j * stride];
+                const auto b                = values[(j + half) * stride];
+                values[j * stride]          = a + b;
+                values[(j + half) * stride] = a - b;
+            }
+}
+
+// The coefficients are transposed like in the SIMD implementation, so the weight of
+// block[v * 8 + u] is at u * 8 + v.
+uint32_t calculateHadamardEnergy8x8_c(const int16_t *samples,
+                                      unsigned stride,
+                                      unsigned bitDepth,
+                                      const int16_t *weights)
+{
+    int32_t block[64];
+    for (unsigned y = 0; y < 8; y++)
+        for (unsigned x = 0; x < 8; x++)
+            block[y * 8 + x] = samples[y * stride + x];
+
+    for (unsigned x = 0; x < 8; x++)
+        hadamard8(block + x, 8);
+    for (auto &value : block)
+        value = scaleFirstStage(value, bitDepth);
+    for (unsigned y = 0; y < 8; y++)
+        hadamard8(block + y * 8, 1);
+
+    uint32_t weightedSum = 0;
+    for (unsigned v = 0; v < 8; v++)
+        for (unsigned u = 0; u < 8; u++)
+            weightedSum += uint32_t(weights[u * 8 + v] * std::abs(block[v * 8 + u]));
+    return weightedSum >> 8;
+}
+
+#if VCA_HADAMARD_SSE2
+
+void hadamard8_sse2(__m128i *rows)
+{
+    for (unsigned half = 1; half < 8; half *= 2)
+        for (unsigned i = 0; i < 8; i += 2 * half)
+            for (auto j = i; j < i + half; j++)
+            {
+                const auto a   = rows[j];
+                const auto b   = rows[j + half];
+                rows[j]        = _mm_add_epi16(a, b);
+                rows[j + half] = _mm_sub_epi16(a, b);
+            }
+}
+
+void transpose8x8_sse2(__m128i *rows)
+{
+    const auto a0 = _mm_unpacklo_epi16(rows[0], rows[1]);
+    const auto a1 = _mm_unpackhi_epi16(rows[0], rows[1]);
+    const auto a2 = _mm_unpacklo_epi16(rows[2], rows[3]);
+    const auto a3 = _mm_unpackhi_epi16(rows[2], rows[3]);
+    const auto a4 = _mm_unpacklo_epi16(rows[4], rows[5]);
+    const auto a5 = _mm_unpackhi_epi16(rows[4], rows[5]);
+    const auto a6 = _mm_unpacklo_epi16(rows[6], rows[7]);
+    const auto a7 = _mm_unpackhi_epi16(rows[6], rows[7]);
+
+    const auto b0 = _mm_unpacklo_epi32(a0, a2);
+    const auto b1 = _mm_unpackhi_epi32(a0, a2);
+    const auto b2 = _mm_unpacklo_epi32(a1, a3);
+    const auto b3 = _mm_unpackhi_epi32(a1, a3);
+    const auto b4 = _mm_unpacklo_epi32(a4, a6);
+    const auto b5 = _mm_unpackhi_epi32(a4, a6);
+    const auto b6 = _mm_unpacklo_epi32(a5, a7);
+    const auto b7 = _mm_unpackhi_epi32(a5, a7);
+
+    rows[0] = _mm_unpacklo_epi64(b0, b4);
+    rows[1] = _mm_unpackhi_epi64(b0, b4);
+    rows[2] = _mm_unpacklo_epi64(b1, b5);
+    rows[3] = _mm_unpackhi_epi64(b1, b5);
+    rows[4] = _mm_unpacklo_epi64(b2, b6);
+    rows[5] = _mm_unpackhi_epi64(b2, b6);
+    rows[6] = _mm_unpacklo_epi64(b3, b7);
+    rows[7] = _mm_unpackhi_epi64(b3, b7);
+}
+
+// The transform of the columns, then of the rows of the transposed block. The coefficients
+// are not transposed back, the weights are in this order.
+uint32_t calculateHadamardEnergy8x8_sse2(const int16_t *samples,
+                                         unsigned stride,
+                                         unsigned bitDepth,
+                                         const int16_t *weights)
+{
+    __m128i rows[8];
+    for (unsigned y = 0; y < 8; y++)
+        rows[y] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(samples + y * stride));
+
+    hadamard8_sse2(rows);
+    for (auto &row : rows)
+        row = (bitDepth == 8) ? _mm_slli_epi16(row, 1)
+                              : _mm_sra_epi16(row, _mm_cvtsi32_si128(int(bitDepth) - 9));
+    transpose8x8_sse2(rows);
+    hadamard8_sse2(rows);
+
+    const auto zero = _mm_setzero_si128();
+    auto sumVec     = _mm_setzero_si128();
+    for (unsigned y = 0; y < 8; y++)
+    {
+        const auto absolute  = _mm_max_epi16(rows[y], _mm_sub_epi16(zero, rows[y]));
+        const auto weightVec = _mm_load_si128(reinterpret_cast<const __m128i *>(weights + y * 8));
+        sumVec = _mm_add_epi32(sumVec, _mm_madd_epi16(absolute, weightVec));
+    }
+    sumVec = _mm_add_epi32(sumVec, _mm_shuffle_epi32(sumVec, _MM_SHUFFLE(1, 0, 3, 2)));
+    sumVec = _mm_add_epi32(sumVec, _mm_shuffle_epi32(sumVec, _MM_SHUFFLE(2, 3, 0, 1)));
+    return uint32_t(_mm_cvtsi128_si32(sumVec)) >> 8;
+}
+
+#endif
+
+} // namespace
+
+HadamardWeights getHadamardWeights(const int16_t *weightsByFrequency)
+{
+    // Transposed, see calculateHadamardEnergy8x8_c
+    HadamardWeights weights;
+    for (unsigned u = 0; u < 8; u++)
+        for (unsigned v = 0; v < 8; v++)
+            weights.values[u * 8 + v] = weightsByFrequency[hadamardFrequency[v] * 8
+                                                           + hadamardFrequency[u]];
+    return weights;
+}
+
+uint32_t calculateHadamardEnergy(const int16_t *samples,
+                                 unsigned stride,
+                                 unsigned size,
+                                 unsigned bitDepth,
+                                 const HadamardWeights &weights,
+                                 CpuSimd cpuSimd)
+{
+    uint32_t energy = 0;
+    for (unsigned y = 0; y < size; y += 8)
+        for (unsigned x = 0; x < size; x += 8)
+        {
+            const auto block = samples + y * stride + x;
+#if VCA_HADAMARD_SSE2
+            if (cpuSimd != CpuSimd::None && bitDepth <= 12)
+            {
+                energy += calculateHadamardEnergy8x8_sse2(block, stride, bitDepth, weights.values);
+                continue;
+            }
+#else
+            (void) cpuSimd;
+#endif
+            energy += calculateHadamardEnergy8x8_c(block, stride, bitDepth, weights.values);
+        }
+    return energy;
+}
+
+} // namespace vca
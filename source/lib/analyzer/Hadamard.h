@@ -0,0 +1,50 @@
+/* Copyright (C) 2024 Christian Doppler Laboratory ATHENA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.
+ *****************************************************************************/
+
+#pragma once
+
+#include <vcaLib.h>
+
+#include <stdint.h>
+
+namespace vca {
+
+// The weights of the 64 coefficients of the 8x8 Walsh-Hadamard transform in the order in
+// which calculateHadamardEnergy calculates them.
+struct HadamardWeights
+{
+    alignas(16) int16_t values[64];
+};
+
+// weightsByFrequency[v * 8 + u] is the weight of the coefficient with the vertical frequency
+// v and the horizontal frequency u. The frequency of a basis function of the transform is
+// its number of sign changes.
+HadamardWeights getHadamardWeights(const int16_t *weightsByFrequency);
+
+// The weighted sum of the absolute coefficients of the 8x8 Walsh-Hadamard transforms of all
+// 8x8 sub blocks of size x size samples (size must be a multiple of 8). The transform only
+// needs additions and subtractions. The coefficients are scaled like the coefficients of
+// performDCT (the DC is the mean << (15 - bitDepth)). The weighted sum of every 8x8 block is
+// divided by 256. The SIMD (up to 12 bit) and the native implementation give the same
+// result.
+uint32_t calculateHadamardEnergy(const int16_t *samples,
+                                 unsigned stride,
+                                 unsigned size,
+                                 unsigned bitDepth,
+                                 const HadamardWeights &weights,
+                                 CpuSimd cpuSimd);
+
+} // namespace vca
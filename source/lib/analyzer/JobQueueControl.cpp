@@ -0,0 +1,75 @@
+/* Copyright (C) 2024 Christian Doppler Laboratory ATHENA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.
+ *****************************************************************************/
+
+
+#include "JobQueueControl.h"
+
+#include <algorithm>
+
+namespace vca {
+
+namespace {
+
+// The previous fixed size of the queue
+const auto defaultSize = 5u;
+const auto minSize     = 2u;
+
+// The size is adapted after this many results
+const auto resultsPerUpdate = 16u;
+
+// Grow if the threads are idle for more than this fraction of the time
+const auto maxIdleRatio = 0.05;
+
+} // namespace
+
+JobQueueController::JobQueueController(unsigned configuredSize, unsigned nrThreads)
+{
+    this->isAdaptive = (configuredSize == 0);
+    this->size       = this->isAdaptive ? defaultSize : configuredSize;
+    this->maxSize    = std::max(4 * nrThreads, 8u);
+}
+
+bool JobQueueController::addResult(double idleTime, double processingTime, size_t nrQueuedResults)
+{
+    if (!this->isAdaptive)
+        return false;
+
+    this->idleTime += idleTime;
+    this->processingTime += processingTime;
+    this->nrQueuedResults += nrQueuedResults;
+    if (++this->nrResults < resultsPerUpdate)
+        return false;
+
+    const auto totalTime  = this->idleTime + this->processingTime;
+    const auto idleRatio  = (totalTime > 0.0) ? this->idleTime / totalTime : 0.0;
+    const auto averageLag = double(this->nrQueuedResults) / this->nrResults;
+    this->nrResults       = 0;
+    this->idleTime        = 0.0;
+    this->processingTime  = 0.0;
+    this->nrQueuedResults = 0;
+
+    auto newSize = this->size;
+    if (averageLag > 1.0)
+        newSize = std::max(this->size - 1, minSize);
+    else if (idleRatio > maxIdleRatio)
+        newSize = std::min(this->size + 1, this->maxSize);
+
+    const auto changed = (newSize != this->size);
+    this->size         = newSize;
+    return changed;
+}
+
+} // namespace vca
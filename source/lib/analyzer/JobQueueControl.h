@@ -0,0 +1,52 @@
+/* Copyright (C) 2024 Christian Doppler Laboratory ATHENA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.
+ *****************************************************************************/
+
+
+#pragma once
+
+#include <cstddef>
+
+namespace vca {
+
+// Adapts the size of the job queue (see vca_param::jobQueueSize). If the threads wait for
+// jobs while the results are pulled in time, a larger queue can absorb bursts of pushed
+// frames, so the size grows. If results wait to be pulled, the consumer does not keep up
+// and there is no need to analyze further ahead, so the size shrinks. A configured size is
+// kept fixed.
+class JobQueueController
+{
+public:
+    JobQueueController(unsigned configuredSize, unsigned nrThreads);
+
+    unsigned getSize() const { return this->size; }
+
+    // idleTime is the time that the thread waited for the job, processingTime the time that
+    // it worked on it (both in seconds) and nrQueuedResults the number of results that still
+    // wait to be pulled. Returns true if the size changed.
+    bool addResult(double idleTime, double processingTime, size_t nrQueuedResults);
+
+private:
+    bool isAdaptive{};
+    unsigned size{};
+    unsigned maxSize{};
+
+    unsigned nrResults{};
+    double idleTime{};
+    double processingTime{};
+    size_t nrQueuedResults{};
+};
+
+} // namespace vca
@@ -0,0 +1,330 @@
+/* Copyright (C) 2024 Christian Doppler Laboratory ATHENA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.
+ *****************************************************************************/
+
+#include "Ladder.h"
+
+#include <analyzer/Decimation.h>
+#include <analyzer/common/common.h>
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <stdexcept>
+
+namespace vca {
+
+namespace {
+
+// The weights of the area filter are in Q14. The horizontal pass keeps 4 fractional bits,
+// so that the sums of the vertical pass fit into 32 bit for up to 12 bit samples.
+constexpr unsigned WEIGHT_BITS       = 14;
+constexpr unsigned INTERMEDIATE_BITS = 4;
+
+// For every output sample of one dimension the first input sample and the weights of the
+// input samples that it covers
+struct FilterTaps
+{
+    std::vector<unsigned> start;
+    std::vector<unsigned> offset;
+    std::vector<unsigned> count;
+    std::vector<uint16_t> weights;
+};
+
+FilterTaps calculateAreaFilterTaps(unsigned inputSize, unsigned outputSize)
+{
+    FilterTaps taps;
+    taps.start.resize(outputSize);
+    taps.offset.resize(outputSize);
+    taps.count.resize(outputSize);
+
+    // Output sample i covers [i * inputSize, (i + 1) * inputSize) and input sample k covers
+    // [k * outputSize, (k + 1) * outputSize) in units of 1 / outputSize input samples. The
+    // weights are rounded from the accumulated coverage so that they sum up to 1 exactly.
+    for (unsigned i = 0; i < outputSize; i++)
+    {
+        const auto begin = uint64_t(i) * inputSize;
+        const auto end   = begin + inputSize;
+        const auto first = unsigned(begin / outputSize);
+        const auto last  = unsigned((end - 1) / outputSize);
+
+        taps.start[i]  = first;
+        taps.offset[i] = unsigned(taps.weights.size());
+        taps.count[i]  = last - first + 1;
+
+        uint64_t covered          = 0;
+        unsigned previousWeighted = 0;
+        for (auto k = first; k <= last; k++)
+        {
+            const auto sampleBegin = std::max(begin, uint64_t(k) * outputSize);
+            const auto sampleEnd   = std::min(end, uint64_t(k + 1) * outputSize);
+            covered += sampleEnd - sampleBegin;
+            const auto weighted = unsigned(((covered << WEIGHT_BITS) + inputSize / 2)
+                                           / inputSize);
+            taps.weights.push_back(uint16_t(weighted - previousWeighted));
+            previousWeighted = weighted;
+        }
+    }
+    return taps;
+}
+
+template<typename T>
+void resizePlaneAreaFilter(const uint8_t *src,
+                           unsigned srcStride,
+                           unsigned width,
+                           unsigned height,
+                           uint8_t *dst,
+                           unsigned dstStride,
+                           unsigned outputWidth,
+                           unsigned outputHeight,
+                           std::vector<uint16_t> &intermediate)
+{
+    const auto tapsX = calculateAreaFilterTaps(width, outputWidth);
+    const auto tapsY = calculateAreaFilterTaps(height, outputHeight);
+
+    constexpr auto horizontalShift = WEIGHT_BITS - INTERMEDIATE_BITS;
+    intermediate.resize(size_t(outputWidth) * height);
+    for (unsigned y = 0; y < height; y++)
+    {
+        const auto srcLine = reinterpret_cast<const T *>(src + y * srcStride);
+        const auto line    = intermediate.data() + size_t(y) * outputWidth;
+        for (unsigned x = 0; x < outputWidth; x++)
+        {
+            const auto input   = srcLine + tapsX.start[x];
+            const auto weights = tapsX.weights.data() + tapsX.offset[x];
+            uint32_t sum       = 0;
+            for (unsigned i = 0; i < tapsX.count[x]; i++)
+                sum += uint32_t(input[i]) * weights[i];
+            line[x] = uint16_t((sum + (1u << (horizontalShift - 1))) >> horizontalShift);
+        }
+    }
+
+    constexpr auto verticalShift = WEIGHT_BITS + INTERMEDIATE_BITS;
+    for (unsigned y = 0; y < outputHeight; y++)
+    {
+        const auto input   = intermediate.data() + size_t(tapsY.start[y]) * outputWidth;
+        const auto weights = tapsY.weights.data() + tapsY.offset[y];
+        auto dstLine       = reinterpret_cast<T *>(dst + y * dstStride);
+        for (unsigned x = 0; x < outputWidth; x++)
+        {
+            uint32_t sum = 0;
+            for (unsigned i = 0; i < tapsY.count[y]; i++)
+                sum += uint32_t(input[i * outputWidth + x]) * weights[i];
+            dstLine[x] = T((sum + (1u << (verticalShift - 1))) >> verticalShift);
+        }
+    }
+}
+
+// Returns 2 or 4 if the output is exactly this factor smaller in both dimensions, else 0
+unsigned getDecimationFactor(unsigned width,
+                             unsigned height,
+                             unsigned outputWidth,
+                             unsigned outputHeight)
+{
+    for (auto factor : {2u, 4u})
+        if (width == outputWidth * factor && height == outputHeight * factor)
+            return factor;
+    return 0;
+}
+
+void resizePlane(const uint8_t *src,
+                 unsigned srcStride,
+                 unsigned width,
+                 unsigned height,
+                 uint8_t *dst,
+                 unsigned dstStride,
+                 unsigned outputWidth,
+                 unsigned outputHeight,
+                 unsigned bitDepth,
+                 CpuSimd cpuSimd,
+                 std::vector<uint16_t> &intermediate)
+{
+    if (outputWidth == 0 || outputHeight == 0 || outputWidth > width || outputHeight > height)
+        throw std::invalid_argument("Invalid output size for the downscaling");
+
+    const auto bytesPerSample = (bitDepth > 8) ? 2u : 1u;
+    if (outputWidth == width && outputHeight == height)
+    {
+        for (unsigned y = 0; y < height; y++)
+            std::memcpy(dst + y * dstStride, src + y * srcStride, width * bytesPerSample);
+        return;
+    }
+
+    if (const auto factor = getDecimationFactor(width, height, outputWidth, outputHeight))
+    {
+        decimatePlane(src, srcStride, width, height, dst, dstStride, factor, bitDepth, cpuSimd);
+        return;
+    }
+
+    if (bytesPerSample == 2)
+        resizePlaneAreaFilter<uint16_t>(src,
+                                        srcStride,
+                                        width,
+                                        height,
+                                        dst,
+                                        dstStride,
+                                        outputWidth,
+                                        outputHeight,
+                                        intermediate);
+    else
+        resizePlaneAreaFilter<uint8_t>(src,
+                                       srcStride,
+                                       width,
+                                       height,
+                                       dst,
+                                       dstStride,
+                                       outputWidth,
+                                       outputHeight,
+                                       intermediate);
+}
+
+} // namespace
+
+void resizePlane(const uint8_t *src,
+                 unsigned srcStride,
+                 unsigned width,
+                 unsigned height,
+                 uint8_t *dst,
+                 unsigned dstStride,
+                 unsigned outputWidth,
+                 unsigned outputHeight,
+                 unsigned bitDepth,
+                 CpuSimd cpuSimd)
+{
+    std::vector<uint16_t> intermediate;
+    resizePlane(src,
+                srcStride,
+                width,
+                height,
+                dst,
+                dstStride,
+                outputWidth,
+                outputHeight,
+                bitDepth,
+                cpuSimd,
+                intermediate);
+}
+
+vca_rect scaleRect(const vca_rect &rect, vca_resolution from, vca_resolution to)
+{
+    if (rect.width == 0 || rect.height == 0)
+        return {};
+    const auto scaleDown = [](unsigned value, unsigned fromSize, unsigned toSize) {
+        return unsigned(uint64_t(value) * toSize / fromSize);
+    };
+    const auto scaleUp = [](unsigned value, unsigned fromSize, unsigned toSize) {
+        return unsigned((uint64_t(value) * toSize + fromSize - 1) / fromSize);
+    };
+    const auto left   = scaleDown(rect.x, from.width, to.width);
+    const auto top    = scaleDown(rect.y, from.height, to.height);
+    const auto right  = scaleUp(rect.x + rect.width, from.width, to.width);
+    const auto bottom = scaleUp(rect.y + rect.height, from.height, to.height);
+    return {left, top, right - left, bottom - top};
+}
+
+void LadderFrames::update(const vca_frame &frame,
+                          const vca_resolution *resolutions,
+                          unsigned nrResolutions,
+                          CpuSimd cpuSimd)
+{
+    const auto &info          = frame.info;
+    const auto bytesPerSample = (info.bitDepth > 8) ? 2u : 1u;
+    const auto [subsamplingX, subsamplingY] = getChromaSubsampling(info.colorspace);
+    const auto nrPlanes = (info.colorspace == vca_colorSpace::YUV400) ? 1u : 3u;
+
+    this->levels.resize(nrResolutions);
+
+    // From the largest to the smallest resolution
+    std::vector<unsigned> order(nrResolutions);
+    std::iota(order.begin(), order.end(), 0u);
+    const auto area = [&](unsigned i) {
+        return uint64_t(resolutions[i].width) * resolutions[i].height;
+    };
+    std::stable_sort(order.begin(), order.end(), [&](unsigned a, unsigned b) {
+        return area(a) > area(b);
+    });
+
+    std::vector<const vca_frame *> available = {&frame};
+    for (const auto i : order)
+    {
+        const auto target = resolutions[i];
+
+        // The candidates are ordered by size, so later candidates are smaller. A decimation
+        // by 2 or 4 is preferred over the area filter.
+        const vca_frame *source = nullptr;
+        auto sourceIsDecimation = false;
+        for (const auto candidate : available)
+        {
+            const auto &candidateInfo = candidate->info;
+            if (candidateInfo.width < target.width || candidateInfo.height < target.height)
+                continue;
+            const auto isDecimation = getDecimationFactor(candidateInfo.width,
+                                                          candidateInfo.height,
+                                                          target.width,
+                                                          target.height)
+                                      > 0;
+            if (isDecimation || !sourceIsDecimation)
+            {
+                source             = candidate;
+                sourceIsDecimation = isDecimation;
+            }
+        }
+        if (source == nullptr)
+            throw std::invalid_argument("Ladder resolution larger than the input");
+
+        auto &level       = this->levels[i];
+        level.frame       = {};
+        level.frame.stats = frame.stats;
+        level.frame.info  = info;
+        level.frame.info.width  = target.width;
+        level.frame.info.height = target.height;
+
+        for (unsigned plane = 0; plane < nrPlanes; plane++)
+        {
+            if (source->planes[plane] == nullptr)
+                continue;
+
+            const auto isLuma       = (plane == 0);
+            const auto width        = isLuma ? source->info.width
+                                             : source->info.width / subsamplingX;
+            const auto height       = isLuma ? source->info.height
+                                             : source->info.height / subsamplingY;
+            const auto outputWidth  = isLuma ? target.width : target.width / subsamplingX;
+            const auto outputHeight = isLuma ? target.height : target.height / subsamplingY;
+            const auto outputStride = outputWidth * bytesPerSample;
+
+            auto &data = level.planes[plane];
+            data.resize(outputStride * outputHeight);
+            resizePlane(source->planes[plane],
+                        unsigned(source->stride[plane]),
+                        width,
+                        height,
+                        data.data(),
+                        outputStride,
+                        outputWidth,
+                        outputHeight,
+                        info.bitDepth,
+                        cpuSimd,
+                        this->intermediate);
+
+            level.frame.planes[plane] = data.data();
+            level.frame.stride[plane] = int(outputStride);
+            level.frame.height[plane] = int(outputHeight);
+        }
+        available.push_back(&level.frame);
+    }
+}
+
+} // namespace vca
@@ -0,0 +1,77 @@
+/* Copyright (C) 2024 Christian Doppler Laboratory ATHENA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.
+ *****************************************************************************/
+
+#pragma once
+
+#include <vcaLib.h>
+
+#include <array>
+#include <stdint.h>
+#include <vector>
+
+namespace vca {
+
+// Downscale a plane to outputWidth x outputHeight samples with an area filter. Every output
+// sample is the mean of the input area that it covers (input samples that are only partly
+// covered are weighted by the covered fraction). The output must not be larger than the
+// input. If the size is reduced by exactly 2 or 4 in both dimensions, this gives the same
+// result as decimatePlane.
+void resizePlane(const uint8_t *src,
+                 unsigned srcStride,
+                 unsigned width,
+                 unsigned height,
+                 uint8_t *dst,
+                 unsigned dstStride,
+                 unsigned outputWidth,
+                 unsigned outputHeight,
+                 unsigned bitDepth,
+                 CpuSimd cpuSimd);
+
+// Scale a rectangle in luma samples from a frame of size from to a frame of size to. The
+// result covers all samples that the rectangle touches. An empty rectangle stays empty.
+vca_rect scaleRect(const vca_rect &rect, vca_resolution from, vca_resolution to);
+
+// The input frame downscaled to all resolutions of an ABR ladder. The resolutions are
+// calculated from the largest to the smallest one. Each one is downscaled from the smallest
+// frame that is already available and that is 2x or 4x its size (this is done with the
+// SIMD decimation) or otherwise the smallest frame that is larger. The memory is kept so
+// that it can be reused for the next frame.
+class LadderFrames
+{
+public:
+    LadderFrames() = default;
+    LadderFrames(const LadderFrames &) = delete;
+    LadderFrames &operator=(const LadderFrames &) = delete;
+
+    void update(const vca_frame &frame,
+                const vca_resolution *resolutions,
+                unsigned nrResolutions,
+                CpuSimd cpuSimd);
+
+    // The frame at resolutions[i] of the last update
+    vca_frame *getFrame(unsigned i) { return &this->levels[i].frame; }
+
+private:
+    struct Level
+    {
+        std::array<std::vector<uint8_t>, 3> planes;
+        vca_frame frame;
+    };
+    std::vector<Level> levels;
+    std::vector<uint16_t> intermediate;
+};
+
+} // namespace vca
@@ -0,0 +1,123 @@
+/* Copyright (C) 2024 Christian Doppler Laboratory ATHENA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.
+ *****************************************************************************/
+
+#include "LetterboxDetection.h"
+
+#include <algorithm>
+
+namespace vca {
+
+namespace {
+
+template<typename T>
+bool isBlackLine(const T *line, unsigned width, unsigned threshold)
+{
+    for (unsigned x = 0; x < width; x++)
+        if (line[x] > threshold)
+            return false;
+    return true;
+}
+
+template<typename T>
+std::optional<vca_rect> detectActiveAreaInPlane(const vca_frame &frame, unsigned threshold)
+{
+    const auto width  = frame.info.width;
+    const auto height = frame.info.height;
+    const auto src    = reinterpret_cast<const T *>(frame.planes[0]);
+    const auto stride = unsigned(frame.stride[0]) / sizeof(T);
+
+    unsigned top = 0;
+    while (top < height && isBlackLine(src + top * stride, width, threshold))
+        top++;
+    if (top == height)
+        return {};
+
+    // Line 'top' is not black so this stops there at the latest
+    auto bottom = height;
+    while (isBlackLine(src + (bottom - 1) * stride, width, threshold))
+        bottom--;
+
+    // Only the samples outside of the current left/right limits have to be checked. For
+    // most lines this stops after the first few samples of the picture.
+    auto left  = width;
+    auto right = 0u;
+    for (auto y = top; y < bottom; y++)
+    {
+        const auto line = src + y * stride;
+        for (unsigned x = 0; x < left; x++)
+        {
+            if (line[x] > threshold)
+            {
+                left = x;
+                break;
+            }
+        }
+        for (auto x = width; x > right; x--)
+        {
+            if (line[x - 1] > threshold)
+            {
+                right = x;
+                break;
+            }
+        }
+    }
+
+    return vca_rect{left, top, right - left, bottom - top};
+}
+
+} // namespace
+
+std::optional<vca_rect> detectActiveArea(const vca_frame &frame)
+{
+    const auto threshold = LETTERBOX_BLACK_THRESHOLD_8BIT << (frame.info.bitDepth - 8);
+    if (frame.info.bitDepth > 8)
+        return detectActiveAreaInPlane<uint16_t>(frame, threshold);
+    return detectActiveAreaInPlane<uint8_t>(frame, threshold);
+}
+
+void LetterboxDetector::addFrame(const vca_frame &frame)
+{
+    this->nrFrames++;
+
+    const auto area = detectActiveArea(frame);
+    if (!area)
+        return;
+    if (!this->activeArea)
+    {
+        this->activeArea = area;
+        return;
+    }
+
+    const auto left   = std::min(this->activeArea->x, area->x);
+    const auto top    = std::min(this->activeArea->y, area->y);
+    const auto right  = std::max(this->activeArea->x + this->activeArea->width,
+                                 area->x + area->width);
+    const auto bottom = std::max(this->activeArea->y + this->activeArea->height,
+                                 area->y + area->height);
+    this->activeArea  = vca_rect{left, top, right - left, bottom - top};
+}
+
+unsigned LetterboxDetector::getNrFrames() const
+{
+    return this->nrFrames;
+}
+
+std::optional<vca_rect> LetterboxDetector::getActiveArea() const
+{
+    return this->activeArea;
+}
+
+} // namespace vca
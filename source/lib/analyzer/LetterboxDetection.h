@@ -0,0 +1,50 @@
+/* Copyright (C) 2024 Christian Doppler Laboratory ATHENA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.
+ *****************************************************************************/
+
+#pragma once
+
+#include <vcaLib.h>
+
+#include <optional>
+
+namespace vca {
+
+// Luma samples up to this value (scaled to the bit depth) are considered black. This is the
+// black level of limited range video plus a margin for noise and coding artifacts.
+constexpr unsigned LETTERBOX_BLACK_THRESHOLD_8BIT = 32;
+
+// Find the area of the frame that is not covered by black borders (letterbox or pillarbox
+// bars). Returns empty if the whole frame is black.
+std::optional<vca_rect> detectActiveArea(const vca_frame &frame);
+
+// Detects the black borders that are present in all frames that were added. The active
+// area is the bounding box of the active areas of the single frames. So a dark scene in one
+// frame does not remove picture content as long as the other frames are not dark there.
+class LetterboxDetector
+{
+public:
+    void addFrame(const vca_frame &frame);
+    unsigned getNrFrames() const;
+
+    // Empty if no frames were added or if all frames were black.
+    std::optional<vca_rect> getActiveArea() const;
+
+private:
+    unsigned nrFrames{};
+    std::optional<vca_rect> activeArea;
+};
+
+} // namespace vca
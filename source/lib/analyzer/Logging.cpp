@@ -0,0 +1,120 @@
+/* Copyright (C) 2024 Christian Doppler Laboratory ATHENA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.
+ *****************************************************************************/
+
+
+#include "Logging.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace vca {
+
+namespace {
+
+// The longest time a message waits in a ring before it is passed on
+constexpr auto FlushInterval = std::chrono::milliseconds(10);
+
+} // namespace
+
+LogRing::LogRing() : entries(Capacity) {}
+
+void LogRing::push(LogLevel level, const std::string &message)
+{
+    const auto head = this->head.load(std::memory_order_relaxed);
+    const auto tail = this->tail.load(std::memory_order_acquire);
+    if (head - tail == Capacity)
+    {
+        this->nrDropped++;
+        return;
+    }
+
+    auto &entry       = this->entries[head % Capacity];
+    const auto length = std::min(message.size(), MaxMessageLength);
+    entry.level       = level;
+    std::memcpy(entry.message, message.data(), length);
+    entry.message[length] = '\0';
+    this->head.store(head + 1, std::memory_order_release);
+}
+
+bool LogRing::pop(LogLevel &level, std::string &message)
+{
+    const auto tail = this->tail.load(std::memory_order_relaxed);
+    const auto head = this->head.load(std::memory_order_acquire);
+    if (tail == head)
+        return false;
+
+    const auto &entry = this->entries[tail % Capacity];
+    level             = entry.level;
+    message           = entry.message;
+    this->tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+LogFlusher::LogFlusher(const vca_param &cfg, unsigned nrRings)
+    : cfg(cfg), reportedDropped(nrRings)
+{
+    for (unsigned i = 0; i < nrRings; i++)
+        this->rings.push_back(std::make_unique<LogRing>());
+    this->thread = std::thread(&LogFlusher::threadFunction, this);
+}
+
+LogFlusher::~LogFlusher()
+{
+    {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->stop = true;
+    }
+    this->stopCV.notify_all();
+    this->thread.join();
+    this->flush();
+}
+
+void LogFlusher::threadFunction()
+{
+    std::unique_lock<std::mutex> lock(this->mutex);
+    while (!this->stop)
+    {
+        lock.unlock();
+        this->flush();
+        lock.lock();
+        this->stopCV.wait_for(lock, FlushInterval, [this]() { return this->stop; });
+    }
+}
+
+void LogFlusher::flush()
+{
+    LogLevel level;
+    std::string message;
+    for (size_t i = 0; i < this->rings.size(); i++)
+    {
+        auto &ring = *this->rings[i];
+        while (ring.pop(level, message))
+            log(this->cfg, level, message);
+
+        const auto nrDropped = ring.getNrDroppedMessages();
+        if (nrDropped > this->reportedDropped[i])
+        {
+            log(this->cfg,
+                LogLevel::Warning,
+                std::to_string(nrDropped - this->reportedDropped[i])
+                    + " log messages of a processing thread were dropped");
+            this->reportedDropped[i] = nrDropped;
+        }
+    }
+}
+
+} // namespace vca
@@ -0,0 +1,94 @@
+/* Copyright (C) 2024 Christian Doppler Laboratory ATHENA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.
+ *****************************************************************************/
+
+
+#pragma once
+
+#include <analyzer/common/common.h>
+#include <vcaLib.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace vca {
+
+// The log messages of one thread. Only this thread pushes messages and only the LogFlusher
+// pops them. Neither side waits for the other. If the ring is full, the message is dropped.
+class LogRing
+{
+public:
+    static constexpr size_t Capacity         = 256;
+    static constexpr size_t MaxMessageLength = 255;
+
+    LogRing();
+
+    // Longer messages are truncated to MaxMessageLength
+    void push(LogLevel level, const std::string &message);
+    bool pop(LogLevel &level, std::string &message);
+
+    uint64_t getNrDroppedMessages() const { return this->nrDropped.load(); }
+
+private:
+    struct Entry
+    {
+        LogLevel level{};
+        char message[MaxMessageLength + 1]{};
+    };
+
+    std::vector<Entry> entries;
+    std::atomic<size_t> head{};
+    std::atomic<size_t> tail{};
+    std::atomic<uint64_t> nrDropped{};
+};
+
+// Passes the messages of the rings to vca_param::logFunction from a background thread.
+// The remaining messages are passed on when the flusher is destroyed.
+class LogFlusher
+{
+public:
+    LogFlusher(const vca_param &cfg, unsigned nrRings);
+    ~LogFlusher();
+
+    LogRing *getRing(unsigned index) { return this->rings.at(index).get(); }
+
+private:
+    void threadFunction();
+    void flush();
+
+    vca_param cfg;
+    std::vector<std::unique_ptr<LogRing>> rings;
+    std::vector<uint64_t> reportedDropped;
+
+    std::mutex mutex;
+    std::condition_variable stopCV;
+    bool stop{};
+    std::thread thread;
+};
+
+// Log from a processing thread. Only calls makeMessage if the level is logged.
+template<typename MakeMessage>
+void log(const vca_param &cfg, LogRing *ring, LogLevel level, MakeMessage &&makeMessage)
+{
+    if (ring != nullptr && isLogged(cfg, level))
+        ring->push(level, makeMessage());
+}
+
+} // namespace vca
@@ -20,8 +20,49 @@
 
 #include <analyzer/common/common.h>
 
+#include <algorithm>
+
 namespace vca {
 
+namespace {
+
+template<typename V>
+size_t getVectorMemory(const std::vector<V> &values)
+{
+    return values.capacity() * sizeof(V);
+}
+
+size_t getMemorySize(const Job &)
+{
+    return sizeof(Job);
+}
+
+size_t getMemorySize(const Result &result)
+{
+    auto memory = sizeof(Result) + getVectorMemory(result.brightnessPerBlock)
+                  + getVectorMemory(result.energyPerBlock)
+                  + getVectorMemory(result.energyDiffPerBlock)
+                  + getVectorMemory(result.energyEpsilonPerBlock)
+                  + getVectorMemory(result.averageUPerBlock)
+                  + getVectorMemory(result.averageVPerBlock)
+                  + getVectorMemory(result.energyUPerBlock)
+                  + getVectorMemory(result.energyVPerBlock)
+                  + getVectorMemory(result.entropyPerBlock)
+                  + getVectorMemory(result.entropyDiffPerBlock)
+                  + getVectorMemory(result.entropyUPerBlock)
+                  + getVectorMemory(result.entropyVPerBlock)
+                  + getVectorMemory(result.edgeDensityPerBlock);
+    for (const auto &grid : result.blockGrids)
+        memory += sizeof(BlockGridResult) + getVectorMemory(grid.brightnessPerBlock)
+                  + getVectorMemory(grid.energyPerBlock)
+                  + getVectorMemory(grid.edgeDensityPerBlock);
+    for (const auto &levelResult : result.ladderResults)
+        memory += getMemorySize(levelResult);
+    return memory;
+}
+
+} // namespace
+
 template<class T>
 void MultiThreadQueue<T>::abort()
 {
@@ -36,16 +77,19 @@ void MultiThreadQueue<T>::waitAndPush(T item)
     if (this->aborted)
         return;
 
+    const auto itemMemory = getMemorySize(item);
+
     std::unique_lock<std::mutex> lock(this->accessMutex);
-    this->popJobCV.wait(lock, [this]() {
-        return this->maximumQueueSize == 0 || this->items.size() < this->maximumQueueSize
-               || this->aborted;
+    this->popJobCV.wait(lock, [this, itemMemory]() {
+        return this->isSlotFree(itemMemory) || this->aborted;
     });
 
     if (this->aborted)
         return;
 
     this->items.push(std::move(item));
+    this->queueMemory += itemMemory;
+    this->peakMemory = std::max(this->peakMemory, this->queueMemory);
     this->pushJobCV.notify_one();
 }
 
@@ -55,23 +99,35 @@ void MultiThreadQueue<T>::waitAndPushInOrder(T item, size_t orderCounter)
     if (this->aborted)
         return;
 
+    const auto itemMemory = getMemorySize(item);
+
     std::unique_lock<std::mutex> lock(this->accessMutex);
-    this->popJobCV.wait(lock, [this, orderCounter]() {
+    this->popJobCV.wait(lock, [this, orderCounter, itemMemory]() {
         if (this->aborted)
             return true;
-        auto slotFree = this->maximumQueueSize == 0 || this->items.size() < this->maximumQueueSize;
-        return slotFree && orderCounter == this->pushCounter;
+        return this->isSlotFree(itemMemory) && orderCounter == this->pushCounter;
     });
 
     if (this->aborted)
         return;
 
     this->items.push(std::move(item));
+    this->queueMemory += itemMemory;
+    this->peakMemory = std::max(this->peakMemory, this->queueMemory);
     this->pushCounter++;
     this->popJobCV.notify_all();
     this->pushJobCV.notify_one();
 }
 
+template<class T>
+void MultiThreadQueue<T>::waitForTurn(size_t orderCounter)
+{
+    std::unique_lock<std::mutex> lock(this->accessMutex);
+    this->popJobCV.wait(lock, [this, orderCounter]() {
+        return this->aborted || orderCounter == this->pushCounter;
+    });
+}
+
 template<class T>
 std::optional<T> MultiThreadQueue<T>::waitAndPop()
 {
@@ -81,9 +137,12 @@ std::optional<T> MultiThreadQueue<T>::waitAndPop()
     if (this->aborted)
         return {};
 
-    auto item = this->items.front();
+    auto item = std::move(this->items.front());
     this->items.pop();
-    this->popJobCV.notify_one();
+    this->queueMemory -= std::min(getMemorySize(item), this->queueMemory);
+
+    // The thread that pushes the next item in order may not be the first waiting thread
+    this->popJobCV.notify_all();
     return item;
 }
 
@@ -100,7 +159,46 @@ bool MultiThreadQueue<T>::empty()
 template<class T>
 void MultiThreadQueue<T>::setMaximumQueueSize(size_t max)
 {
-    this->maximumQueueSize = max;
+    {
+        std::unique_lock<std::mutex> lock(this->accessMutex);
+        this->maximumQueueSize = max;
+    }
+    this->popJobCV.notify_all();
+}
+
+template<class T>
+void MultiThreadQueue<T>::setMaximumQueueMemory(size_t max)
+{
+    {
+        std::unique_lock<std::mutex> lock(this->accessMutex);
+        this->maximumQueueMemory = max;
+    }
+    this->popJobCV.notify_all();
+}
+
+template<class T>
+size_t MultiThreadQueue<T>::size()
+{
+    std::unique_lock<std::mutex> lock(this->accessMutex);
+    return this->items.size();
+}
+
+template<class T>
+size_t MultiThreadQueue<T>::getPeakMemory()
+{
+    std::unique_lock<std::mutex> lock(this->accessMutex);
+    return this->peakMemory;
+}
+
+template<class T>
+bool MultiThreadQueue<T>::isSlotFree(size_t itemMemory) const
+{
+    if (this->items.empty())
+        return true;
+    if (this->maximumQueueSize > 0 && this->items.size() >= this->maximumQueueSize)
+        return false;
+    return this->maximumQueueMemory == 0
+           || this->queueMemory + itemMemory <= this->maximumQueueMemory;
 }
 
 template class MultiThreadQueue<Job>;
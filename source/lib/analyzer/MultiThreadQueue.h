@@ -36,6 +36,8 @@ public:
     // Pushing threads will be paused until the pushs are in order.
     // Don't mix calls to these two push functions.
     void waitAndPushInOrder(T item, size_t counter);
+    // Wait until the item with this counter is the next one to push in order
+    void waitForTurn(size_t counter);
 
     // Get an item. If the queue is empty, wait until an item is pushed.
     // Will return empty opt if abort is called.
@@ -45,10 +47,19 @@ public:
     bool empty();
 
     // If the queue is fuller then this limit, the push function will wait until
-    // there is enought space. 0 means no limit.
+    // there is enought space. 0 means no limit. Can be changed while threads are waiting.
     void setMaximumQueueSize(size_t max);
 
+    // The same for the memory of the queued items (see getMemorySize). An item is always
+    // pushed to an empty queue.
+    void setMaximumQueueMemory(size_t max);
+
+    size_t size();
+    size_t getPeakMemory();
+
 private:
+    bool isSlotFree(size_t itemMemory) const;
+
     std::queue<T> items;
     std::mutex accessMutex;
     std::condition_variable pushJobCV;
@@ -56,6 +67,9 @@ private:
 
     bool aborted{};
     size_t maximumQueueSize{};
+    size_t maximumQueueMemory{};
+    size_t queueMemory{};
+    size_t peakMemory{};
     size_t pushCounter{};
 };
 
@@ -0,0 +1,85 @@
+/* Copyright (C) 2024 Christian Doppler Laboratory ATHENA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.
+ *****************************************************************************/
+
+
+#include "PerformanceCounters.h"
+
+#include <algorithm>
+
+namespace vca {
+
+PerformanceCounters::PerformanceCounters(unsigned nrThreads, bool enableStageTimings)
+    : enableStageTimings(enableStageTimings), threadBusyTime(nrThreads)
+{}
+
+void PerformanceCounters::addFrame()
+{
+    if (!this->startTime)
+        this->startTime = std::chrono::steady_clock::now();
+}
+
+void PerformanceCounters::addResult(const Result &result)
+{
+    if (result.threadIndex < this->threadBusyTime.size())
+        this->threadBusyTime[result.threadIndex] += result.processingTime;
+
+    if (!this->enableStageTimings)
+        return;
+
+    Times times;
+    std::copy(std::begin(result.stageTimes.seconds),
+              std::end(result.stageTimes.seconds),
+              times.begin());
+    for (unsigned i = 0; i < VCA_NR_STAGES; i++)
+    {
+        this->totalTimes[i] += times[i];
+        this->recentTimesSum[i] += times[i];
+    }
+
+    this->recentTimes.push_back(times);
+    if (this->recentTimes.size() > VCA_STAGE_TIMING_WINDOW)
+    {
+        for (unsigned i = 0; i < VCA_NR_STAGES; i++)
+            this->recentTimesSum[i] -= this->recentTimes.front()[i];
+        this->recentTimes.pop_front();
+    }
+}
+
+void PerformanceCounters::getStats(vca_analyzer_stats *stats) const
+{
+    if (this->enableStageTimings && !this->recentTimes.empty())
+    {
+        for (unsigned i = 0; i < VCA_NR_STAGES; i++)
+        {
+            stats->stageTimeTotal[i]  = this->totalTimes[i];
+            stats->stageTimeRecent[i] = std::max(this->recentTimesSum[i], 0.0)
+                                        / this->recentTimes.size();
+        }
+    }
+
+    stats->nrThreads = unsigned(this->threadBusyTime.size());
+    if (this->startTime)
+    {
+        const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now()
+                                                           - *this->startTime)
+                                 .count();
+        const auto nrThreads = std::min(stats->nrThreads, unsigned(VCA_MAX_THREAD_STATS));
+        for (unsigned i = 0; i < nrThreads && elapsed > 0.0; i++)
+            stats->threadUtilization[i] = std::min(this->threadBusyTime[i] / elapsed, 1.0);
+    }
+}
+
+} // namespace vca
@@ -0,0 +1,57 @@
+/* Copyright (C) 2024 Christian Doppler Laboratory ATHENA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.
+ *****************************************************************************/
+
+
+#pragma once
+
+#include <analyzer/common/common.h>
+#include <vcaLib.h>
+
+#include <array>
+#include <chrono>
+#include <deque>
+#include <optional>
+#include <vector>
+
+namespace vca {
+
+// Collects the stage times (see vca_param::enableStageTimings) of the pulled results and
+// the time that each thread worked on frames
+class PerformanceCounters
+{
+public:
+    PerformanceCounters(unsigned nrThreads, bool enableStageTimings);
+
+    // Called for every pushed frame. The utilization of the threads is measured from the
+    // first frame on.
+    void addFrame();
+    void addResult(const Result &result);
+
+    void getStats(vca_analyzer_stats *stats) const;
+
+private:
+    using Times = std::array<double, VCA_NR_STAGES>;
+
+    bool enableStageTimings{};
+    Times totalTimes{};
+    std::deque<Times> recentTimes;
+    Times recentTimesSum{};
+
+    std::optional<std::chrono::steady_clock::time_point> startTime;
+    std::vector<double> threadBusyTime;
+};
+
+} // namespace vca
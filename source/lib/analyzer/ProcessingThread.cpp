@@ -20,17 +20,47 @@
 
 #include <analyzer/EnergyCalculation.h>
 #include <analyzer/EntropyCalculation.h>
+#include <analyzer/QualityControl.h>
+
+#include <chrono>
+#include <optional>
 
 namespace vca {
 
+namespace {
+
+bool isChromaAnalyzed(const vca_param &cfg)
+{
+    return (cfg.enableDCTenergy && cfg.enableEnergyChroma)
+           || (cfg.enableEntropy && cfg.enableEntropyChroma);
+}
+
+} // namespace
+
 ProcessingThread::ProcessingThread(vca_param cfg,
                                    MultiThreadQueue<Job> &jobs,
                                    MultiThreadQueue<Result> &results,
-                                   unsigned id)
+                                   BlockCache &blockCache,
+                                   FrameHashHistory &frameHashes,
+                                   unsigned id,
+                                   TraceBuffer *traceBuffer,
+                                   LogRing *logRing)
+    : blockCache(blockCache)
+    , frameHashes(frameHashes)
+    , traceBuffer(traceBuffer)
+    , logRing(logRing)
 {
     this->cfg = cfg;
     this->id  = id;
 
+    // Blocks of 64x64 and 128x128 samples are analyzed with the 32x32 lowpass approach
+    if (cfg.blockSize > 32)
+    {
+        this->largeBlockFactor = cfg.blockSize / 32;
+        this->cfg.blockSize    = 32;
+    }
+    this->baseCfg = this->cfg;
+
     this->thread = std::thread(&ProcessingThread::threadFunction,
                                this,
                                std::ref(jobs),
@@ -42,51 +72,306 @@ void ProcessingThread::threadFunction(MultiThreadQueue<Job> &jobQueue,
 {
     while (!this->aborted)
     {
-        auto job = jobQueue.waitAndPop();
+        const auto waitStartTime = std::chrono::steady_clock::now();
+        auto job                 = jobQueue.waitAndPop();
         if (!job)
             break;
 
-        log(this->cfg,
-            LogLevel::Debug,
-            "Thread " + std::to_string(this->id) + ": Start work on job " + job->infoString());
+        log(this->cfg, this->logRing, LogLevel::Debug, [&]() {
+            return "Thread " + std::to_string(this->id) + ": Start work on job "
+                   + job->infoString();
+        });
+
+        const auto startTime = std::chrono::steady_clock::now();
+        const auto idleTime  = std::chrono::duration<double>(startTime - waitStartTime);
+        this->cfg            = getQualityTierConfig(this->baseCfg, job->qualityTier);
 
         Result result;
-        result.poc   = job->frame->stats.poc;
-        result.jobID = job->jobID;
-        if (this->cfg.enableDCTenergy)
+        result.poc                = job->frame->stats.poc;
+        result.jobID              = job->jobID;
+        result.regionOfInterest   = job->regionOfInterest;
+        result.isDiscontinuity    = job->isDiscontinuity;
+        result.qualityTier        = job->qualityTier;
+        result.idleTime           = idleTime.count();
+        result.threadIndex        = this->id;
+        result.stageTimes.enabled = this->cfg.enableStageTimings;
+
+        // The results of a duplicate frame are copied from the previous frame in
+        // Analyzer::pullResult where the results are handled in order.
+        if (this->cfg.enableDuplicateFrameDetection && this->isDuplicateOfPreviousFrame(*job))
+        {
+            result.isDuplicate = true;
+            if (!this->cfg.enableShotDetectionOnly)
+            {
+                if (job->jobID > 0)
+                    this->blockCache.releaseEntry(job->jobID - 1);
+                this->blockCache.addEntryWithoutResult(job->jobID);
+            }
+        }
+        else if (job->decimationFactor > 1 || this->largeBlockFactor > 1)
+        {
+            const auto factor = job->decimationFactor * this->largeBlockFactor;
+            auto decimatedJob = *job;
+            {
+                TraceSpan span(this->traceBuffer, "Decimate", job->jobID);
+                decimatedJob.frame = this->decimatedFrame.decimate(*job->frame,
+                                                                   factor,
+                                                                   this->cfg.cpuSimd);
+            }
+            decimatedJob.regionOfInterest = decimateRect(job->regionOfInterest, factor);
+            decimatedJob.largeBlockFactor = this->largeBlockFactor;
+            this->analyzeFrame(decimatedJob, result);
+        }
+        else
+            this->analyzeFrame(*job, result);
+
+        if (!result.isDuplicate && this->cfg.nrLadderResolutions > 0)
+        {
+            TraceSpan span(this->traceBuffer, "Ladder", job->jobID);
+            this->analyzeLadder(*job, result);
+        }
+
+        log(this->cfg, this->logRing, LogLevel::Debug, [&]() {
+            return "Thread " + std::to_string(this->id) + ": Finished work on job "
+                   + job->infoString();
+        });
+
+        const auto endTime    = std::chrono::steady_clock::now();
+        result.processingTime = std::chrono::duration<double>(endTime - startTime).count();
+        result.latency        = std::chrono::duration<double>(endTime - job->pushTime).count();
+        if (this->traceBuffer)
+            this->traceBuffer->add("Job", job->jobID, startTime, endTime);
+
+        if (result.stageTimes.enabled)
+        {
+            const auto queueWait = std::chrono::duration<double>(startTime - job->pushTime);
+            result.stageTimes.add(vca_stage::QueueWait, queueWait.count());
+            result.stageTimes.add(vca_stage::Frame, result.processingTime);
+        }
+        if (result.stageTimes.enabled || this->traceBuffer)
+        {
+            StageTimer timer(result.stageTimes, vca_stage::ReorderWait);
+            TraceSpan span(this->traceBuffer, "Reorder wait", job->jobID);
+            results.waitForTurn(result.jobID);
+        }
+        results.waitAndPushInOrder(result, result.jobID);
+    }
+
+    log(this->cfg, this->logRing, LogLevel::Debug, [&]() {
+        return "Thread " + std::to_string(this->id) + " quit";
+    });
+}
+
+bool ProcessingThread::isDuplicateOfPreviousFrame(const Job &job)
+{
+    // The hash is added before the analysis, so waiting for the hash of the previous job
+    // does not wait for the analysis of the previous frame.
+    const auto hash = calculateFrameHash(*job.frame, this->cfg.cpuSimd);
+    this->frameHashes.add(job.jobID, hash);
+    if (job.jobID == 0)
+        return false;
+
+    const auto previousHash = this->frameHashes.waitAndTake(job.jobID - 1);
+    return previousHash && *previousHash == hash;
+}
+
+void ProcessingThread::analyzeFrame(const Job &job, Result &result)
+{
+    // The results of blocks that did not change are copied from a reference frame. This
+    // is the previous frame if the frame has dirty rectangles or the most recent frame
+    // with the static block cache. With block sampling, most blocks of the reference frame
+    // have no results. Every job takes part in the block cache if it is used for the
+    // configured analysis, also if the quality tier of the job does not use it.
+    const auto enableBlockCache = !this->cfg.enableShotDetectionOnly
+                                  && this->baseCfg.blockSamplingInterval == 1;
+    const auto enableChroma     = isChromaAnalyzed(this->cfg);
+    if (enableBlockCache && this->cfg.blockSamplingInterval > 1)
+    {
+        if (job.jobID > 0)
+            this->blockCache.releaseEntry(job.jobID - 1);
+        this->blockCache.addEntryWithoutResult(job.jobID);
+        this->analyzeBlocks(job, result, nullptr);
+        return;
+    }
+
+    FrameBlockHashes blockHashes;
+    std::optional<StaticBlocks> staticBlocks;
+    if (enableBlockCache)
+    {
+        if (this->cfg.enableStaticBlockCache)
+        {
+            TraceSpan span(this->traceBuffer, "Block hashes", job.jobID);
+            blockHashes = calculateFrameBlockHashes(job.frame,
+                                                    this->cfg.blockSize,
+                                                    enableChroma,
+                                                    this->cfg.cpuSimd);
+        }
+        if (job.jobID > 0)
         {
-            computeWeightedDCTEnergy(*job,
-                                     result,
-                                     this->cfg.blockSize,
-                                     this->cfg.cpuSimd,
-                                     this->cfg.enableEnergyChroma,
-                                     this->cfg.enableLowpass);
+            if (job.frame->dirtyRects != nullptr)
+            {
+                TraceSpan span(this->traceBuffer, "Wait for previous frame", job.jobID);
+                if (auto previous = this->blockCache.waitAndTakeEntry(job.jobID - 1))
+                    staticBlocks.emplace(*job.frame,
+                                         this->cfg.blockSize,
+                                         enableChroma,
+                                         std::move(previous));
+            }
+            else
+                this->blockCache.releaseEntry(job.jobID - 1);
         }
-        if (this->cfg.enableEntropy)
+        if (!staticBlocks && this->cfg.enableStaticBlockCache)
         {
-            computeEntropy(*job,
+            if (auto reference = this->blockCache.getReference())
+                staticBlocks.emplace(blockHashes, std::move(reference));
+        }
+
+        // The results of other quality tiers were calculated with different features
+        if (staticBlocks && staticBlocks->referenceResult().qualityTier != job.qualityTier)
+            staticBlocks.reset();
+    }
+
+    this->analyzeBlocks(job, result, staticBlocks ? &*staticBlocks : nullptr);
+
+    if (enableBlockCache)
+        this->blockCache.addEntry(result.jobID,
+                                  std::move(blockHashes),
+                                  result,
+                                  this->cfg.enableStaticBlockCache);
+}
+
+void ProcessingThread::analyzeBlocks(const Job &job,
+                                     Result &result,
+                                     const StaticBlocks *staticBlocks)
+{
+    const auto enableChroma = isChromaAnalyzed(this->cfg);
+
+    // Without a required energy output, only the brightness is calculated
+    const auto enableEnergy = isOutputRequired(this->cfg,
+                                               VCA_OUTPUT_ENERGY | VCA_OUTPUT_ENERGY_DIFF);
+
+    // The lowpass DCT (block size 16 and 32) and the lowpass entropy share the planes
+    // downsampled by 2.
+    const auto enableLowpassDCT = this->cfg.enableDCTenergy && this->cfg.blockSize >= 16
+                                  && (enableEnergy || this->cfg.enableEnergyChroma);
+    const auto useHalfResolution = this->cfg.enableLowpass && !this->cfg.enableShotDetectionOnly
+                                   && (enableLowpassDCT || this->cfg.enableEntropy);
+    if (useHalfResolution)
+    {
+        TraceSpan span(this->traceBuffer, "Half resolution", job.jobID);
+        this->halfResolutionFrame.update(*job.frame,
+                                         this->cfg.blockSize,
+                                         enableChroma,
+                                         this->cfg.cpuSimd);
+    }
+    const auto halfResolutionPtr = useHalfResolution ? &this->halfResolutionFrame : nullptr;
+
+    if (this->cfg.enableShotDetectionOnly)
+    {
+        TraceSpan span(this->traceBuffer, "Energy", job.jobID);
+        computeShotDetectionEnergy(job,
+                                   result,
+                                   this->cfg.blockSize,
+                                   this->cfg.cpuSimd,
+                                   this->cfg.enableLowpass,
+                                   this->shotDetectionLuma);
+    }
+    else if (this->cfg.enableDCTenergy)
+    {
+        TraceSpan span(this->traceBuffer, "Energy", job.jobID);
+        computeWeightedDCTEnergy(job,
+                                 result,
+                                 this->cfg.blockSize,
+                                 this->cfg.cpuSimd,
+                                 enableEnergy,
+                                 this->cfg.enableEnergyChroma,
+                                 this->cfg.enableLowpass,
+                                 this->cfg.enableHadamardEnergy,
+                                 this->cfg.flatBlockThreshold,
+                                 staticBlocks,
+                                 halfResolutionPtr);
+    }
+    if (this->cfg.enableEntropy)
+    {
+        TraceSpan span(this->traceBuffer, "Entropy", job.jobID);
+        computeEntropy(job,
+                       result,
+                       this->cfg.blockSize,
+                       this->cfg.cpuSimd,
+                       this->cfg.enableLowpass,
+                       this->cfg.enableEntropyChroma,
+                       this->cfg.flatBlockThreshold,
+                       staticBlocks,
+                       halfResolutionPtr);
+    }
+    if (this->cfg.enableEdgeDensity)
+    {
+        TraceSpan span(this->traceBuffer, "Edge density", job.jobID);
+        computeEdgeDensity(job,
                            result,
                            this->cfg.blockSize,
                            this->cfg.cpuSimd,
                            this->cfg.enableLowpass,
-                           this->cfg.enableEntropyChroma);
-        }
-        if (this->cfg.enableEdgeDensity)
+                           staticBlocks);
+    }
+
+    result.blockGrids.resize(this->cfg.nrBlockGrids);
+    for (unsigned i = 0; i < this->cfg.nrBlockGrids; i++)
+    {
+        TraceSpan span(this->traceBuffer, "Block grid", job.jobID);
+        computeBlockGrid(job,
+                         result,
+                         this->cfg.blockSize,
+                         this->cfg.blockGridSizes[i],
+                         this->cfg.enableLowpass,
+                         result.blockGrids[i]);
+    }
+}
+
+void ProcessingThread::analyzeLadder(const Job &job, Result &result)
+{
+    // The levels are calculated from the input frame (also in the reduced resolution mode)
+    // and are not compared to a reference frame, so the static block cache is not used.
+    const auto nrLevels = this->cfg.nrLadderResolutions;
+    this->ladderFrames.update(*job.frame,
+                              this->cfg.ladderResolutions,
+                              nrLevels,
+                              this->cfg.cpuSimd);
+
+    const auto &info = job.frame->info;
+    result.ladderResults.resize(nrLevels);
+    for (unsigned i = 0; i < nrLevels; i++)
+    {
+        const auto level      = this->ladderFrames.getFrame(i);
+        const auto resolution = this->cfg.ladderResolutions[i];
+
+        auto levelJob             = job;
+        levelJob.frame            = level;
+        levelJob.decimationFactor = 1;
+        if (job.regionOfInterest.width > 0)
+            levelJob.regionOfInterest = alignToBlockGrid(
+                scaleRect(job.regionOfInterest, {info.width, info.height}, resolution),
+                this->cfg.blockSize * this->largeBlockFactor,
+                level->info);
+
+        auto &levelResult            = result.ladderResults[i];
+        levelResult                  = {};
+        levelResult.poc              = result.poc;
+        levelResult.jobID            = result.jobID;
+        levelResult.regionOfInterest = levelJob.regionOfInterest;
+
+        if (this->largeBlockFactor > 1)
         {
-            computeEdgeDensity(*job,
-                               result,
-                               this->cfg.blockSize,
-                               this->cfg.cpuSimd,
-                               this->cfg.enableLowpass);
+            levelJob.frame = this->largeBlockFrame.decimate(*level,
+                                                            this->largeBlockFactor,
+                                                            this->cfg.cpuSimd);
+            levelJob.regionOfInterest = decimateRect(levelJob.regionOfInterest,
+                                                     this->largeBlockFactor);
+            levelJob.largeBlockFactor = this->largeBlockFactor;
         }
-        log(this->cfg,
-            LogLevel::Debug,
-            "Thread " + std::to_string(this->id) + ": Finished work on job " + job->infoString());
 
-        results.waitAndPushInOrder(result, result.jobID);
+        this->analyzeBlocks(levelJob, levelResult, nullptr);
     }
-
-    log(this->cfg, LogLevel::Debug, "Thread " + std::to_string(this->id) + " quit");
 }
 
 void ProcessingThread::abort()
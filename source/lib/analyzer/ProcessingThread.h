@@ -18,7 +18,13 @@
 
 #pragma once
 
+#include <analyzer/BlockCache.h>
+#include <analyzer/Decimation.h>
+#include <analyzer/FrameHash.h>
+#include <analyzer/Ladder.h>
+#include <analyzer/Logging.h>
 #include <analyzer/MultiThreadQueue.h>
+#include <analyzer/Tracing.h>
 #include <analyzer/common/common.h>
 #include <vcaLib.h>
 
@@ -34,7 +40,11 @@ public:
     ProcessingThread(vca_param cfg,
                      MultiThreadQueue<Job> &jobs,
                      MultiThreadQueue<Result> &results,
-                     unsigned id);
+                     BlockCache &blockCache,
+                     FrameHashHistory &frameHashes,
+                     unsigned id,
+                     TraceBuffer *traceBuffer,
+                     LogRing *logRing);
     ~ProcessingThread() = default;
 
     void abort();
@@ -42,11 +52,43 @@ public:
 
 private:
     void threadFunction(MultiThreadQueue<Job> &jobQueue, MultiThreadQueue<Result> &results);
+    bool isDuplicateOfPreviousFrame(const Job &job);
+    void analyzeFrame(const Job &job, Result &result);
+    void analyzeBlocks(const Job &job, Result &result, const StaticBlocks *staticBlocks);
+    void analyzeLadder(const Job &job, Result &result);
 
     std::thread thread;
     bool aborted{};
     unsigned id{};
+
+    // The configuration of the quality tier of the current job (see QualityController)
     vca_param cfg;
+    vca_param baseCfg;
+    BlockCache &blockCache;
+    FrameHashHistory &frameHashes;
+
+    // Only set if tracing is enabled
+    TraceBuffer *traceBuffer{};
+
+    // Only set if there is a log function
+    LogRing *logRing{};
+
+    // Reused for all frames in the reduced resolution mode and for the large block sizes
+    DecimatedFrame decimatedFrame;
+
+    // With block sizes of 64 and 128, cfg.blockSize is 32 and the frames are decimated by
+    // this factor. The ladder levels are decimated into largeBlockFrame.
+    unsigned largeBlockFactor{1};
+    DecimatedFrame largeBlockFrame;
+
+    // The input of the lowpass features. Reused for all frames.
+    HalfResolutionFrame halfResolutionFrame;
+
+    // The downsampled luma plane in the shot detection only mode. Reused for all frames.
+    std::vector<uint8_t> shotDetectionLuma;
+
+    // The frame at the ladder resolutions. Reused for all frames.
+    LadderFrames ladderFrames;
 };
 
 } // namespace vca
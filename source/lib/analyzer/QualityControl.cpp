@@ -0,0 +1,141 @@
+/* Copyright (C) 2024 Christian Doppler Laboratory ATHENA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.
+ *****************************************************************************/
+
+#include "QualityControl.h"
+
+#include <algorithm>
+
+namespace vca {
+
+namespace {
+
+// Weight of a new frame in the smoothed times
+const auto smoothingFactor = 0.2;
+
+// Step down above this load, step up if the load of the previous tier is estimated below
+// the lower threshold. The gap avoids switching back and forth.
+const auto maxLoad     = 0.95;
+const auto maxLoadUp   = 0.75;
+const auto minFramesUp = 4u;
+
+// The assumed cost of the previous tier relative to the current tier if it was not
+// measured (e.g. if the previous tier had no frames yet)
+const auto defaultCostRatio = 2.0;
+
+const auto samplingIntervalOfLastTier = 4u;
+
+} // namespace
+
+vca_param getQualityTierConfig(const vca_param &cfg, unsigned tier)
+{
+    auto tierCfg = cfg;
+    if (tier >= 1)
+    {
+        tierCfg.enableEnergyChroma  = false;
+        tierCfg.enableEntropyChroma = false;
+        tierCfg.enableLowpass       = true;
+    }
+    if (tier >= 2 && tierCfg.enableDCTenergy)
+    {
+        tierCfg.enableEntropy     = false;
+        tierCfg.enableEdgeDensity = false;
+    }
+    if (tier >= 3)
+    {
+        tierCfg.blockSamplingInterval  = std::max(cfg.blockSamplingInterval,
+                                                 samplingIntervalOfLastTier);
+        tierCfg.nrBlockGrids           = 0;
+        tierCfg.enableStaticBlockCache = false;
+    }
+    return tierCfg;
+}
+
+QualityController::QualityController(const vca_param &cfg, unsigned nrThreads)
+    : frameRate(cfg.realTimeFrameRate), latencyBudget(cfg.realTimeLatencyMs / 1000.0),
+      nrThreads(std::max(nrThreads, 1u))
+{}
+
+bool QualityController::isEnabled() const
+{
+    return this->frameRate > 0.0 || this->latencyBudget > 0.0;
+}
+
+double QualityController::getLoad(unsigned tier) const
+{
+    // The fraction of the real-time budget of the threads that is used for the analysis
+    const auto &statistics = this->tierStatistics[tier];
+    auto load              = 0.0;
+    if (this->frameRate > 0.0)
+        load = statistics.processingTime * this->frameRate / this->nrThreads;
+    if (this->latencyBudget > 0.0)
+        load = std::max(load, statistics.latency / this->latencyBudget);
+    return load;
+}
+
+bool QualityController::addResult(unsigned resultTier, double processingTime, double latency)
+{
+    auto &statistics = this->tierStatistics[resultTier];
+    if (statistics.nrFrames == 0)
+    {
+        statistics.processingTime = processingTime;
+        statistics.latency        = latency;
+    }
+    else
+    {
+        statistics.processingTime += (processingTime - statistics.processingTime)
+                                     * smoothingFactor;
+        statistics.latency += (latency - statistics.latency) * smoothingFactor;
+    }
+    statistics.nrFrames++;
+
+    // The frames that were in flight when the tier changed do not show the effect yet
+    const unsigned tier = this->tier;
+    this->resultsSinceChange++;
+    if (resultTier != tier || this->resultsSinceChange < this->nrThreads + minFramesUp)
+        return false;
+
+    // The cost of the previous tier relative to this tier is measured right after stepping
+    // down, while the content is still similar
+    const auto &current = this->tierStatistics[tier];
+    if (tier > 0 && this->costRatio[tier] == 0.0 && current.processingTime > 0.0)
+        this->costRatio[tier] = std::max(
+            this->tierStatistics[tier - 1].processingTime / current.processingTime,
+            1.0);
+
+    const auto load = this->getLoad(tier);
+    if (load > maxLoad && tier + 1 < VCA_NR_QUALITY_TIERS)
+    {
+        this->tier                = tier + 1;
+        this->costRatio[tier + 1] = 0.0;
+        this->resultsSinceChange  = 0;
+        return true;
+    }
+
+    if (tier > 0)
+    {
+        const auto costRatio = (this->costRatio[tier] > 0.0) ? this->costRatio[tier]
+                                                             : defaultCostRatio;
+        if (load * costRatio < maxLoadUp)
+        {
+            this->tier               = tier - 1;
+            this->resultsSinceChange = 0;
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace vca
@@ -0,0 +1,73 @@
+/* Copyright (C) 2024 Christian Doppler Laboratory ATHENA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.
+ *****************************************************************************/
+
+#pragma once
+
+#include <vcaLib.h>
+
+#include <array>
+#include <atomic>
+
+namespace vca {
+
+// The configuration of a quality tier of the real-time mode. Each tier is cheaper than the
+// previous one. Tier 0 is the configured analysis.
+//   1: No chroma, lowpass DCT and entropy
+//   2: Additionally no entropy and edge density (if the DCT energy is enabled)
+//   3: Additionally only one of 4 blocks is analyzed (block sampling)
+vca_param getQualityTierConfig(const vca_param &cfg, unsigned tier);
+
+// Selects the quality tier of the next frames in the real-time mode (see
+// vca_param::realTimeFrameRate) from the measured processing time and latency of the
+// analyzed frames. It steps down one tier if the analysis does not keep up and steps up
+// again if the previous tier is estimated to keep up with some headroom.
+class QualityController
+{
+public:
+    QualityController(const vca_param &cfg, unsigned nrThreads);
+
+    bool isEnabled() const;
+    unsigned getTier() const { return this->tier; }
+
+    // processingTime is the time that a thread worked on the frame, latency the time from
+    // pushing the frame until the result was ready (both in seconds). Returns true if the
+    // tier changed.
+    bool addResult(unsigned resultTier, double processingTime, double latency);
+
+private:
+    double getLoad(unsigned tier) const;
+
+    double frameRate{};
+    double latencyBudget{};
+    unsigned nrThreads{1};
+
+    std::atomic<unsigned> tier{0};
+    unsigned resultsSinceChange{};
+
+    // Smoothed processing time and latency of the frames of each tier
+    struct TierStatistics
+    {
+        double processingTime{};
+        double latency{};
+        unsigned nrFrames{};
+    };
+    std::array<TierStatistics, VCA_NR_QUALITY_TIERS> tierStatistics{};
+
+    // The processing time of the previous tier relative to each tier. 0 if not measured.
+    std::array<double, VCA_NR_QUALITY_TIERS> costRatio{};
+};
+
+} // namespace vca
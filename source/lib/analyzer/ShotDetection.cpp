@@ -18,14 +18,19 @@
 
 #include "ShotDetection.h"
 
+#include <algorithm>
+#include <memory>
+#include <optional>
+#include <stdexcept>
 #include <string>
+#include <thread>
 #include <vector>
 
 namespace {
 
 inline void log(const vca_shot_detection_param &cfg, LogLevel level, const std::string &message)
 {
-    if (cfg.logFunction)
+    if (cfg.logFunction && level <= cfg.logLevel)
         cfg.logFunction(cfg.logFunctionPrivateData, level, message.c_str());
 }
 
@@ -88,6 +93,192 @@ void detect(const vca_shot_detection_param &param, vca_frame_results *frames, si
     log(param, LogLevel::Debug, "Detected " + std::to_string(numDetectedShots) + " shots.");
 }
 
+/* Chunked version of detect for several parameter sets.
+ *
+ * The first pass classifies every frame as sure shot, unsure or no shot. This only depends
+ * on the frame itself, so the chunks are independent. The second pass needs two values that
+ * cross chunk boundaries: the position of the last sure shot before a frame and the index
+ * of the next unsure frame after it. Both are reconciled between the passes from a small
+ * summary of every chunk.
+ */
+enum class FrameClass : uint8_t
+{
+    NoShot,
+    SureShot,
+    Unsure
+};
+
+struct ChunkSummary
+{
+    std::optional<size_t> lastSureShot;
+    std::optional<size_t> firstUnsure;
+
+    // Reconciled values from the neighboring chunks
+    size_t prevShotPosAtStart{0};
+    std::optional<size_t> nextUnsureAfterEnd;
+};
+
+struct Chunk
+{
+    size_t start{};
+    size_t end{};
+};
+
+std::vector<Chunk> splitIntoChunks(size_t num_frames, unsigned nrChunks)
+{
+    std::vector<Chunk> chunks;
+    const auto chunkSize = (num_frames + nrChunks - 1) / nrChunks;
+    for (size_t start = 0; start < num_frames; start += chunkSize)
+        chunks.push_back({start, std::min(start + chunkSize, num_frames)});
+    return chunks;
+}
+
+template<typename Function>
+void runForEachChunk(size_t nrChunks, Function function)
+{
+    if (nrChunks == 1)
+    {
+        function(0);
+        return;
+    }
+
+    std::vector<std::thread> threads;
+    for (size_t chunkIndex = 0; chunkIndex < nrChunks; chunkIndex++)
+        threads.emplace_back(function, chunkIndex);
+    for (auto &thread : threads)
+        thread.join();
+}
+
+bool isUnsureFrameNewShot(const vca_shot_detection_param &param,
+                          size_t index,
+                          size_t previousShotDistance,
+                          std::optional<size_t> nextUnsureIndex,
+                          size_t num_frames)
+{
+    if (previousShotDistance < param.fps)
+        return false;
+    if (nextUnsureIndex)
+        return (*nextUnsureIndex - index) >= param.fps;
+    return (index + param.fps) <= num_frames;
+}
+
+void detectChunked(const vca_shot_detection_param *params,
+                   size_t num_params,
+                   const vca_frame_results *frames,
+                   size_t num_frames,
+                   unsigned nrThreads,
+                   bool *isNewShot)
+{
+    const auto chunks   = splitIntoChunks(num_frames, nrThreads);
+    const auto nrChunks = chunks.size();
+    auto frameClasses   = std::vector<FrameClass>(num_params * num_frames, FrameClass::NoShot);
+    auto chunkSummaries = std::vector<ChunkSummary>(num_params * nrChunks);
+
+    /* First pass. Every frame is read once and classified for all parameter sets. */
+    runForEachChunk(nrChunks, [&](size_t chunkIndex) {
+        const auto &chunk = chunks[chunkIndex];
+        for (auto i = std::max(chunk.start, size_t(2)); i < chunk.end; i++)
+        {
+            const auto energyEpsilon = frames[i].energyEpsilon;
+            const auto energyDiff    = frames[i].energyDiff;
+            for (size_t p = 0; p < num_params; p++)
+            {
+                auto &summary    = chunkSummaries[p * nrChunks + chunkIndex];
+                auto &frameClass = frameClasses[p * num_frames + i];
+                if (energyEpsilon > params[p].maxEpsilonThresh)
+                {
+                    frameClass           = FrameClass::SureShot;
+                    summary.lastSureShot = i;
+                }
+                else if (energyEpsilon >= params[p].minEpsilonThresh
+                         && energyDiff >= params[p].maxSadThresh)
+                {
+                    frameClass = FrameClass::Unsure;
+                    if (!summary.firstUnsure)
+                        summary.firstUnsure = i;
+                }
+            }
+        }
+    });
+
+    /* Reconcile the chunk boundaries */
+    for (size_t p = 0; p < num_params; p++)
+    {
+        size_t prevShotPos = 0;
+        for (size_t c = 0; c < nrChunks; c++)
+        {
+            auto &summary              = chunkSummaries[p * nrChunks + c];
+            summary.prevShotPosAtStart = prevShotPos;
+            if (summary.lastSureShot)
+                prevShotPos = *summary.lastSureShot;
+        }
+
+        std::optional<size_t> nextUnsure;
+        for (size_t c = nrChunks; c > 0; c--)
+        {
+            auto &summary              = chunkSummaries[p * nrChunks + c - 1];
+            summary.nextUnsureAfterEnd = nextUnsure;
+            if (summary.firstUnsure)
+                nextUnsure = summary.firstUnsure;
+        }
+    }
+
+    /* Second pass */
+    runForEachChunk(nrChunks, [&](size_t chunkIndex) {
+        const auto &chunk = chunks[chunkIndex];
+        for (size_t p = 0; p < num_params; p++)
+        {
+            const auto &param   = params[p];
+            const auto &summary = chunkSummaries[p * nrChunks + chunkIndex];
+            auto classes        = &frameClasses[p * num_frames];
+            auto output         = &isNewShot[p * num_frames];
+
+            auto prevShotPos = summary.prevShotPosAtStart;
+            struct UnsureFrame
+            {
+                size_t index{};
+                size_t distance{};
+            };
+            std::optional<UnsureFrame> lastUnsure;
+
+            for (auto i = chunk.start; i < chunk.end; i++)
+            {
+                output[i] = (classes[i] == FrameClass::SureShot);
+                if (classes[i] == FrameClass::SureShot)
+                    prevShotPos = i;
+                else if (classes[i] == FrameClass::Unsure)
+                {
+                    if (lastUnsure)
+                        output[lastUnsure->index] = isUnsureFrameNewShot(
+                            param, lastUnsure->index, lastUnsure->distance, i, num_frames);
+                    lastUnsure = UnsureFrame{i, i - prevShotPos};
+                }
+            }
+
+            if (lastUnsure)
+                output[lastUnsure->index] = isUnsureFrameNewShot(param,
+                                                                 lastUnsure->index,
+                                                                 lastUnsure->distance,
+                                                                 summary.nextUnsureAfterEnd,
+                                                                 num_frames);
+        }
+    });
+
+    for (size_t p = 0; p < num_params; p++)
+        isNewShot[p * num_frames] = true;
+}
+
+unsigned getNrThreads(const vca_shot_detection_param &param, size_t num_frames)
+{
+    auto nrThreads = param.nrThreads;
+    if (nrThreads == 0)
+        nrThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    // Starting threads is not worth it for small chunks
+    const size_t minFramesPerThread = 4096;
+    nrThreads = unsigned(std::min(size_t(nrThreads), num_frames / minFramesPerThread));
+    return std::max(nrThreads, 1u);
+}
+
 } // namespace
 
 namespace vca {
@@ -107,7 +298,27 @@ vca_result shot_detection(const vca_shot_detection_param &param,
 
     try
     {
-        detect(param, frames, num_frames);
+        const auto nrThreads = getNrThreads(param, num_frames);
+        if (nrThreads == 1)
+            detect(param, frames, num_frames);
+        else
+        {
+            log(param,
+                LogLevel::Debug,
+                "Running shot detection in " + std::to_string(nrThreads) + " chunks.");
+            std::unique_ptr<bool[]> isNewShot(new bool[num_frames]);
+            detectChunked(&param, 1, frames, num_frames, nrThreads, isNewShot.get());
+            // The first pass of detect starts at frame 2 and leaves frame 1 untouched
+            size_t numDetectedShots = 0;
+            for (size_t i = 2; i < num_frames; i++)
+            {
+                frames[i].isNewShot = isNewShot[i];
+                numDetectedShots += isNewShot[i];
+            }
+            log(param,
+                LogLevel::Debug,
+                "Detected " + std::to_string(numDetectedShots) + " shots.");
+        }
     }
     catch (const std::exception &e)
     {
@@ -119,4 +330,142 @@ vca_result shot_detection(const vca_shot_detection_param &param,
     return vca_result::VCA_OK;
 }
 
+vca_result shot_detection_batch(const vca_shot_detection_param *params,
+                                size_t num_params,
+                                const vca_frame_results *frames,
+                                size_t num_frames,
+                                bool *isNewShot)
+{
+    const auto &logParam = params[0];
+    log(logParam,
+        LogLevel::Info,
+        "Starting shot detection for " + std::to_string(num_params) + " parameter sets and "
+            + std::to_string(num_frames) + " frames");
+
+    if (num_frames == 0)
+        return vca_result::VCA_OK;
+
+    try
+    {
+        const auto nrThreads = getNrThreads(logParam, num_frames);
+        detectChunked(params, num_params, frames, num_frames, nrThreads, isNewShot);
+    }
+    catch (const std::exception &e)
+    {
+        std::string exception_str = e.what();
+        log(logParam, LogLevel::Error, "Exception " + exception_str);
+        return vca_result::VCA_ERROR;
+    }
+
+    return vca_result::VCA_OK;
+}
+
+ShotDetector::ShotDetector(vca_shot_detection_param param)
+    : param(param)
+{
+    if (param.fps < 0.0)
+        throw std::invalid_argument("Invalid fps for shot detection");
+}
+
+vca_result ShotDetector::push(const vca_frame_results &frame)
+{
+    if (this->flushed)
+    {
+        log(this->param, LogLevel::Error, "Can not push frames after flushing");
+        return vca_result::VCA_ERROR;
+    }
+
+    const auto index = this->frameCounter++;
+    this->pendingFrames.push_back({frame, false});
+
+    bool isUnsure = false;
+    if (index == 0)
+        this->decide(index, true);
+    else if (index == 1)
+        this->decide(index, false);
+    else if (frame.energyEpsilon > this->param.maxEpsilonThresh)
+    {
+        this->decide(index, true);
+        this->prevShotPos = index;
+    }
+    else
+    {
+        isUnsure = frame.energyEpsilon >= this->param.minEpsilonThresh
+                   && frame.energyDiff >= this->param.maxSadThresh;
+        if (!isUnsure)
+            this->decide(index, false);
+    }
+
+    /* Resolve previous unsure frames that are now far enough in the past or that are
+     * followed by this unsure frame within the fps window. */
+    while (!this->undecidedUnsureFrames.empty())
+    {
+        const auto &unsure  = this->undecidedUnsureFrames.front();
+        const auto distance = index - unsure.index;
+        if (distance >= this->param.fps)
+            this->decide(unsure.index, unsure.previousShotDistance >= this->param.fps);
+        else if (isUnsure)
+            this->decide(unsure.index, false);
+        else
+            break;
+        this->undecidedUnsureFrames.pop_front();
+    }
+
+    if (isUnsure)
+    {
+        const auto previousShotDistance = index - this->prevShotPos;
+        if (previousShotDistance < this->param.fps)
+            this->decide(index, false);
+        else
+            this->undecidedUnsureFrames.push_back({index, previousShotDistance});
+    }
+
+    this->moveDecidedFramesToOutput();
+    return vca_result::VCA_OK;
+}
+
+vca_result ShotDetector::flush()
+{
+    const auto num_frames = this->frameCounter;
+    for (const auto &unsure : this->undecidedUnsureFrames)
+        this->decide(unsure.index, (unsure.index + this->param.fps) <= num_frames);
+    this->undecidedUnsureFrames.clear();
+
+    this->moveDecidedFramesToOutput();
+    this->flushed = true;
+    return vca_result::VCA_OK;
+}
+
+bool ShotDetector::resultAvailable()
+{
+    return !this->decidedFrames.empty();
+}
+
+vca_result ShotDetector::pull(vca_frame_results *frame)
+{
+    if (this->decidedFrames.empty())
+        return vca_result::VCA_ERROR;
+
+    *frame = this->decidedFrames.front();
+    this->decidedFrames.pop_front();
+    return vca_result::VCA_OK;
+}
+
+void ShotDetector::decide(size_t index, bool isNewShot)
+{
+    auto &pending            = this->pendingFrames.at(index - this->firstPendingIndex);
+    pending.result.isNewShot = isNewShot;
+    pending.decided          = true;
+}
+
+void ShotDetector::moveDecidedFramesToOutput()
+{
+    while (!this->pendingFrames.empty() && this->pendingFrames.front().decided)
+    {
+        this->decidedFrames.push_back(this->pendingFrames.front().result);
+        this->pendingFrames.pop_front();
+        this->firstPendingIndex++;
+    }
+}
+
 } // namespace vca
@@ -20,10 +20,62 @@
 
 #include <vcaLib.h>
 
+#include <deque>
+
 namespace vca {
 
 vca_result shot_detection(const vca_shot_detection_param &param,
                           vca_frame_results *frames,
                           size_t num_frames);
 
-}
+vca_result shot_detection_batch(const vca_shot_detection_param *params,
+                                size_t num_params,
+                                const vca_frame_results *frames,
+                                size_t num_frames,
+                                bool *isNewShot);
+
+/* Incremental version of shot_detection. The decisions are identical to the two pass
+ * algorithm. The second pass only needs the distance to the next unsure frame, so an
+ * unsure frame can be decided as soon as either another unsure frame shows up within
+ * fps frames or fps frames have passed without one.
+ */
+class ShotDetector
+{
+public:
+    ShotDetector(vca_shot_detection_param param);
+
+    vca_result push(const vca_frame_results &frame);
+    vca_result flush();
+    bool resultAvailable();
+    vca_result pull(vca_frame_results *frame);
+
+private:
+    struct PendingFrame
+    {
+        vca_frame_results result{};
+        bool decided{};
+    };
+
+    void decide(size_t index, bool isNewShot);
+    void moveDecidedFramesToOutput();
+
+    vca_shot_detection_param param{};
+
+    size_t frameCounter{0};
+    size_t prevShotPos{0};
+    bool flushed{false};
+
+    std::deque<PendingFrame> pendingFrames;
+    size_t firstPendingIndex{0};
+
+    struct UnsureFrame
+    {
+        size_t index{};
+        size_t previousShotDistance{};
+    };
+    std::deque<UnsureFrame> undecidedUnsureFrames;
+
+    std::deque<vca_frame_results> decidedFrames;
+};
+
+} // namespace vca
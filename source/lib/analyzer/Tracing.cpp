@@ -0,0 +1,106 @@
+/* Copyright (C) 2024 Christian Doppler Laboratory ATHENA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.
+ *****************************************************************************/
+
+
+#include "Tracing.h"
+
+#include <string>
+
+namespace vca {
+
+namespace {
+
+// The trace event format has timestamps in microseconds
+std::string toMicroseconds(int64_t nanoseconds)
+{
+    const auto microseconds = std::to_string(nanoseconds / 1000);
+    auto fraction           = std::to_string(nanoseconds % 1000);
+    return microseconds + "." + std::string(3 - fraction.size(), '0') + fraction;
+}
+
+} // namespace
+
+TraceBuffer::TraceBuffer(size_t capacity, Clock::time_point startTime)
+    : startTime(startTime), events(capacity)
+{}
+
+void TraceBuffer::add(const char *name,
+                      unsigned jobID,
+                      Clock::time_point start,
+                      Clock::time_point end)
+{
+    const auto index = this->nrEvents.load(std::memory_order_relaxed);
+    if (index == this->events.size())
+    {
+        this->nrDropped++;
+        return;
+    }
+
+    auto &event    = this->events[index];
+    event.name     = name;
+    event.jobID    = jobID;
+    event.start    = std::chrono::nanoseconds(start - this->startTime).count();
+    event.duration = std::chrono::nanoseconds(end - start).count();
+
+    // Publish the event to readers on other threads
+    this->nrEvents.store(index + 1, std::memory_order_release);
+}
+
+Tracer::Tracer(unsigned nrThreads, size_t eventsPerThread) : nrThreads(nrThreads)
+{
+    const auto startTime = TraceBuffer::Clock::now();
+    for (unsigned i = 0; i < nrThreads + 2; i++)
+        this->buffers.push_back(std::make_unique<TraceBuffer>(eventsPerThread, startTime));
+}
+
+void Tracer::write(std::ostream &stream) const
+{
+    stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    for (unsigned tid = 0; tid < this->buffers.size(); tid++)
+    {
+        std::string threadName;
+        if (tid < this->nrThreads)
+            threadName = "Processing thread " + std::to_string(tid);
+        else
+            threadName = (tid == this->nrThreads) ? "Push" : "Pull";
+        stream << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << tid
+               << ",\"args\":{\"name\":\"" << threadName << "\"}},\n";
+        stream << "{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":0,\"tid\":" << tid
+               << ",\"args\":{\"sort_index\":" << tid << "}}";
+
+        const auto &buffer = *this->buffers[tid];
+        const auto size    = buffer.size();
+        for (size_t i = 0; i < size; i++)
+        {
+            const auto &event = buffer[i];
+            stream << ",\n{\"name\":\"" << event.name << "\",\"cat\":\"vca\",\"ph\":\"X\",\"ts\":"
+                   << toMicroseconds(event.start) << ",\"dur\":" << toMicroseconds(event.duration)
+                   << ",\"pid\":0,\"tid\":" << tid << ",\"args\":{\"job\":" << event.jobID << "}}";
+        }
+        stream << (tid + 1 < this->buffers.size() ? ",\n" : "\n");
+    }
+    stream << "]}\n";
+}
+
+uint64_t Tracer::getNrDroppedEvents() const
+{
+    uint64_t nrDropped = 0;
+    for (const auto &buffer : this->buffers)
+        nrDropped += buffer->getNrDroppedEvents();
+    return nrDropped;
+}
+
+} // namespace vca
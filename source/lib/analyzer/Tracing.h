@@ -0,0 +1,105 @@
+/* Copyright (C) 2024 Christian Doppler Laboratory ATHENA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.
+ *****************************************************************************/
+
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <vector>
+
+namespace vca {
+
+// A span of work of a thread. The name must be a string literal. The times are in ns since
+// the start of the trace.
+struct TraceEvent
+{
+    const char *name{};
+    unsigned jobID{};
+    int64_t start{};
+    int64_t duration{};
+};
+
+// The events of one thread with a fixed capacity. Only this thread adds events. Other
+// threads can read the events that were added so far at any time without locking. If the
+// buffer is full, further events are dropped.
+class TraceBuffer
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    TraceBuffer(size_t capacity, Clock::time_point startTime);
+
+    void add(const char *name, unsigned jobID, Clock::time_point start, Clock::time_point end);
+
+    size_t size() const { return this->nrEvents.load(std::memory_order_acquire); }
+    const TraceEvent &operator[](size_t i) const { return this->events[i]; }
+    uint64_t getNrDroppedEvents() const { return this->nrDropped.load(); }
+
+private:
+    Clock::time_point startTime;
+    std::vector<TraceEvent> events;
+    std::atomic<size_t> nrEvents{};
+    std::atomic<uint64_t> nrDropped{};
+};
+
+// Adds the time from construction to destruction as an event. Does nothing without a buffer.
+class TraceSpan
+{
+public:
+    TraceSpan(TraceBuffer *buffer, const char *name, unsigned jobID)
+        : buffer(buffer), name(name), jobID(jobID)
+    {
+        if (this->buffer)
+            this->start = TraceBuffer::Clock::now();
+    }
+    ~TraceSpan()
+    {
+        if (this->buffer)
+            this->buffer->add(this->name, this->jobID, this->start, TraceBuffer::Clock::now());
+    }
+
+private:
+    TraceBuffer *buffer{};
+    const char *name{};
+    unsigned jobID{};
+    TraceBuffer::Clock::time_point start;
+};
+
+// One buffer per processing thread and one each for the threads that push the frames and
+// pull the results (see vca_param::enableTracing)
+class Tracer
+{
+public:
+    Tracer(unsigned nrThreads, size_t eventsPerThread);
+
+    TraceBuffer *getThreadBuffer(unsigned thread) { return this->buffers.at(thread).get(); }
+    TraceBuffer *getPushBuffer() { return this->buffers.at(this->nrThreads).get(); }
+    TraceBuffer *getPullBuffer() { return this->buffers.at(this->nrThreads + 1).get(); }
+
+    // Writes the events recorded so far in the Chrome trace event JSON format
+    void write(std::ostream &stream) const;
+    uint64_t getNrDroppedEvents() const;
+
+private:
+    unsigned nrThreads{};
+    std::vector<std::unique_ptr<TraceBuffer>> buffers;
+};
+
+} // namespace vca
@@ -21,8 +21,12 @@
 #include <analyzer/common/EnumMapper.h>
 #include <vcaLib.h>
 
+#include <algorithm>
+#include <chrono>
+#include <iterator>
 #include <mutex>
 #include <string>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -40,12 +44,40 @@ const auto CpuSimdMapper = EnumMapper<CpuSimd>({{CpuSimd::None, "NoSimd"},
                                                 {CpuSimd::SSE4, "SSE4"},
                                                 {CpuSimd::AVX2, "AVX2"}});
 
-inline void log(const vca_param &cfg, LogLevel level, const std::string &message)
+// Messages above vca_param::logLevel are neither formatted nor passed to the log function
+inline bool isLogged(const vca_param &cfg, LogLevel level)
+{
+    return cfg.logFunction != nullptr && level <= cfg.logLevel;
+}
+
+// Serializes the calls of the log function. The processing threads log through a LogRing
+// (see Logging.h) and never wait for this mutex.
+inline std::mutex &getLoggingMutex()
 {
     static std::mutex loggingMutex;
-    std::unique_lock<std::mutex> lock(loggingMutex);
-    if (cfg.logFunction)
-        cfg.logFunction(cfg.logFunctionPrivateData, level, message.c_str());
+    return loggingMutex;
+}
+
+inline void log(const vca_param &cfg, LogLevel level, const std::string &message)
+{
+    if (!isLogged(cfg, level))
+        return;
+    std::unique_lock<std::mutex> lock(getLoggingMutex());
+    cfg.logFunction(cfg.logFunctionPrivateData, level, message.c_str());
+}
+
+// Only calls makeMessage if the level is logged
+template<typename MakeMessage, typename = std::enable_if_t<std::is_invocable_v<MakeMessage>>>
+void log(const vca_param &cfg, LogLevel level, MakeMessage &&makeMessage)
+{
+    if (isLogged(cfg, level))
+        log(cfg, level, makeMessage());
+}
+
+// Check if any of the given outputs (VCA_OUTPUT_* flags) is in vca_param::requiredOutputs
+inline bool isOutputRequired(const vca_param &cfg, uint32_t outputs)
+{
+    return (cfg.requiredOutputs & outputs) != 0;
 }
 
 inline std::pair<unsigned, unsigned> getFrameSizeInBlocks(unsigned blockSize,
@@ -65,6 +97,70 @@ inline std::pair<unsigned, unsigned> getChromaFrameSizeInBlocks(unsigned blockSi
     return {widthInBlocks, heightInBlock};
 }
 
+inline std::pair<unsigned, unsigned> getChromaSubsampling(vca_colorSpace colorspace)
+{
+    const auto subsamplingX = (colorspace == vca_colorSpace::YUV444) ? 1u : 2u;
+    const auto subsamplingY = (colorspace == vca_colorSpace::YUV420) ? 2u : 1u;
+    return {subsamplingX, subsamplingY};
+}
+
+// The blocks [left, right) x [top, bottom) of a plane that are analyzed
+struct BlockRegion
+{
+    unsigned left{};
+    unsigned top{};
+    unsigned right{};
+    unsigned bottom{};
+
+    unsigned getNrBlocks() const
+    {
+        return (this->right - this->left) * (this->bottom - this->top);
+    }
+};
+
+// Get the blocks of a plane that intersect the region of interest. The region of interest is
+// given in luma samples and is scaled by the subsampling for the chroma planes. An empty
+// region of interest selects all blocks of the plane.
+inline BlockRegion getBlockRegion(const vca_rect &regionOfInterest,
+                                  unsigned blockSize,
+                                  std::pair<unsigned, unsigned> sizeInBlocks,
+                                  std::pair<unsigned, unsigned> subsampling = {1, 1})
+{
+    const auto [widthInBlocks, heightInBlocks] = sizeInBlocks;
+    if (regionOfInterest.width == 0 || regionOfInterest.height == 0)
+        return {0, 0, widthInBlocks, heightInBlocks};
+
+    const auto [subsamplingX, subsamplingY] = subsampling;
+    const auto blockWidth  = blockSize * subsamplingX;
+    const auto blockHeight = blockSize * subsamplingY;
+    const auto right       = regionOfInterest.x + regionOfInterest.width;
+    const auto bottom      = regionOfInterest.y + regionOfInterest.height;
+
+    BlockRegion region;
+    region.left   = std::min(regionOfInterest.x / blockWidth, widthInBlocks);
+    region.top    = std::min(regionOfInterest.y / blockHeight, heightInBlocks);
+    region.right  = std::min((right + blockWidth - 1) / blockWidth, widthInBlocks);
+    region.bottom = std::min((bottom + blockHeight - 1) / blockHeight, heightInBlocks);
+    return region;
+}
+
+// Extend the rectangle to the block grid. Returns an empty rectangle if this covers the
+// whole frame.
+inline vca_rect alignToBlockGrid(const vca_rect &rect,
+                                 unsigned blockSize,
+                                 const vca_frame_info &info)
+{
+    const auto left   = rect.x / blockSize * blockSize;
+    const auto top    = rect.y / blockSize * blockSize;
+    const auto right  = std::min((rect.x + rect.width + blockSize - 1) / blockSize * blockSize,
+                                 info.width);
+    const auto bottom = std::min((rect.y + rect.height + blockSize - 1) / blockSize * blockSize,
+                                 info.height);
+    if (left == 0 && top == 0 && right == info.width && bottom == info.height)
+        return {};
+    return {left, top, right - left, bottom - top};
+}
+
 struct MacroblockRange
 {
     unsigned start{};
@@ -77,6 +173,28 @@ struct Job
     MacroblockRange macroblockRange;
     unsigned jobID;
 
+    // Only the blocks that intersect this region (in luma samples) are analyzed. An empty
+    // region means the whole frame.
+    vca_rect regionOfInterest{};
+
+    // The frame was decimated by this factor before the analysis
+    unsigned decimationFactor{1};
+
+    // Blocks of 64x64 or 128x128 samples are analyzed as 32x32 blocks of the frame decimated
+    // by this factor (2 or 4). This is independent of decimationFactor.
+    unsigned largeBlockFactor{1};
+
+    // Only one out of samplingInterval blocks is analyzed (see BlockSampler)
+    unsigned samplingInterval{1};
+    vca_sampling_pattern samplingPattern{vca_sampling_pattern::Stratified};
+
+    // The frame does not follow the previous frame (see vca_frame::isDiscontinuity)
+    bool isDiscontinuity{};
+
+    // The quality tier of the real-time mode and the time when the frame was pushed
+    unsigned qualityTier{};
+    std::chrono::steady_clock::time_point pushTime{};
+
     std::string infoString()
     {
         return "Job " + std::to_string(this->jobID) + " POC "
@@ -85,6 +203,128 @@ struct Job
     }
 };
 
+// The time in seconds spent in each stage of the analysis of a frame (see vca_stage). Only
+// measured if enabled.
+struct StageTimes
+{
+    // Reading the clock for every block would cost more than the transform of a small block.
+    // The stages that are measured per block only measure every BlockSamplingInterval-th
+    // block and count its time for all blocks of the interval.
+    static constexpr unsigned BlockSamplingInterval = 16;
+
+    bool enabled{};
+    unsigned nrBlocks{};
+    double seconds[VCA_NR_STAGES]{};
+
+    void add(vca_stage stage, double time) { this->seconds[unsigned(stage)] += time; }
+
+    // Count a block of a per block stage and check if its time is measured
+    bool isBlockSampled()
+    {
+        return this->enabled && (this->nrBlocks++ % BlockSamplingInterval) == 0;
+    }
+};
+
+// Adds the time from construction to destruction to a stage. Timers within the scope of a
+// running timer are not measured, so their time only counts for the outer stage. Does not
+// read the clock if the times are not enabled.
+class StageTimer
+{
+public:
+    StageTimer(StageTimes &times, vca_stage stage)
+        : StageTimer(times, stage, times.enabled, 1.0)
+    {
+    }
+
+    // A timer of a per block stage. It only measures if the block is sampled (see
+    // StageTimes::isBlockSampled) and counts the time for all blocks of the interval.
+    StageTimer(StageTimes &times, vca_stage stage, bool isBlockSampled)
+        : StageTimer(times, stage, isBlockSampled, double(StageTimes::BlockSamplingInterval))
+    {
+    }
+
+    ~StageTimer()
+    {
+        if (this->isRunning)
+        {
+            const auto time = std::chrono::steady_clock::now() - this->startTime;
+            this->times.add(this->stage,
+                            std::chrono::duration<double>(time).count() * this->weight);
+            this->times.enabled = true;
+        }
+    }
+
+private:
+    StageTimer(StageTimes &times, vca_stage stage, bool measure, double weight)
+        : times(times), stage(stage), weight(weight), isRunning(measure && times.enabled)
+    {
+        if (this->isRunning)
+        {
+            this->times.enabled = false;
+            this->startTime     = std::chrono::steady_clock::now();
+        }
+    }
+
+    StageTimes &times;
+    vca_stage stage;
+    double weight{};
+    bool isRunning{};
+    std::chrono::steady_clock::time_point startTime;
+};
+
+// Measures a loop over the blocks of a frame that contains per block stage timers. If the
+// extrapolated times of the sampled blocks add up to more than the loop took (e.g. because a
+// sampled block was interrupted by the operating system), they are scaled down to the time of
+// the loop.
+class BlockLoopTimer
+{
+public:
+    explicit BlockLoopTimer(StageTimes &times)
+        : times(times), isRunning(times.enabled)
+    {
+        if (this->isRunning)
+        {
+            std::copy(std::begin(times.seconds), std::end(times.seconds), this->startSeconds);
+            this->startTime = std::chrono::steady_clock::now();
+        }
+    }
+    ~BlockLoopTimer()
+    {
+        if (!this->isRunning)
+            return;
+
+        const auto time     = std::chrono::steady_clock::now() - this->startTime;
+        const auto loopTime = std::chrono::duration<double>(time).count();
+        double blockTime    = 0.0;
+        for (unsigned i = 0; i < VCA_NR_STAGES; i++)
+            blockTime += this->times.seconds[i] - this->startSeconds[i];
+        if (blockTime <= loopTime)
+            return;
+        for (unsigned i = 0; i < VCA_NR_STAGES; i++)
+            this->times.seconds[i] = this->startSeconds[i]
+                                     + (this->times.seconds[i] - this->startSeconds[i])
+                                           * loopTime / blockTime;
+    }
+
+private:
+    StageTimes &times;
+    bool isRunning{};
+    double startSeconds[VCA_NR_STAGES]{};
+    std::chrono::steady_clock::time_point startTime;
+};
+
+// The results on a coarser block grid derived from the results of the analysis block size
+struct BlockGridResult
+{
+    unsigned blockSize{};
+    std::vector<uint32_t> brightnessPerBlock;
+    std::vector<uint32_t> energyPerBlock;
+    std::vector<double> edgeDensityPerBlock;
+    uint32_t averageBrightness{};
+    uint32_t averageEnergy{};
+    double averageEdgeDensity{};
+};
+
 struct Result
 {
     std::vector<uint32_t> brightnessPerBlock;
@@ -117,6 +357,49 @@ struct Result
     std::vector<double> edgeDensityPerBlock;
     double averageEdgeDensity{};
 
+    // The half width of the 95% confidence intervals of the frame averages if only a sample
+    // of the blocks was analyzed
+    double averageEnergyConfidence{};
+    double entropyConfidence{};
+    double averageEdgeDensityConfidence{};
+
+    // The results at vca_param::blockGridSizes (in the same order)
+    std::vector<BlockGridResult> blockGrids;
+
+    // Number of blocks that were analyzed / skipped as flat blocks / copied from the static
+    // block cache summed over all features
+    unsigned nrAnalyzedBlocks{};
+    unsigned nrSkippedBlocks{};
+    unsigned nrReusedBlocks{};
+
+    // The frame is identical to the previous frame. The results are not calculated but
+    // copied from the previous frame in Analyzer::pullResult.
+    bool isDuplicate{};
+
+    // No temporal differences are calculated to the previous frame
+    bool isDiscontinuity{};
+
+    // The quality tier of the real-time mode that analyzed the frame, the time that a thread
+    // worked on it and the time from pushing the frame until the result was ready (seconds)
+    unsigned qualityTier{};
+    double processingTime{};
+    double latency{};
+
+    // The time that the thread waited for this job (seconds) and the index of the thread
+    double idleTime{};
+    unsigned threadIndex{};
+
+    StageTimes stageTimes;
+
+    // The analyzed region of the frame. The frame averages and the temporal differences are
+    // calculated over the nrBlocksInRegion luma blocks in this region. The per block values
+    // of all other blocks are 0.
+    vca_rect regionOfInterest{};
+    unsigned nrBlocksInRegion{};
+
+    // The results at vca_param::ladderResolutions (in the same order)
+    std::vector<Result> ladderResults;
+
     int poc{};
     unsigned jobID{};
 };
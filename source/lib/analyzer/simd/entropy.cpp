@@ -26,15 +26,15 @@
 #include <unordered_map>
 
 // x86 AVX2 SIMD optimized entropy function
-double entropy_avx2(const std::vector<int16_t> &block)
+double entropy_avx2(const int16_t *block, unsigned nrSamples)
 {
     std::unordered_map<int, int> pixelCounts;
-    int totalPixels = static_cast<int>(block.size());
+    int totalPixels = static_cast<int>(nrSamples);
 
     // Count occurrences of each pixel value
-    for (int pixel : block)
+    for (unsigned i = 0; i < nrSamples; i++)
     {
-        pixelCounts[pixel]++;
+        pixelCounts[block[i]]++;
     }
 
     // Calculate entropy
@@ -23,4 +23,4 @@
 
 #include <stdint.h>
 
-double entropy_avx2(const std::vector<int16_t> &block);
+double entropy_avx2(const int16_t *block, unsigned nrSamples);
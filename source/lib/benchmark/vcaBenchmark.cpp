@@ -0,0 +1,634 @@
+/* Copyright (C) 2024 Christian Doppler Laboratory ATHENA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.
+ *****************************************************************************/
+
+// Times the analysis kernels in isolation. Every kernel runs on a pool of blocks that fits
+// into the caches. See docs/build.md.
+
+#include <analyzer/DCTTransform.h>
+#include <analyzer/EnergyCalculation.h>
+#include <analyzer/EntropyCalculation.h>
+#include <analyzer/EntropyNative.h>
+#include <analyzer/common/common.h>
+#include <analyzer/simd/cpu.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+#if defined(VCA_ARCH_X86)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// The number of different blocks that a kernel cycles through
+constexpr unsigned NrPoolBlocks = 64;
+
+// The blocks per frame of the temporal kernels (1920x1080 with 16x16 blocks)
+constexpr unsigned NrFrameBlocks = 120 * 68;
+
+struct Options
+{
+    unsigned repetitions{25};
+    double minRepetitionTimeMs{2.0};
+    std::string filter;
+    std::string jsonFile;
+};
+
+struct Kernel
+{
+    std::string name;
+    std::string isa;
+    unsigned blockSize{};
+    // 0 if the kernel does not depend on the bit depth
+    unsigned bitDepth{};
+    unsigned blocksPerCall{1};
+    unsigned pixelsPerBlock{};
+    std::function<void(size_t nrCalls)> run;
+};
+
+struct Statistics
+{
+    double median{};
+    double mean{};
+    double stddev{};
+    double min{};
+};
+
+struct Measurement
+{
+    const Kernel *kernel{};
+    size_t nrCallsPerRepetition{};
+    Statistics nsPerBlock;
+    // Reference cycles of the time stamp counter. Not available on all platforms.
+    std::optional<double> cyclesPerPixel;
+};
+
+// Results are accumulated here so that the compiler can not drop the kernel calls
+volatile uint64_t sink;
+
+uint64_t readTimestampCounter()
+{
+#if defined(VCA_ARCH_X86)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+bool hasTimestampCounter()
+{
+#if defined(VCA_ARCH_X86)
+    return true;
+#else
+    return false;
+#endif
+}
+
+// Buffer of int16_t values with the 32 byte alignment that the SIMD kernels expect
+class AlignedBuffer
+{
+public:
+    explicit AlignedBuffer(size_t size) : storage(size + 16)
+    {
+        const auto address = reinterpret_cast<uintptr_t>(this->storage.data());
+        this->alignedData  = this->storage.data() + ((32 - address % 32) % 32) / 2;
+    }
+
+    int16_t *data() { return this->alignedData; }
+
+private:
+    std::vector<int16_t> storage;
+    int16_t *alignedData{};
+};
+
+// Natural content is smooth with some texture. The blocks are a gradient plus noise.
+void fillWithContent(int16_t *data, unsigned width, unsigned height, unsigned bitDepth)
+{
+    std::mt19937 generator(width * 1000 + height + bitDepth);
+    const auto maxValue = (1 << bitDepth) - 1;
+    std::normal_distribution<double> noise(0.0, maxValue / 20.0);
+    for (unsigned y = 0; y < height; y++)
+        for (unsigned x = 0; x < width; x++)
+        {
+            const auto gradient = double(x + y) / (width + height) * maxValue;
+            const auto value    = int(std::lround(gradient + noise(generator)));
+            data[y * width + x] = int16_t(std::clamp(value, 0, maxValue));
+        }
+}
+
+std::vector<CpuSimd> getDCTIsas(unsigned transformSize)
+{
+    std::vector<CpuSimd> isas;
+    if (transformSize == 8)
+        isas = {CpuSimd::None, CpuSimd::SSE2, CpuSimd::SSE4, CpuSimd::AVX2};
+    else
+        isas = {CpuSimd::None, CpuSimd::SSSE3, CpuSimd::AVX2};
+    isas.erase(std::remove_if(isas.begin(),
+                              isas.end(),
+                              [](CpuSimd isa) {
+#if !ENABLE_NASM
+                                  // Without nasm the assembly kernels are only placeholders
+                                  if (isa != CpuSimd::None && isa != CpuSimd::SSSE3)
+                                      return true;
+#endif
+                                  return isa != CpuSimd::None && !vca::isSimdSupported(isa);
+                              }),
+               isas.end());
+    return isas;
+}
+
+std::string getIsaName(CpuSimd isa)
+{
+    return isa == CpuSimd::None ? "C" : vca::CpuSimdMapper.getName(isa);
+}
+
+void addDCTKernels(std::vector<Kernel> &kernels)
+{
+    for (const auto blockSize : {8u, 16u, 32u})
+        for (const auto bitDepth : {8u, 10u, 12u})
+        {
+            const auto nrSamples = blockSize * blockSize;
+            auto pool = std::make_shared<AlignedBuffer>(NrPoolBlocks * nrSamples + nrSamples);
+            fillWithContent(pool->data(), nrSamples, NrPoolBlocks + 1, bitDepth);
+
+            for (const auto isa : getDCTIsas(blockSize))
+                kernels.push_back({"dct",
+                                   getIsaName(isa),
+                                   blockSize,
+                                   bitDepth,
+                                   1,
+                                   nrSamples,
+                                   [=](size_t nrCalls) {
+                                       // The coefficients are written behind the pool
+                                       auto coeff = pool->data() + NrPoolBlocks * nrSamples;
+                                       for (size_t i = 0; i < nrCalls; i++)
+                                       {
+                                           auto block = pool->data()
+                                                        + (i % NrPoolBlocks) * nrSamples;
+                                           vca::performDCT(
+                                               blockSize, bitDepth, block, coeff, isa, false);
+                                           sink += uint16_t(coeff[0]);
+                                       }
+                                   }});
+        }
+}
+
+// The lowpass DCT from the full resolution block (downsampled in the kernel) and from the
+// block of a HalfResolutionFrame
+void addLowpassDCTKernels(std::vector<Kernel> &kernels)
+{
+    for (const auto blockSize : {16u, 32u})
+        for (const auto bitDepth : {8u, 10u, 12u})
+        {
+            const auto nrSamples     = blockSize * blockSize;
+            const auto halfBlockSize = blockSize / 2;
+            auto pool = std::make_shared<AlignedBuffer>(NrPoolBlocks * nrSamples + nrSamples);
+            fillWithContent(pool->data(), nrSamples, NrPoolBlocks + 1, bitDepth);
+
+            // A row of half resolution blocks
+            const auto halfResStride = NrPoolBlocks * halfBlockSize;
+            auto halfRes = std::make_shared<AlignedBuffer>(halfResStride * halfBlockSize);
+            fillWithContent(halfRes->data(), halfResStride, halfBlockSize, bitDepth);
+
+            for (const auto isa : getDCTIsas(blockSize / 2))
+            {
+                kernels.push_back({"lowpassDct",
+                                   getIsaName(isa),
+                                   blockSize,
+                                   bitDepth,
+                                   1,
+                                   nrSamples,
+                                   [=](size_t nrCalls) {
+                                       auto coeff = pool->data() + NrPoolBlocks * nrSamples;
+                                       for (size_t i = 0; i < nrCalls; i++)
+                                       {
+                                           auto block = pool->data()
+                                                        + (i % NrPoolBlocks) * nrSamples;
+                                           vca::performDCT(
+                                               blockSize, bitDepth, block, coeff, isa, true);
+                                           sink += uint16_t(coeff[0]);
+                                       }
+                                   }});
+                kernels.push_back({"lowpassDctHalfResolution",
+                                   getIsaName(isa),
+                                   blockSize,
+                                   bitDepth,
+                                   1,
+                                   nrSamples,
+                                   [=](size_t nrCalls) {
+                                       auto coeff = pool->data() + NrPoolBlocks * nrSamples;
+                                       for (size_t i = 0; i < nrCalls; i++)
+                                       {
+                                           auto block = halfRes->data()
+                                                        + (i % NrPoolBlocks) * halfBlockSize;
+                                           vca::performLowpassDCT(blockSize,
+                                                                  bitDepth,
+                                                                  block,
+                                                                  halfResStride,
+                                                                  int32_t(i),
+                                                                  coeff,
+                                                                  isa);
+                                           sink += uint16_t(coeff[1]);
+                                       }
+                                   }});
+            }
+        }
+}
+
+void addWeightedCoeffSumKernels(std::vector<Kernel> &kernels)
+{
+    for (const auto blockSize : {8u, 16u, 32u})
+    {
+        // The coefficients of the DCT of natural content
+        const auto nrSamples = blockSize * blockSize;
+        auto pool = std::make_shared<AlignedBuffer>(NrPoolBlocks * nrSamples + nrSamples);
+        fillWithContent(pool->data(), nrSamples, NrPoolBlocks + 1, 8);
+        ALIGN_VAR_32(int16_t, coeff[32 * 32]);
+        for (unsigned i = 0; i < NrPoolBlocks; i++)
+        {
+            auto block = pool->data() + i * nrSamples;
+            vca::performDCT(blockSize, 8, block, coeff, CpuSimd::None, false);
+            std::memcpy(block, coeff, nrSamples * sizeof(int16_t));
+        }
+
+        kernels.push_back({"calculateWeightedCoeffSum",
+                           "C",
+                           blockSize,
+                           0,
+                           1,
+                           nrSamples,
+                           [=](size_t nrCalls) {
+                               for (size_t i = 0; i < nrCalls; i++)
+                               {
+                                   auto block = pool->data() + (i % NrPoolBlocks) * nrSamples;
+                                   sink += vca::calculateWeightedCoeffSum(blockSize, block, false);
+                               }
+                           }});
+    }
+}
+
+void addEntropyAndEdgeDensityKernels(std::vector<Kernel> &kernels)
+{
+    for (const auto blockSize : {8u, 16u, 32u})
+        for (const auto bitDepth : {8u, 10u, 12u})
+        {
+            const auto nrSamples = blockSize * blockSize;
+            auto pool = std::make_shared<AlignedBuffer>(NrPoolBlocks * nrSamples);
+            fillWithContent(pool->data(), nrSamples, NrPoolBlocks, bitDepth);
+
+            kernels.push_back({"entropy_c",
+                               "C",
+                               blockSize,
+                               bitDepth,
+                               1,
+                               nrSamples,
+                               [=](size_t nrCalls) {
+                                   for (size_t i = 0; i < nrCalls; i++)
+                                   {
+                                       auto block = pool->data() + (i % NrPoolBlocks) * nrSamples;
+                                       sink += uint64_t(vca::entropy_c(block, nrSamples) * 1000);
+                                   }
+                               }});
+            kernels.push_back({"performEdgeDensity",
+                               "C",
+                               blockSize,
+                               bitDepth,
+                               1,
+                               nrSamples,
+                               [=](size_t nrCalls) {
+                                   for (size_t i = 0; i < nrCalls; i++)
+                                   {
+                                       auto block = pool->data() + (i % NrPoolBlocks) * nrSamples;
+                                       const auto density = vca::performEdgeDensity(
+                                           blockSize, bitDepth, block, CpuSimd::None, false);
+                                       sink += uint64_t(density * 1000);
+                                   }
+                               }});
+        }
+}
+
+// Copy from a plane like in the analysis. The padded variant copies the blocks at the
+// bottom right border of the frame of which only the top left quarter is in the frame.
+void addCopyKernels(std::vector<Kernel> &kernels)
+{
+    for (const auto blockSize : {8u, 16u, 32u})
+        for (const auto bitDepth : {8u, 10u})
+        {
+            const auto bytesPerSample = bitDepth > 8 ? 2u : 1u;
+            const auto strideBytes    = NrPoolBlocks * blockSize * bytesPerSample;
+            const auto nrSamples      = blockSize * blockSize;
+
+            std::vector<int16_t> content(NrPoolBlocks * nrSamples);
+            fillWithContent(content.data(), NrPoolBlocks * blockSize, blockSize, bitDepth);
+            auto plane = std::make_shared<std::vector<uint8_t>>(strideBytes * blockSize);
+            if (bytesPerSample == 1)
+                std::transform(content.begin(), content.end(), plane->begin(), [](int16_t v) {
+                    return uint8_t(v);
+                });
+            else
+                std::memcpy(plane->data(), content.data(), plane->size());
+
+            for (const auto padding : {0u, blockSize / 2})
+                kernels.push_back({padding == 0 ? "copyPixelValuesToBuffer"
+                                                : "copyPixelValuesToBufferWithPadding",
+                                   "C",
+                                   blockSize,
+                                   bitDepth,
+                                   1,
+                                   nrSamples,
+                                   [=](size_t nrCalls) {
+                                       ALIGN_VAR_32(int16_t, buffer[32 * 32]);
+                                       for (size_t i = 0; i < nrCalls; i++)
+                                       {
+                                           const auto offset = unsigned(i % NrPoolBlocks)
+                                                               * blockSize * bytesPerSample;
+                                           vca::copyPixelValuesToBuffer(bitDepth,
+                                                                        offset,
+                                                                        blockSize,
+                                                                        plane->data(),
+                                                                        strideBytes,
+                                                                        buffer,
+                                                                        padding,
+                                                                        padding);
+                                           sink += uint16_t(buffer[nrSamples - 1]);
+                                       }
+                                   }});
+        }
+}
+
+// The differences to the previous frame. One call processes all blocks of a frame.
+void addTemporalKernels(std::vector<Kernel> &kernels)
+{
+    std::mt19937 generator(1);
+    std::uniform_int_distribution<uint32_t> energy(0, 5000);
+    std::uniform_real_distribution<double> entropy(0.0, 8.0);
+
+    auto frames = std::make_shared<std::vector<vca::Result>>(2);
+    for (auto &frame : *frames)
+    {
+        frame.nrBlocksInRegion = NrFrameBlocks;
+        for (unsigned i = 0; i < NrFrameBlocks; i++)
+        {
+            frame.energyPerBlock.push_back(energy(generator));
+            frame.energyDiffPerBlock.push_back(energy(generator));
+            frame.entropyPerBlock.push_back(entropy(generator));
+        }
+        frame.energyEpsilonPerBlock.resize(NrFrameBlocks);
+        frame.entropyDiffPerBlock.resize(NrFrameBlocks);
+    }
+
+    const std::vector<std::pair<std::string, void (*)(vca::Result &, const vca::Result &)>>
+        temporalKernels = {{"computeTextureSAD", &vca::computeTextureSAD},
+                           {"computeTextureEpsilon", &vca::computeTextureEpsilon},
+                           {"computeEntropySAD", &vca::computeEntropySAD}};
+    for (const auto &[name, function] : temporalKernels)
+        kernels.push_back({name,
+                           "C",
+                           16,
+                           0,
+                           NrFrameBlocks,
+                           16 * 16,
+                           [frames, function = function](size_t nrCalls) {
+                               auto &current        = frames->at(0);
+                               const auto &previous = frames->at(1);
+                               for (size_t i = 0; i < nrCalls; i++)
+                               {
+                                   function(current, previous);
+                                   sink += current.energyDiffPerBlock[i % NrFrameBlocks];
+                               }
+                           }});
+}
+
+std::vector<Kernel> createKernels()
+{
+    std::vector<Kernel> kernels;
+    addDCTKernels(kernels);
+    addLowpassDCTKernels(kernels);
+    addWeightedCoeffSumKernels(kernels);
+    addEntropyAndEdgeDensityKernels(kernels);
+    addCopyKernels(kernels);
+    addTemporalKernels(kernels);
+    return kernels;
+}
+
+std::string getKernelID(const Kernel &kernel)
+{
+    auto id = kernel.name + "/" + kernel.isa + "/" + std::to_string(kernel.blockSize);
+    if (kernel.bitDepth > 0)
+        id += "/" + std::to_string(kernel.bitDepth) + "bit";
+    return id;
+}
+
+Statistics calculateStatistics(std::vector<double> values)
+{
+    Statistics statistics;
+    std::sort(values.begin(), values.end());
+    const auto n      = values.size();
+    statistics.median = (n % 2 == 1) ? values[n / 2] : (values[n / 2 - 1] + values[n / 2]) / 2;
+    statistics.min    = values.front();
+    for (const auto value : values)
+        statistics.mean += value;
+    statistics.mean /= double(n);
+    if (n > 1)
+    {
+        for (const auto value : values)
+            statistics.stddev += (value - statistics.mean) * (value - statistics.mean);
+        statistics.stddev = std::sqrt(statistics.stddev / double(n - 1));
+    }
+    return statistics;
+}
+
+double getElapsedMs(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+Measurement measure(const Kernel &kernel, const Options &options)
+{
+    // Warm up the caches and the clock of the CPU. The number of calls is doubled until
+    // one repetition takes at least the minimum repetition time.
+    size_t nrCalls = 1;
+    while (true)
+    {
+        const auto start = Clock::now();
+        kernel.run(nrCalls);
+        if (getElapsedMs(start) >= options.minRepetitionTimeMs)
+            break;
+        nrCalls *= 2;
+    }
+    kernel.run(nrCalls);
+
+    const auto nrBlocks = double(nrCalls) * kernel.blocksPerCall;
+    std::vector<double> nsPerBlock;
+    std::vector<double> cyclesPerPixel;
+    for (unsigned i = 0; i < options.repetitions; i++)
+    {
+        const auto start      = Clock::now();
+        const auto startTicks = readTimestampCounter();
+        kernel.run(nrCalls);
+        const auto ticks = readTimestampCounter() - startTicks;
+        const auto ns    = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+
+        nsPerBlock.push_back(ns / nrBlocks);
+        cyclesPerPixel.push_back(double(ticks) / (nrBlocks * kernel.pixelsPerBlock));
+    }
+
+    Measurement measurement;
+    measurement.kernel               = &kernel;
+    measurement.nrCallsPerRepetition = nrCalls;
+    measurement.nsPerBlock           = calculateStatistics(nsPerBlock);
+    if (hasTimestampCounter())
+        measurement.cyclesPerPixel = calculateStatistics(cyclesPerPixel).median;
+    return measurement;
+}
+
+void writeJson(std::ostream &stream,
+               const Options &options,
+               const std::vector<Measurement> &measurements)
+{
+    stream << std::setprecision(6);
+    stream << "{\n";
+    stream << "  \"version\": \"" << vca_version_str << "\",\n";
+    stream << "  \"maxSimd\": \"" << vca::CpuSimdMapper.getName(vca::cpuDetectMaxSimd()) << "\",\n";
+    stream << "  \"repetitions\": " << options.repetitions << ",\n";
+    stream << "  \"minRepetitionTimeMs\": " << options.minRepetitionTimeMs << ",\n";
+    stream << "  \"benchmarks\": [";
+    for (size_t i = 0; i < measurements.size(); i++)
+    {
+        const auto &measurement = measurements[i];
+        const auto &kernel      = *measurement.kernel;
+        const auto &ns          = measurement.nsPerBlock;
+        stream << (i == 0 ? "\n" : ",\n");
+        stream << "    {\"kernel\": \"" << kernel.name << "\", \"isa\": \"" << kernel.isa
+               << "\", \"blockSize\": " << kernel.blockSize
+               << ", \"bitDepth\": " << kernel.bitDepth
+               << ", \"blocksPerRepetition\": "
+               << measurement.nrCallsPerRepetition * kernel.blocksPerCall
+               << ", \"nsPerBlock\": {\"median\": " << ns.median << ", \"mean\": " << ns.mean
+               << ", \"stddev\": " << ns.stddev << ", \"min\": " << ns.min
+               << "}, \"cyclesPerPixel\": ";
+        if (measurement.cyclesPerPixel)
+            stream << *measurement.cyclesPerPixel;
+        else
+            stream << "null";
+        stream << "}";
+    }
+    stream << "\n  ]\n}\n";
+}
+
+void printUsage()
+{
+    std::cout << "Usage: vcaBenchmark [options]\n"
+              << "  --filter <text>          Only run the kernels of which the ID contains text\n"
+              << "  --repetitions <n>        Number of timed repetitions per kernel (25)\n"
+              << "  --min-time <ms>          Minimum duration of one repetition (2.0)\n"
+              << "  --json <file>            Write the results as JSON to file\n"
+              << "  --list                   List the kernel IDs and exit\n";
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    Options options;
+    bool listOnly = false;
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+        const auto hasValue   = i + 1 < argc;
+        try
+        {
+            if (arg == "--filter" && hasValue)
+                options.filter = argv[++i];
+            else if (arg == "--repetitions" && hasValue)
+                options.repetitions = unsigned(std::stoul(argv[++i]));
+            else if (arg == "--min-time" && hasValue)
+                options.minRepetitionTimeMs = std::stod(argv[++i]);
+            else if (arg == "--json" && hasValue)
+                options.jsonFile = argv[++i];
+            else if (arg == "--list")
+                listOnly = true;
+            else
+            {
+                printUsage();
+                return arg == "--help" ? 0 : 1;
+            }
+        }
+        catch (const std::exception &)
+        {
+            std::cerr << "Invalid value for " << arg << "\n";
+            return 1;
+        }
+    }
+    if (options.repetitions == 0)
+    {
+        std::cerr << "At least one repetition is required\n";
+        return 1;
+    }
+
+    const auto kernels = createKernels();
+    std::vector<Measurement> measurements;
+    std::cout << std::fixed << std::setprecision(2);
+    for (const auto &kernel : kernels)
+    {
+        const auto id = getKernelID(kernel);
+        if (id.find(options.filter) == std::string::npos)
+            continue;
+        if (listOnly)
+        {
+            std::cout << id << "\n";
+            continue;
+        }
+
+        const auto measurement = measure(kernel, options);
+        std::cout << std::left << std::setw(48) << id << std::right << std::setw(12)
+                  << measurement.nsPerBlock.median << " ns/block +- " << std::setw(8)
+                  << measurement.nsPerBlock.stddev;
+        if (measurement.cyclesPerPixel)
+            std::cout << std::setw(10) << *measurement.cyclesPerPixel << " cycles/pixel";
+        std::cout << std::endl;
+        measurements.push_back(measurement);
+    }
+
+    if (!options.jsonFile.empty() && !listOnly)
+    {
+        std::ofstream file(options.jsonFile);
+        writeJson(file, options, measurements);
+        if (!file)
+        {
+            std::cerr << "Error writing " << options.jsonFile << "\n";
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,304 @@
+/* Copyright (C) 2024 Christian Doppler Laboratory ATHENA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.
+ *****************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include "common/functions.h"
+
+#include <analyzer/Analyzer.h>
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+
+namespace {
+
+enum class BlockMap
+{
+    Brightness,
+    Energy,
+    EnergyDiff,
+    EnergyEpsilon,
+    AverageU,
+    AverageV,
+    EnergyU,
+    EnergyV,
+    Entropy,
+    EntropyDiff,
+    EntropyU,
+    EntropyV,
+    EdgeDensity
+};
+
+constexpr BlockMap AllBlockMaps[] = {BlockMap::Brightness,
+                                     BlockMap::Energy,
+                                     BlockMap::EnergyDiff,
+                                     BlockMap::EnergyEpsilon,
+                                     BlockMap::AverageU,
+                                     BlockMap::AverageV,
+                                     BlockMap::EnergyU,
+                                     BlockMap::EnergyV,
+                                     BlockMap::Entropy,
+                                     BlockMap::EntropyDiff,
+                                     BlockMap::EntropyU,
+                                     BlockMap::EntropyV,
+                                     BlockMap::EdgeDensity};
+
+bool isIntegerMap(BlockMap map)
+{
+    return map != BlockMap::Entropy && map != BlockMap::EntropyDiff && map != BlockMap::EntropyU
+           && map != BlockMap::EntropyV && map != BlockMap::EdgeDensity;
+}
+
+double getFixed16Scale(BlockMap map)
+{
+    if (map == BlockMap::EdgeDensity)
+        return VCA_FIXED16_EDGE_DENSITY_SCALE;
+    if (isIntegerMap(map))
+        return 1.0;
+    return VCA_FIXED16_ENTROPY_SCALE;
+}
+
+void setPointer(vca_frame_results &result, BlockMap map, void *data)
+{
+    auto integers = static_cast<uint32_t *>(data);
+    auto doubles  = static_cast<double *>(data);
+    switch (map)
+    {
+        case BlockMap::Brightness:
+            result.brightnessPerBlock = integers;
+            break;
+        case BlockMap::Energy:
+            result.energyPerBlock = integers;
+            break;
+        case BlockMap::EnergyDiff:
+            result.energyDiffPerBlock = integers;
+            break;
+        case BlockMap::EnergyEpsilon:
+            result.energyEpsilonPerBlock = integers;
+            break;
+        case BlockMap::AverageU:
+            result.averageUPerBlock = integers;
+            break;
+        case BlockMap::AverageV:
+            result.averageVPerBlock = integers;
+            break;
+        case BlockMap::EnergyU:
+            result.energyUPerBlock = integers;
+            break;
+        case BlockMap::EnergyV:
+            result.energyVPerBlock = integers;
+            break;
+        case BlockMap::Entropy:
+            result.entropyPerBlock = doubles;
+            break;
+        case BlockMap::EntropyDiff:
+            result.entropyDiffPerBlock = doubles;
+            break;
+        case BlockMap::EntropyU:
+            result.entropyUPerBlock = doubles;
+            break;
+        case BlockMap::EntropyV:
+            result.entropyVPerBlock = doubles;
+            break;
+        case BlockMap::EdgeDensity:
+            result.edgeDensityPerBlock = doubles;
+            break;
+    }
+}
+
+// The per block maps of one frame as raw memory in the selected format
+struct FrameMaps
+{
+    std::vector<std::vector<uint8_t>> maps;
+    vca_frame_results result;
+
+    template<typename T>
+    T get(BlockMap map, size_t block) const
+    {
+        T value;
+        std::memcpy(&value, this->maps[size_t(map)].data() + block * sizeof(T), sizeof(T));
+        return value;
+    }
+};
+
+std::vector<FrameMaps> analyze(const std::vector<vca_frame *> &frames,
+                               vca_param param,
+                               vca_block_format format)
+{
+    param.blockFormat = format;
+    vca::Analyzer analyzer(param);
+    const auto [widthInBlocks, heightInBlocks] = vca::getFrameSizeInBlocks(param.blockSize,
+                                                                          param.frameInfo);
+    const auto nrBlocks = widthInBlocks * heightInBlocks;
+
+    // The buffers have the size for the native values, the reduced formats use less of it
+    std::vector<FrameMaps> results(frames.size());
+    for (size_t i = 0; i < frames.size(); i++)
+    {
+        auto &frameMaps = results[i];
+        for (const auto map : AllBlockMaps)
+        {
+            frameMaps.maps.emplace_back(nrBlocks * sizeof(double));
+            setPointer(frameMaps.result, map, frameMaps.maps.back().data());
+        }
+        EXPECT_EQ(analyzer.pushFrame(frames[i]), vca_result::VCA_OK);
+        EXPECT_EQ(analyzer.pullResult(&frameMaps.result), vca_result::VCA_OK);
+    }
+    return results;
+}
+
+double getNativeValue(const FrameMaps &frameMaps, BlockMap map, size_t block)
+{
+    if (isIntegerMap(map))
+        return frameMaps.get<uint32_t>(map, block);
+    return frameMaps.get<double>(map, block);
+}
+
+// Compare the Float32 and Fixed16 maps with the native maps within the precision of the
+// format. Counts the Fixed16 values that were saturated.
+void compareWithNative(const std::vector<FrameMaps> &native,
+                       const std::vector<FrameMaps> &float32,
+                       const std::vector<FrameMaps> &fixed16,
+                       size_t nrBlocks,
+                       unsigned &nrSaturatedValues)
+{
+    for (size_t i = 0; i < native.size(); i++)
+        for (const auto map : AllBlockMaps)
+        {
+            const auto name = "Frame " + std::to_string(i) + " map "
+                              + std::to_string(int(map));
+            for (size_t b = 0; b < nrBlocks; b++)
+            {
+                const auto value = getNativeValue(native[i], map, b);
+                ASSERT_EQ(float32[i].get<float>(map, b), static_cast<float>(value)) << name;
+
+                const auto scale       = getFixed16Scale(map);
+                const auto fixedValue  = fixed16[i].get<uint16_t>(map, b);
+                const auto scaledValue = value * scale;
+                if (scaledValue >= 65535.0)
+                {
+                    ASSERT_EQ(fixedValue, 65535) << name;
+                    nrSaturatedValues++;
+                }
+                else
+                    ASSERT_NEAR(fixedValue / scale, value, 0.5 / scale) << name;
+            }
+        }
+}
+
+} // namespace
+
+TEST(BlockFormat, ReducedFormatsMatchNative)
+{
+    vca_frame_info info;
+    info.width  = 320;
+    info.height = 192;
+    test::SyntheticVideo video(info, {3, 3}, 7);
+
+    std::vector<vca_frame *> frames;
+    for (size_t i = 0; i < video.getNrFrames(); i++)
+        frames.push_back(video.getFrame(i));
+
+    for (const auto blockSize : {8u, 32u})
+    {
+        vca_param param;
+        param.frameInfo           = info;
+        param.blockSize           = blockSize;
+        param.enableEnergyChroma  = true;
+        param.enableEntropyChroma = true;
+
+        const auto native  = analyze(frames, param, vca_block_format::Native);
+        const auto float32 = analyze(frames, param, vca_block_format::Float32);
+        const auto fixed16 = analyze(frames, param, vca_block_format::Fixed16);
+
+        const auto [widthInBlocks, heightInBlocks] = vca::getFrameSizeInBlocks(blockSize, info);
+        const auto nrBlocks        = widthInBlocks * heightInBlocks;
+        unsigned nrSaturatedValues = 0;
+        compareWithNative(native, float32, fixed16, nrBlocks, nrSaturatedValues);
+
+        // All maps were written and the temporal maps are not all 0
+        for (const auto map :
+             {BlockMap::EnergyDiff, BlockMap::EnergyEpsilon, BlockMap::EntropyDiff})
+        {
+            double sum = 0;
+            for (size_t b = 0; b < nrBlocks; b++)
+                sum += getNativeValue(native.back(), map, b);
+            EXPECT_GT(sum, 0.0) << "Map " << int(map);
+        }
+
+        for (size_t i = 0; i < native.size(); i++)
+        {
+            EXPECT_EQ(float32[i].result.averageEnergy, native[i].result.averageEnergy);
+            EXPECT_EQ(fixed16[i].result.energyDiff, native[i].result.energyDiff);
+        }
+    }
+}
+
+TEST(BlockFormat, Fixed16Saturates)
+{
+    // Noise with the full value range has a block energy of more than 65535 with 32x32
+    // blocks. The difference to the flat frame before it is just as large.
+    vca_frame_info info;
+    info.width  = 128;
+    info.height = 128;
+
+    const auto lumaSize   = info.width * info.height;
+    const auto chromaSize = lumaSize / 4;
+    std::vector<uint8_t> flatData(lumaSize + 2 * chromaSize, 128);
+    std::vector<uint8_t> noiseData(flatData);
+    std::default_random_engine randomEngine(1);
+    for (unsigned i = 0; i < lumaSize; i++)
+        noiseData[i] = uint8_t((randomEngine() % 2) * 255);
+
+    auto makeFrame = [&](std::vector<uint8_t> &data) {
+        vca_frame frame;
+        frame.info      = info;
+        frame.planes[0] = data.data();
+        frame.planes[1] = data.data() + lumaSize;
+        frame.planes[2] = data.data() + lumaSize + chromaSize;
+        frame.stride[0] = int(info.width);
+        frame.stride[1] = frame.stride[2] = int(info.width / 2);
+        frame.height[0] = int(info.height);
+        frame.height[1] = frame.height[2] = int(info.height / 2);
+        return frame;
+    };
+    auto flatFrame  = makeFrame(flatData);
+    auto noiseFrame = makeFrame(noiseData);
+
+    vca_param param;
+    param.frameInfo = info;
+    param.blockSize = 32;
+
+    const std::vector<vca_frame *> frames = {&flatFrame, &noiseFrame};
+    const auto native  = analyze(frames, param, vca_block_format::Native);
+    const auto float32 = analyze(frames, param, vca_block_format::Float32);
+    const auto fixed16 = analyze(frames, param, vca_block_format::Fixed16);
+
+    for (size_t b = 0; b < 16; b++)
+    {
+        EXPECT_GT(native[1].get<uint32_t>(BlockMap::Energy, b), 65535u);
+        EXPECT_GT(native[1].get<uint32_t>(BlockMap::EnergyDiff, b), 65535u);
+    }
+    unsigned nrSaturatedValues = 0;
+    compareWithNative(native, float32, fixed16, 16, nrSaturatedValues);
+    EXPECT_GE(nrSaturatedValues, 32u);
+
+    // The frame level values are not saturated
+    EXPECT_GT(fixed16[1].result.averageEnergy, 0u);
+    EXPECT_EQ(fixed16[1].result.averageEnergy, native[1].result.averageEnergy);
+    EXPECT_EQ(fixed16[1].result.energyDiff, native[1].result.energyDiff);
+}
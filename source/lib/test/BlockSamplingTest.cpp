@@ -0,0 +1,150 @@
+/* Copyright (C) 2024 Christian Doppler Laboratory ATHENA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.
+ *****************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include "common/functions.h"
+
+#include <analyzer/Analyzer.h>
+#include <analyzer/BlockSampling.h>
+
+#include <cmath>
+#include <stdexcept>
+
+TEST(BlockSampling, SamplerSelectsOneBlockPerInterval)
+{
+    vca::BlockRegion region{2, 1, 22, 13};
+    const auto width    = region.right - region.left;
+    const auto nrBlocks = region.getNrBlocks();
+
+    for (auto pattern : {vca_sampling_pattern::Stratified, vca_sampling_pattern::Checkerboard})
+        for (auto interval : {2u, 4u, 5u, 16u})
+        {
+            vca::Job job{};
+            job.samplingInterval = interval;
+            job.samplingPattern  = pattern;
+
+            std::vector<unsigned> timesSampled(nrBlocks);
+            for (unsigned frame = 0; frame < interval; frame++)
+            {
+                job.jobID = frame;
+                const vca::BlockSampler sampler(job, region);
+                EXPECT_TRUE(sampler.isEnabled());
+
+                unsigned nrSampled = 0;
+                for (auto y = region.top; y < region.bottom; y++)
+                    for (auto x = region.left; x < region.right; x++)
+                        if (sampler.isSampled(x, y))
+                        {
+                            nrSampled++;
+                            timesSampled[(y - region.top) * width + x - region.left]++;
+                        }
+                EXPECT_NEAR(double(nrSampled), double(nrBlocks) / interval, interval)
+                    << "Interval " << interval;
+            }
+
+            // The checkerboard moves over all blocks within one interval of frames
+            if (pattern == vca_sampling_pattern::Checkerboard)
+                for (auto count : timesSampled)
+                    EXPECT_EQ(count, 1u) << "Interval " << interval;
+        }
+
+    // Too small regions are analyzed completely
+    vca::Job job{};
+    job.samplingInterval = 16;
+    const vca::BlockSampler sampler(job, vca::BlockRegion{0, 0, 5, 5});
+    EXPECT_FALSE(sampler.isEnabled());
+    EXPECT_TRUE(sampler.isSampled(3, 4));
+}
+
+TEST(BlockSampling, ConfidenceOfTheMean)
+{
+    vca::SampleStatistics statistics;
+    for (auto value : {1.0, 2.0, 3.0, 4.0})
+        statistics.add(value);
+
+    // Sample variance 5/3, finite population correction 1 - 4/16
+    EXPECT_NEAR(statistics.getConfidence(16), 1.96 * std::sqrt(5.0 / 3.0 / 4.0 * 0.75), 1e-9);
+    EXPECT_EQ(statistics.getConfidence(4), 0.0);
+}
+
+TEST(BlockSampling, FrameAveragesWithinConfidence)
+{
+    vca_frame_info info;
+    info.width  = 640;
+    info.height = 384;
+    test::SyntheticVideo video(info, {6, 6}, 3);
+
+    vca_param param;
+    param.frameInfo = info;
+    param.blockSize = 16;
+    const auto full = test::analyzeFrames(video.getFrames(), param);
+    for (const auto &frame : full)
+    {
+        EXPECT_EQ(frame.result.averageEnergyConfidence, 0.0);
+        EXPECT_EQ(frame.result.averageEntropyConfidence, 0.0);
+    }
+
+    for (auto pattern : {vca_sampling_pattern::Stratified, vca_sampling_pattern::Checkerboard})
+    {
+        param.blockSamplingInterval = 4;
+        param.blockSamplingPattern  = pattern;
+        const auto sampled          = test::analyzeFrames(video.getFrames(), param);
+
+        unsigned nrEnergyInside  = 0;
+        unsigned nrEntropyInside = 0;
+        for (size_t i = 0; i < full.size(); i++)
+        {
+            const auto &fullResult = full[i].result;
+            const auto &result     = sampled[i].result;
+            EXPECT_GT(result.averageEnergyConfidence, 0.0);
+            EXPECT_GT(result.averageEntropyConfidence, 0.0);
+            if (std::abs(double(result.averageEnergy) - double(fullResult.averageEnergy))
+                <= result.averageEnergyConfidence + 1.0)
+                nrEnergyInside++;
+            if (std::abs(result.averageEntropy - fullResult.averageEntropy)
+                <= result.averageEntropyConfidence)
+                nrEntropyInside++;
+
+            // About one quarter of the blocks is analyzed, the others are 0
+            unsigned nrAnalyzed = 0;
+            for (size_t b = 0; b < sampled[i].entropy.size(); b++)
+                if (sampled[i].entropy[b] > 0)
+                {
+                    nrAnalyzed++;
+                    EXPECT_EQ(sampled[i].entropy[b], full[i].entropy[b]);
+                }
+            EXPECT_LE(nrAnalyzed, sampled[i].entropy.size() / 4 + 4);
+
+            // No temporal differences with sampling
+            EXPECT_EQ(result.energyDiff, 0.0);
+        }
+
+        // The 95% intervals contain the full values in most frames
+        EXPECT_GE(nrEnergyInside, full.size() * 8 / 10);
+        EXPECT_GE(nrEntropyInside, full.size() * 8 / 10);
+    }
+}
+
+TEST(BlockSampling, InvalidSettings)
+{
+    vca_param param;
+    param.blockSamplingInterval = 0;
+    EXPECT_THROW(vca::Analyzer analyzer(param), std::invalid_argument);
+
+    param.blockSamplingInterval = 17;
+    EXPECT_THROW(vca::Analyzer analyzer(param), std::invalid_argument);
+}
@@ -0,0 +1,187 @@
+/* Copyright (C) 2024 Christian Doppler Laboratory ATHENA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.
+ *****************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <analyzer/Analyzer.h>
+
+#include <algorithm>
+#include <array>
+#include <random>
+
+namespace {
+
+using Plane = std::vector<unsigned>;
+
+// A frame of frameInfo size that shows the content (of contentInfo size). Samples right of
+// or below the content repeat the last column and line of the content. Every luma line has
+// extraLumaStride samples after the width that are filled with random values. The chroma
+// planes have no extra samples because the analysis takes the chroma width from the stride.
+class PaddedFrame
+{
+public:
+    PaddedFrame(const std::array<Plane, 3> &content,
+                vca_frame_info contentInfo,
+                vca_frame_info frameInfo,
+                unsigned extraLumaStride)
+    {
+        const auto bytesPerSample = frameInfo.bitDepth > 8 ? 2u : 1u;
+        std::default_random_engine randomEngine(7);
+        std::uniform_int_distribution<unsigned> valueDist(0, (1u << frameInfo.bitDepth) - 1);
+
+        this->frame.info = frameInfo;
+        for (unsigned c = 0; c < 3; c++)
+        {
+            const auto scale         = (c == 0) ? 1u : 2u;
+            const auto contentWidth  = contentInfo.width / scale;
+            const auto contentHeight = contentInfo.height / scale;
+            const auto width         = frameInfo.width / scale;
+            const auto height        = frameInfo.height / scale;
+            const auto stride        = width + (c == 0 ? extraLumaStride : 0);
+            auto &plane              = this->planes[c];
+            plane.resize(stride * height * bytesPerSample);
+            for (unsigned y = 0; y < height; y++)
+                for (unsigned x = 0; x < stride; x++)
+                {
+                    const auto contentX = std::min(x, contentWidth - 1);
+                    const auto contentY = std::min(y, contentHeight - 1);
+                    const auto value    = x < width
+                                              ? content[c][contentY * contentWidth + contentX]
+                                              : valueDist(randomEngine);
+                    const auto index    = y * stride + x;
+                    if (bytesPerSample == 1)
+                        plane[index] = uint8_t(value);
+                    else
+                        reinterpret_cast<uint16_t *>(plane.data())[index] = uint16_t(value);
+                }
+            this->frame.planes[c] = plane.data();
+            this->frame.stride[c] = int(stride * bytesPerSample);
+            this->frame.height[c] = int(height);
+        }
+    }
+
+    vca_frame *getFrame() { return &this->frame; }
+
+private:
+    std::array<std::vector<uint8_t>, 3> planes;
+    vca_frame frame;
+};
+
+struct FrameValues
+{
+    std::vector<uint32_t> brightness, energy, averageU, energyU;
+    std::vector<double> entropy, entropyU;
+    vca_frame_results result;
+};
+
+FrameValues analyze(PaddedFrame &frame, vca_param param)
+{
+    // More than enough for every block size
+    const auto nrBlocks = param.frameInfo.width * param.frameInfo.height;
+
+    FrameValues values;
+    for (auto vector : {&values.brightness, &values.energy, &values.averageU, &values.energyU})
+        vector->resize(nrBlocks);
+    values.entropy.resize(nrBlocks);
+    values.entropyU.resize(nrBlocks);
+
+    auto &result              = values.result;
+    result.brightnessPerBlock = values.brightness.data();
+    result.energyPerBlock     = values.energy.data();
+    result.averageUPerBlock   = values.averageU.data();
+    result.energyUPerBlock    = values.energyU.data();
+    result.entropyPerBlock    = values.entropy.data();
+    result.entropyUPerBlock   = values.entropyU.data();
+
+    vca::Analyzer analyzer(param);
+    EXPECT_EQ(analyzer.pushFrame(frame.getFrame()), vca_result::VCA_OK);
+    EXPECT_EQ(analyzer.pullResult(&result), vca_result::VCA_OK);
+    return values;
+}
+
+} // namespace
+
+// The padding of the border blocks repeats the last valid sample of the plane. So the results
+// of the border blocks must match a frame where these samples are part of the picture, and
+// the samples of the stride after the width must not be read.
+TEST(BorderPadding, MatchesExplicitlyExtendedFrame)
+{
+    vca_frame_info info;
+    info.width  = 200;
+    info.height = 120;
+
+    for (auto bitDepth : {8u, 10u})
+    {
+        info.bitDepth = bitDepth;
+        std::default_random_engine randomEngine(bitDepth);
+        std::uniform_int_distribution<unsigned> valueDist(0, (1u << bitDepth) - 1);
+
+        std::array<Plane, 3> content;
+        for (unsigned c = 0; c < 3; c++)
+        {
+            const auto scale = (c == 0) ? 1u : 2u;
+            content[c].resize((info.width / scale) * (info.height / scale));
+            for (auto &value : content[c])
+                value = valueDist(randomEngine);
+        }
+
+        // Aligned to 64 samples, so the chroma planes are aligned to the block size as well
+        auto extendedInfo   = info;
+        extendedInfo.width  = 256;
+        extendedInfo.height = 128;
+        PaddedFrame frame(content, info, info, 24);
+        PaddedFrame extendedFrame(content, info, extendedInfo, 0);
+
+        for (auto blockSize : {16u, 32u})
+            for (auto enableLowpass : {false, true})
+            {
+                vca_param param;
+                param.frameInfo     = info;
+                param.blockSize     = blockSize;
+                param.enableLowpass = enableLowpass;
+                const auto values   = analyze(frame, param);
+
+                param.frameInfo      = extendedInfo;
+                const auto reference = analyze(extendedFrame, param);
+
+                for (unsigned c = 0; c < 2; c++)
+                {
+                    const auto scale          = (c == 0) ? 1u : 2u;
+                    const auto widthInBlocks  = (info.width / scale + blockSize - 1) / blockSize;
+                    const auto heightInBlocks = (info.height / scale + blockSize - 1) / blockSize;
+                    const auto referenceWidth = extendedInfo.width / scale / blockSize;
+                    for (unsigned y = 0; y < heightInBlocks; y++)
+                        for (unsigned x = 0; x < widthInBlocks; x++)
+                        {
+                            const auto i = y * widthInBlocks + x;
+                            const auto r = y * referenceWidth + x;
+                            if (c == 0)
+                            {
+                                EXPECT_EQ(values.brightness[i], reference.brightness[r]);
+                                EXPECT_EQ(values.energy[i], reference.energy[r]);
+                                EXPECT_EQ(values.entropy[i], reference.entropy[r]);
+                            }
+                            else
+                            {
+                                EXPECT_EQ(values.averageU[i], reference.averageU[r]);
+                                EXPECT_EQ(values.energyU[i], reference.energyU[r]);
+                                EXPECT_EQ(values.entropyU[i], reference.entropyU[r]);
+                            }
+                        }
+                }
+            }
+    }
+}
@@ -0,0 +1,276 @@
+/* Copyright (C) 2024 Christian Doppler Laboratory ATHENA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.
+ *****************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include "common/functions.h"
+
+#include <analyzer/Analyzer.h>
+#include <analyzer/DCTTransform.h>
+#include <analyzer/Decimation.h>
+#include <analyzer/EntropyCalculation.h>
+#include <analyzer/simd/cpu.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace {
+
+constexpr unsigned NR_FRAMES     = 8;
+constexpr unsigned SHOT_BOUNDARY = 4;
+
+// A texture with a natural image like spectrum that is panned over the frame. Every frame
+// also has some new noise. In the second half of the frames the texture is replaced by one
+// with more detail (a shot boundary).
+test::GeneratedVideo generatePanningTextureVideo(vca_frame_info info)
+{
+    std::default_random_engine randomEngine(1);
+    std::uniform_real_distribution<double> noiseDist(-1.0, 1.0);
+
+    const auto textureWidth = info.width + NR_FRAMES * 6;
+    const std::vector<double> textures[2]
+        = {test::generateNoiseTexture(textureWidth, info.height, 64, 12.0, randomEngine),
+           test::generateNoiseTexture(textureWidth, info.height, 64, 24.0, randomEngine)};
+
+    const auto getSample = [&](unsigned i, unsigned c, unsigned x, unsigned y) {
+        const auto scale        = (c == 0) ? 1u : 2u;
+        const auto &texture     = textures[i < SHOT_BOUNDARY ? 0 : 1];
+        const auto textureValue = texture[y * scale * textureWidth + x * scale + i * 6];
+        const auto value        = 128.0 + textureValue * (c == 0 ? 0.5 : 0.2)
+                           + noiseDist(randomEngine) * 2;
+        return unsigned(std::clamp(value, 0.0, 255.0));
+    };
+    return test::GeneratedVideo(info, NR_FRAMES, getSample);
+}
+
+// How many times larger the larger one of the two values is
+double ratio(double a, double b)
+{
+    return std::max(a, b) / std::min(a, b);
+}
+
+} // namespace
+
+TEST(Decimation, SIMDMatchesNative)
+{
+    if (!vca::isSimdSupported(CpuSimd::SSE2))
+        GTEST_SKIP() << "SSE2 not supported";
+
+    std::default_random_engine randomEngine(1);
+    for (auto bitDepth : {8u, 10u, 12u})
+    {
+        const auto bytesPerSample = bitDepth > 8 ? 2u : 1u;
+        std::uniform_int_distribution<unsigned> valueDist(0, (1u << bitDepth) - 1);
+        for (auto factor : {2u, 4u})
+        {
+            // Sizes that are not a multiple of the SIMD width or the factor
+            const unsigned width  = 203;
+            const unsigned height = 37;
+            const auto stride     = (width + 5) * bytesPerSample;
+            std::vector<uint8_t> src(stride * height);
+            for (unsigned i = 0; i < src.size() / bytesPerSample; i++)
+            {
+                if (bytesPerSample == 1)
+                    src[i] = uint8_t(valueDist(randomEngine));
+                else
+                    reinterpret_cast<uint16_t *>(src.data())[i] = uint16_t(valueDist(randomEngine));
+            }
+
+            const auto outputWidth  = (width + factor - 1) / factor;
+            const auto outputHeight = (height + factor - 1) / factor;
+            const auto outputStride = outputWidth * bytesPerSample;
+            std::vector<uint8_t> native(outputStride * outputHeight);
+            std::vector<uint8_t> simd(outputStride * outputHeight);
+            vca::decimatePlane(src.data(), stride, width, height, native.data(), outputStride,
+                               factor, bitDepth, CpuSimd::None);
+            vca::decimatePlane(src.data(), stride, width, height, simd.data(), outputStride,
+                               factor, bitDepth, CpuSimd::SSE2);
+            EXPECT_EQ(native, simd) << "Bit depth " << bitDepth << " factor " << factor;
+
+            // The first output sample is the rounded mean of the first box
+            unsigned sum = 0;
+            for (unsigned y = 0; y < factor; y++)
+                for (unsigned x = 0; x < factor; x++)
+                {
+                    const auto index = y * stride / bytesPerSample + x;
+                    sum += bytesPerSample == 1
+                               ? src[index]
+                               : reinterpret_cast<const uint16_t *>(src.data())[index];
+                }
+            const auto expected = (sum + factor * factor / 2) / (factor * factor);
+            const auto first    = bytesPerSample == 1
+                                      ? native[0]
+                                      : reinterpret_cast<const uint16_t *>(native.data())[0];
+            EXPECT_EQ(unsigned(first), expected);
+        }
+    }
+}
+
+TEST(Decimation, FrameValuesStayComparable)
+{
+    vca_frame_info info;
+    info.width  = 512;
+    info.height = 256;
+
+    auto video = generatePanningTextureVideo(info);
+
+    for (auto blockSize : {8u, 16u, 32u})
+    {
+        for (auto factor : {2u, 4u})
+        {
+            // A decimated block covers as many input samples as a block of
+            // blockSize * factor samples in the full analysis
+            vca_param param;
+            param.frameInfo = info;
+            param.blockSize = blockSize * factor;
+            const auto full = test::analyzeFrames(video.getFrames(), param);
+
+            param.blockSize        = blockSize;
+            param.decimationFactor = factor;
+            const auto decimated   = test::analyzeFrames(video.getFrames(), param);
+
+            for (unsigned i = 0; i < NR_FRAMES; i++)
+            {
+                EXPECT_NEAR(double(full[i].result.averageBrightness),
+                            double(decimated[i].result.averageBrightness),
+                            2.0);
+
+                // The 8x8 blocks of a frame decimated by 4 and the 16x16 blocks of a frame
+                // decimated by 2 or 4 have fewer coefficients than the lowpass DCT of the full
+                // analysis. The other combinations give the same values up to rounding.
+                EXPECT_LT(ratio(full[i].result.averageEnergy, decimated[i].result.averageEnergy),
+                          1.3)
+                    << "Block size " << blockSize << " factor " << factor << " frame " << i;
+            }
+            EXPECT_LT(ratio(full[SHOT_BOUNDARY].result.energyDiff,
+                            decimated[SHOT_BOUNDARY].result.energyDiff),
+                      1.3)
+                << "Block size " << blockSize << " factor " << factor;
+
+            // Relations between frames must be kept: The more detailed shot has more energy
+            // and the largest energy difference is at the shot boundary.
+            for (const auto *values : {&full, &decimated})
+            {
+                const auto &results = *values;
+                EXPECT_GT(results[SHOT_BOUNDARY].result.averageEnergy,
+                          results[SHOT_BOUNDARY - 1].result.averageEnergy);
+                for (unsigned i = 1; i < NR_FRAMES; i++)
+                    if (i != SHOT_BOUNDARY)
+                        EXPECT_GT(results[SHOT_BOUNDARY].result.energyDiff,
+                                  results[i].result.energyDiff * 2)
+                            << "Block size " << blockSize << " factor " << factor
+                            << " frame " << i;
+            }
+        }
+    }
+}
+
+TEST(Decimation, HalfResolutionMatchesBlockLowpass)
+{
+    // Not a multiple of the block size, so the padding of the border blocks is covered
+    vca_frame_info info;
+    info.width  = 75;
+    info.height = 41;
+
+    for (auto bitDepth : {8u, 10u})
+    {
+        info.bitDepth             = bitDepth;
+        const auto bytesPerSample = bitDepth > 8 ? 2u : 1u;
+        std::default_random_engine randomEngine(bitDepth);
+        std::uniform_int_distribution<unsigned> valueDist(0, (1u << bitDepth) - 1);
+
+        std::vector<uint8_t> plane(info.width * info.height * bytesPerSample);
+        const auto sample = [&](unsigned x, unsigned y) {
+            x                = std::min(x, info.width - 1);
+            y                = std::min(y, info.height - 1);
+            const auto index = y * info.width + x;
+            return bytesPerSample == 1
+                       ? int16_t(plane[index])
+                       : int16_t(reinterpret_cast<const uint16_t *>(plane.data())[index]);
+        };
+        for (unsigned i = 0; i < info.width * info.height; i++)
+        {
+            if (bytesPerSample == 1)
+                plane[i] = uint8_t(valueDist(randomEngine));
+            else
+                reinterpret_cast<uint16_t *>(plane.data())[i] = uint16_t(valueDist(randomEngine));
+        }
+
+        vca_frame frame;
+        frame.info      = info;
+        frame.planes[0] = plane.data();
+        frame.stride[0] = int(info.width * bytesPerSample);
+        frame.height[0] = int(info.height);
+
+        for (auto cpuSimd : {CpuSimd::None, CpuSimd::SSE2})
+        {
+            if (!vca::isSimdSupported(cpuSimd))
+                continue;
+
+            for (auto blockSize : {16u, 32u})
+            {
+                vca::HalfResolutionFrame halfResolution;
+                halfResolution.update(frame, blockSize, false, cpuSimd);
+
+                std::vector<int16_t> block(blockSize * blockSize);
+                std::vector<int16_t> coeffs(blockSize * blockSize);
+                std::vector<int16_t> coeffsHalfResolution(blockSize * blockSize);
+                for (unsigned blockY = 0; blockY < info.height; blockY += blockSize)
+                    for (unsigned blockX = 0; blockX < info.width; blockX += blockSize)
+                    {
+                        int32_t sum = 0;
+                        for (unsigned y = 0; y < blockSize; y++)
+                            for (unsigned x = 0; x < blockSize; x++)
+                            {
+                                block[y * blockSize + x] = sample(blockX + x, blockY + y);
+                                sum += block[y * blockSize + x];
+                            }
+
+                        vca::performDCT(blockSize,
+                                        bitDepth,
+                                        block.data(),
+                                        coeffs.data(),
+                                        CpuSimd::None,
+                                        true);
+                        const auto halfResolutionBlock = halfResolution.getBlock(0,
+                                                                                 blockX,
+                                                                                 blockY);
+                        vca::performLowpassDCT(blockSize,
+                                               bitDepth,
+                                               halfResolutionBlock,
+                                               halfResolution.getStride(0),
+                                               sum,
+                                               coeffsHalfResolution.data(),
+                                               CpuSimd::None);
+                        EXPECT_EQ(coeffs, coeffsHalfResolution)
+                            << "Block size " << blockSize << " block " << blockX << "x"
+                            << blockY;
+
+                        EXPECT_EQ(vca::performEntropy(blockSize,
+                                                      bitDepth,
+                                                      block.data(),
+                                                      CpuSimd::None,
+                                                      true),
+                                  vca::performLowpassEntropy(blockSize,
+                                                             halfResolutionBlock,
+                                                             halfResolution.getStride(0),
+                                                             CpuSimd::None));
+                    }
+            }
+        }
+    }
+}
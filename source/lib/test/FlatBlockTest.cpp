@@ -0,0 +1,112 @@
+/* Copyright (C) 2024 Christian Doppler Laboratory ATHENA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.
+ *****************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <analyzer/BlockStatistics.h>
+#include <analyzer/DCTTransform.h>
+#include <analyzer/EntropyCalculation.h>
+#include <analyzer/common/common.h>
+#include <analyzer/simd/cpu.h>
+#include <test/common/functions.h>
+
+#include <algorithm>
+
+using BlockSize = unsigned;
+using BitDepth  = unsigned;
+using Lowpass   = bool;
+using TestCase  = std::tuple<BlockSize, BitDepth, Lowpass>;
+
+class FlatBlockFixture : public testing::TestWithParam<TestCase>
+{
+};
+
+TEST_P(FlatBlockFixture, ClosedFormResultsMatchFullAnalysis)
+{
+    const auto blockSize     = std::get<0>(GetParam());
+    const auto bitDepth      = std::get<1>(GetParam());
+    const auto enableLowpass = std::get<2>(GetParam());
+    const auto nrSamples     = blockSize * blockSize;
+    const auto maxValue      = (1 << bitDepth) - 1;
+
+    ALIGN_VAR_32(int16_t, pixelBuffer[32 * 32]);
+    ALIGN_VAR_32(int16_t, coeffBuffer[32 * 32]);
+
+    for (const auto value : {0, 1, 16, 100, 235, maxValue / 2, maxValue})
+    {
+        std::fill(pixelBuffer, pixelBuffer + nrSamples, int16_t(value));
+
+        const auto statistics = vca::calculateBlockStatistics(pixelBuffer,
+                                                              nrSamples,
+                                                              vca::cpuDetectMaxSimd());
+        EXPECT_EQ(statistics.range(), 0u);
+        EXPECT_EQ(statistics.sum, int32_t(value * nrSamples));
+
+        vca::performDCT(blockSize,
+                        bitDepth,
+                        pixelBuffer,
+                        coeffBuffer,
+                        CpuSimd::None,
+                        enableLowpass);
+        EXPECT_EQ(coeffBuffer[0],
+                  vca::calculateFlatBlockDC(blockSize, bitDepth, statistics.sum, enableLowpass))
+            << "Value " << value;
+        for (unsigned i = 1; i < nrSamples; i++)
+            ASSERT_EQ(coeffBuffer[i], 0) << "Value " << value << " coefficient " << i;
+
+        EXPECT_EQ(vca::performEntropy(blockSize,
+                                      bitDepth,
+                                      pixelBuffer,
+                                      CpuSimd::None,
+                                      enableLowpass),
+                  0.0);
+        EXPECT_EQ(vca::performEdgeDensity(blockSize,
+                                          bitDepth,
+                                          pixelBuffer,
+                                          CpuSimd::None,
+                                          enableLowpass),
+                  0.0);
+    }
+}
+
+TEST_P(FlatBlockFixture, BlockStatisticsSIMDMatchesNative)
+{
+    const auto blockSize = std::get<0>(GetParam());
+    const auto bitDepth  = std::get<1>(GetParam());
+    const auto nrSamples = blockSize * blockSize;
+
+    ALIGN_VAR_32(int16_t, pixelBuffer[32 * 32]);
+    for (int i = 0; i < 10; i++)
+    {
+        test::fillBlockWithRandomData(pixelBuffer, blockSize, bitDepth);
+
+        const auto native = vca::calculateBlockStatistics(pixelBuffer, nrSamples, CpuSimd::None);
+        const auto simd   = vca::calculateBlockStatistics(pixelBuffer,
+                                                        nrSamples,
+                                                        vca::cpuDetectMaxSimd());
+        EXPECT_EQ(native.min, *std::min_element(pixelBuffer, pixelBuffer + nrSamples));
+        EXPECT_EQ(native.max, *std::max_element(pixelBuffer, pixelBuffer + nrSamples));
+        EXPECT_EQ(native.min, simd.min);
+        EXPECT_EQ(native.max, simd.max);
+        EXPECT_EQ(native.sum, simd.sum);
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(FlatBlock,
+                         FlatBlockFixture,
+                         testing::Combine(testing::Values(8u, 16u, 32u),
+                                          testing::Values(8u, 10u, 12u),
+                                          testing::Bool()));
@@ -0,0 +1,214 @@
+/* Copyright (C) 2024 Christian Doppler Laboratory ATHENA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.
+ *****************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include "common/functions.h"
+
+#include <analyzer/Analyzer.h>
+#include <analyzer/Hadamard.h>
+#include <analyzer/simd/cpu.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace {
+
+double calculateCorrelation(const std::vector<uint32_t> &a, const std::vector<uint32_t> &b)
+{
+    double sumA = 0, sumB = 0, sumAA = 0, sumBB = 0, sumAB = 0;
+    for (size_t i = 0; i < a.size(); i++)
+    {
+        sumA += a[i];
+        sumB += b[i];
+        sumAA += double(a[i]) * a[i];
+        sumBB += double(b[i]) * b[i];
+        sumAB += double(a[i]) * b[i];
+    }
+    const auto n = double(a.size());
+    return (sumAB - sumA * sumB / n)
+           / std::sqrt((sumAA - sumA * sumA / n) * (sumBB - sumB * sumB / n));
+}
+
+// A texture with a natural image like spectrum (the amplitude falls with the frequency)
+test::GeneratedVideo generateTextureFrame(vca_frame_info info)
+{
+    std::default_random_engine randomEngine(2);
+    const auto texture = test::generateNoiseTexture(info.width, info.height, 64, 6.0, randomEngine);
+    return test::GeneratedVideo(info, 1, [&](unsigned, unsigned c, unsigned x, unsigned y) {
+        const auto scale = (c == 0) ? 1u : 2u;
+        const auto value = 128.0 + texture[y * scale * info.width + x * scale];
+        return unsigned(std::clamp(value, 0.0, 255.0));
+    });
+}
+
+} // namespace
+
+TEST(Hadamard, SIMDMatchesNative)
+{
+    if (!vca::isSimdSupported(CpuSimd::SSE2))
+        GTEST_SKIP() << "SSE2 not supported";
+
+    int16_t weightsByFrequency[64];
+    for (unsigned i = 0; i < 64; i++)
+        weightsByFrequency[i] = int16_t(i == 0 ? 0 : 255 - i);
+    const auto weights = vca::getHadamardWeights(weightsByFrequency);
+
+    std::default_random_engine randomEngine(1);
+    for (auto bitDepth : {8u, 10u, 12u})
+    {
+        const auto maxValue = int((1u << bitDepth) - 1);
+        std::uniform_int_distribution<int> valueDist(0, maxValue);
+        for (auto size : {8u, 16u, 32u})
+        {
+            // Random samples and the extreme case of a checkerboard with the maximum range
+            const auto stride = size + 8;
+            std::vector<int16_t> samples(stride * size);
+            for (unsigned pattern = 0; pattern < 2; pattern++)
+            {
+                for (unsigned i = 0; i < samples.size(); i++)
+                    samples[i] = int16_t(pattern == 0 ? valueDist(randomEngine)
+                                                      : ((i % stride + i / stride) % 2) * maxValue);
+
+                const auto native = vca::calculateHadamardEnergy(samples.data(),
+                                                                 stride,
+                                                                 size,
+                                                                 bitDepth,
+                                                                 weights,
+                                                                 CpuSimd::None);
+                const auto simd   = vca::calculateHadamardEnergy(samples.data(),
+                                                               stride,
+                                                               size,
+                                                               bitDepth,
+                                                               weights,
+                                                               CpuSimd::SSE2);
+                EXPECT_EQ(native, simd) << "Bit depth " << bitDepth << " size " << size;
+            }
+        }
+    }
+}
+
+TEST(Hadamard, SingleFrequency)
+{
+    // A checkerboard only has the DC and the highest frequency in both directions
+    int16_t weightsByFrequency[64] = {};
+    weightsByFrequency[63]         = 256;
+    const auto weights             = vca::getHadamardWeights(weightsByFrequency);
+
+    for (auto bitDepth : {8u, 10u})
+    {
+        const auto low  = 40 << (bitDepth - 8);
+        const auto high = 200 << (bitDepth - 8);
+        int16_t samples[64];
+        for (unsigned i = 0; i < 64; i++)
+            samples[i] = int16_t(((i % 8 + i / 8) % 2) ? high : low);
+
+        // The coefficient has the scale of the DCT (a constant block has the DC
+        // mean << (15 - bitDepth))
+        const auto amplitude = (high - low) / 2;
+        const auto expected  = uint32_t(amplitude * 64) >> (bitDepth - 8) << 1;
+        for (auto cpuSimd : {CpuSimd::None, CpuSimd::SSE2})
+            EXPECT_EQ(vca::calculateHadamardEnergy(samples, 8, 8, bitDepth, weights, cpuSimd),
+                      expected)
+                << "Bit depth " << bitDepth;
+
+        for (auto &sample : samples)
+            sample = int16_t(low);
+        EXPECT_EQ(vca::calculateHadamardEnergy(samples, 8, 8, bitDepth, weights, CpuSimd::None),
+                  0u);
+    }
+}
+
+TEST(Hadamard, FollowsDCTEnergy)
+{
+    vca_frame_info info;
+    info.width  = 320;
+    info.height = 192;
+    auto frame = generateTextureFrame(info);
+
+    for (auto blockSize : {8u, 16u, 32u, 64u})
+        for (auto enableLowpass : {true, false})
+        {
+            std::vector<test::FrameValues> values[2];
+            for (unsigned mode = 0; mode < 2; mode++)
+            {
+                vca_param param;
+                param.frameInfo            = info;
+                param.blockSize            = blockSize;
+                param.enableLowpass        = enableLowpass;
+                param.enableHadamardEnergy = (mode == 1);
+                values[mode]               = test::analyzeFrames(frame.getFrames(), param);
+            }
+            const auto &dct      = values[0][0];
+            const auto &hadamard = values[1][0];
+
+            // The scale of the Hadamard energy is calibrated on generated blocks, not on this
+            // texture. The 8x8 transforms do not see structures larger than 8x8 samples, so
+            // the energy of the individual blocks is less similar for large blocks without the
+            // lowpass filter.
+            const auto name = "Block size " + std::to_string(blockSize) + " lowpass "
+                              + std::to_string(enableLowpass);
+            const auto ratio = double(hadamard.result.averageEnergy)
+                               / double(dct.result.averageEnergy);
+            EXPECT_GT(ratio, 0.75) << name;
+            EXPECT_LT(ratio, 1.33) << name;
+            const auto minCorrelation = (blockSize == 64 && !enableLowpass) ? 0.6 : 0.8;
+            EXPECT_GT(calculateCorrelation(dct.energy, hadamard.energy), minCorrelation) << name;
+            for (size_t i = 0; i < dct.brightness.size(); i++)
+                ASSERT_NEAR(double(dct.brightness[i]), double(hadamard.brightness[i]), 1.0)
+                    << name;
+        }
+}
+
+TEST(Hadamard, FollowsDCTEnergyOfSyntheticVideo)
+{
+    vca_frame_info info;
+    info.width  = 320;
+    info.height = 192;
+    test::SyntheticVideo video(info, {4, 4}, 5);
+
+    // Sharp edges and noise have relatively less energy in the Hadamard domain than the
+    // content that the scale is calibrated on, so the Hadamard energy is lower (down to about
+    // half of the DCT energy for large blocks without the lowpass DCT)
+    for (auto blockSize : {8u, 16u, 32u, 64u})
+        for (auto enableLowpass : {true, false})
+        {
+            std::vector<uint32_t> energies[2];
+            double frameEnergies[2] = {};
+            for (unsigned mode = 0; mode < 2; mode++)
+            {
+                vca_param param;
+                param.frameInfo            = info;
+                param.blockSize            = blockSize;
+                param.enableLowpass        = enableLowpass;
+                param.enableHadamardEnergy = (mode == 1);
+                for (const auto &values : test::analyzeFrames(video.getFrames(), param))
+                {
+                    energies[mode].insert(energies[mode].end(),
+                                          values.energy.begin(),
+                                          values.energy.end());
+                    frameEnergies[mode] += values.result.averageEnergy;
+                }
+            }
+            const auto name  = "Block size " + std::to_string(blockSize) + " lowpass "
+                              + std::to_string(enableLowpass);
+            const auto ratio = frameEnergies[1] / frameEnergies[0];
+            EXPECT_GT(ratio, 0.4) << name;
+            EXPECT_LT(ratio, 1.25) << name;
+            EXPECT_GT(calculateCorrelation(energies[0], energies[1]), 0.8) << name;
+        }
+}
@@ -0,0 +1,145 @@
+/* Copyright (C) 2024 Christian Doppler Laboratory ATHENA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.
+ *****************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include "common/functions.h"
+
+#include <analyzer/Analyzer.h>
+#include <analyzer/JobQueueControl.h>
+#include <analyzer/MultiThreadQueue.h>
+
+#include <atomic>
+#include <thread>
+
+namespace {
+
+vca::Result resultWithBlocks(unsigned jobID, size_t nrBlocks)
+{
+    vca::Result result;
+    result.jobID = jobID;
+    result.energyPerBlock.resize(nrBlocks);
+    return result;
+}
+
+} // namespace
+
+TEST(JobQueue, ControllerAdaptsSize)
+{
+    vca::JobQueueController fixed(3, 4);
+    for (unsigned i = 0; i < 100; i++)
+        EXPECT_FALSE(fixed.addResult(1.0, 1.0, 0));
+    EXPECT_EQ(fixed.getSize(), 3u);
+
+    // Idle threads and results that are pulled in time grow the queue up to its maximum
+    vca::JobQueueController controller(0, 2);
+    EXPECT_EQ(controller.getSize(), 5u);
+    for (unsigned i = 0; i < 16 * 10; i++)
+        controller.addResult(0.01, 0.01, 0);
+    EXPECT_EQ(controller.getSize(), 8u);
+
+    // Busy threads keep the size
+    for (unsigned i = 0; i < 16 * 4; i++)
+        EXPECT_FALSE(controller.addResult(0.0, 0.01, 1));
+    EXPECT_EQ(controller.getSize(), 8u);
+
+    // Results that wait to be pulled shrink it down to 2
+    for (unsigned i = 0; i < 16 * 10; i++)
+        controller.addResult(0.01, 0.01, 4);
+    EXPECT_EQ(controller.getSize(), 2u);
+}
+
+TEST(JobQueue, MemoryLimitBlocksPush)
+{
+    vca::MultiThreadQueue<vca::Result> queue;
+    const auto resultMemory = sizeof(vca::Result) + 1000 * sizeof(uint32_t);
+    queue.setMaximumQueueMemory(2 * resultMemory);
+
+    queue.waitAndPushInOrder(resultWithBlocks(0, 1000), 0);
+    queue.waitAndPushInOrder(resultWithBlocks(1, 1000), 1);
+    EXPECT_EQ(queue.size(), 2u);
+
+    std::atomic<bool> pushed{false};
+    std::thread pusher([&]() {
+        queue.waitAndPushInOrder(resultWithBlocks(2, 1000), 2);
+        pushed = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_FALSE(pushed);
+
+    EXPECT_EQ(queue.waitAndPop()->jobID, 0u);
+    pusher.join();
+    EXPECT_TRUE(pushed);
+    EXPECT_EQ(queue.size(), 2u);
+    EXPECT_EQ(queue.getPeakMemory(), 2 * resultMemory);
+
+    // A result larger than the limit is pushed to an empty queue
+    queue.waitAndPop();
+    queue.waitAndPop();
+    queue.waitAndPushInOrder(resultWithBlocks(3, 10000), 3);
+    EXPECT_EQ(queue.size(), 1u);
+}
+
+TEST(JobQueue, AnalyzerWithMemoryLimit)
+{
+    vca_frame_info info;
+    info.width  = 320;
+    info.height = 192;
+    test::SyntheticVideo video(info, {10, 10}, 7);
+
+    vca_param param;
+    param.frameInfo      = info;
+    param.blockSize      = 16;
+    param.nrFrameThreads = 4;
+
+    // Push all frames before pulling the results
+    vca::Analyzer reference(param);
+    for (size_t i = 0; i < video.getNrFrames(); i++)
+        EXPECT_EQ(reference.pushFrame(video.getFrame(i)), vca_result::VCA_OK);
+    std::vector<vca_frame_results> expected(video.getNrFrames());
+    for (auto &result : expected)
+        EXPECT_EQ(reference.pullResult(&result), vca_result::VCA_OK);
+
+    // Only one result can wait at a time. The results are pulled from another thread.
+    param.maxQueuedResultsMemory = 1;
+    param.jobQueueSize           = 2;
+    vca::Analyzer analyzer(param);
+    std::vector<vca_frame_results> results(video.getNrFrames());
+    std::thread consumer([&]() {
+        for (auto &result : results)
+            EXPECT_EQ(analyzer.pullResult(&result), vca_result::VCA_OK);
+    });
+    for (size_t i = 0; i < video.getNrFrames(); i++)
+        EXPECT_EQ(analyzer.pushFrame(video.getFrame(i)), vca_result::VCA_OK);
+    consumer.join();
+
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        EXPECT_EQ(results[i].jobID, expected[i].jobID);
+        EXPECT_EQ(results[i].averageEnergy, expected[i].averageEnergy);
+        EXPECT_EQ(results[i].energyDiff, expected[i].energyDiff);
+        EXPECT_EQ(results[i].averageEntropy, expected[i].averageEntropy);
+    }
+
+    vca_analyzer_stats stats;
+    analyzer.getStats(&stats);
+    EXPECT_EQ(stats.jobQueueSize, 2u);
+    EXPECT_GT(stats.peakQueuedResultsMemory, 0u);
+
+    vca_analyzer_stats referenceStats;
+    reference.getStats(&referenceStats);
+    EXPECT_LT(stats.peakQueuedResultsMemory, referenceStats.peakQueuedResultsMemory);
+}
@@ -0,0 +1,190 @@
+/* Copyright (C) 2024 Christian Doppler Laboratory ATHENA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.
+ *****************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include "common/functions.h"
+
+#include <analyzer/Analyzer.h>
+#include <analyzer/Ladder.h>
+
+#include <algorithm>
+#include <random>
+
+namespace {
+
+constexpr unsigned NR_FRAMES = 4;
+
+// Random frames with a smooth gradient so that the blocks differ in brightness
+test::GeneratedVideo generateGradientVideo(vca_frame_info info)
+{
+    std::default_random_engine randomEngine(1);
+    std::uniform_int_distribution<int> noiseDist(-40, 40);
+
+    const auto getSample = [&](unsigned i, unsigned, unsigned x, unsigned y) {
+        const auto value = int(40 + (x + y + i * 4) % 160) + noiseDist(randomEngine);
+        return unsigned(std::clamp(value, 0, 255));
+    };
+    return test::GeneratedVideo(info, NR_FRAMES, getSample);
+}
+
+// The frames of the video decimated by 2 in both dimensions (the rounded mean of 2x2 samples
+// like vca::decimatePlane)
+test::GeneratedVideo generateHalfResolutionVideo(test::GeneratedVideo &video)
+{
+    auto info = video.getFrame(0)->info;
+    info.width /= 2;
+    info.height /= 2;
+
+    const auto getSample = [&](unsigned i, unsigned c, unsigned x, unsigned y) {
+        const auto frame  = video.getFrame(i);
+        const auto stride = unsigned(frame->stride[c]);
+        const auto src    = frame->planes[c] + 2 * y * stride + 2 * x;
+        return (src[0] + src[1] + src[stride] + src[stride + 1] + 2u) / 4;
+    };
+    return test::GeneratedVideo(info, unsigned(video.getNrFrames()), getSample);
+}
+
+} // namespace
+
+TEST(Ladder, ResizeConstantPlane)
+{
+    for (auto bitDepth : {8u, 10u})
+    {
+        const auto bytesPerSample = bitDepth > 8 ? 2u : 1u;
+        const auto value          = (1u << bitDepth) / 3;
+        const unsigned width      = 190;
+        const unsigned height     = 46;
+        std::vector<uint16_t> src(width * height, uint16_t(value));
+        if (bytesPerSample == 1)
+            for (unsigned i = 0; i < width * height; i++)
+                reinterpret_cast<uint8_t *>(src.data())[i] = uint8_t(value);
+
+        for (auto [outputWidth, outputHeight] : {std::pair{127u, 31u}, std::pair{95u, 23u}})
+        {
+            std::vector<uint16_t> dst(outputWidth * outputHeight);
+            vca::resizePlane(reinterpret_cast<const uint8_t *>(src.data()),
+                             width * bytesPerSample,
+                             width,
+                             height,
+                             reinterpret_cast<uint8_t *>(dst.data()),
+                             outputWidth * bytesPerSample,
+                             outputWidth,
+                             outputHeight,
+                             bitDepth,
+                             CpuSimd::None);
+            for (unsigned i = 0; i < outputWidth * outputHeight; i++)
+            {
+                const auto output = bytesPerSample == 1
+                                        ? unsigned(reinterpret_cast<uint8_t *>(dst.data())[i])
+                                        : unsigned(dst[i]);
+                ASSERT_EQ(output, value) << "Output " << outputWidth << "x" << outputHeight;
+            }
+        }
+    }
+}
+
+TEST(Ladder, HalfResolutionMatchesSeparateAnalysis)
+{
+    vca_frame_info info;
+    info.width  = 320;
+    info.height = 192;
+    const vca_resolution half{info.width / 2, info.height / 2};
+
+    auto video     = generateGradientVideo(info);
+    auto halfVideo = generateHalfResolutionVideo(video);
+
+    for (auto blockSize : {8u, 32u})
+    {
+        vca_param param;
+        param.frameInfo            = info;
+        param.blockSize            = blockSize;
+        param.ladderResolutions[0] = half;
+        param.nrLadderResolutions  = 1;
+        vca::Analyzer ladderAnalyzer(param);
+
+        param.frameInfo.width     = half.width;
+        param.frameInfo.height    = half.height;
+        param.nrLadderResolutions = 0;
+        vca::Analyzer separateAnalyzer(param);
+
+        for (unsigned i = 0; i < NR_FRAMES; i++)
+        {
+            EXPECT_EQ(ladderAnalyzer.pushFrame(video.getFrame(i)), vca_result::VCA_OK);
+            EXPECT_EQ(separateAnalyzer.pushFrame(halfVideo.getFrame(i)), vca_result::VCA_OK);
+
+            test::FrameValues full({info.width, info.height}, blockSize);
+            test::FrameValues level(half, blockSize);
+            test::FrameValues separate(half, blockSize);
+            full.result.ladderResults = &level.result;
+            EXPECT_EQ(ladderAnalyzer.pullResult(&full.result), vca_result::VCA_OK);
+            EXPECT_EQ(separateAnalyzer.pullResult(&separate.result), vca_result::VCA_OK);
+
+            EXPECT_EQ(level.result.poc, int(i));
+            EXPECT_EQ(level.brightness, separate.brightness) << "Block size " << blockSize;
+            EXPECT_EQ(level.energy, separate.energy) << "Block size " << blockSize;
+            EXPECT_EQ(level.energyDiff, separate.energyDiff) << "Block size " << blockSize;
+            EXPECT_EQ(level.result.energyDiff, separate.result.energyDiff);
+            EXPECT_EQ(level.result.averageEntropy, separate.result.averageEntropy);
+            EXPECT_EQ(level.result.entropyDiff, separate.result.entropyDiff);
+        }
+    }
+}
+
+TEST(Ladder, NonIntegerRatioWithRegionOfInterest)
+{
+    vca_frame_info info;
+    info.width  = 320;
+    info.height = 192;
+    const vca_resolution resolution{224, 134};
+
+    vca_param param;
+    param.frameInfo            = info;
+    param.blockSize            = 16;
+    param.regionOfInterest     = {64, 32, 192, 128};
+    param.ladderResolutions[0] = resolution;
+    param.nrLadderResolutions  = 1;
+    vca::Analyzer analyzer(param);
+
+    auto video = generateGradientVideo(info);
+    for (unsigned i = 0; i < NR_FRAMES; i++)
+    {
+        EXPECT_EQ(analyzer.pushFrame(video.getFrame(i)), vca_result::VCA_OK);
+
+        test::FrameValues full({info.width, info.height}, param.blockSize);
+        test::FrameValues level(resolution, param.blockSize);
+        full.result.ladderResults = &level.result;
+        EXPECT_EQ(analyzer.pullResult(&full.result), vca_result::VCA_OK);
+
+        // The region of interest scaled by 0.7 and aligned to the block grid of the level
+        const auto &region = level.result.analysisRegion;
+        EXPECT_EQ(region.x, 32u);
+        EXPECT_EQ(region.y, 16u);
+        EXPECT_EQ(region.x + region.width, 192u);
+        EXPECT_EQ(region.y + region.height, 112u);
+
+        EXPECT_NEAR(double(level.result.averageBrightness),
+                    double(full.result.averageBrightness),
+                    4.0);
+        EXPECT_GT(level.result.averageEnergy, 0u);
+        EXPECT_EQ(level.brightness[0], 0u);
+    }
+
+    // A level that is larger than the input is rejected
+    param.ladderResolutions[0] = {info.width + 2, info.height};
+    vca::Analyzer invalidAnalyzer(param);
+    EXPECT_EQ(invalidAnalyzer.pushFrame(video.getFrame(0)), vca_result::VCA_ERROR);
+}
@@ -0,0 +1,145 @@
+/* Copyright (C) 2024 Christian Doppler Laboratory ATHENA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.
+ *****************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include "common/functions.h"
+
+#include <analyzer/Analyzer.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+
+namespace {
+
+// Random detail on a smooth gradient. The amplitude of the detail increases from left to
+// right. The height is not a multiple of 128 so that the padded blocks are covered.
+test::GeneratedVideo generateGradientNoiseFrame(vca_frame_info info)
+{
+    std::default_random_engine randomEngine(3);
+    const auto texture = test::generateNoiseTexture(info.width, info.height, 32, 1.0, randomEngine);
+    return test::GeneratedVideo(info, 1, [&](unsigned, unsigned c, unsigned x, unsigned y) {
+        const auto scale     = (c == 0) ? 1u : 2u;
+        const auto amplitude = 0.5 + 8.0 * x * scale / info.width;
+        const auto value     = 50.0 + 120.0 * y * scale / info.height
+                           + texture[y * scale * info.width + x * scale] * amplitude;
+        return unsigned(std::clamp(value, 0.0, 255.0));
+    });
+}
+
+test::FrameValues analyze(test::GeneratedVideo &frame, const vca_param &param)
+{
+    auto values = test::analyzeFrames(frame.getFrames(), param);
+    return std::move(values.front());
+}
+
+} // namespace
+
+TEST(LargeBlock, MatchesAggregatedSmallBlocks)
+{
+    vca_frame_info info;
+    info.width  = 512;
+    info.height = 200;
+    auto frame = generateGradientNoiseFrame(info);
+
+    vca_param param;
+    param.frameInfo = info;
+    param.blockSize = 32;
+    const auto small = analyze(frame, param);
+
+    for (auto blockSize : {64u, 128u})
+    {
+        param.blockSize  = blockSize;
+        const auto large = analyze(frame, param);
+        const auto ratio = blockSize / 32;
+
+        // 4x or 16x fewer blocks than with 32x32 blocks (apart from the padded border)
+        EXPECT_EQ(large.widthInBlocks, small.widthInBlocks / ratio);
+        EXPECT_EQ(large.heightInBlocks, (small.heightInBlocks + ratio - 1) / ratio);
+
+        // The brightness is the root of the mean DC of the contained 32x32 blocks. The border
+        // blocks are padded differently, so only complete blocks are compared.
+        for (unsigned y = 0; y < info.height / blockSize; y++)
+            for (unsigned x = 0; x < large.widthInBlocks; x++)
+            {
+                double dcSum = 0;
+                for (unsigned j = 0; j < ratio; j++)
+                    for (unsigned i = 0; i < ratio; i++)
+                    {
+                        const auto b = small.brightness[(y * ratio + j) * small.widthInBlocks
+                                                        + x * ratio + i];
+                        dcSum += double(b) * b + b;
+                    }
+                EXPECT_NEAR(double(large.brightness[y * large.widthInBlocks + x]),
+                            std::sqrt(dcSum / (ratio * ratio)),
+                            1.0)
+                    << "Block size " << blockSize << " block " << x << "," << y;
+            }
+
+        // The detail increases from left to right
+        const auto lastRow = (large.heightInBlocks - 1) * large.widthInBlocks;
+        EXPECT_LT(large.energy[lastRow], large.energy[lastRow + large.widthInBlocks - 1]);
+        EXPECT_LT(large.energy[0], large.energy[large.widthInBlocks - 1]);
+        EXPECT_LT(large.entropy[0], large.entropy[large.widthInBlocks - 1]);
+        EXPECT_GT(large.result.averageEnergy, 0u);
+    }
+}
+
+TEST(LargeBlock, RegionOfInterestIsAlignedToLargeBlocks)
+{
+    vca_frame_info info;
+    info.width  = 512;
+    info.height = 200;
+    auto frame = generateGradientNoiseFrame(info);
+
+    vca_param param;
+    param.frameInfo        = info;
+    param.blockSize        = 64;
+    param.regionOfInterest = {100, 70, 200, 60};
+    const auto values      = analyze(frame, param);
+
+    const auto &region = values.result.analysisRegion;
+    EXPECT_EQ(region.x, 64u);
+    EXPECT_EQ(region.y, 64u);
+    EXPECT_EQ(region.width, 256u);
+    EXPECT_EQ(region.height, 128u);
+
+    for (unsigned y = 0; y < values.heightInBlocks; y++)
+        for (unsigned x = 0; x < values.widthInBlocks; x++)
+        {
+            const auto inRegion = x >= 1 && x <= 4 && y >= 1 && y <= 2;
+            EXPECT_EQ(values.brightness[y * values.widthInBlocks + x] > 0, inRegion)
+                << x << "," << y;
+        }
+}
+
+TEST(LargeBlock, InvalidCombinations)
+{
+    vca_param param;
+    param.blockSize = 48;
+    EXPECT_THROW(vca::Analyzer analyzer(param), std::invalid_argument);
+
+    param.blockSize        = 64;
+    param.decimationFactor = 2;
+    EXPECT_THROW(vca::Analyzer analyzer(param), std::invalid_argument);
+
+    param.decimationFactor  = 1;
+    param.blockGridSizes[0] = 32;
+    param.nrBlockGrids      = 1;
+    EXPECT_THROW(vca::Analyzer analyzer(param), std::invalid_argument);
+}
@@ -0,0 +1,146 @@
+/* Copyright (C) 2024 Christian Doppler Laboratory ATHENA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.
+ *****************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include "common/functions.h"
+
+#include <analyzer/Analyzer.h>
+#include <analyzer/Logging.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+
+namespace {
+
+// Collects the messages. Messages of the processing threads wait until they are released.
+struct MessageCollector
+{
+    std::mutex mutex;
+    std::condition_variable releaseCV;
+    bool released{};
+    std::vector<std::pair<LogLevel, std::string>> messages;
+
+    static void logFunction(void *privateData, LogLevel level, const char *message)
+    {
+        auto collector = static_cast<MessageCollector *>(privateData);
+        std::unique_lock<std::mutex> lock(collector->mutex);
+        if (std::string(message).rfind("Thread ", 0) == 0)
+            collector->releaseCV.wait(lock, [collector]() { return collector->released; });
+        collector->messages.push_back({level, message});
+    }
+
+    void release()
+    {
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->released = true;
+        }
+        this->releaseCV.notify_all();
+    }
+
+    unsigned count(LogLevel level)
+    {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        return unsigned(std::count_if(this->messages.begin(),
+                                      this->messages.end(),
+                                      [level](const auto &message) {
+                                          return message.first == level;
+                                      }));
+    }
+};
+
+} // namespace
+
+TEST(Logging, RingDropsMessagesWhenFull)
+{
+    vca::LogRing ring;
+    for (unsigned i = 0; i < vca::LogRing::Capacity + 10; i++)
+        ring.push(LogLevel::Debug, "Message " + std::to_string(i));
+    EXPECT_EQ(ring.getNrDroppedMessages(), 10u);
+
+    LogLevel level;
+    std::string message;
+    for (unsigned i = 0; i < vca::LogRing::Capacity; i++)
+    {
+        ASSERT_TRUE(ring.pop(level, message));
+        EXPECT_EQ(message, "Message " + std::to_string(i));
+    }
+    EXPECT_FALSE(ring.pop(level, message));
+
+    ring.push(LogLevel::Warning, std::string(1000, 'x'));
+    ASSERT_TRUE(ring.pop(level, message));
+    EXPECT_EQ(level, LogLevel::Warning);
+    EXPECT_EQ(message.size(), vca::LogRing::MaxMessageLength);
+}
+
+TEST(Logging, MessagesAboveLevelAreNotFormatted)
+{
+    MessageCollector collector;
+    vca_param param;
+    param.logFunction            = &MessageCollector::logFunction;
+    param.logFunctionPrivateData = &collector;
+    param.logLevel               = LogLevel::Info;
+
+    bool formatted = false;
+    vca::log(param, LogLevel::Debug, [&]() {
+        formatted = true;
+        return std::string("Debug");
+    });
+    EXPECT_FALSE(formatted);
+    vca::log(param, LogLevel::Warning, [&]() {
+        formatted = true;
+        return std::string("Warning");
+    });
+    EXPECT_TRUE(formatted);
+    EXPECT_EQ(collector.count(LogLevel::Warning), 1u);
+    EXPECT_EQ(collector.count(LogLevel::Debug), 0u);
+}
+
+TEST(Logging, ProcessingThreadsDoNotWaitForLogFunction)
+{
+    vca_frame_info info;
+    info.width  = 320;
+    info.height = 192;
+    test::SyntheticVideo video(info, {10}, 3);
+
+    MessageCollector collector;
+    vca_param param;
+    param.frameInfo              = info;
+    param.blockSize              = 16;
+    param.nrFrameThreads         = 2;
+    param.logLevel               = LogLevel::Debug;
+    param.logFunction            = &MessageCollector::logFunction;
+    param.logFunctionPrivateData = &collector;
+
+    {
+        // The log function blocks the messages of the processing threads until all frames
+        // are analyzed
+        vca::Analyzer analyzer(param);
+        for (size_t i = 0; i < video.getNrFrames(); i++)
+        {
+            vca_frame_results result;
+            EXPECT_EQ(analyzer.pushFrame(video.getFrame(i)), vca_result::VCA_OK);
+            EXPECT_EQ(analyzer.pullResult(&result), vca_result::VCA_OK);
+        }
+        collector.release();
+    }
+
+    // Start, finish and quit of each thread
+    const auto nrFrames = unsigned(video.getNrFrames());
+    EXPECT_EQ(collector.count(LogLevel::Debug), nrFrames * 2 + param.nrFrameThreads);
+}
@@ -0,0 +1,199 @@
+/* Copyright (C) 2024 Christian Doppler Laboratory ATHENA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.
+ *****************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include "common/functions.h"
+
+#include <analyzer/Analyzer.h>
+#include <analyzer/QualityControl.h>
+
+#include <stdexcept>
+
+namespace {
+
+// Adds results of the current tier with the given processing time until the tier changes.
+// Returns the number of results that were added.
+unsigned addResultsUntilTierChange(vca::QualityController &controller,
+                                   double processingTime,
+                                   unsigned maxResults = 50)
+{
+    const auto tier = controller.getTier();
+    for (unsigned i = 1; i <= maxResults; i++)
+        if (controller.addResult(tier, processingTime, 0.0))
+            return i;
+    return maxResults;
+}
+
+} // namespace
+
+TEST(QualityControl, TierConfigs)
+{
+    vca_param param;
+    param.enableStaticBlockCache = true;
+    param.enableLowpass          = false;
+    param.blockSize              = 8;
+    param.blockGridSizes[0]      = 16;
+    param.nrBlockGrids           = 1;
+
+    const auto tier0 = vca::getQualityTierConfig(param, 0);
+    EXPECT_TRUE(tier0.enableEnergyChroma);
+    EXPECT_FALSE(tier0.enableLowpass);
+
+    const auto tier1 = vca::getQualityTierConfig(param, 1);
+    EXPECT_FALSE(tier1.enableEnergyChroma);
+    EXPECT_FALSE(tier1.enableEntropyChroma);
+    EXPECT_TRUE(tier1.enableLowpass);
+    EXPECT_TRUE(tier1.enableEntropy);
+
+    const auto tier2 = vca::getQualityTierConfig(param, 2);
+    EXPECT_FALSE(tier2.enableEntropy);
+    EXPECT_FALSE(tier2.enableEdgeDensity);
+    EXPECT_TRUE(tier2.enableDCTenergy);
+    EXPECT_EQ(tier2.nrBlockGrids, 1u);
+
+    const auto tier3 = vca::getQualityTierConfig(param, 3);
+    EXPECT_EQ(tier3.blockSamplingInterval, 4u);
+    EXPECT_EQ(tier3.nrBlockGrids, 0u);
+    EXPECT_FALSE(tier3.enableStaticBlockCache);
+
+    // Without the energy, the entropy is the only feature left
+    param.enableDCTenergy = false;
+    EXPECT_TRUE(vca::getQualityTierConfig(param, 2).enableEntropy);
+}
+
+TEST(QualityControl, ControllerStepsDownAndUp)
+{
+    vca_param param;
+    EXPECT_FALSE(vca::QualityController(param, 1).isEnabled());
+
+    // 40 ms per frame at 25 fps
+    param.realTimeFrameRate = 25.0;
+    vca::QualityController controller(param, 1);
+    EXPECT_TRUE(controller.isEnabled());
+
+    // Keeping up
+    for (unsigned i = 0; i < 20; i++)
+        EXPECT_FALSE(controller.addResult(0, 0.03, 0.0));
+    EXPECT_EQ(controller.getTier(), 0u);
+
+    // Too slow
+    EXPECT_LE(addResultsUntilTierChange(controller, 0.05), 10u);
+    EXPECT_EQ(controller.getTier(), 1u);
+
+    // Results of frames that were pushed before the change do not change the tier
+    for (unsigned i = 0; i < 10; i++)
+        EXPECT_FALSE(controller.addResult(0, 1.0, 0.0));
+
+    EXPECT_LE(addResultsUntilTierChange(controller, 0.045), 10u);
+    EXPECT_EQ(controller.getTier(), 2u);
+
+    // Tier 1 would still be too slow
+    for (unsigned i = 0; i < 20; i++)
+        EXPECT_FALSE(controller.addResult(2, 0.01, 0.0));
+    EXPECT_EQ(controller.getTier(), 2u);
+
+    // The content got easier, so that there is enough headroom for tier 1
+    EXPECT_LT(addResultsUntilTierChange(controller, 0.004), 50u);
+    EXPECT_EQ(controller.getTier(), 1u);
+}
+
+TEST(QualityControl, ControllerLatencyBudget)
+{
+    vca_param param;
+    param.realTimeLatencyMs = 100;
+    vca::QualityController controller(param, 4);
+    EXPECT_TRUE(controller.isEnabled());
+
+    for (unsigned i = 0; i < 20; i++)
+        EXPECT_FALSE(controller.addResult(0, 0.5, 0.08));
+    for (unsigned i = 0; i < 20 && controller.getTier() == 0; i++)
+        controller.addResult(0, 0.5, 0.2);
+    EXPECT_EQ(controller.getTier(), 1u);
+}
+
+TEST(QualityControl, AnalyzerReportsTiers)
+{
+    vca_frame_info info;
+    info.width  = 320;
+    info.height = 192;
+    test::SyntheticVideo video(info, {20, 20}, 5);
+
+    // No frame can be analyzed at this rate, so every tier is used
+    vca_param param;
+    param.frameInfo              = info;
+    param.blockSize              = 8;
+    param.blockGridSizes[0]      = 16;
+    param.nrBlockGrids           = 1;
+    param.enableStaticBlockCache = true;
+    param.nrFrameThreads         = 1;
+    param.realTimeFrameRate      = 1e6;
+    vca::Analyzer analyzer(param);
+
+    const auto [widthInBlocks, heightInBlocks] = vca::getFrameSizeInBlocks(param.blockSize, info);
+    std::vector<uint32_t> energy(widthInBlocks * heightInBlocks);
+    std::vector<double> entropy(widthInBlocks * heightInBlocks);
+
+    std::vector<vca_frame_results> results(video.getNrFrames());
+    for (size_t i = 0; i < video.getNrFrames(); i++)
+    {
+        auto &result           = results[i];
+        result.energyPerBlock  = energy.data();
+        result.entropyPerBlock = entropy.data();
+        EXPECT_EQ(analyzer.pushFrame(video.getFrame(i)), vca_result::VCA_OK);
+        EXPECT_EQ(analyzer.pullResult(&result), vca_result::VCA_OK);
+    }
+
+    for (size_t i = 1; i < results.size(); i++)
+    {
+        const auto &result = results[i];
+        const auto tier    = result.qualityTier;
+        EXPECT_GE(tier, results[i - 1].qualityTier);
+        EXPECT_GT(result.averageEnergy, 0u);
+        if (tier >= 1)
+            EXPECT_EQ(result.energyU, 0u) << "Frame " << i;
+        if (tier >= 2)
+            EXPECT_EQ(result.averageEntropy, 0.0) << "Frame " << i;
+        else
+            EXPECT_GT(result.averageEntropy, 0.0) << "Frame " << i;
+        if (tier == 3)
+            EXPECT_GT(result.averageEnergyConfidence, 0.0) << "Frame " << i;
+
+        // No temporal differences between tiers and with block sampling
+        if (tier != results[i - 1].qualityTier || tier == 3)
+            EXPECT_EQ(result.energyDiff, 0.0) << "Frame " << i;
+        else if (i != 20)
+            EXPECT_GT(result.energyDiff, 0.0) << "Frame " << i;
+    }
+    EXPECT_EQ(results.back().qualityTier, 3u);
+
+    vca_analyzer_stats stats;
+    analyzer.getStats(&stats);
+    uint64_t nrFrames = 0;
+    for (unsigned tier = 0; tier < VCA_NR_QUALITY_TIERS; tier++)
+    {
+        EXPECT_GT(stats.framesPerQualityTier[tier], 0u) << "Tier " << tier;
+        nrFrames += stats.framesPerQualityTier[tier];
+    }
+    EXPECT_EQ(nrFrames, results.size());
+}
+
+TEST(QualityControl, InvalidFrameRate)
+{
+    vca_param param;
+    param.realTimeFrameRate = -1.0;
+    EXPECT_THROW(vca::Analyzer analyzer(param), std::invalid_argument);
+}
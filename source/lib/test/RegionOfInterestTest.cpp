@@ -0,0 +1,201 @@
+/* Copyright (C) 2024 Christian Doppler Laboratory ATHENA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.
+ *****************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include "common/functions.h"
+
+#include <analyzer/Analyzer.h>
+#include <analyzer/LetterboxDetection.h>
+
+#include <random>
+
+namespace {
+
+constexpr unsigned NR_FRAMES = 4;
+
+// 4:2:0 frames with random picture content inside of the active area and noisy black
+// (limited range) samples outside of it.
+test::GeneratedVideo generateLetterboxedVideo(vca_frame_info info,
+                                              vca_rect activeArea,
+                                              unsigned nrFrames,
+                                              unsigned seed)
+{
+    const auto shift = info.bitDepth - 8;
+    std::default_random_engine randomEngine(seed);
+    std::uniform_int_distribution<unsigned> pictureDist(40u << shift, 235u << shift);
+    std::uniform_int_distribution<unsigned> blackDist(16u << shift, 24u << shift);
+
+    const auto getSample = [&](unsigned, unsigned c, unsigned x, unsigned y) {
+        const auto scale  = (c == 0) ? 1u : 2u;
+        const auto active = x * scale >= activeArea.x
+                            && x * scale < activeArea.x + activeArea.width
+                            && y * scale >= activeArea.y
+                            && y * scale < activeArea.y + activeArea.height;
+        return active ? pictureDist(randomEngine) : blackDist(randomEngine);
+    };
+    return test::GeneratedVideo(info, nrFrames, getSample);
+}
+
+bool isInside(unsigned blockX, unsigned blockY, const vca::BlockRegion &region)
+{
+    return blockX >= region.left && blockX < region.right && blockY >= region.top
+           && blockY < region.bottom;
+}
+
+} // namespace
+
+TEST(LetterboxDetection, DetectsBordersPresentInAllFrames)
+{
+    for (auto bitDepth : {8u, 10u})
+    {
+        vca_frame_info info;
+        info.width    = 320;
+        info.height   = 180;
+        info.bitDepth = bitDepth;
+
+        auto video      = generateLetterboxedVideo(info, {10, 24, 300, 136}, 1, 1);
+        const auto area = vca::detectActiveArea(*video.getFrame(0));
+        ASSERT_TRUE(area);
+        EXPECT_EQ(area->x, 10u);
+        EXPECT_EQ(area->y, 24u);
+        EXPECT_EQ(area->width, 300u);
+        EXPECT_EQ(area->height, 136u);
+
+        // A dark part at the top of the second frame must not be cropped
+        auto darkVideo = generateLetterboxedVideo(info, {10, 60, 300, 100}, 1, 2);
+        vca::LetterboxDetector detector;
+        detector.addFrame(*video.getFrame(0));
+        detector.addFrame(*darkVideo.getFrame(0));
+        EXPECT_EQ(detector.getNrFrames(), 2u);
+        const auto activeArea = detector.getActiveArea();
+        ASSERT_TRUE(activeArea);
+        EXPECT_EQ(activeArea->y, 24u);
+        EXPECT_EQ(activeArea->height, 136u);
+
+        auto blackVideo = generateLetterboxedVideo(info, {}, 1, 3);
+        EXPECT_FALSE(vca::detectActiveArea(*blackVideo.getFrame(0)));
+    }
+}
+
+TEST(RegionOfInterest, ResultsMatchFullAnalysisInsideRegion)
+{
+    vca_frame_info info;
+    info.width  = 200;
+    info.height = 120;
+
+    auto video = generateLetterboxedVideo(info, {0, 0, 200, 120}, NR_FRAMES, 1);
+
+    vca_param param;
+    param.frameInfo      = info;
+    param.blockSize      = 16;
+    param.nrFrameThreads = 2;
+    const auto full      = test::analyzeFrames(video.getFrames(), param);
+
+    param.regionOfInterest = {40, 20, 90, 50};
+    const auto cropped     = test::analyzeFrames(video.getFrames(), param);
+
+    const auto [widthInBlocks, heightInBlocks] = vca::getFrameSizeInBlocks(16, info);
+    const auto region  = vca::getBlockRegion(param.regionOfInterest,
+                                            16,
+                                            {widthInBlocks, heightInBlocks});
+    const auto regionC = vca::getBlockRegion(param.regionOfInterest,
+                                             16,
+                                             vca::getChromaFrameSizeInBlocks(16, 100, 60),
+                                             {2, 2});
+    EXPECT_EQ(region.getNrBlocks(), 7u * 4u);
+    EXPECT_EQ(regionC.getNrBlocks(), 4u * 3u);
+
+    for (unsigned i = 0; i < NR_FRAMES; i++)
+    {
+        const auto &analysisRegion = cropped[i].result.analysisRegion;
+        EXPECT_EQ(analysisRegion.x, 32u);
+        EXPECT_EQ(analysisRegion.y, 16u);
+        EXPECT_EQ(analysisRegion.width, 112u);
+        EXPECT_EQ(analysisRegion.height, 64u);
+
+        uint64_t brightnessSum = 0;
+        for (unsigned blockY = 0; blockY < heightInBlocks; blockY++)
+            for (unsigned blockX = 0; blockX < widthInBlocks; blockX++)
+            {
+                const auto index = blockY * widthInBlocks + blockX;
+                if (isInside(blockX, blockY, region))
+                {
+                    EXPECT_EQ(cropped[i].brightness[index], full[i].brightness[index]);
+                    EXPECT_EQ(cropped[i].energy[index], full[i].energy[index]);
+                    EXPECT_EQ(cropped[i].energyDiff[index], full[i].energyDiff[index]);
+                    EXPECT_EQ(cropped[i].entropy[index], full[i].entropy[index]);
+                    EXPECT_EQ(cropped[i].edgeDensity[index], full[i].edgeDensity[index]);
+                    brightnessSum += full[i].brightness[index];
+                }
+                else
+                {
+                    EXPECT_EQ(cropped[i].brightness[index], 0u);
+                    EXPECT_EQ(cropped[i].energy[index], 0u);
+                    EXPECT_EQ(cropped[i].energyDiff[index], 0u);
+                    EXPECT_EQ(cropped[i].entropy[index], 0.0);
+                    EXPECT_EQ(cropped[i].edgeDensity[index], 0.0);
+                }
+            }
+        EXPECT_EQ(cropped[i].result.averageBrightness, brightnessSum / region.getNrBlocks());
+
+        const auto widthInBlocksC = vca::getChromaFrameSizeInBlocks(16, 100, 60).first;
+        for (unsigned blockY = 0; blockY < 4; blockY++)
+            for (unsigned blockX = 0; blockX < widthInBlocksC; blockX++)
+            {
+                const auto index = blockY * widthInBlocksC + blockX;
+                if (isInside(blockX, blockY, regionC))
+                {
+                    EXPECT_EQ(cropped[i].averageU[index], full[i].averageU[index]);
+                    EXPECT_EQ(cropped[i].energyV[index], full[i].energyV[index]);
+                }
+                else
+                    EXPECT_EQ(cropped[i].averageU[index], 0u);
+            }
+    }
+}
+
+TEST(RegionOfInterest, LetterboxDetectionRestrictsAnalysis)
+{
+    vca_frame_info info;
+    info.width  = 256;
+    info.height = 144;
+
+    auto video = generateLetterboxedVideo(info, {0, 20, 256, 100}, NR_FRAMES, 1);
+
+    vca_param param;
+    param.frameInfo = info;
+    param.blockSize = 16;
+
+    // Less frames are pushed than used for the detection. The detection is finished with
+    // the first pulled result.
+    param.letterboxDetectionFrames = 10;
+    const auto results = test::analyzeFrames(video.getFrames(), param);
+
+    for (const auto &frame : results)
+    {
+        const auto &analysisRegion = frame.result.analysisRegion;
+        EXPECT_EQ(analysisRegion.x, 0u);
+        EXPECT_EQ(analysisRegion.y, 16u);
+        EXPECT_EQ(analysisRegion.width, 256u);
+        EXPECT_EQ(analysisRegion.height, 112u);
+
+        // The first block row is in the black border
+        for (unsigned blockX = 0; blockX < 16; blockX++)
+            EXPECT_EQ(frame.brightness[blockX], 0u);
+        EXPECT_GT(frame.result.averageBrightness, 0u);
+    }
+}
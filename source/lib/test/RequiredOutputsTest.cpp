@@ -0,0 +1,120 @@
+/* Copyright (C) 2024 Christian Doppler Laboratory ATHENA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.
+ *****************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include "common/functions.h"
+
+#include <analyzer/Analyzer.h>
+
+#include <stdexcept>
+
+TEST(RequiredOutputs, BrightnessWithoutTransform)
+{
+    vca_frame_info info;
+    info.width  = 320;
+    info.height = 192;
+    test::SyntheticVideo video(info, {3, 3}, 4);
+
+    for (auto blockSize : {8u, 16u, 32u})
+        for (auto enableLowpass : {true, false})
+        {
+            vca_param param;
+            param.frameInfo     = info;
+            param.blockSize     = blockSize;
+            param.enableLowpass = enableLowpass;
+            const auto full     = test::analyzeFrames(video.getFrames(), param);
+
+            param.requiredOutputs = VCA_OUTPUT_BRIGHTNESS;
+            const auto brightness = test::analyzeFrames(video.getFrames(), param);
+
+            // The DC from the sum of the samples only differs from the DCT by rounding
+            const auto name = "Block size " + std::to_string(blockSize) + " lowpass "
+                              + std::to_string(enableLowpass);
+            for (size_t i = 0; i < full.size(); i++)
+            {
+                const auto &result = brightness[i].result;
+                EXPECT_NEAR(double(result.averageBrightness),
+                            double(full[i].result.averageBrightness),
+                            1.0)
+                    << name;
+                for (size_t b = 0; b < full[i].brightness.size(); b++)
+                    ASSERT_NEAR(double(brightness[i].brightness[b]),
+                                double(full[i].brightness[b]),
+                                1.0)
+                        << name;
+
+                EXPECT_EQ(result.averageEnergy, 0u) << name;
+                EXPECT_EQ(result.energyDiff, 0.0) << name;
+                EXPECT_EQ(result.averageEntropy, 0.0) << name;
+                EXPECT_EQ(result.averageEdgeDensity, 0.0) << name;
+                EXPECT_EQ(result.energyU, 0u) << name;
+            }
+        }
+}
+
+TEST(RequiredOutputs, OutputsMatchFullAnalysis)
+{
+    vca_frame_info info;
+    info.width  = 320;
+    info.height = 192;
+    test::SyntheticVideo video(info, {3, 3}, 4);
+
+    vca_param param;
+    param.frameInfo = info;
+    param.blockSize = 16;
+    const auto full = test::analyzeFrames(video.getFrames(), param);
+
+    param.requiredOutputs = VCA_OUTPUT_ENERGY_DIFF;
+    const auto energyDiff = test::analyzeFrames(video.getFrames(), param);
+    param.requiredOutputs = VCA_OUTPUT_ENTROPY_DIFF | VCA_OUTPUT_EDGE_DENSITY;
+    const auto entropyDiff = test::analyzeFrames(video.getFrames(), param);
+
+    for (size_t i = 0; i < full.size(); i++)
+    {
+        EXPECT_EQ(energyDiff[i].energy, full[i].energy);
+        EXPECT_EQ(energyDiff[i].energyDiff, full[i].energyDiff);
+        EXPECT_EQ(energyDiff[i].result.energyDiff, full[i].result.energyDiff);
+        EXPECT_EQ(energyDiff[i].result.energyEpsilon, full[i].result.energyEpsilon);
+        EXPECT_EQ(energyDiff[i].result.averageEntropy, 0.0);
+        EXPECT_EQ(energyDiff[i].result.averageEdgeDensity, 0.0);
+
+        EXPECT_EQ(entropyDiff[i].result.entropyDiff, full[i].result.entropyDiff);
+        EXPECT_EQ(entropyDiff[i].result.entropyEpsilon, full[i].result.entropyEpsilon);
+        EXPECT_EQ(entropyDiff[i].result.averageEdgeDensity, full[i].result.averageEdgeDensity);
+        EXPECT_EQ(entropyDiff[i].result.averageEnergy, 0u);
+        EXPECT_EQ(entropyDiff[i].result.energyDiff, 0.0);
+    }
+
+    // Without the temporal outputs, the differences are not calculated
+    param.requiredOutputs = VCA_OUTPUT_ENERGY | VCA_OUTPUT_ENTROPY;
+    for (const auto &frame : test::analyzeFrames(video.getFrames(), param))
+    {
+        EXPECT_GT(frame.result.averageEnergy, 0u);
+        EXPECT_EQ(frame.result.energyDiff, 0.0);
+        EXPECT_EQ(frame.result.entropyDiff, 0.0);
+    }
+}
+
+TEST(RequiredOutputs, InvalidOutputs)
+{
+    vca_param param;
+    param.requiredOutputs = 0;
+    EXPECT_THROW(vca::Analyzer analyzer(param), std::invalid_argument);
+
+    param.requiredOutputs = VCA_OUTPUT_ALL + 1;
+    EXPECT_THROW(vca::Analyzer analyzer(param), std::invalid_argument);
+}
@@ -0,0 +1,349 @@
+/* Copyright (C) 2024 Christian Doppler Laboratory ATHENA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.
+ *****************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <analyzer/Analyzer.h>
+#include <analyzer/ShotDetection.h>
+#include <test/common/functions.h>
+
+#include <algorithm>
+#include <random>
+#include <set>
+
+namespace {
+
+constexpr double FPS = 25.0;
+
+struct AnalysisRun
+{
+    std::vector<vca_frame_results> results;
+    std::vector<std::vector<uint32_t>> energyPerBlock;
+};
+
+template <typename Video>
+AnalysisRun runAnalysis(Video &video, vca_param param)
+{
+    AnalysisRun run;
+
+    const auto [widthInBlocks, heightInBlocks] = vca::getFrameSizeInBlocks(param.blockSize,
+                                                                          param.frameInfo);
+
+    vca::Analyzer analyzer(param);
+    size_t nrPulledFrames = 0;
+    auto pullResult       = [&]() {
+        vca_frame_results result;
+        std::vector<uint32_t> energy(widthInBlocks * heightInBlocks);
+        result.energyPerBlock = energy.data();
+        ASSERT_EQ(analyzer.pullResult(&result), vca_result::VCA_OK);
+        result.energyPerBlock = nullptr;
+        run.results.push_back(result);
+        run.energyPerBlock.push_back(std::move(energy));
+        nrPulledFrames++;
+    };
+
+    for (size_t i = 0; i < video.getNrFrames(); i++)
+    {
+        EXPECT_EQ(analyzer.pushFrame(video.getFrame(i)), vca_result::VCA_OK);
+        while (analyzer.resultAvailable())
+            pullResult();
+    }
+    while (nrPulledFrames < video.getNrFrames())
+        pullResult();
+
+    return run;
+}
+
+// Shots of upscaled textures that pan over the frame with black bars at the top and bottom.
+// The content is smoother than test::SyntheticVideo, so the lowest frequencies hold more of
+// the energy.
+constexpr unsigned SMOOTH_SHOT_LENGTH = 25;
+constexpr unsigned SMOOTH_NR_SHOTS    = 4;
+
+test::GeneratedVideo generateSmoothVideo(vca_frame_info info)
+{
+    std::default_random_engine randomEngine(7);
+
+    const auto nrFrames     = SMOOTH_SHOT_LENGTH * SMOOTH_NR_SHOTS;
+    const auto textureWidth = info.width / 2 + SMOOTH_SHOT_LENGTH;
+    std::vector<std::vector<double>> textures;
+    for (unsigned shot = 0; shot < SMOOTH_NR_SHOTS; shot++)
+        textures.push_back(
+            test::generateNoiseTexture(textureWidth, info.height / 2, 64, 16.0, randomEngine));
+
+    const auto barHeight = info.height / 8;
+    const auto getSample = [&](unsigned i, unsigned c, unsigned x, unsigned y) {
+        if (c > 0)
+            return 128u;
+        if (y < barHeight || y >= info.height - barHeight)
+            return 16u;
+        const auto shot         = i / SMOOTH_SHOT_LENGTH;
+        const auto offset       = i % SMOOTH_SHOT_LENGTH;
+        const auto textureValue = textures[shot][(y / 2) * textureWidth + x / 2 + offset];
+        const auto value        = 100.0 + shot * 20 + textureValue;
+        return unsigned(std::clamp(value, 0.0, 255.0));
+    };
+    return test::GeneratedVideo(info, nrFrames, getSample);
+}
+
+std::vector<unsigned> generateShotLengths(unsigned seed)
+{
+    std::default_random_engine randomEngine(seed);
+    std::uniform_int_distribution<unsigned> shotLengthDist(30, 60);
+    std::vector<unsigned> shotLengths(5);
+    for (auto &length : shotLengths)
+        length = shotLengthDist(randomEngine);
+    return shotLengths;
+}
+
+std::vector<size_t> detectShots(std::vector<vca_frame_results> &results)
+{
+    vca_shot_detection_param shotParam;
+    shotParam.fps = FPS;
+    EXPECT_EQ(vca::shot_detection(shotParam, results.data(), results.size()), vca_result::VCA_OK);
+
+    std::vector<size_t> newShots;
+    for (size_t i = 0; i < results.size(); i++)
+        if (results[i].isNewShot)
+            newShots.push_back(i);
+    return newShots;
+}
+
+// The detector marks the first frame of the new shot and often the next frame as well (the
+// epsilon is high for both). A cut counts as detected if either of them is marked.
+std::set<size_t> getDetectedCuts(const std::vector<size_t> &newShots,
+                                 const std::vector<size_t> &cutPositions)
+{
+    std::set<size_t> detectedCuts;
+    for (const auto frame : newShots)
+    {
+        const auto cut = std::find_if(cutPositions.begin(), cutPositions.end(), [&](size_t c) {
+            return frame == c || frame == c + 1;
+        });
+        EXPECT_NE(cut, cutPositions.end()) << "Frame " << frame << " is not at a cut";
+        if (cut != cutPositions.end())
+            detectedCuts.insert(*cut);
+    }
+    return detectedCuts;
+}
+
+} // namespace
+
+using BlockSize = unsigned;
+using Seed      = unsigned;
+using TestCase  = std::tuple<BlockSize, Seed>;
+
+class ShotDetectionOnlyFixture : public testing::TestWithParam<TestCase>
+{
+};
+
+TEST_P(ShotDetectionOnlyFixture, DetectsTheCutsOfTheFullAnalysis)
+{
+    const auto blockSize = std::get<0>(GetParam());
+    const auto seed      = std::get<1>(GetParam());
+
+    vca_frame_info info;
+    info.width      = 640;
+    info.height     = 360;
+    info.bitDepth   = 8;
+    info.colorspace = vca_colorSpace::YUV420;
+
+    test::SyntheticVideo video(info, generateShotLengths(seed), seed);
+
+    vca_param param;
+    param.frameInfo      = info;
+    param.blockSize      = blockSize;
+    param.nrFrameThreads = 1;
+
+    auto full = runAnalysis(video, param);
+
+    param.enableShotDetectionOnly = true;
+    auto fast                     = runAnalysis(video, param);
+
+    double sumEnergyFull = 0;
+    double sumEnergyFast = 0;
+    for (size_t i = 0; i < full.energyPerBlock.size(); i++)
+        for (size_t b = 0; b < full.energyPerBlock[i].size(); b++)
+        {
+            sumEnergyFull += full.energyPerBlock[i][b];
+            sumEnergyFast += fast.energyPerBlock[i][b];
+        }
+
+    // The brightness is calculated from the downsampled blocks in the fast mode
+    for (size_t i = 0; i < full.results.size(); i++)
+        EXPECT_NEAR(full.results[i].averageBrightness, fast.results[i].averageBrightness, 1);
+
+    const auto &cutPositions = video.getCutPositions();
+    const auto newShotsFull  = detectShots(full.results);
+    const auto newShotsFast  = detectShots(fast.results);
+    const auto detectedFull  = getDetectedCuts(newShotsFull, cutPositions);
+    const auto detectedFast  = getDetectedCuts(newShotsFast, cutPositions);
+
+    RecordProperty("energyRatio", std::to_string(sumEnergyFull / sumEnergyFast));
+
+    if (blockSize == 32)
+    {
+        // The thresholds of the detector are tuned for 32x32 blocks. Both modes must find
+        // every cut and mark the same frames.
+        EXPECT_EQ(detectedFull.size(), cutPositions.size());
+        EXPECT_EQ(detectedFast.size(), cutPositions.size());
+        EXPECT_EQ(newShotsFull, newShotsFast);
+    }
+    else
+    {
+        // With 16x16 blocks, the energy differences at some cuts stay below the thresholds in
+        // both modes. The fast mode must not miss a cut that the full analysis finds.
+        for (const auto cut : detectedFull)
+            EXPECT_EQ(detectedFast.count(cut), 1u) << "Cut at frame " << cut << " missed";
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(ShotDetectionOnly,
+                         ShotDetectionOnlyFixture,
+                         testing::Combine(testing::Values(16u, 32u),
+                                          testing::Values(1u, 2u, 3u)));
+
+// The energy of the fast mode is scaled to the full energy of a subset of the blocks of each
+// frame, so the energy differences must also match on content that is smoother than the
+// test::SyntheticVideo clips.
+TEST(ShotDetectionOnly, SmoothContentMatchesTheFullAnalysis)
+{
+    vca_frame_info info;
+    info.width      = 640;
+    info.height     = 360;
+    info.bitDepth   = 8;
+    info.colorspace = vca_colorSpace::YUV420;
+
+    auto video = generateSmoothVideo(info);
+
+    std::vector<size_t> cutPositions;
+    for (size_t shot = 0; shot < SMOOTH_NR_SHOTS; shot++)
+        cutPositions.push_back(shot * SMOOTH_SHOT_LENGTH);
+
+    for (const auto blockSize : {16u, 32u})
+    {
+        vca_param param;
+        param.frameInfo      = info;
+        param.blockSize      = blockSize;
+        param.nrFrameThreads = 1;
+
+        auto full = runAnalysis(video, param);
+
+        param.enableShotDetectionOnly = true;
+        auto fast                     = runAnalysis(video, param);
+
+        // With 16x16 blocks the fast mode transforms the same downsampled blocks as the
+        // lowpass DCT. With 32x32 blocks the energy differences within the shots are about 30%
+        // higher than with the full analysis.
+        double sumEnergyDiffFull = 0;
+        double sumEnergyDiffFast = 0;
+        for (size_t i = 1; i < full.results.size(); i++)
+        {
+            sumEnergyDiffFull += full.results[i].energyDiff;
+            sumEnergyDiffFast += fast.results[i].energyDiff;
+        }
+        const auto energyDiffRatio = sumEnergyDiffFast / sumEnergyDiffFull;
+        EXPECT_GT(energyDiffRatio, 0.8) << "Block size " << blockSize;
+        EXPECT_LT(energyDiffRatio, 1.5) << "Block size " << blockSize;
+
+        const auto newShotsFull = detectShots(full.results);
+        const auto newShotsFast = detectShots(fast.results);
+        const auto detectedFull = getDetectedCuts(newShotsFull, cutPositions);
+        const auto detectedFast = getDetectedCuts(newShotsFast, cutPositions);
+        if (blockSize == 32)
+        {
+            EXPECT_EQ(detectedFull.size(), cutPositions.size());
+            EXPECT_EQ(newShotsFull, newShotsFast);
+        }
+        else
+        {
+            for (const auto cut : detectedFull)
+                EXPECT_EQ(detectedFast.count(cut), 1u) << "Cut at frame " << cut << " missed";
+        }
+    }
+}
+
+// The DC of the lowpass DCT is 128 * mean for all bit depths, while the DCT has a DC of
+// mean * 2^(15 - bitDepth). The fast mode must calculate the DC like the full analysis in both
+// cases. The lowpass DC wraps for means above 255, where a rounding difference of the sum can
+// change the brightness completely, so the samples stay below that.
+TEST(ShotDetectionOnly, HighBitDepthBrightnessMatchesTheFullAnalysis)
+{
+    for (const auto bitDepth : {10u, 12u})
+    {
+        vca_frame_info info;
+        info.width      = 640;
+        info.height     = 360;
+        info.bitDepth   = bitDepth;
+        info.colorspace = vca_colorSpace::YUV420;
+
+        std::default_random_engine randomEngine(bitDepth);
+        const auto texture = test::generateNoiseTexture(info.width + 8,
+                                                        info.height,
+                                                        64,
+                                                        8.0,
+                                                        randomEngine);
+        const auto getSample = [&](unsigned i, unsigned c, unsigned x, unsigned y) {
+            if (c > 0)
+                return 1u << (bitDepth - 1);
+            const auto value = 140.0 + texture[y * (info.width + 8) + x + i * 4];
+            return unsigned(std::clamp(value, 0.0, 255.0));
+        };
+        test::GeneratedVideo video(info, 3, getSample);
+
+        for (const auto blockSize : {16u, 32u})
+            for (const auto enableLowpass : {false, true})
+            {
+                vca_param param;
+                param.frameInfo      = info;
+                param.blockSize      = blockSize;
+                param.enableLowpass  = enableLowpass;
+                param.nrFrameThreads = 1;
+
+                const auto full = test::analyzeFrames(video.getFrames(), param);
+
+                param.enableShotDetectionOnly = true;
+                const auto fast               = test::analyzeFrames(video.getFrames(), param);
+
+                for (size_t i = 0; i < full.size(); i++)
+                {
+                    EXPECT_NEAR(full[i].result.averageBrightness,
+                                fast[i].result.averageBrightness,
+                                1)
+                        << "Bit depth " << bitDepth << ", block size " << blockSize
+                        << ", lowpass " << enableLowpass << ", frame " << i;
+
+                    // The blocks at the bottom border are padded with the last downsampled
+                    // line in the fast mode and can differ more
+                    const auto nrFullBlocks = (info.height / blockSize) * full[i].widthInBlocks;
+                    for (size_t b = 0; b < nrFullBlocks; b++)
+                        ASSERT_NEAR(full[i].brightness[b], fast[i].brightness[b], 1)
+                            << "Bit depth " << bitDepth << ", block size " << blockSize
+                            << ", lowpass " << enableLowpass << ", block " << b;
+                }
+            }
+    }
+}
+
+TEST(ShotDetectionOnly, BlockSize8IsRejected)
+{
+    vca_param param;
+    param.frameInfo.width         = 640;
+    param.frameInfo.height        = 360;
+    param.blockSize               = 8;
+    param.enableShotDetectionOnly = true;
+    EXPECT_THROW(vca::Analyzer analyzer(param), std::invalid_argument);
+}
@@ -0,0 +1,193 @@
+/* Copyright (C) 2024 Christian Doppler Laboratory ATHENA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.
+ *****************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <analyzer/ShotDetection.h>
+
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace {
+
+std::vector<vca_frame_results> generateRandomFrameResults(size_t nrFrames,
+                                                          unsigned seed,
+                                                          double quietFrameProbability = 0.7)
+{
+    std::mt19937 generator(seed);
+    std::uniform_real_distribution<double> epsilonDistribution(0.0, 60.0);
+    std::uniform_real_distribution<double> sadDistribution(0.0, 200.0);
+    std::bernoulli_distribution quietFrame(quietFrameProbability);
+
+    std::vector<vca_frame_results> frames(nrFrames);
+    for (size_t i = 0; i < nrFrames; i++)
+    {
+        frames[i].poc = static_cast<int>(i);
+        if (quietFrame(generator))
+            continue;
+        frames[i].energyEpsilon = epsilonDistribution(generator);
+        frames[i].energyDiff    = sadDistribution(generator);
+    }
+    return frames;
+}
+
+std::vector<bool> runOnlineShotDetection(const vca_shot_detection_param &param,
+                                         const std::vector<vca_frame_results> &frames)
+{
+    vca::ShotDetector detector(param);
+
+    std::vector<bool> isNewShot;
+    auto pullDecidedFrames = [&]() {
+        vca_frame_results result;
+        while (detector.resultAvailable())
+        {
+            EXPECT_EQ(detector.pull(&result), vca_result::VCA_OK);
+            EXPECT_EQ(result.poc, static_cast<int>(isNewShot.size()));
+            isNewShot.push_back(result.isNewShot);
+        }
+    };
+
+    for (const auto &frame : frames)
+    {
+        EXPECT_EQ(detector.push(frame), vca_result::VCA_OK);
+        pullDecidedFrames();
+        EXPECT_LE(frame.poc + 1 - isNewShot.size(), static_cast<size_t>(std::ceil(param.fps)) + 1);
+    }
+    EXPECT_EQ(detector.flush(), vca_result::VCA_OK);
+    pullDecidedFrames();
+
+    return isNewShot;
+}
+
+} // namespace
+
+using FPS      = double;
+using Seed     = unsigned;
+using TestCase = std::tuple<FPS, Seed>;
+
+class ShotDetectionOnlineOfflineFixture : public testing::TestWithParam<TestCase>
+{
+};
+
+TEST_P(ShotDetectionOnlineOfflineFixture, OnlineDetectionMatchesOfflineDetection)
+{
+    const auto fps  = std::get<0>(GetParam());
+    const auto seed = std::get<1>(GetParam());
+
+    vca_shot_detection_param param;
+    param.fps = fps;
+
+    for (const size_t nrFrames : {1, 2, 3, 10, 500})
+    {
+        auto frames = generateRandomFrameResults(nrFrames, seed);
+
+        const auto online = runOnlineShotDetection(param, frames);
+
+        ASSERT_EQ(vca::shot_detection(param, frames.data(), frames.size()), vca_result::VCA_OK);
+
+        ASSERT_EQ(online.size(), frames.size());
+        for (size_t i = 0; i < frames.size(); i++)
+            EXPECT_EQ(online[i], frames[i].isNewShot) << "Frame " << i << " of " << nrFrames;
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(ShotDetection,
+                         ShotDetectionOnlineOfflineFixture,
+                         testing::Combine(testing::Values(0.0, 1.0, 5.0, 23.976, 30.0),
+                                          testing::Values(1u, 2u, 3u)));
+
+using NrThreads        = unsigned;
+using QuietProbability = double;
+using ParallelTestCase = std::tuple<NrThreads, QuietProbability, Seed>;
+
+class ShotDetectionParallelFixture : public testing::TestWithParam<ParallelTestCase>
+{
+};
+
+TEST_P(ShotDetectionParallelFixture, ChunkedDetectionMatchesSequentialDetection)
+{
+    const auto nrThreads        = std::get<0>(GetParam());
+    const auto quietProbability = std::get<1>(GetParam());
+    const auto seed             = std::get<2>(GetParam());
+
+    const size_t nrFrames = 50000;
+    auto sequentialFrames = generateRandomFrameResults(nrFrames, seed, quietProbability);
+    auto parallelFrames   = sequentialFrames;
+
+    vca_shot_detection_param param;
+    param.fps = 24.0;
+    ASSERT_EQ(vca::shot_detection(param, sequentialFrames.data(), nrFrames), vca_result::VCA_OK);
+
+    param.nrThreads = nrThreads;
+    ASSERT_EQ(vca::shot_detection(param, parallelFrames.data(), nrFrames), vca_result::VCA_OK);
+
+    for (size_t i = 0; i < nrFrames; i++)
+        ASSERT_EQ(sequentialFrames[i].isNewShot, parallelFrames[i].isNewShot) << "Frame " << i;
+}
+
+TEST_P(ShotDetectionParallelFixture, BatchDetectionMatchesSequentialDetection)
+{
+    const auto nrThreads        = std::get<0>(GetParam());
+    const auto quietProbability = std::get<1>(GetParam());
+    const auto seed             = std::get<2>(GetParam());
+
+    const size_t nrFrames = 50000;
+    const auto frames     = generateRandomFrameResults(nrFrames, seed, quietProbability);
+
+    std::vector<vca_shot_detection_param> params;
+    for (const auto minEpsilonThresh : {1.0, 1.5, 10.0})
+        for (const auto maxEpsilonThresh : {30.0, 50.0})
+            for (const auto fps : {10.0, 29.97})
+            {
+                vca_shot_detection_param param;
+                param.minEpsilonThresh = minEpsilonThresh;
+                param.maxEpsilonThresh = maxEpsilonThresh;
+                param.fps              = fps;
+                param.nrThreads        = nrThreads;
+                params.push_back(param);
+            }
+
+    std::unique_ptr<bool[]> isNewShot(new bool[params.size() * nrFrames]);
+    ASSERT_EQ(vca::shot_detection_batch(params.data(),
+                                        params.size(),
+                                        frames.data(),
+                                        nrFrames,
+                                        isNewShot.get()),
+              vca_result::VCA_OK);
+
+    for (size_t p = 0; p < params.size(); p++)
+    {
+        auto sequentialFrames = frames;
+        auto param            = params[p];
+        param.nrThreads       = 1;
+        ASSERT_EQ(vca::shot_detection(param, sequentialFrames.data(), nrFrames),
+                  vca_result::VCA_OK);
+
+        // Frame 1 is never a shot
+        for (size_t i = 0; i < nrFrames; i++)
+            if (i != 1)
+                ASSERT_EQ(sequentialFrames[i].isNewShot, isNewShot[p * nrFrames + i])
+                    << "Parameter set " << p << " frame " << i;
+        ASSERT_FALSE(isNewShot[p * nrFrames + 1]);
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(ShotDetection,
+                         ShotDetectionParallelFixture,
+                         testing::Combine(testing::Values(1u, 2u, 3u, 8u),
+                                          testing::Values(0.7, 0.995),
+                                          testing::Values(1u, 2u)));
@@ -0,0 +1,131 @@
+/* Copyright (C) 2024 Christian Doppler Laboratory ATHENA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.
+ *****************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include "common/functions.h"
+
+#include <analyzer/Analyzer.h>
+
+namespace {
+
+double getStageTime(const vca_analyzer_stats &stats, vca_stage stage)
+{
+    return stats.stageTimeTotal[unsigned(stage)];
+}
+
+vca_analyzer_stats analyze(test::SyntheticVideo &video,
+                           const vca_param &param,
+                           std::vector<vca_frame_results> &results)
+{
+    vca::Analyzer analyzer(param);
+    results.resize(video.getNrFrames());
+    for (size_t i = 0; i < video.getNrFrames(); i++)
+    {
+        EXPECT_EQ(analyzer.pushFrame(video.getFrame(i)), vca_result::VCA_OK);
+        EXPECT_EQ(analyzer.pullResult(&results[i]), vca_result::VCA_OK);
+    }
+
+    vca_analyzer_stats stats;
+    analyzer.getStats(&stats);
+    return stats;
+}
+
+} // namespace
+
+TEST(StageTimings, StagesAreMeasured)
+{
+    vca_frame_info info;
+    info.width  = 320;
+    info.height = 192;
+    test::SyntheticVideo video(info, {8, 8}, 3);
+
+    vca_param param;
+    param.frameInfo          = info;
+    param.blockSize          = 16;
+    param.nrFrameThreads     = 2;
+    param.enableStageTimings = true;
+
+    std::vector<vca_frame_results> results;
+    const auto stats = analyze(video, param, results);
+
+    for (auto stage : {vca_stage::Frame,
+                       vca_stage::DCT,
+                       vca_stage::WeightedSum,
+                       vca_stage::Entropy,
+                       vca_stage::EdgeDensity,
+                       vca_stage::Chroma,
+                       vca_stage::Temporal,
+                       vca_stage::CopyOut})
+    {
+        EXPECT_GT(getStageTime(stats, stage), 0.0) << "Stage " << unsigned(stage);
+        EXPECT_GT(stats.stageTimeRecent[unsigned(stage)], 0.0) << "Stage " << unsigned(stage);
+        EXPECT_LE(stats.stageTimeRecent[unsigned(stage)], getStageTime(stats, stage));
+    }
+
+    // The feature stages do not overlap and are part of the work on the frame
+    const auto featureTime = getStageTime(stats, vca_stage::DCT)
+                             + getStageTime(stats, vca_stage::WeightedSum)
+                             + getStageTime(stats, vca_stage::Entropy)
+                             + getStageTime(stats, vca_stage::EdgeDensity)
+                             + getStageTime(stats, vca_stage::Chroma);
+    EXPECT_LE(featureTime, getStageTime(stats, vca_stage::Frame));
+
+    EXPECT_EQ(stats.nrThreads, 2u);
+    for (unsigned i = 0; i < stats.nrThreads; i++)
+    {
+        EXPECT_GT(stats.threadUtilization[i], 0.0);
+        EXPECT_LE(stats.threadUtilization[i], 1.0);
+    }
+}
+
+TEST(StageTimings, DisabledByDefault)
+{
+    vca_frame_info info;
+    info.width  = 320;
+    info.height = 192;
+    test::SyntheticVideo video(info, {6}, 3);
+
+    vca_param param;
+    param.frameInfo      = info;
+    param.blockSize      = 16;
+    param.nrFrameThreads = 2;
+
+    std::vector<vca_frame_results> results;
+    const auto stats = analyze(video, param, results);
+    for (unsigned i = 0; i < VCA_NR_STAGES; i++)
+    {
+        EXPECT_EQ(stats.stageTimeTotal[i], 0.0);
+        EXPECT_EQ(stats.stageTimeRecent[i], 0.0);
+    }
+
+    // The thread utilization is always reported
+    EXPECT_EQ(stats.nrThreads, 2u);
+    EXPECT_GT(stats.threadUtilization[0] + stats.threadUtilization[1], 0.0);
+
+    // Measuring does not change the results
+    param.enableStageTimings = true;
+    std::vector<vca_frame_results> timedResults;
+    analyze(video, param, timedResults);
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        EXPECT_EQ(timedResults[i].averageEnergy, results[i].averageEnergy);
+        EXPECT_EQ(timedResults[i].energyDiff, results[i].energyDiff);
+        EXPECT_EQ(timedResults[i].averageEntropy, results[i].averageEntropy);
+        EXPECT_EQ(timedResults[i].averageEdgeDensity, results[i].averageEdgeDensity);
+        EXPECT_EQ(timedResults[i].energyU, results[i].energyU);
+    }
+}
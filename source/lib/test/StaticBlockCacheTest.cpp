@@ -0,0 +1,237 @@
+/* Copyright (C) 2024 Christian Doppler Laboratory ATHENA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.
+ *****************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include "common/functions.h"
+
+#include <analyzer/Analyzer.h>
+#include <analyzer/FrameHash.h>
+#include <analyzer/simd/cpu.h>
+
+#include <array>
+#include <random>
+
+namespace {
+
+constexpr unsigned NR_FRAMES = 20;
+
+// A static random background with a random square that moves over it. The size is not a
+// multiple of the block size so that the padding of the border blocks is covered as well.
+// Every position can be shown for several frames (repeated frames).
+test::GeneratedVideo generateMovingSquareVideo(vca_frame_info info, unsigned framesPerPosition = 1)
+{
+    std::default_random_engine randomEngine(1);
+    std::uniform_int_distribution<unsigned> valueDist(0, (1u << info.bitDepth) - 1);
+
+    std::vector<unsigned> background[3];
+    std::vector<unsigned> square[3];
+    for (unsigned c = 0; c < 3; c++)
+    {
+        const auto planeSize = (c == 0) ? info.width * info.height
+                                        : (info.width / 2) * (info.height / 2);
+        background[c].resize(planeSize);
+        for (auto &value : background[c])
+            value = valueDist(randomEngine);
+        square[c].resize(planeSize);
+        for (auto &value : square[c])
+            value = valueDist(randomEngine);
+    }
+
+    const auto getSample = [&](unsigned i, unsigned c, unsigned x, unsigned y) {
+        const auto scale        = (c == 0) ? 1u : 2u;
+        const auto posX         = (i / framesPerPosition) * 12;
+        const auto posY         = (i / framesPerPosition) * 5;
+        const auto insideSquare = x >= posX / scale && x < (posX + 40) / scale
+                                  && y >= posY / scale && y < (posY + 40) / scale;
+        const auto index        = y * (info.width / scale) + x;
+        return insideSquare ? square[c][index] : background[c][index];
+    };
+    return test::GeneratedVideo(info, NR_FRAMES, getSample);
+}
+
+// Set the old and the new position of the square as the dirty rectangles of each frame. The
+// returned rectangles are referenced by the frames.
+std::vector<std::array<vca_rect, 2>> setDirtyRects(test::GeneratedVideo &video)
+{
+    std::vector<std::array<vca_rect, 2>> dirtyRects(NR_FRAMES);
+    for (unsigned i = 1; i < NR_FRAMES; i++)
+    {
+        dirtyRects[i][0]    = {(i - 1) * 12, (i - 1) * 5, 40, 40};
+        dirtyRects[i][1]    = {i * 12, i * 5, 40, 40};
+        auto frame          = video.getFrame(i);
+        frame->dirtyRects   = dirtyRects[i].data();
+        frame->nrDirtyRects = 2;
+    }
+    return dirtyRects;
+}
+
+} // namespace
+
+using BlockSize = unsigned;
+using BitDepth  = unsigned;
+using NrThreads = unsigned;
+using TestCase  = std::tuple<BlockSize, BitDepth, NrThreads>;
+
+class StaticBlockCacheFixture : public testing::TestWithParam<TestCase>
+{
+};
+
+TEST_P(StaticBlockCacheFixture, ResultsMatchFullAnalysis)
+{
+    vca_frame_info info;
+    info.width    = 200;
+    info.height   = 120;
+    info.bitDepth = std::get<1>(GetParam());
+
+    auto video = generateMovingSquareVideo(info);
+
+    vca_param param;
+    param.frameInfo      = info;
+    param.blockSize      = std::get<0>(GetParam());
+    param.nrFrameThreads = std::get<2>(GetParam());
+
+    vca_analyzer_stats statsFull;
+    const auto full = test::analyzeFrames(video.getFrames(), param, &statsFull);
+
+    param.enableStaticBlockCache = true;
+    vca_analyzer_stats statsCached;
+    const auto cached = test::analyzeFrames(video.getFrames(), param, &statsCached);
+
+    EXPECT_EQ(statsFull.blocksReused, 0u);
+    EXPECT_GT(statsCached.blocksReused, statsCached.blocksAnalyzed / 4);
+    EXPECT_EQ(statsFull.blocksAnalyzed, statsCached.blocksAnalyzed);
+
+    for (unsigned i = 0; i < NR_FRAMES; i++)
+    {
+        EXPECT_EQ(full[i].brightness, cached[i].brightness) << "Frame " << i;
+        EXPECT_EQ(full[i].energy, cached[i].energy) << "Frame " << i;
+        EXPECT_EQ(full[i].averageU, cached[i].averageU) << "Frame " << i;
+        EXPECT_EQ(full[i].averageV, cached[i].averageV) << "Frame " << i;
+        EXPECT_EQ(full[i].energyU, cached[i].energyU) << "Frame " << i;
+        EXPECT_EQ(full[i].energyV, cached[i].energyV) << "Frame " << i;
+        EXPECT_EQ(full[i].entropy, cached[i].entropy) << "Frame " << i;
+        EXPECT_EQ(full[i].entropyU, cached[i].entropyU) << "Frame " << i;
+        EXPECT_EQ(full[i].entropyV, cached[i].entropyV) << "Frame " << i;
+        EXPECT_EQ(full[i].edgeDensity, cached[i].edgeDensity) << "Frame " << i;
+        EXPECT_EQ(full[i].result.energyEpsilon, cached[i].result.energyEpsilon);
+        EXPECT_EQ(full[i].result.entropyEpsilon, cached[i].result.entropyEpsilon);
+    }
+}
+
+TEST_P(StaticBlockCacheFixture, DirtyRectsMatchFullAnalysis)
+{
+    vca_frame_info info;
+    info.width    = 200;
+    info.height   = 120;
+    info.bitDepth = std::get<1>(GetParam());
+
+    auto video = generateMovingSquareVideo(info);
+
+    vca_param param;
+    param.frameInfo      = info;
+    param.blockSize      = std::get<0>(GetParam());
+    param.nrFrameThreads = std::get<2>(GetParam());
+
+    vca_analyzer_stats statsFull;
+    const auto full = test::analyzeFrames(video.getFrames(), param, &statsFull);
+
+    const auto dirtyRects = setDirtyRects(video);
+    vca_analyzer_stats statsDirty;
+    const auto dirty = test::analyzeFrames(video.getFrames(), param, &statsDirty);
+
+    EXPECT_GT(statsDirty.blocksReused, statsDirty.blocksAnalyzed / 4);
+
+    for (unsigned i = 0; i < NR_FRAMES; i++)
+    {
+        EXPECT_EQ(full[i].brightness, dirty[i].brightness) << "Frame " << i;
+        EXPECT_EQ(full[i].energy, dirty[i].energy) << "Frame " << i;
+        EXPECT_EQ(full[i].averageU, dirty[i].averageU) << "Frame " << i;
+        EXPECT_EQ(full[i].energyV, dirty[i].energyV) << "Frame " << i;
+        EXPECT_EQ(full[i].entropy, dirty[i].entropy) << "Frame " << i;
+        EXPECT_EQ(full[i].entropyU, dirty[i].entropyU) << "Frame " << i;
+        EXPECT_EQ(full[i].edgeDensity, dirty[i].edgeDensity) << "Frame " << i;
+    }
+}
+
+TEST_P(StaticBlockCacheFixture, DuplicateFramesMatchFullAnalysis)
+{
+    vca_frame_info info;
+    info.width    = 200;
+    info.height   = 120;
+    info.bitDepth = std::get<1>(GetParam());
+
+    auto video = generateMovingSquareVideo(info, 2);
+
+    vca_param param;
+    param.frameInfo      = info;
+    param.blockSize      = std::get<0>(GetParam());
+    param.nrFrameThreads = std::get<2>(GetParam());
+
+    vca_analyzer_stats statsFull;
+    const auto full = test::analyzeFrames(video.getFrames(), param, &statsFull);
+
+    param.enableDuplicateFrameDetection = true;
+    vca_analyzer_stats statsDuplicate;
+    const auto duplicate = test::analyzeFrames(video.getFrames(), param, &statsDuplicate);
+
+    EXPECT_EQ(statsDuplicate.duplicateFrames, NR_FRAMES / 2);
+
+    for (unsigned i = 0; i < NR_FRAMES; i++)
+    {
+        EXPECT_FALSE(full[i].result.isDuplicate);
+        EXPECT_EQ(duplicate[i].result.isDuplicate, i % 2 == 1) << "Frame " << i;
+        EXPECT_EQ(full[i].result.poc, duplicate[i].result.poc);
+        EXPECT_EQ(full[i].brightness, duplicate[i].brightness) << "Frame " << i;
+        EXPECT_EQ(full[i].energy, duplicate[i].energy) << "Frame " << i;
+        EXPECT_EQ(full[i].energyU, duplicate[i].energyU) << "Frame " << i;
+        EXPECT_EQ(full[i].entropy, duplicate[i].entropy) << "Frame " << i;
+        EXPECT_EQ(full[i].entropyV, duplicate[i].entropyV) << "Frame " << i;
+        EXPECT_EQ(full[i].edgeDensity, duplicate[i].edgeDensity) << "Frame " << i;
+        EXPECT_EQ(full[i].result.averageEnergy, duplicate[i].result.averageEnergy);
+        EXPECT_EQ(full[i].result.energyDiff, duplicate[i].result.energyDiff);
+        EXPECT_EQ(full[i].result.energyEpsilon, duplicate[i].result.energyEpsilon);
+        EXPECT_EQ(full[i].result.entropyDiff, duplicate[i].result.entropyDiff);
+        EXPECT_EQ(full[i].result.entropyEpsilon, duplicate[i].result.entropyEpsilon);
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(StaticBlockCache,
+                         StaticBlockCacheFixture,
+                         testing::Combine(testing::Values(8u, 16u, 32u),
+                                          testing::Values(8u, 10u),
+                                          testing::Values(1u, 4u)));
+
+TEST(FrameHash, SIMDMatchesNative)
+{
+    std::default_random_engine randomEngine(1);
+    std::uniform_int_distribution<unsigned> byteDist(0, 255);
+
+    std::vector<uint8_t> data(1000);
+    for (auto &value : data)
+        value = uint8_t(byteDist(randomEngine));
+
+    for (unsigned nrBytes : {1u, 8u, 15u, 16u, 17u, 64u, 999u, 1000u})
+        EXPECT_EQ(vca::hashLine(data.data(), nrBytes, CpuSimd::None),
+                  vca::hashLine(data.data(), nrBytes, vca::cpuDetectMaxSimd()))
+            << nrBytes << " bytes";
+
+    // The hash depends on the position of the bytes
+    auto swapped = data;
+    std::swap_ranges(swapped.begin(), swapped.begin() + 16, swapped.begin() + 16);
+    EXPECT_NE(vca::hashLine(data.data(), 32, CpuSimd::None),
+              vca::hashLine(swapped.data(), 32, CpuSimd::None));
+}
@@ -0,0 +1,112 @@
+/* Copyright (C) 2024 Christian Doppler Laboratory ATHENA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.
+ *****************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include "common/functions.h"
+
+#include <analyzer/Analyzer.h>
+
+#include <map>
+
+namespace {
+
+// Analyzes the given frames of the video in this order. A frame that does not follow the
+// previously analyzed frame is marked as a discontinuity.
+std::map<size_t, vca_frame_results> analyze(test::SyntheticVideo &video,
+                                            const std::vector<size_t> &frameIndices)
+{
+    vca_param param;
+    param.frameInfo = video.getFrame(0)->info;
+    param.blockSize = 16;
+    vca::Analyzer analyzer(param);
+
+    std::map<size_t, vca_frame_results> results;
+    for (size_t i = 0; i < frameIndices.size(); i++)
+    {
+        const auto index       = frameIndices[i];
+        auto frame             = video.getFrame(index);
+        frame->isDiscontinuity = (i > 0 && frameIndices[i - 1] + 1 != index);
+        EXPECT_EQ(analyzer.pushFrame(frame), vca_result::VCA_OK);
+        EXPECT_EQ(analyzer.pullResult(&results[index]), vca_result::VCA_OK);
+        frame->isDiscontinuity = false;
+    }
+    return results;
+}
+
+} // namespace
+
+TEST(TemporalSampling, DiscontinuityResetsTemporalValues)
+{
+    vca_frame_info info;
+    info.width  = 320;
+    info.height = 192;
+    test::SyntheticVideo video(info, {12}, 3);
+
+    std::vector<size_t> allFrames(video.getNrFrames());
+    for (size_t i = 0; i < allFrames.size(); i++)
+        allFrames[i] = i;
+    auto full = analyze(video, allFrames);
+
+    // Runs of 3 frames at the positions 0, 5 and 9
+    const auto sampled = analyze(video, {0, 1, 2, 5, 6, 7, 9, 10, 11});
+    for (const auto &[index, result] : sampled)
+    {
+        const auto &fullResult = full[index];
+        EXPECT_EQ(result.averageEnergy, fullResult.averageEnergy) << "Frame " << index;
+        EXPECT_EQ(result.averageEntropy, fullResult.averageEntropy) << "Frame " << index;
+
+        const auto runStart      = (index >= 9) ? 9 : (index >= 5 ? 5 : 0);
+        const auto positionInRun = index - runStart;
+        if (positionInRun == 0)
+        {
+            EXPECT_EQ(result.energyDiff, 0.0) << "Frame " << index;
+            EXPECT_EQ(result.entropyDiff, 0.0) << "Frame " << index;
+        }
+        else
+        {
+            // The differences to the previous frame in the input are the same as in the full
+            // analysis. Epsilon needs the two previous frames.
+            EXPECT_GT(fullResult.energyDiff, 0.0) << "Frame " << index;
+            EXPECT_EQ(result.energyDiff, fullResult.energyDiff) << "Frame " << index;
+            EXPECT_EQ(result.entropyDiff, fullResult.entropyDiff) << "Frame " << index;
+        }
+        if (positionInRun == 2)
+            EXPECT_EQ(result.energyEpsilon, fullResult.energyEpsilon) << "Frame " << index;
+        else
+            EXPECT_EQ(result.energyEpsilon, 0.0) << "Frame " << index;
+    }
+}
+
+TEST(TemporalSampling, DirtyRectsOfDiscontinuity)
+{
+    vca_frame_info info;
+    info.width  = 320;
+    info.height = 192;
+    test::SyntheticVideo video(info, {2}, 3);
+
+    vca_param param;
+    param.frameInfo = info;
+    vca::Analyzer analyzer(param);
+    EXPECT_EQ(analyzer.pushFrame(video.getFrame(0)), vca_result::VCA_OK);
+
+    const vca_rect dirtyRect{0, 0, 32, 32};
+    auto frame             = video.getFrame(1);
+    frame->dirtyRects      = &dirtyRect;
+    frame->nrDirtyRects    = 1;
+    frame->isDiscontinuity = true;
+    EXPECT_EQ(analyzer.pushFrame(frame), vca_result::VCA_ERROR);
+}
@@ -0,0 +1,147 @@
+/* Copyright (C) 2024 Christian Doppler Laboratory ATHENA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.
+ *****************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include "common/functions.h"
+
+#include <analyzer/Analyzer.h>
+#include <analyzer/Tracing.h>
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+std::string readFile(const std::string &filename)
+{
+    std::ifstream file(filename);
+    std::stringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
+
+unsigned countOccurrences(const std::string &text, const std::string &pattern)
+{
+    unsigned count = 0;
+    auto pos       = text.find(pattern);
+    while (pos != std::string::npos)
+    {
+        count++;
+        pos = text.find(pattern, pos + 1);
+    }
+    return count;
+}
+
+} // namespace
+
+TEST(Tracing, BufferDropsEventsWhenFull)
+{
+    const auto start = vca::TraceBuffer::Clock::now();
+    vca::TraceBuffer buffer(3, start);
+    for (unsigned i = 0; i < 5; i++)
+        buffer.add("Test",
+                   i,
+                   start + std::chrono::microseconds(i),
+                   start + std::chrono::microseconds(i + 2));
+
+    EXPECT_EQ(buffer.size(), 3u);
+    EXPECT_EQ(buffer.getNrDroppedEvents(), 2u);
+    EXPECT_EQ(buffer[2].jobID, 2u);
+    EXPECT_EQ(buffer[2].start, 2000);
+    EXPECT_EQ(buffer[2].duration, 2000);
+
+    {
+        vca::TraceSpan span(nullptr, "Nothing", 0);
+    }
+    std::stringstream stream;
+    vca::Tracer tracer(1, 1);
+    {
+        vca::TraceSpan span(tracer.getThreadBuffer(0), "Span", 7);
+    }
+    tracer.write(stream);
+    EXPECT_NE(stream.str().find("\"name\":\"Span\""), std::string::npos);
+    EXPECT_NE(stream.str().find("\"args\":{\"job\":7}"), std::string::npos);
+    EXPECT_EQ(tracer.getNrDroppedEvents(), 0u);
+}
+
+TEST(Tracing, AnalyzerWritesTrace)
+{
+    vca_frame_info info;
+    info.width  = 320;
+    info.height = 192;
+    test::SyntheticVideo video(info, {8}, 3);
+
+    vca_param param;
+    param.frameInfo         = info;
+    param.blockSize         = 16;
+    param.nrFrameThreads    = 2;
+    param.nrBlockGrids      = 1;
+    param.blockGridSizes[0] = 32;
+
+    vca::Analyzer untraced(param);
+    EXPECT_FALSE(untraced.writeTrace(testing::TempDir() + "untraced.json"));
+
+    param.enableTracing = true;
+    vca::Analyzer analyzer(param);
+    const auto filename = testing::TempDir() + "trace.json";
+    std::vector<vca_frame_results> results(video.getNrFrames());
+    for (size_t i = 0; i < video.getNrFrames(); i++)
+    {
+        EXPECT_EQ(analyzer.pushFrame(video.getFrame(i)), vca_result::VCA_OK);
+        EXPECT_EQ(analyzer.pullResult(&results[i]), vca_result::VCA_OK);
+
+        // The trace can be written at any time
+        if (i == 3)
+        {
+            EXPECT_TRUE(analyzer.writeTrace(filename));
+            EXPECT_GE(countOccurrences(readFile(filename), "\"name\":\"Job\""), 4u);
+        }
+    }
+
+    EXPECT_TRUE(analyzer.writeTrace(filename));
+    const auto trace = readFile(filename);
+    EXPECT_EQ(trace.rfind("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", 0), 0u);
+    EXPECT_EQ(trace.substr(trace.size() - 3), "]}\n");
+
+    const auto nrFrames = unsigned(video.getNrFrames());
+    for (auto name : {"Job",
+                      "Energy",
+                      "Entropy",
+                      "Edge density",
+                      "Block grid",
+                      "Reorder wait",
+                      "Push",
+                      "Wait for result",
+                      "Temporal",
+                      "Copy out"})
+        EXPECT_EQ(countOccurrences(trace, "\"name\":\"" + std::string(name) + "\",\"cat\""),
+                  name == std::string("Temporal") ? nrFrames - 1 : nrFrames)
+            << name;
+    for (auto name : {"Processing thread 0", "Processing thread 1", "Push", "Pull"})
+        EXPECT_NE(trace.find("\"args\":{\"name\":\"" + std::string(name) + "\"}"),
+                  std::string::npos)
+            << name;
+}
+
+TEST(Tracing, InvalidBufferSize)
+{
+    vca_param param;
+    param.enableTracing   = true;
+    param.traceBufferSize = 0;
+    EXPECT_THROW(vca::Analyzer analyzer(param), std::invalid_argument);
+}
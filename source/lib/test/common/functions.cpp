@@ -18,7 +18,13 @@
 
 #include "functions.h"
 
-#include <random>
+#include <analyzer/Analyzer.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
 
 namespace test {
 
@@ -36,4 +42,316 @@ void fillBlockWithRandomData(int16_t *data, const unsigned blockSize, const unsi
         data[i] = int16_t(uniform_dist(randomEngine));
 }
 
-} // namespace test
\ No newline at end of file
+namespace {
+
+struct ShotTexture
+{
+    unsigned width{};
+    unsigned height{};
+    std::vector<unsigned> values;
+    int speedX{};
+    int speedY{};
+    unsigned noiseAmplitude{};
+};
+
+ShotTexture generateShotTexture(unsigned width,
+                                unsigned height,
+                                unsigned maxValue,
+                                std::default_random_engine &randomEngine)
+{
+    ShotTexture texture;
+    texture.width  = width * 2;
+    texture.height = height * 2;
+    texture.values.resize(texture.width * texture.height);
+
+    std::uniform_int_distribution<unsigned> levelDist(maxValue / 4, maxValue - maxValue / 4);
+    std::uniform_int_distribution<int> gradientDist(-3, 3);
+    std::uniform_int_distribution<int> speedDist(-1, 1);
+    std::uniform_int_distribution<unsigned> noiseDist(0, maxValue / 128);
+
+    const auto background = int(levelDist(randomEngine));
+    const auto gradientX  = gradientDist(randomEngine);
+    const auto gradientY  = gradientDist(randomEngine);
+    for (unsigned y = 0; y < texture.height; y++)
+        for (unsigned x = 0; x < texture.width; x++)
+        {
+            const auto value = background + (gradientX * int(x) + gradientY * int(y)) / 16;
+            texture.values[y * texture.width + x] = unsigned(std::clamp(value, 0, int(maxValue)));
+        }
+
+    std::uniform_int_distribution<unsigned> nrRectanglesDist(10, 50);
+    std::uniform_int_distribution<unsigned> sizeDist(4, std::max(width, height) / 4);
+    std::uniform_int_distribution<unsigned> leftDist(0, texture.width - 1);
+    std::uniform_int_distribution<unsigned> topDist(0, texture.height - 1);
+    const auto nrRectangles = nrRectanglesDist(randomEngine);
+    for (unsigned i = 0; i < nrRectangles; i++)
+    {
+        const auto rectWidth  = sizeDist(randomEngine);
+        const auto rectHeight = sizeDist(randomEngine);
+        const auto left       = leftDist(randomEngine);
+        const auto top        = topDist(randomEngine);
+        const auto level      = levelDist(randomEngine);
+        for (unsigned y = top; y < std::min(top + rectHeight, texture.height); y++)
+            for (unsigned x = left; x < std::min(left + rectWidth, texture.width); x++)
+                texture.values[y * texture.width + x] = level;
+    }
+
+    texture.speedX         = speedDist(randomEngine);
+    texture.speedY         = speedDist(randomEngine);
+    texture.noiseAmplitude = noiseDist(randomEngine);
+    return texture;
+}
+
+} // namespace
+
+SyntheticVideo::SyntheticVideo(vca_frame_info info,
+                               const std::vector<unsigned> &shotLengths,
+                               unsigned seed)
+    : info(info)
+{
+    if (info.colorspace != vca_colorSpace::YUV420)
+        throw std::invalid_argument("Only YUV 4:2:0 is supported");
+
+    std::default_random_engine randomEngine(seed);
+
+    const auto maxValue      = (1u << info.bitDepth) - 1;
+    const auto bytesPerPixel = info.bitDepth > 8 ? 2u : 1u;
+    const auto lumaSize      = info.width * info.height;
+    const auto chromaSize    = (info.width / 2) * (info.height / 2);
+
+    for (const auto shotLength : shotLengths)
+    {
+        this->cutPositions.push_back(this->frames.size());
+
+        const auto texture    = generateShotTexture(info.width, info.height, maxValue, randomEngine);
+        const auto chromaU    = std::uniform_int_distribution<unsigned>(0, maxValue)(randomEngine);
+        const auto chromaV    = std::uniform_int_distribution<unsigned>(0, maxValue)(randomEngine);
+        const auto noiseRange = int(texture.noiseAmplitude);
+        std::uniform_int_distribution<int> noiseDist(-noiseRange, noiseRange);
+
+        for (unsigned t = 0; t < shotLength; t++)
+        {
+            std::vector<uint8_t> data((lumaSize + 2 * chromaSize) * bytesPerPixel);
+
+            const auto offsetX = unsigned(int(t) * texture.speedX + int(texture.width));
+            const auto offsetY = unsigned(int(t) * texture.speedY + int(texture.height));
+            for (unsigned y = 0; y < info.height; y++)
+                for (unsigned x = 0; x < info.width; x++)
+                {
+                    const auto textureX = (x + offsetX) % texture.width;
+                    const auto textureY = (y + offsetY) % texture.height;
+                    auto value = int(texture.values[textureY * texture.width + textureX])
+                                 + noiseDist(randomEngine);
+                    value      = std::clamp(value, 0, int(maxValue));
+
+                    const auto i = y * info.width + x;
+                    if (bytesPerPixel == 1)
+                        data[i] = uint8_t(value);
+                    else
+                        reinterpret_cast<uint16_t *>(data.data())[i] = uint16_t(value);
+                }
+
+            for (unsigned i = 0; i < chromaSize; i++)
+            {
+                const auto indexU = lumaSize + i;
+                const auto indexV = lumaSize + chromaSize + i;
+                if (bytesPerPixel == 1)
+                {
+                    data[indexU] = uint8_t(chromaU);
+                    data[indexV] = uint8_t(chromaV);
+                }
+                else
+                {
+                    reinterpret_cast<uint16_t *>(data.data())[indexU] = uint16_t(chromaU);
+                    reinterpret_cast<uint16_t *>(data.data())[indexV] = uint16_t(chromaV);
+                }
+            }
+
+            this->frames.push_back(std::move(data));
+        }
+    }
+
+    for (size_t frameIndex = 0; frameIndex < this->frames.size(); frameIndex++)
+    {
+        auto data = this->frames[frameIndex].data();
+
+        vca_frame frame;
+        frame.planes[0] = data;
+        frame.planes[1] = data + lumaSize * bytesPerPixel;
+        frame.planes[2] = data + (lumaSize + chromaSize) * bytesPerPixel;
+        frame.stride[0] = int(info.width * bytesPerPixel);
+        frame.stride[1] = int(info.width / 2 * bytesPerPixel);
+        frame.stride[2] = int(info.width / 2 * bytesPerPixel);
+        frame.height[0] = int(info.height);
+        frame.height[1] = int(info.height / 2);
+        frame.height[2] = int(info.height / 2);
+        frame.info      = info;
+        frame.stats.poc = int(frameIndex);
+        this->vcaFrames.push_back(frame);
+    }
+}
+
+vca_frame *SyntheticVideo::getFrame(size_t frameIndex)
+{
+    return &this->vcaFrames.at(frameIndex);
+}
+
+std::vector<vca_frame *> SyntheticVideo::getFrames()
+{
+    std::vector<vca_frame *> frames;
+    for (auto &frame : this->vcaFrames)
+        frames.push_back(&frame);
+    return frames;
+}
+
+std::vector<double> generateNoiseTexture(unsigned width,
+                                         unsigned height,
+                                         unsigned maxCellSize,
+                                         double amplitude,
+                                         std::default_random_engine &randomEngine)
+{
+    std::uniform_real_distribution<double> valueDist(-1.0, 1.0);
+
+    std::vector<double> texture(width * height, 0.0);
+    for (unsigned cellSize = 2; cellSize <= maxCellSize; cellSize *= 2)
+    {
+        const auto gridWidth = width / cellSize + 2;
+        std::vector<double> grid(gridWidth * (height / cellSize + 2));
+        for (auto &value : grid)
+            value = valueDist(randomEngine) * std::sqrt(double(cellSize)) * amplitude;
+
+        // Bilinear interpolation of the grid
+        for (unsigned y = 0; y < height; y++)
+            for (unsigned x = 0; x < width; x++)
+            {
+                const auto ix = x / cellSize;
+                const auto iy = y / cellSize;
+                const auto fx = double(x % cellSize) / cellSize;
+                const auto fy = double(y % cellSize) / cellSize;
+                const auto g  = [&](unsigned i, unsigned j) { return grid[j * gridWidth + i]; };
+                const auto top    = (1 - fx) * g(ix, iy) + fx * g(ix + 1, iy);
+                const auto bottom = (1 - fx) * g(ix, iy + 1) + fx * g(ix + 1, iy + 1);
+                texture[y * width + x] += (1 - fy) * top + fy * bottom;
+            }
+    }
+    return texture;
+}
+
+GeneratedVideo::GeneratedVideo(vca_frame_info info,
+                               unsigned nrFrames,
+                               const SampleFunction &getSample)
+{
+    if (info.colorspace != vca_colorSpace::YUV420)
+        throw std::invalid_argument("Only YUV 4:2:0 is supported");
+
+    const auto bytesPerPixel = info.bitDepth > 8 ? 2u : 1u;
+    const unsigned widths[3]  = {info.width, info.width / 2, info.width / 2};
+    const unsigned heights[3] = {info.height, info.height / 2, info.height / 2};
+
+    this->frames.resize(nrFrames);
+    for (unsigned i = 0; i < nrFrames; i++)
+    {
+        auto &data = this->frames[i];
+        data.resize((widths[0] * heights[0] + 2 * widths[1] * heights[1]) * bytesPerPixel);
+
+        vca_frame frame;
+        frame.info      = info;
+        frame.stats.poc = int(i);
+        auto plane      = data.data();
+        for (unsigned c = 0; c < 3; c++)
+        {
+            for (unsigned y = 0; y < heights[c]; y++)
+                for (unsigned x = 0; x < widths[c]; x++)
+                {
+                    const auto value = getSample(i, c, x, y);
+                    const auto index = y * widths[c] + x;
+                    if (bytesPerPixel == 1)
+                        plane[index] = uint8_t(value);
+                    else
+                        reinterpret_cast<uint16_t *>(plane)[index] = uint16_t(value);
+                }
+            frame.planes[c] = plane;
+            frame.stride[c] = int(widths[c] * bytesPerPixel);
+            frame.height[c] = int(heights[c]);
+            plane += widths[c] * heights[c] * bytesPerPixel;
+        }
+        this->vcaFrames.push_back(frame);
+    }
+}
+
+vca_frame *GeneratedVideo::getFrame(size_t frameIndex)
+{
+    return &this->vcaFrames.at(frameIndex);
+}
+
+std::vector<vca_frame *> GeneratedVideo::getFrames()
+{
+    std::vector<vca_frame *> frames;
+    for (auto &frame : this->vcaFrames)
+        frames.push_back(&frame);
+    return frames;
+}
+
+FrameValues::FrameValues(vca_resolution resolution, unsigned blockSize)
+{
+    this->widthInBlocks  = (resolution.width + blockSize - 1) / blockSize;
+    this->heightInBlocks = (resolution.height + blockSize - 1) / blockSize;
+    const auto nrBlocks  = this->widthInBlocks * this->heightInBlocks;
+
+    for (auto vector : {&this->brightness,
+                        &this->energy,
+                        &this->energyDiff,
+                        &this->energyEpsilon,
+                        &this->averageU,
+                        &this->averageV,
+                        &this->energyU,
+                        &this->energyV})
+        vector->resize(nrBlocks);
+    for (auto vector :
+         {&this->entropy, &this->entropyDiff, &this->entropyU, &this->entropyV, &this->edgeDensity})
+        vector->resize(nrBlocks);
+
+    this->result.brightnessPerBlock    = this->brightness.data();
+    this->result.energyPerBlock        = this->energy.data();
+    this->result.energyDiffPerBlock    = this->energyDiff.data();
+    this->result.energyEpsilonPerBlock = this->energyEpsilon.data();
+    this->result.averageUPerBlock      = this->averageU.data();
+    this->result.averageVPerBlock      = this->averageV.data();
+    this->result.energyUPerBlock       = this->energyU.data();
+    this->result.energyVPerBlock       = this->energyV.data();
+    this->result.entropyPerBlock       = this->entropy.data();
+    this->result.entropyDiffPerBlock   = this->entropyDiff.data();
+    this->result.entropyUPerBlock      = this->entropyU.data();
+    this->result.entropyVPerBlock      = this->entropyV.data();
+    this->result.edgeDensityPerBlock   = this->edgeDensity.data();
+}
+
+std::vector<FrameValues> analyzeFrames(const std::vector<vca_frame *> &frames,
+                                       const vca_param &param,
+                                       vca_analyzer_stats *stats)
+{
+    const vca_resolution resolution{param.frameInfo.width, param.frameInfo.height};
+    const auto blockSize = param.blockSize * param.decimationFactor;
+
+    std::vector<FrameValues> values;
+    values.reserve(frames.size());
+    for (size_t i = 0; i < frames.size(); i++)
+        values.emplace_back(resolution, blockSize);
+
+    vca::Analyzer analyzer(param);
+    size_t nrPulledFrames = 0;
+    for (auto frame : frames)
+    {
+        EXPECT_EQ(analyzer.pushFrame(frame), vca_result::VCA_OK);
+        while (analyzer.resultAvailable())
+            EXPECT_EQ(analyzer.pullResult(&values[nrPulledFrames++].result), vca_result::VCA_OK);
+    }
+    while (nrPulledFrames < frames.size())
+        EXPECT_EQ(analyzer.pullResult(&values[nrPulledFrames++].result), vca_result::VCA_OK);
+
+    if (stats != nullptr)
+        analyzer.getStats(stats);
+    return values;
+}
+
+} // namespace test
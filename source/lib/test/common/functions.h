@@ -21,10 +21,102 @@
 #include <analyzer/common/EnumMapper.h>
 #include <vcaLib.h>
 
+#include <functional>
+#include <random>
 #include <stdint.h>
+#include <vector>
 
 namespace test {
 
 void fillBlockWithRandomData(int16_t *data, const unsigned blockSize, const unsigned bitDepth);
 
+/* A synthetic YUV 4:2:0 sequence that consists of shots with hard cuts in between. Every
+ * shot shows a different random texture (blocks, gradients and noise) that is panned with a
+ * constant speed. The content only depends on the seed.
+ */
+class SyntheticVideo
+{
+public:
+    SyntheticVideo(vca_frame_info info, const std::vector<unsigned> &shotLengths, unsigned seed);
+
+    size_t getNrFrames() const { return this->frames.size(); }
+    const std::vector<size_t> &getCutPositions() const { return this->cutPositions; }
+
+    // The returned frames and their planes are owned by this class.
+    vca_frame *getFrame(size_t frameIndex);
+    std::vector<vca_frame *> getFrames();
+
+private:
+    vca_frame_info info;
+    std::vector<std::vector<uint8_t>> frames;
+    std::vector<vca_frame> vcaFrames;
+    std::vector<size_t> cutPositions;
+};
+
+/* A texture with a natural image like spectrum. It is the sum of random grids with a cell size
+ * of 2 to maxCellSize samples that are interpolated bilinearly. The amplitude of every grid
+ * is amplitude * sqrt(cellSize), so it falls with the frequency. The values are centered
+ * around 0.
+ */
+std::vector<double> generateNoiseTexture(unsigned width,
+                                         unsigned height,
+                                         unsigned maxCellSize,
+                                         double amplitude,
+                                         std::default_random_engine &randomEngine);
+
+/* A YUV 4:2:0 sequence of which every sample is given by a function. The function gets the
+ * frame index, the plane and the position in the plane. The frames have 8 bit samples, or
+ * 16 bit samples if the bit depth is higher. The samples are generated in the order of the
+ * frames, planes, lines and samples, so random content only depends on the seed.
+ */
+class GeneratedVideo
+{
+public:
+    using SampleFunction = std::function<unsigned(unsigned frame,
+                                                  unsigned plane,
+                                                  unsigned x,
+                                                  unsigned y)>;
+
+    GeneratedVideo(vca_frame_info info, unsigned nrFrames, const SampleFunction &getSample);
+    GeneratedVideo(GeneratedVideo &&) = default;
+    GeneratedVideo(const GeneratedVideo &) = delete;
+    GeneratedVideo &operator=(const GeneratedVideo &) = delete;
+
+    size_t getNrFrames() const { return this->vcaFrames.size(); }
+
+    // The returned frames and their planes are owned by this class.
+    vca_frame *getFrame(size_t frameIndex);
+    std::vector<vca_frame *> getFrames();
+
+private:
+    std::vector<std::vector<uint8_t>> frames;
+    std::vector<vca_frame> vcaFrames;
+};
+
+/* The per block values of one frame. The per block pointers of result point to the vectors,
+ * which hold one value per block of the given block size.
+ */
+struct FrameValues
+{
+    FrameValues(vca_resolution resolution, unsigned blockSize);
+    FrameValues(FrameValues &&) = default;
+    FrameValues(const FrameValues &) = delete;
+    FrameValues &operator=(const FrameValues &) = delete;
+
+    unsigned widthInBlocks{};
+    unsigned heightInBlocks{};
+    std::vector<uint32_t> brightness, energy, energyDiff, energyEpsilon;
+    std::vector<uint32_t> averageU, averageV, energyU, energyV;
+    std::vector<double> entropy, entropyDiff, entropyU, entropyV, edgeDensity;
+    vca_frame_results result{};
+};
+
+/* Analyze the frames with a new analyzer and return the results of all frames. The block
+ * grid of the values is the one of the input frame (blockSize * decimationFactor). If stats
+ * is set, the statistics of the analyzer are returned in it.
+ */
+std::vector<FrameValues> analyzeFrames(const std::vector<vca_frame *> &frames,
+                                       const vca_param &param,
+                                       vca_analyzer_stats *stats = nullptr);
+
 } // namespace test
@@ -68,6 +68,25 @@ DLL_PUBLIC vca_result vca_analyzer_pull_frame_result(vca_analyzer *enc, vca_fram
     return analyzer->pullResult(result);
 }
 
+DLL_PUBLIC vca_result vca_analyzer_get_stats(vca_analyzer *enc, vca_analyzer_stats *stats)
+{
+    if (enc == nullptr || stats == nullptr)
+        return vca_result::VCA_ERROR;
+
+    auto analyzer = (vca::Analyzer *) (enc);
+    analyzer->getStats(stats);
+    return vca_result::VCA_OK;
+}
+
+DLL_PUBLIC vca_result vca_analyzer_write_trace(vca_analyzer *enc, const char *filename)
+{
+    if (enc == nullptr || filename == nullptr)
+        return vca_result::VCA_ERROR;
+
+    auto analyzer = (vca::Analyzer *) (enc);
+    return analyzer->writeTrace(filename) ? vca_result::VCA_OK : vca_result::VCA_ERROR;
+}
+
 DLL_PUBLIC void vca_analyzer_close(vca_analyzer *enc)
 {
     auto analyzer = (vca::Analyzer *) enc;
@@ -87,4 +106,70 @@ DLL_PUBLIC vca_result vca_shot_detection(const vca_shot_detection_param &param,
     return vca::shot_detection(param, frames, num_frames);
 }
 
+DLL_PUBLIC vca_result vca_shot_detection_batch(const vca_shot_detection_param *params,
+                                               size_t num_params,
+                                               const vca_frame_results *frames,
+                                               size_t num_frames,
+                                               bool *isNewShot)
+{
+    if (params == nullptr || num_params == 0 || frames == nullptr || isNewShot == nullptr)
+        return vca_result::VCA_ERROR;
+
+    return vca::shot_detection_batch(params, num_params, frames, num_frames, isNewShot);
+}
+
+DLL_PUBLIC vca_shot_detector *vca_shot_detector_open(vca_shot_detection_param param)
+{
+    try
+    {
+        auto newDetector = new vca::ShotDetector(param);
+        return newDetector;
+    }
+    catch (const std::exception &)
+    {
+        return nullptr;
+    }
+}
+
+DLL_PUBLIC vca_result vca_shot_detector_push(vca_shot_detector *detector,
+                                             const vca_frame_results *frame)
+{
+    if (detector == nullptr || frame == nullptr)
+        return vca_result::VCA_ERROR;
+
+    auto shotDetector = (vca::ShotDetector *) detector;
+    return shotDetector->push(*frame);
+}
+
+DLL_PUBLIC vca_result vca_shot_detector_flush(vca_shot_detector *detector)
+{
+    if (detector == nullptr)
+        return vca_result::VCA_ERROR;
+
+    auto shotDetector = (vca::ShotDetector *) detector;
+    return shotDetector->flush();
+}
+
+DLL_PUBLIC bool vca_shot_detector_result_available(vca_shot_detector *detector)
+{
+    auto shotDetector = (vca::ShotDetector *) detector;
+    return shotDetector->resultAvailable();
+}
+
+DLL_PUBLIC vca_result vca_shot_detector_pull(vca_shot_detector *detector,
+                                             vca_frame_results *frame)
+{
+    if (detector == nullptr || frame == nullptr)
+        return vca_result::VCA_ERROR;
+
+    auto shotDetector = (vca::ShotDetector *) detector;
+    return shotDetector->pull(frame);
+}
+
+DLL_PUBLIC void vca_shot_detector_close(vca_shot_detector *detector)
+{
+    auto shotDetector = (vca::ShotDetector *) detector;
+    delete shotDetector;
+}
+
 const char *vca_version_str = XSTR(VCA_VERSION);
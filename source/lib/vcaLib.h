@@ -67,6 +67,136 @@ enum class vca_colorSpace
     YUV444
 };
 
+/* Storage format of the per block values that are written to the pointers in
+ * vca_frame_results. The frame level values are not affected by this. Only the
+ * output is converted, the analyzer keeps the native values internally. */
+enum class vca_block_format
+{
+    /* uint32_t for energy, brightness and their differences. double for
+     * entropy and edge density. */
+    Native,
+    /* One float per block for all per block values. */
+    Float32,
+    /* One uint16_t per block for all per block values. Integer values are
+     * saturated to 16 bit without any signal, so 65535 means 65535 or more (the
+     * energy of 32x32 blocks with strong noise can exceed it). Entropy values are
+     * stored in fixed point with a scale of VCA_FIXED16_ENTROPY_SCALE and edge
+     * density values with a scale of VCA_FIXED16_EDGE_DENSITY_SCALE. */
+    Fixed16
+};
+
+/* The blocks that are analyzed in the block sampling mode (see
+ * vca_param::blockSamplingInterval). Both patterns change from frame to frame. */
+enum class vca_sampling_pattern
+{
+    /* One block at a random position out of each run of N blocks (in raster
+     * order). */
+    Stratified,
+    /* Every N-th block along diagonal lines (a checkerboard for N = 2). The
+     * pattern moves by one block per frame, so all blocks are analyzed once
+     * within N frames. */
+    Checkerboard
+};
+
+/* The stages of the analysis that are timed if vca_param::enableStageTimings is set. The
+ * stages do not overlap. DCT, WeightedSum, Entropy and EdgeDensity cover the luma blocks,
+ * Chroma covers all work on the chroma planes. */
+enum class vca_stage
+{
+    /* A pushed frame waits in the job queue for a free thread */
+    QueueWait,
+    /* A thread works on the frame (includes all of the following analysis stages) */
+    Frame,
+    /* The DCT or Hadamard transform of the luma blocks */
+    DCT,
+    /* The weighted sum of the DCT coefficients of the luma blocks */
+    WeightedSum,
+    /* The entropy of the luma blocks */
+    Entropy,
+    /* The edge density of the luma blocks */
+    EdgeDensity,
+    /* Energy and entropy of the chroma planes */
+    Chroma,
+    /* An analyzed frame waits until the results of all previous frames are queued */
+    ReorderWait,
+    /* The temporal differences calculated when pulling the result */
+    Temporal,
+    /* Copying the result to the vca_frame_results of the caller */
+    CopyOut
+};
+#define VCA_NR_STAGES 10
+
+/* The number of results over which the recent stage timings are averaged */
+#define VCA_STAGE_TIMING_WINDOW 32
+
+/* The maximum number of threads for which the utilization is reported */
+#define VCA_MAX_THREAD_STATS 64
+
+#define VCA_FIXED16_ENTROPY_SCALE 4096
+#define VCA_FIXED16_EDGE_DENSITY_SCALE 65535
+
+/* The outputs of vca_frame_results that a caller needs (see vca_param::requiredOutputs).
+ * The flags can be combined with |. Each flag covers the frame level and the per block
+ * values. */
+/* averageBrightness */
+#define VCA_OUTPUT_BRIGHTNESS (1u << 0)
+/* averageEnergy */
+#define VCA_OUTPUT_ENERGY (1u << 1)
+/* energyDiff and energyEpsilon */
+#define VCA_OUTPUT_ENERGY_DIFF (1u << 2)
+/* averageU, averageV, energyU and energyV */
+#define VCA_OUTPUT_CHROMA_ENERGY (1u << 3)
+/* averageEntropy */
+#define VCA_OUTPUT_ENTROPY (1u << 4)
+/* entropyDiff and entropyEpsilon */
+#define VCA_OUTPUT_ENTROPY_DIFF (1u << 5)
+/* entropyU and entropyV */
+#define VCA_OUTPUT_CHROMA_ENTROPY (1u << 6)
+/* averageEdgeDensity */
+#define VCA_OUTPUT_EDGE_DENSITY (1u << 7)
+#define VCA_OUTPUT_ALL 0xffu
+
+/* The number of quality tiers of the real-time mode (see vca_param::realTimeFrameRate) */
+#define VCA_NR_QUALITY_TIERS 4
+
+/* A rectangle in luma samples */
+struct vca_rect
+{
+    unsigned x{};
+    unsigned y{};
+    unsigned width{};
+    unsigned height{};
+};
+
+/* A frame size in luma samples */
+struct vca_resolution
+{
+    unsigned width{};
+    unsigned height{};
+};
+
+#define VCA_MAX_LADDER_RESOLUTIONS 8
+
+/* The results on a coarser block grid (see vca_param::blockGridSizes). They are derived from
+ * the results of the analysis block size, so the frame is only transformed once. The per
+ * block pointers work like the ones in vca_frame_results with one value per block of this
+ * grid. */
+struct vca_block_grid_results
+{
+    unsigned blockSize{};
+
+    uint32_t *brightnessPerBlock{};
+    uint32_t averageBrightness{};
+
+    uint32_t *energyPerBlock{};
+    uint32_t averageEnergy{};
+
+    double *edgeDensityPerBlock{};
+    double averageEdgeDensity{};
+};
+
+#define VCA_MAX_BLOCK_GRIDS 2
+
 /* Frame level statistics */
 struct vca_frame_stats
 {
@@ -82,6 +212,9 @@ struct vca_frame_results
     /* The pointers are pointers to memory for storage of one value per block in the frame.
      * The caller must make sure that this is pointing to a valid and big enough block of memory.
      * If they are nullptr, no data will be written.
+     * If vca_param::blockFormat is not Native, the pointers are reinterpreted as
+     * pointers to float (Float32) or uint16_t (Fixed16) values. In this case the
+     * memory only needs to hold one value of that type per block.
      */
     uint32_t *brightnessPerBlock{};
     uint32_t averageBrightness;
@@ -118,9 +251,41 @@ struct vca_frame_results
     double *edgeDensityPerBlock{};
     double averageEdgeDensity{};
 
+    // The half width of the 95% confidence intervals of averageEnergy, averageEntropy and
+    // averageEdgeDensity in the block sampling mode (see vca_param::blockSamplingInterval).
+    // 0 if all blocks were analyzed.
+    double averageEnergyConfidence{};
+    double averageEntropyConfidence{};
+    double averageEdgeDensityConfidence{};
+
+    // The quality tier of the real-time mode that analyzed the frame (see
+    // vca_param::realTimeFrameRate). Always 0 if the real-time mode is disabled.
+    unsigned qualityTier{};
+
     int poc{};
     bool isNewShot{};
 
+    // The frame is identical to the previous frame (only set if duplicate frame detection
+    // is enabled). All results are copied from the previous frame and the temporal
+    // differences are 0.
+    bool isDuplicate{};
+
+    // The analyzed area of the frame in luma samples. This is the region of interest (see
+    // vca_param) aligned to the block grid. The per block values are always written for all
+    // blocks of the frame. The values of blocks outside of this area are 0.
+    vca_rect analysisRegion{};
+
+    // The results at the ladder resolutions (see vca_param::ladderResolutions) in the same
+    // order. If this is not nullptr, it must point to one vca_frame_results per ladder
+    // resolution. Their per block pointers must hold one value per block of the block grid at
+    // that resolution (or be nullptr). Their analysisRegion is given in samples of the ladder
+    // resolution.
+    vca_frame_results *ladderResults{};
+
+    // The results on the coarser block grids (see vca_param::blockGridSizes) in the same
+    // order. The caller sets the per block pointers, blockSize is set by the analyzer.
+    vca_block_grid_results blockGrids[VCA_MAX_BLOCK_GRIDS]{};
+
     // An increasing counter that is incremented with each call to 'vca_analyzer_push'.
     // So with this one can double check that the results are recieved in the right order.
     unsigned jobID{};
@@ -148,6 +313,20 @@ struct vca_frame
 
     vca_frame_stats stats;
     vca_frame_info info;
+
+    /* Optional list of the regions that changed compared to the previous frame (e.g. known
+     * from a screen capture layer). Only the blocks that intersect one of the rectangles are
+     * analyzed. The per block results of all other blocks are copied from the previous
+     * frame. nullptr (default) means that the whole frame changed. A list with 0 entries
+     * means that nothing changed. The list must be valid until the frame was analyzed. */
+    const vca_rect *dirtyRects{nullptr};
+    unsigned nrDirtyRects{0};
+
+    /* The frame does not follow the previously pushed frame (e.g. if only every Nth frame of
+     * a video is analyzed). Like for the first frame, the temporal differences (energyDiff,
+     * entropyDiff and the epsilons) of this frame are 0 and the next frame is compared to
+     * this frame. Dirty rectangles can not be used with such a frame. */
+    bool isDiscontinuity{false};
 };
 
 /* vca input parameters
@@ -164,18 +343,143 @@ struct vca_param
     bool enableEntropy{true};
     bool enableEdgeDensity{true};
 
+    // Only compute what is needed for shot detection (brightness, energy and the temporal
+    // energy differences). The luma plane is downsampled to 8x8 samples per block, which are
+    // transformed with the 8x8 DCT. The energy is scaled to the full DCT energy of one out of
+    // 16 blocks of each frame. The brightness is calculated from the sum of the downsampled
+    // block with the DC scale of the full analysis (also for high bit depths) and can differ
+    // by 1 from it (more in blocks at the right and bottom border). Entropy, edge density and
+    // chroma are not computed. The block size must be 16 or more.
+    bool enableShotDetectionOnly{false};
+
+    // Estimate the energy of each block from the 8x8 Walsh-Hadamard transforms of the block
+    // instead of the DCT. This only needs additions and subtractions and is faster. The
+    // energies are scaled per block size to stay on the scale of the DCT energies. The scale
+    // is calibrated on generated content (see docs/api.md for the deviation from the DCT
+    // values on test sequences). The brightness is calculated from
+    // the sum of the samples and can differ by 1 from the DC of the DCT.
+    bool enableHadamardEnergy{false};
+
     vca_frame_info frameInfo{};
 
-    // Size (width/height) of the analysis block. Must be 8, 16 or 32.
+    // The outputs that are needed (VCA_OUTPUT_* flags). Only the features that these outputs
+    // depend on are calculated, e.g. with only VCA_OUTPUT_BRIGHTNESS the brightness of each
+    // block is calculated from the sum of its samples without any transform. The outputs
+    // that are not required are 0. The enable flags above still apply. Block grids also
+    // require the brightness, energy and edge density. Ignored in shot detection only mode.
+    uint32_t requiredOutputs{VCA_OUTPUT_ALL};
+
+    // Size (width/height) of the analysis block. Must be 8, 16, 32, 64 or 128. Blocks of 64
+    // and 128 are analyzed as 32x32 blocks of the frame decimated by 2 or 4 (see
+    // docs/api.md). They can not be combined with decimationFactor.
     unsigned blockSize{32};
 
+    // Format of the per block values written by vca_analyzer_pull_frame_result. Only the copy
+    // into the memory of the caller is converted, the queued results always hold the native
+    // types.
+    vca_block_format blockFormat{vca_block_format::Native};
+
+    // Blocks of which all samples have the same value are not transformed. Their results
+    // (energy, entropy and edge density 0, brightness from the DC) are calculated directly,
+    // which gives identical results. If this is set to a value above 0, blocks where the
+    // difference between the maximum and minimum sample is at most this value are also
+    // handled like flat blocks (energy and entropy 0, brightness from the mean).
+    unsigned flatBlockThreshold{0};
+
+    // Compare each block with the block at the same position in the most recently analyzed
+    // frame using a 64 bit hash of the samples. The results of unchanged blocks are copied
+    // instead of being calculated again. This speeds up content where large parts of the
+    // frame do not change (e.g. screen content or slide shows). No effect in shot detection
+    // only mode.
+    bool enableStaticBlockCache{false};
+
+    // Detect frames that are identical to the previous frame (e.g. repeated frames in
+    // telecined or frame rate padded content) using a hash of all planes. The analysis of
+    // these frames is skipped and the results of the previous frame are reused.
+    bool enableDuplicateFrameDetection{false};
+
+    // Measure the time spent in each stage of the analysis (see vca_stage and
+    // vca_analyzer_stats::stageTimeTotal). The stages that run per block are measured on
+    // every 16th block only. There is no overhead if it is disabled.
+    bool enableStageTimings{false};
+
+    // Record the work of each thread on each frame as a timeline that can be written with
+    // vca_analyzer_write_trace. Up to traceBufferSize events are kept per thread, further
+    // events are dropped.
+    bool enableTracing{false};
+    unsigned traceBufferSize{65536};
+
+    // Only analyze the blocks that intersect this rectangle. The frame averages and the
+    // temporal differences are calculated over these blocks only. A width or height of 0
+    // (default) selects the whole frame.
+    vca_rect regionOfInterest{};
+
+    // Analyze a copy of the frame that is decimated by this factor (1, 2 or 4) in each
+    // dimension with a box filter. This is faster but less accurate. The per block values
+    // refer to blocks of blockSize * decimationFactor luma samples of the input frame and
+    // the energy values are comparable with the full analysis at this block size.
+    unsigned decimationFactor{1};
+
+    // Detect black borders (letterbox or pillarbox bars) in the first N frames and restrict
+    // the analysis to the active picture area (within the region of interest). The results
+    // of the first N frames are only available after N frames were pushed (or when a result
+    // is pulled). 0 (default) disables the detection.
+    unsigned letterboxDetectionFrames{0};
+
+    // Additional resolutions (e.g. the renditions of an ABR ladder) at which every frame is
+    // analyzed. The input frame is downscaled in the analyzer (each resolution from the
+    // smallest larger one that was already calculated), so the input is only read once and
+    // all resolutions are analyzed by the same threads. Width and height must be even and
+    // not larger than the input. The results are written to vca_frame_results::ladderResults.
+    vca_resolution ladderResolutions[VCA_MAX_LADDER_RESOLUTIONS]{};
+    unsigned nrLadderResolutions{0};
+
+    // Coarser block grids (16 or 32 and larger than blockSize) for which the brightness,
+    // energy and edge density are derived from the analysis at blockSize. This replaces
+    // running one analyzer per block size. The energy of a coarser block is estimated from
+    // the energies of the blocks that it contains (see docs/api.md). The results are written
+    // to vca_frame_results::blockGrids.
+    unsigned blockGridSizes[VCA_MAX_BLOCK_GRIDS]{};
+    unsigned nrBlockGrids{0};
+
+    // Only analyze one out of every blockSamplingInterval blocks (1 to 16) in each frame,
+    // selected with blockSamplingPattern. The frame averages are estimated from the analyzed
+    // blocks and their confidence intervals are written to vca_frame_results. This is meant
+    // for fast frame level statistics: the per block values of blocks that are not analyzed
+    // are 0, the temporal differences are not calculated and the static block cache, dirty
+    // rectangles and block grids are not used. 1 (default) analyzes all blocks.
+    unsigned blockSamplingInterval{1};
+    vca_sampling_pattern blockSamplingPattern{vca_sampling_pattern::Stratified};
+
+    // Real-time mode: The frames must be analyzed at this rate (frames per second) and/or
+    // each result must be available within this many milliseconds after pushing the frame.
+    // If the analysis does not keep up, the analyzer steps down to cheaper quality tiers and
+    // steps up again when there is headroom (see docs/api.md). 0 disables the mode.
+    double realTimeFrameRate{0.0};
+    unsigned realTimeLatencyMs{0};
+
     unsigned nrFrameThreads{0};
     unsigned nrSliceThreads{0};
 
+    // The number of pushed frames that can wait for a free thread before vca_analyzer_push
+    // blocks. 0 (default) adapts the size to the measured idle time of the threads and the
+    // results that wait to be pulled (see docs/api.md).
+    unsigned jobQueueSize{0};
+
+    // The maximum memory (in bytes) of the analyzed results that wait to be pulled. If it is
+    // reached, the threads wait until results are pulled. One result is always kept. 0
+    // (default) is no limit. With a limit, results must be pulled while pushing frames (from
+    // the same thread or another thread), otherwise vca_analyzer_push can block forever.
+    size_t maxQueuedResultsMemory{0};
+
     CpuSimd cpuSimd{CpuSimd::Autodetect};
 
+    // Messages above logLevel are not formatted and not passed to logFunction. The default
+    // (Debug) passes all messages. The messages of the processing threads are passed to
+    // logFunction from a background thread, so the analysis does not wait for it.
     void (*logFunction)(void *, LogLevel, const char *){};
     void *logFunctionPrivateData{};
+    LogLevel logLevel{LogLevel::Debug};
 };
 
 /* Create a new analyzer or nullptr if the config is invalid.
@@ -207,6 +511,47 @@ DLL_PUBLIC bool vca_result_available(vca_analyzer *enc);
  */
 DLL_PUBLIC vca_result vca_analyzer_pull_frame_result(vca_analyzer *enc, vca_frame_results *result);
 
+/* Statistics about the work done by the analyzer. The values cover all results that were
+ * pulled so far. Every analysis of a block for one feature (e.g. the energy of a chroma
+ * block) counts as one analyzed block.
+ */
+struct vca_analyzer_stats
+{
+    uint64_t blocksAnalyzed{};
+    // Blocks for which the analysis was skipped because the block is flat
+    uint64_t blocksSkipped{};
+    // Blocks for which the results were copied from the static block cache
+    uint64_t blocksReused{};
+    // Frames that were identical to the previous frame and not analyzed
+    uint64_t duplicateFrames{};
+    double skipRatio{};
+    double reuseRatio{};
+    // Frames analyzed in each quality tier of the real-time mode
+    uint64_t framesPerQualityTier[VCA_NR_QUALITY_TIERS]{};
+    // The current size of the job queue (see vca_param::jobQueueSize)
+    unsigned jobQueueSize{};
+    // The maximum memory of the results that waited to be pulled at the same time
+    uint64_t peakQueuedResultsMemory{};
+
+    // Only set if vca_param::enableStageTimings is set. The time in seconds spent in each
+    // stage (indexed by vca_stage) summed over all pulled results and the average per frame
+    // over the last VCA_STAGE_TIMING_WINDOW results.
+    double stageTimeTotal[VCA_NR_STAGES]{};
+    double stageTimeRecent[VCA_NR_STAGES]{};
+
+    // The fraction of the time since the first frame was pushed that each thread worked on
+    // frames (for the first VCA_MAX_THREAD_STATS of nrThreads threads)
+    unsigned nrThreads{};
+    double threadUtilization[VCA_MAX_THREAD_STATS]{};
+};
+
+DLL_PUBLIC vca_result vca_analyzer_get_stats(vca_analyzer *enc, vca_analyzer_stats *stats);
+
+/* Write the events recorded so far with vca_param::enableTracing to a Chrome trace JSON
+ * file. This can be called at any time while the analyzer is open.
+ */
+DLL_PUBLIC vca_result vca_analyzer_write_trace(vca_analyzer *enc, const char *filename);
+
 DLL_PUBLIC void vca_analyzer_close(vca_analyzer *enc);
 
 struct vca_shot_detection_param
@@ -217,14 +562,64 @@ struct vca_shot_detection_param
 
     double fps{};
 
+    // Number of threads for vca_shot_detection and vca_shot_detection_batch. The frames are
+    // split into one chunk per thread. 0 selects the number of hardware threads.
+    unsigned nrThreads{1};
+
     void (*logFunction)(void *, LogLevel, const char *){};
     void *logFunctionPrivateData{};
+    LogLevel logLevel{LogLevel::Debug};
 };
 
 DLL_PUBLIC vca_result vca_shot_detection(const vca_shot_detection_param &param,
                                          vca_frame_results *frames,
                                          size_t num_frames);
 
+/* Run the shot detection for several parameter sets (e.g. a sweep over the thresholds)
+ * in one pass over the frame results. The frames are not modified. isNewShot must point
+ * to memory for num_params * num_frames values. The decision for parameter set p and
+ * frame i is written to isNewShot[p * num_frames + i]. The number of threads and the log
+ * function are taken from the first parameter set.
+ */
+DLL_PUBLIC vca_result vca_shot_detection_batch(const vca_shot_detection_param *params,
+                                               size_t num_params,
+                                               const vca_frame_results *frames,
+                                               size_t num_frames,
+                                               bool *isNewShot);
+
+/* vca_shot_detector:
+ *      opaque handler for an incremental shot detector */
+typedef void vca_shot_detector;
+
+/* Create an incremental shot detector. It makes the same decisions as
+ * vca_shot_detection but works on a stream of frame results. Only a look ahead
+ * window of ceil(fps) frames is kept in memory, so the decision for a frame is
+ * available at most ceil(fps) frames after it was pushed.
+ */
+DLL_PUBLIC vca_shot_detector *vca_shot_detector_open(vca_shot_detection_param param);
+
+/* Push the next frame result (in display order) to the detector. Only the frame
+ * level values are used. The per block pointers are copied but not accessed.
+ */
+DLL_PUBLIC vca_result vca_shot_detector_push(vca_shot_detector *detector,
+                                             const vca_frame_results *frame);
+
+/* Signal the end of the stream. All remaining frames are decided and can be pulled.
+ */
+DLL_PUBLIC vca_result vca_shot_detector_flush(vca_shot_detector *detector);
+
+/* Check if a decided frame is available to pull.
+ */
+DLL_PUBLIC bool vca_shot_detector_result_available(vca_shot_detector *detector);
+
+/* Pull the next decided frame. This is a copy of the pushed frame result with
+ * isNewShot set. Returns VCA_ERROR if no decided frame is available.
+ */
+DLL_PUBLIC vca_result vca_shot_detector_pull(vca_shot_detector *detector,
+                                             vca_frame_results *frame);
+
+DLL_PUBLIC void vca_shot_detector_close(vca_shot_detector *detector);
+
 DLL_PUBLIC extern const char *vca_version_str;
 
 } // extern "C"